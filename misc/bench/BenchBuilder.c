@@ -0,0 +1,240 @@
+/* Headless benchmark of how quickly chunk meshes are built (see src/Builder.c) */
+/* Usage: BenchBuilder [map file] [iterations] [builder threads] */
+/* If no map file is given, maps/bench.cw is used instead (which is generated with a fixed seed if missing) */
+/* Also checks that meshes built on the builder threads are the same as meshes built on just the main thread */
+/* NOTE: Builder.c is included directly, so that the time spent in its internal functions can be measured */
+#include "../../src/Builder.c"
+#include "../../src/Formats.h"
+#include "../../src/Bitmap.h"
+#include "../../src/Entity.h"
+#include "../../src/Camera.h"
+#include "../../src/Model.h"
+#include "../../src/Logger.h"
+#include "../../src/Event.h"
+#include "../../src/Generator.h"
+#include "../../src/Stream.h"
+#include "../../src/Deflate.h"
+#include "../../src/Utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+struct BenchStats {
+	int chunks, meshes, vertices;
+	cc_uint64 total;
+	struct BuilderTimes times;
+};
+static struct ChunkInfo* chunks;
+static int chunksCount;
+
+/* Only the components needed to load a map and build chunk meshes */
+static struct IGameComponent* const components[] = {
+	&World_Component,    &Blocks_Component,  &Camera_Component, &Models_Component,
+	&Entities_Component, &Lighting_Component, &Builder_Component, &MapRenderer_Component
+};
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+/* Same as Builder_MakeChunk, but also measures time spent in each stage */
+static void MeshChunk(struct ChunkInfo* info, struct BenchStats* stats) {
+	int totalVerts = MakeChunk(&mainState, info, &stats->times);
+	if (!totalVerts) return;
+
+	stats->meshes++;
+	stats->vertices += totalVerts;
+}
+
+/* Adds the given parts of a chunk to the checksum of all the chunk meshes, returning how many vertices they have */
+static int ChecksumParts(struct ChunkPartInfo* parts, cc_uint32* crc) {
+	struct ChunkPartInfo* part;
+	int i, j, count = 0;
+	if (!parts) return 0;
+
+	for (i = 0; i < MapRenderer_1DUsedCount; i++) {
+		part = &parts[i * World.ChunksCount];
+		if (part->Offset < 0) continue;
+
+		*crc   = *crc * 31 + Utils_CRC32((cc_uint8*)part, sizeof(struct ChunkPartInfo));
+		count += part->SpriteCount;
+		for (j = 0; j < FACE_COUNT; j++) { count += part->Counts[j]; }
+	}
+	return count;
+}
+
+/* Calculates a checksum of the occlusion flags, part infos and vertices of all the chunk meshes */
+static cc_uint32 ChecksumMeshes(void) {
+	struct ChunkInfo* info;
+	cc_uint32 crc = 0;
+	void* vertices;
+	int i, count;
+
+	for (i = 0; i < chunksCount; i++) {
+		info  = &chunks[i];
+		crc   = crc * 31 + info->OcclusionFlags + info->AllAir;
+		count = ChecksumParts(info->NormalParts, &crc) + ChecksumParts(info->TranslucentParts, &crc);
+		if (!count || !info->Vb) continue;
+
+		/* NOTE: Only works because the null backend returns the contents of the VB */
+		vertices = Gfx_LockVb(info->Vb, VERTEX_FORMAT_TEXTURED, count);
+		crc = crc * 31 + Utils_CRC32((cc_uint8*)vertices, count * sizeof(struct VertexTextured));
+		Gfx_UnlockVb(info->Vb);
+	}
+	return crc;
+}
+
+static void ResetChunks(void) {
+	struct ChunkInfo* info;
+	int x, y, z;
+	/* Lighting is calculated lazily per column, so must be reset to measure the same work each iteration */
+	Lighting.FreeState();
+	Lighting.AllocState();
+
+	for (z = 0; z < World.ChunksZ; z++) {
+		for (y = 0; y < World.ChunksY; y++) {
+			for (x = 0; x < World.ChunksX; x++) {
+				info = &chunks[World_ChunkPack(x, y, z)];
+				Gfx_DeleteVb(&info->Vb);
+				Mem_Set(info, 0, sizeof(struct ChunkInfo));
+
+				info->CentreX = x * CHUNK_SIZE + HALF_CHUNK_SIZE;
+				info->CentreY = y * CHUNK_SIZE + HALF_CHUNK_SIZE;
+				info->CentreZ = z * CHUNK_SIZE + HALF_CHUNK_SIZE;
+			}
+		}
+	}
+}
+
+static cc_bool RunBuilder(const char* name, int iterations) {
+	struct ChunkInfo** batch;
+	struct BenchStats stats = { 0 };
+	cc_uint32 threadedCrc, singleCrc;
+	cc_uint64 beg, end;
+	int i, j;
+
+	/* Measure overall throughput, without any timing overhead inside of each chunk */
+	batch = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "bench chunks");
+	for (i = 0; i < chunksCount; i++) { batch[i] = &chunks[i]; }
+
+	for (i = 0; i < iterations; i++) {
+		ResetChunks();
+		beg = Stopwatch_Measure();
+		/* Batches are the same size as what MapRenderer would build in one frame */
+		for (j = 0; j < chunksCount; j += 30 * (Builder_ThreadsCount + 1)) {
+			Builder_MakeChunks(batch + j, min(chunksCount - j, 30 * (Builder_ThreadsCount + 1)));
+		}
+		end = Stopwatch_Measure();
+		stats.total += Stopwatch_ElapsedMicroseconds(beg, end);
+	}
+	Mem_Free(batch);
+	threadedCrc = ChecksumMeshes();
+
+	for (i = 0; i < iterations; i++) {
+		ResetChunks();
+		for (j = 0; j < chunksCount; j++) { MeshChunk(&chunks[j], &stats); }
+	}
+	stats.chunks = chunksCount * iterations;
+	singleCrc    = ChecksumMeshes();
+
+	printf("%s builder (%i threads):\n", name, Builder_ThreadsCount);
+	printf("  %i chunks in %.2f ms (%.1f chunks/s)\n", stats.chunks, ElapsedMS(stats.total),
+											stats.chunks / (stats.total / 1000000.0));
+	printf("  %i chunks had a mesh, %.1f vertices/chunk\n", stats.meshes / iterations,
+											stats.meshes ? (float)stats.vertices / stats.meshes : 0.0f);
+	printf("  ReadChunkData: %.2f ms, PrepareChunk (and lighting): %.2f ms, RenderBlock: %.2f ms\n", ElapsedMS(stats.times.read),
+											ElapsedMS(stats.times.prepare), ElapsedMS(stats.times.render));
+
+	if (threadedCrc == singleCrc) {
+		printf("  Meshes match when built on only the main thread (checksum %08x)\n", threadedCrc);
+	} else {
+		printf("  MISMATCH: meshes checksum %08x, but %08x when built on only the main thread\n", threadedCrc, singleCrc);
+	}
+	return threadedCrc == singleCrc;
+}
+
+/* Sets up a 256x256 terrain atlas, so that the 1D atlases are the same as with the default texture pack */
+static void InitAtlas(void) {
+	struct Bitmap bmp;
+	Bitmap_Allocate(&bmp, 256, 256);
+	Mem_Set(bmp.scan0, 0xFF, Bitmap_DataSize(256, 256));
+	if (!Atlas_TryChange(&bmp)) Logger_Abort("Failed to create terrain atlas");
+}
+
+static void HandleMapLoaded(void* obj) {
+	int i;
+	for (i = 0; i < Array_Elems(components); i++) {
+		if (components[i]->OnNewMapLoaded) components[i]->OnNewMapLoaded();
+	}
+}
+
+static void InitComponents(void) {
+	int i;
+	Event_Register_(&WorldEvents.MapLoaded, NULL, HandleMapLoaded);
+
+	for (i = 0; i < Array_Elems(components); i++) {
+		Game_AddComponent(components[i]);
+		if (components[i]->Init) components[i]->Init();
+	}
+}
+
+static cc_result GenerateMap(const cc_string* path) {
+	struct Stream stream, compStream;
+	struct GZipState state;
+	cc_result res;
+	World_SetDimensions(256, 64, 256);
+
+	Gen_Seed    = 1234;
+	Gen_Vanilla = true;
+	Gen_Blocks  = (BlockRaw*)Mem_Alloc(World.Volume, 1, "bench map blocks");
+	NotchyGen_Generate();
+
+	World_SetNewMap(Gen_Blocks, World.Width, World.Height, World.Length);
+	World.Seed = Gen_Seed;
+	Gen_Blocks = NULL;
+	LocalPlayer_CalcDefaultSpawn();
+
+	Utils_EnsureDirectory("maps");
+	if ((res = Stream_CreateFile(&stream, path))) return res;
+	GZip_MakeStream(&compStream, &state, &stream);
+
+	if (!(res = Cw_Save(&compStream))) res = compStream.Close(&compStream);
+	(void)stream.Close(&stream);
+	return res;
+}
+
+int main(int argc, char** argv) {
+	static const cc_string defPath = String_FromConst("maps/bench.cw");
+	cc_string path = defPath;
+	int iterations, threads;
+	cc_bool match;
+	cc_result res;
+
+	Logger_Hook();
+	Platform_Init();
+	if (argc > 1) path = String_FromReadonly(argv[1]);
+	iterations = argc > 2 ? atoi(argv[2]) : 5;
+	threads    = argc > 3 ? atoi(argv[3]) : 0;
+	Options_SetInt(OPT_BUILDER_THREADS, max(0, threads));
+
+	Gfx_Create();
+	GameVersion_Load();
+	InitComponents();
+	InitAtlas();
+
+	if (argc <= 1 && !File_Exists(&path) && (res = GenerateMap(&path))) {
+		printf("Failed to generate %.*s (error %x)\n", path.length, path.buffer, res); return 1;
+	}
+	res = Map_LoadFrom(&path);
+	if (res) { printf("Failed to load %.*s (error %x)\n", path.length, path.buffer, res); return 1; }
+
+	chunksCount = World.ChunksCount;
+	chunks      = (struct ChunkInfo*)Mem_AllocCleared(chunksCount, sizeof(struct ChunkInfo), "bench chunk info");
+	printf("Map: %i x %i x %i (%i chunks), %i iterations\n", World.Width, World.Height, World.Length,
+											chunksCount, max(1, iterations));
+
+	NormalBuilder_SetActive();
+	match = RunBuilder("Normal", max(1, iterations));
+	AdvBuilder_SetActive();
+	match = RunBuilder("Advanced", max(1, iterations)) && match;
+
+	Builder_Component.Free();
+	return match ? 0 : 1;
+}
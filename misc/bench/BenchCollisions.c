@@ -0,0 +1,352 @@
+/* Headless benchmark of how quickly the blocks an entity may collide with are found (see src/Physics.c) */
+/* Usage: BenchCollisions [iterations] [entities] [ticks] */
+/* The movement of many entities on a generated map is recorded first, with some entities walking, some */
+/*  running with speed hacks, some falling from high above the map and some flying quickly through it */
+/* The recorded movement is then replayed, finding the reachable blocks for each entity every tick, */
+/*  first by checking every block like Searcher_FindReachableBlocks used to and then with the solid blocks map */
+/* The found blocks are checked to be exactly the same (including order), and the solid blocks map is also */
+/*  checked to still be correct after many blocks in the map are changed */
+/* NOTE: Physics.c is included directly, so that the old way of finding blocks can be compared against */
+#include "../../src/Physics.c"
+#include "../../src/EntityComponents.h"
+#include "../../src/Generator.h"
+#include "../../src/Utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_WIDTH  256
+#define BENCH_HEIGHT 128
+#define BENCH_LENGTH 256
+#define BENCH_MAX_ENTITIES 256
+
+enum BenchMode { MODE_WALK, MODE_SPEED, MODE_FALL, MODE_FLY, MODE_COUNT };
+static const char* const modeNames[MODE_COUNT] = { "walking", "speed hacks", "falling", "flying" };
+
+struct TraceEntry { Vec3 pos, vel, size; cc_uint8 mode; };
+static struct TraceEntry* trace;
+static int traceCount;
+
+static struct Entity entities[BENCH_MAX_ENTITIES];
+static struct CollisionsComp collisions[BENCH_MAX_ENTITIES];
+static cc_uint8 modes[BENCH_MAX_ENTITIES];
+static RNGState rnd;
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Old way of finding blocks-----------------------------------------------*
+*#########################################################################################################################*/
+static struct SearcherState* refStates;
+static cc_uint32 refCapacity;
+
+static void Reference_QuickSort(int left, int right) {
+	struct SearcherState* keys = refStates; struct SearcherState key;
+
+	while (left < right) {
+		int i = left, j = right;
+		float pivot = keys[(i + j) >> 1].tSquared;
+
+		/* partition the list */
+		while (i <= j) {
+			while (pivot > keys[i].tSquared) i++;
+			while (pivot < keys[j].tSquared) j--;
+			QuickSort_Swap_Maybe();
+		}
+		/* recurse into the smaller subset */
+		QuickSort_Recurse(Reference_QuickSort);
+	}
+}
+
+/* Finds blocks in the same way as Searcher_FindReachableBlocks used to, i.e. by checking every block */
+static int Reference_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, struct AABB* entityExtentBB) {
+	Vec3 vel = entity->Velocity;
+	IVec3 min, max;
+	cc_uint32 elements;
+	struct SearcherState* curState;
+	int count;
+
+	BlockID block;
+	struct AABB blockBB;
+	float xx, yy, zz, tx, ty, tz;
+	int x, y, z;
+
+	Entity_GetBounds(entity, entityBB);
+	entityExtentBB->Min.X = entityBB->Min.X + (vel.X < 0.0f ? vel.X : 0.0f);
+	entityExtentBB->Min.Y = entityBB->Min.Y + (vel.Y < 0.0f ? vel.Y : 0.0f);
+	entityExtentBB->Min.Z = entityBB->Min.Z + (vel.Z < 0.0f ? vel.Z : 0.0f);
+
+	entityExtentBB->Max.X = entityBB->Max.X + (vel.X > 0.0f ? vel.X : 0.0f);
+	entityExtentBB->Max.Y = entityBB->Max.Y + (vel.Y > 0.0f ? vel.Y : 0.0f);
+	entityExtentBB->Max.Z = entityBB->Max.Z + (vel.Z > 0.0f ? vel.Z : 0.0f);
+
+	IVec3_Floor(&min, &entityExtentBB->Min);
+	IVec3_Floor(&max, &entityExtentBB->Max);
+	elements = (max.X - min.X + 1) * (max.Y - min.Y + 1) * (max.Z - min.Z + 1);
+
+	if (elements > refCapacity) {
+		Mem_Free(refStates);
+		refCapacity = elements;
+		refStates   = (struct SearcherState*)Mem_Alloc(elements, sizeof(struct SearcherState), "bench states");
+	}
+	curState = refStates;
+
+	for (y = min.Y; y <= max.Y; y++) {
+		for (z = min.Z; z <= max.Z; z++) {
+			for (x = min.X; x <= max.X; x++) {
+				block = World_GetPhysicsBlock(x, y, z);
+				if (Blocks.Collide[block] != COLLIDE_SOLID) continue;
+
+				xx = (float)x; yy = (float)y; zz = (float)z;
+				blockBB.Min = Blocks.MinBB[block];
+				blockBB.Min.X += xx; blockBB.Min.Y += yy; blockBB.Min.Z += zz;
+				blockBB.Max = Blocks.MaxBB[block];
+				blockBB.Max.X += xx; blockBB.Max.Y += yy; blockBB.Max.Z += zz;
+
+				if (!AABB_Intersects(entityExtentBB, &blockBB)) continue;
+				Searcher_CalcTime(&vel, entityBB, &blockBB, &tx, &ty, &tz);
+				if (tx > 1.0f || ty > 1.0f || tz > 1.0f) continue;
+
+				curState->X = (x << 3) | (block  & 0x007);
+				curState->Y = (y << 4) | ((block & 0x078) >> 3);
+				curState->Z = (z << 3) | ((block & 0x380) >> 7);
+				curState->tSquared = tx * tx + ty * ty + tz * tz;
+				curState++;
+			}
+		}
+	}
+
+	count = (int)(curState - refStates);
+	if (count) Reference_QuickSort(0, count - 1);
+	return count;
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Recording-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Generates a classic map, and then scatters slabs over it so that not every block is a whole block */
+static void MakeMap(void) {
+	int i, x, y, z;
+
+	World_SetDimensions(BENCH_WIDTH, BENCH_HEIGHT, BENCH_LENGTH);
+	Gen_Blocks       = (BlockRaw*)Mem_Alloc(World.Volume, 1, "bench map blocks");
+	Gen_Seed         = 1234;
+	Gen_ThreadsCount = 0;
+	NotchyGen_Generate();
+	World_SetNewMap(Gen_Blocks, BENCH_WIDTH, BENCH_HEIGHT, BENCH_LENGTH);
+	Gen_Blocks = NULL;
+
+	Random_Seed(&rnd, 1234);
+	for (i = 0; i < World.Volume / 256; i++) {
+		x = Random_Next(&rnd, World.Width);
+		z = Random_Next(&rnd, World.Length);
+		y = Random_Next(&rnd, World.Height - 1);
+
+		if (World_GetBlock(x, y, z) != BLOCK_AIR || Blocks.Collide[World_GetBlock(x, y - 1, z)] != COLLIDE_SOLID) continue;
+		World_SetBlock(x, y, z, BLOCK_SLAB);
+	}
+	OnNewMapLoaded();
+}
+
+static void RandomDir(Vec3* vel, float speed, cc_bool vertical) {
+	float angle = Random_Float(&rnd) * 2 * MATH_PI;
+	vel->X = Math_CosF(angle) * speed;
+	vel->Z = Math_SinF(angle) * speed;
+	if (vertical) vel->Y = (Random_Float(&rnd) * 2 - 1) * speed;
+}
+
+static void Spawn(int i) {
+	struct Entity* e = &entities[i];
+	float speed;
+	modes[i] = i % MODE_COUNT;
+
+	e->Position.X = 1 + Random_Float(&rnd) * (World.Width  - 2);
+	e->Position.Z = 1 + Random_Float(&rnd) * (World.Length - 2);
+	e->Position.Y = modes[i] == MODE_FALL ? World.Height + 20.0f : World.Height - 1.0f;
+	Vec3_Set(e->Size, 0.6f, 1.8f, 0.6f);
+	e->OnGround = false;
+	e->Velocity.Y = 0.0f;
+
+	speed = modes[i] == MODE_WALK ? 0.1f : (modes[i] == MODE_FLY ? 3.0f : 1.0f);
+	RandomDir(&e->Velocity, speed + Random_Float(&rnd) * speed, modes[i] == MODE_FLY);
+
+	collisions[i].Entity   = e;
+	collisions[i].StepSize = 0.5f;
+}
+
+/* Moves the entity in roughly the same way as PhysicsComp_Move, but with simpler velocity changes */
+static void Move(int i) {
+	struct Entity* e = &entities[i];
+	struct TraceEntry* entry;
+	float speed;
+
+	if (!Vec3_IsZero(e->Velocity)) {
+		entry = &trace[traceCount++];
+		entry->pos  = e->Position;
+		entry->vel  = e->Velocity;
+		entry->size = e->Size;
+		entry->mode = modes[i];
+
+		Collisions_MoveAndWallSlide(&collisions[i]);
+		Vec3_AddBy(&e->Position, &e->Velocity);
+	}
+
+	if (modes[i] == MODE_FLY) {
+		if (Collisions_HitHorizontal(&collisions[i]) || !Random_Next(&rnd, 40)) RandomDir(&e->Velocity, 3.0f, true);
+	} else {
+		speed = modes[i] == MODE_WALK ? 0.1f : 1.0f;
+		if (e->OnGround && !Random_Next(&rnd, 20)) RandomDir(&e->Velocity, speed, false);
+		if (e->OnGround && Collisions_HitHorizontal(&collisions[i])) e->Velocity.Y = 0.42f;
+
+		e->Velocity.Y = (e->Velocity.Y - 0.08f) * 0.98f;
+		if (e->OnGround) { e->Velocity.X *= 0.98f; e->Velocity.Z *= 0.98f; }
+	}
+
+	/* Start again after leaving the map or falling into a hole */
+	if (e->Position.Y < 0 || e->Position.Y > World.Height + 40 || !World_ContainsXZ((int)e->Position.X, (int)e->Position.Z)) Spawn(i);
+}
+
+static void Record(int entitiesCount, int ticks) {
+	int i, j;
+	trace      = (struct TraceEntry*)Mem_Alloc(entitiesCount * ticks, sizeof(struct TraceEntry), "bench trace");
+	traceCount = 0;
+
+	for (i = 0; i < entitiesCount; i++) { Spawn(i); }
+	for (j = 0; j < ticks; j++) {
+		for (i = 0; i < entitiesCount; i++) { Move(i); }
+	}
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Replaying------------------------------------------------------*
+*#########################################################################################################################*/
+static void SetEntity(struct Entity* e, struct TraceEntry* entry) {
+	e->Position = entry->pos;
+	e->Velocity = entry->vel;
+	e->Size     = entry->size;
+}
+
+static cc_uint64 Replay(cc_bool reference, int mode, int* totalFound) {
+	struct AABB entityBB, extentBB;
+	struct Entity* e = &entities[0];
+	cc_uint64 beg;
+	int i;
+
+	*totalFound = 0;
+	beg = Stopwatch_Measure();
+	for (i = 0; i < traceCount; i++) {
+		if (mode != -1 && trace[i].mode != mode) continue;
+		SetEntity(e, &trace[i]);
+
+		if (reference) {
+			*totalFound += Reference_FindReachableBlocks(e, &entityBB, &extentBB);
+		} else {
+			*totalFound += Searcher_FindReachableBlocks(e, &entityBB, &extentBB);
+		}
+	}
+	return Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+}
+
+static int CountMismatches(void) {
+	struct AABB entityBB, extentBB;
+	struct Entity* e = &entities[0];
+	int i, expected, count, mismatches = 0;
+
+	for (i = 0; i < traceCount; i++) {
+		SetEntity(e, &trace[i]);
+		expected = Reference_FindReachableBlocks(e, &entityBB, &extentBB);
+		count    = Searcher_FindReachableBlocks(e,  &entityBB, &extentBB);
+
+		if (count != expected || !Mem_Equal(refStates, Searcher_States, count * sizeof(struct SearcherState))) mismatches++;
+	}
+	return mismatches;
+}
+
+/* Fastest time out of all the iterations is used, as replays are short enough to be easily disturbed */
+static void RunReplay(const char* name, int mode, int iterations) {
+	cc_uint64 oldTime = 0, newTime = 0, time;
+	int i, searches = 0, found = 0;
+
+	for (i = 0; i < traceCount; i++) {
+		if (mode == -1 || trace[i].mode == mode) searches++;
+	}
+	for (i = 0; i < iterations; i++) {
+		time = Replay(true,  mode, &found);
+		if (!i || time < oldTime) oldTime = time;
+		time = Replay(false, mode, &found);
+		if (!i || time < newTime) newTime = time;
+	}
+
+	printf("  %-11s: %7i searches, %5.1f blocks found on average, %8.2f ms checking every block, "
+			"%8.2f ms with solid blocks map (%.2fx as fast)\n", name, searches, (double)found / searches,
+			ElapsedMS(oldTime), ElapsedMS(newTime), (double)oldTime / newTime);
+}
+
+/* Changes many blocks in the same way as Game_UpdateBlock, then checks the map against a newly built one */
+static cc_bool CheckBlockChanges(void) {
+	static const BlockID changes[] = { BLOCK_AIR, BLOCK_STONE, BLOCK_WATER, BLOCK_SLAB, BLOCK_GLASS, BLOCK_ROSE };
+	int i, x, y, z, rowsSize = World.ChunksCount * CHUNK_SIZE_2 * 2;
+	cc_uint16* rows   = (cc_uint16*)Mem_Alloc(rowsSize, 1, "bench solid rows");
+	cc_uint16* counts = (cc_uint16*)Mem_Alloc(World.ChunksCount, 2, "bench solid counts");
+	BlockID block;
+	cc_bool same;
+
+	for (i = 0; i < 1000000; i++) {
+		x = Random_Next(&rnd, World.Width);
+		y = Random_Next(&rnd, World.Height);
+		z = Random_Next(&rnd, World.Length);
+		block = changes[Random_Next(&rnd, Array_Elems(changes))];
+
+		World_SetBlock(x, y, z, block);
+		Searcher_OnBlockChanged(x, y, z, block);
+	}
+
+	Mem_Copy(rows,   solidRows,   rowsSize);
+	Mem_Copy(counts, solidCounts, World.ChunksCount * 2);
+	SolidMap_Build();
+
+	same = Mem_Equal(rows, solidRows, rowsSize) && Mem_Equal(counts, solidCounts, World.ChunksCount * 2);
+	Mem_Free(rows);
+	Mem_Free(counts);
+	return same;
+}
+
+int main(int argc, char** argv) {
+	int i, iterations, entitiesCount, ticks, mismatches;
+	cc_uint64 beg;
+
+	Logger_Hook();
+	Platform_Init();
+	GameVersion_Load();
+	Blocks_Component.Init();
+	OnInit();
+
+	iterations    = argc > 1 ? atoi(argv[1]) : 20;
+	entitiesCount = argc > 2 ? atoi(argv[2]) : 64;
+	ticks         = argc > 3 ? atoi(argv[3]) : 2000;
+	iterations    = max(1, iterations);
+	entitiesCount = max(MODE_COUNT, min(entitiesCount, BENCH_MAX_ENTITIES));
+	ticks         = max(1, ticks);
+
+	MakeMap();
+	beg = Stopwatch_Measure();
+	SolidMap_Build();
+	printf("Map: %i x %i x %i, solid blocks map built in %.2f ms (%.1f KB)\n", World.Width, World.Height, World.Length,
+			ElapsedMS(Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure())),
+			World.ChunksCount * (CHUNK_SIZE_2 + 1) * 2 / 1024.0f);
+
+	Record(entitiesCount, ticks);
+	printf("%i entities moved for %i ticks, %i searches recorded\n", entitiesCount, ticks, traceCount);
+
+	RunReplay("all", -1, iterations);
+	for (i = 0; i < MODE_COUNT; i++) {
+		RunReplay(modeNames[i], i, iterations);
+	}
+
+	mismatches = CountMismatches();
+	if (mismatches) printf("  FOUND BLOCKS DO NOT MATCH CHECKING EVERY BLOCK FOR %i SEARCHES\n", mismatches);
+	if (!CheckBlockChanges()) printf("  SOLID BLOCKS MAP DOES NOT MATCH MAP AFTER CHANGING BLOCKS\n");
+	return 0;
+}
@@ -0,0 +1,77 @@
+/* Headless benchmark of how quickly classic maps are generated (see NotchyGen_Generate in src/Generator.c) */
+/* Usage: BenchGenerator [generator threads] */
+/* Each map is generated without any threads and then with the given number of threads (default 4), and */
+/*  the generated blocks are checked to be exactly the same as what the original serial generator made */
+/* NOTE: Expected CRC32s are from x86 builds using SSE2 floating point, other platforms may differ */
+#include "../../src/Generator.h"
+#include "../../src/World.h"
+#include "../../src/Platform.h"
+#include "../../src/Logger.h"
+#include "../../src/Utils.h"
+#include "../../src/Funcs.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+struct BenchMap { int width, height, length, seed; cc_uint32 crc; };
+static const struct BenchMap maps[] = {
+	{   64,  64,   64,         0, 0xd2d2762aUL },
+	{   64,  64,   64,      1234, 0xdd97ffcaUL },
+	{  128,  64,  128,         1, 0x90403d50UL },
+	{  256,  64,  256,         0, 0x10ddca9fUL },
+	{  256,  64,  256, 987654321, 0xbe9c9e1dUL },
+	{  256, 128,  256,      1234, 0x835fc44fUL },
+	{  512,  64,  512,         1, 0x149d01e4UL },
+	{  512, 128,  512,         0, 0xb8d876d1UL },
+	{ 1024, 256, 1024,         0, 0x8ed3eb34UL }
+};
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+static cc_uint32 Generate(const struct BenchMap* m, int threads, cc_uint64* elapsed) {
+	cc_uint64 beg;
+	cc_uint32 crc;
+
+	World_SetDimensions(m->width, m->height, m->length);
+	Gen_Blocks       = (BlockRaw*)Mem_Alloc(World.Volume, 1, "bench map blocks");
+	Gen_Seed         = m->seed;
+	Gen_ThreadsCount = threads;
+
+	beg = Stopwatch_Measure();
+	NotchyGen_Generate();
+	*elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+	crc = Utils_CRC32(Gen_Blocks, World.Volume);
+	Mem_Free(Gen_Blocks);
+	Gen_Blocks = NULL;
+	return crc;
+}
+
+int main(int argc, char** argv) {
+	cc_uint64 serial, parallel;
+	cc_uint32 crc1, crc2;
+	int i, threads, failed = 0;
+	const struct BenchMap* m;
+
+	Logger_Hook();
+	Platform_Init();
+	threads = argc > 1 ? atoi(argv[1]) : 4;
+	threads = max(0, min(threads, GEN_MAX_THREADS));
+
+	for (i = 0; i < Array_Elems(maps); i++) {
+		m    = &maps[i];
+		crc1 = Generate(m, 0,       &serial);
+		crc2 = Generate(m, threads, &parallel);
+
+		printf("%4i x %3i x %4i, seed %9i: %8.1f ms without threads, %8.1f ms with %i threads (%.2fx as fast)\n",
+				m->width, m->height, m->length, m->seed, ElapsedMS(serial), ElapsedMS(parallel), threads,
+				(double)serial / parallel);
+
+		if (crc1 != m->crc || crc2 != m->crc) {
+			printf("  MAP DOES NOT MATCH ORIGINAL GENERATOR (CRC32 %08x and %08x, expected %08x)\n", crc1, crc2, m->crc);
+			failed++;
+		}
+	}
+
+	if (failed) printf("%i maps did not match\n", failed);
+	return failed ? 1 : 0;
+}
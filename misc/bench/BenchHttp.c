@@ -0,0 +1,632 @@
+/* Headless benchmark of how http requests are scheduled across the http workers (see src/Http_Worker.c) */
+/* Usage: BenchHttp */
+/* A stand-in HTTP server is run on the local machine, which delays each response by the time given in the url */
+/*  and records when each request was started, how many requests were active at once for each host, and how */
+/*  many connections were made to each host. 127.0.0.x addresses are used as different hosts for the same server */
+/* Checks that requests are spread across hosts, that per-host limits and priorities are followed, and that */
+/*  connections are shared between the workers (requires curl 7.57 or later) */
+/* Also checks that the asset cache index is saved and loaded again exactly (including ETags with spaces), */
+/*  that cached responses are revalidated with 304 responses, and that the least recently used are evicted */
+/* NOTE: Every file in the texturecache folder is deleted first */
+/* NOTE: Results are printed to stderr, as the http workers log every request to stdout */
+/* NOTE: Http_Worker.c is included directly, so that the workers and curl share handle can be inspected */
+/* NOTE: The stand-in server uses BSD sockets and pthreads, so this only runs on unix-like systems */
+#include "../../src/Http_Worker.c"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define BENCH_WORKERS 6
+#define BENCH_MAX_PER_HOST 2
+#define SERVER_MAX_HOSTS 16
+#define SERVER_MAX_LOG 256
+static const cc_string assetDir = String_FromConst(ASSET_CACHE_DIR);
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Stand-in http server--------------------------------------------------*
+*#########################################################################################################################*/
+struct ServerLogEntry { int host; char tag[32]; };
+static struct ServerState {
+	int port, listenFd;
+	pthread_mutex_t mutex;
+	char hosts[SERVER_MAX_HOSTS][64];
+	int hostsCount;
+	int active[SERVER_MAX_HOSTS], maxActive[SERVER_MAX_HOSTS], conns[SERVER_MAX_HOSTS];
+	int totalActive, maxTotalActive, notModified;
+	struct ServerLogEntry log[SERVER_MAX_LOG];
+	int logCount;
+} server;
+
+/* NOTE: server.mutex must be locked when calling this */
+static int Server_HostIndex(const char* host) {
+	int i;
+	for (i = 0; i < server.hostsCount; i++) {
+		if (!strcmp(server.hosts[i], host)) return i;
+	}
+	if (server.hostsCount == SERVER_MAX_HOSTS) return 0;
+
+	snprintf(server.hosts[i], sizeof(server.hosts[i]), "%s", host);
+	return server.hostsCount++;
+}
+
+static int Server_Begin(const char* host, const char* tag, cc_bool newConn) {
+	int i;
+	pthread_mutex_lock(&server.mutex);
+	{
+		i = Server_HostIndex(host);
+		if (newConn) server.conns[i]++;
+
+		server.active[i]++;
+		server.totalActive++;
+		if (server.active[i]    > server.maxActive[i])  server.maxActive[i]  = server.active[i];
+		if (server.totalActive  > server.maxTotalActive) server.maxTotalActive = server.totalActive;
+
+		if (server.logCount < SERVER_MAX_LOG) {
+			server.log[server.logCount].host = i;
+			snprintf(server.log[server.logCount].tag, sizeof(server.log[0].tag), "%s", tag);
+			server.logCount++;
+		}
+	}
+	pthread_mutex_unlock(&server.mutex);
+	return i;
+}
+
+static void Server_End(int host) {
+	pthread_mutex_lock(&server.mutex);
+	{
+		server.active[host]--;
+		server.totalActive--;
+	}
+	pthread_mutex_unlock(&server.mutex);
+}
+
+static void Server_Reset(void) {
+	pthread_mutex_lock(&server.mutex);
+	{
+		memset(server.maxActive, 0, sizeof(server.maxActive));
+		memset(server.conns,     0, sizeof(server.conns));
+		server.maxTotalActive = 0;
+		server.logCount       = 0;
+		server.notModified    = 0;
+	}
+	pthread_mutex_unlock(&server.mutex);
+}
+
+static int Server_LogCount(void) {
+	int count;
+	pthread_mutex_lock(&server.mutex);
+	count = server.logCount;
+	pthread_mutex_unlock(&server.mutex);
+	return count;
+}
+
+/* Reads the header of a request, returns false if the connection was closed */
+static cc_bool Server_ReadHeader(int fd, char* buffer, int capacity) {
+	int len = 0, read;
+	for (;;) {
+		read = (int)recv(fd, buffer + len, capacity - 1 - len, 0);
+		if (read <= 0) return false;
+
+		len += read;
+		buffer[len] = '\0';
+		if (strstr(buffer, "\r\n\r\n")) return true;
+		if (len == capacity - 1) return false;
+	}
+}
+
+#define SERVER_LAST_MODIFIED "Wed, 21 Oct 2015 07:28:00 GMT"
+/* Handles requests of the form GET /[delay]/[tag], where the response body is just the tag */
+/* The ETag of the response contains a space, and 304 is returned if the request has the same ETag */
+static void* Server_Connection(void* arg) {
+	int fd = (int)(size_t)arg;
+	char buffer[4096], host[64], tag[32], etag[64], response[512];
+	cc_bool newConn = true, cached;
+	int delay, len, hostIndex;
+	char* value;
+
+	while (Server_ReadHeader(fd, buffer, sizeof(buffer))) {
+		delay = 0; tag[0] = '\0'; host[0] = '\0';
+		sscanf(buffer, "GET /%d/%31s", &delay, tag);
+
+		value = strstr(buffer, "\r\nHost: ");
+		if (value) sscanf(value + 8, "%63s", host);
+
+		snprintf(etag, sizeof(etag), "\"%s v1\"", tag);
+		value  = strstr(buffer, "\r\nIf-None-Match: ");
+		cached = value && !strncmp(value + 17, etag, strlen(etag)) && value[17 + strlen(etag)] == '\r';
+
+		hostIndex = Server_Begin(host, tag, newConn);
+		newConn   = false;
+		usleep(delay * 1000);
+
+		if (cached) {
+			len = snprintf(response, sizeof(response), "HTTP/1.1 304 Not Modified\r\nETag: %s\r\n\r\n", etag);
+		} else {
+			len = snprintf(response, sizeof(response), "HTTP/1.1 200 OK\r\nContent-Length: %i\r\n"
+							"Content-Type: text/plain\r\nETag: %s\r\nLast-Modified: " SERVER_LAST_MODIFIED
+							"\r\n\r\n%s", (int)strlen(tag), etag, tag);
+		}
+		if (cached) { pthread_mutex_lock(&server.mutex); server.notModified++; pthread_mutex_unlock(&server.mutex); }
+		Server_End(hostIndex);
+		if (send(fd, response, len, 0) != len) break;
+	}
+	close(fd);
+	return NULL;
+}
+
+static void* Server_Accept(void* arg) {
+	pthread_t thread;
+	int fd;
+
+	for (;;) {
+		fd = accept(server.listenFd, NULL, NULL);
+		if (fd < 0) continue;
+		if (pthread_create(&thread, NULL, Server_Connection, (void*)(size_t)fd)) { close(fd); continue; }
+		pthread_detach(thread);
+	}
+	return NULL;
+}
+
+static cc_bool Server_Start(void) {
+	struct sockaddr_in addr = { 0 };
+	socklen_t addrLen = sizeof(addr);
+	pthread_t thread;
+
+	pthread_mutex_init(&server.mutex, NULL);
+	server.listenFd = socket(AF_INET, SOCK_STREAM, 0);
+	if (server.listenFd < 0) return false;
+
+	/* Listen on every 127.0.0.x address, so they can be used as different hosts */
+	addr.sin_family      = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port        = 0;
+
+	if (bind(server.listenFd, (struct sockaddr*)&addr, sizeof(addr)))          return false;
+	if (listen(server.listenFd, 64))                                          return false;
+	if (getsockname(server.listenFd, (struct sockaddr*)&addr, &addrLen))      return false;
+	server.port = ntohs(addr.sin_port);
+
+	if (pthread_create(&thread, NULL, Server_Accept, NULL)) return false;
+	pthread_detach(thread);
+	return true;
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Bench requests------------------------------------------------------*
+*#########################################################################################################################*/
+struct BenchRequest { int id; char tag[32]; };
+
+static void Bench_Request(struct BenchRequest* r, int host, int delay, const char* tag, cc_uint8 flags) {
+	cc_string url; char urlBuffer[URL_MAX_SIZE];
+	String_InitArray(url, urlBuffer);
+	snprintf(r->tag, sizeof(r->tag), "%s", tag);
+
+	String_Format4(&url, "http://127.0.0.%i:%i/%i/%c", &host, &server.port, &delay, r->tag);
+	r->id = Http_AsyncGetData(&url, flags);
+}
+
+/* Waits for all the requests to finish, and checks each response is the request's tag */
+static cc_bool Bench_Wait(struct BenchRequest* reqs, int count) {
+	struct HttpRequest item;
+	cc_bool success = true;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		while (!Http_GetResult(reqs[i].id, &item)) { Thread_Sleep(1); }
+
+		if (!item.success || item.size != strlen(reqs[i].tag) || memcmp(item.data, reqs[i].tag, item.size)) {
+			fprintf(stderr, "  Request %s failed (result %x, status %i)\n", reqs[i].tag, item.result, item.statusCode);
+			success = false;
+		}
+		HttpRequest_Free(&item);
+	}
+	return success;
+}
+
+static void Bench_WaitStarted(int count) {
+	while (Server_LogCount() < count) { Thread_Sleep(1); }
+}
+
+/* Returns the tags of the requests to the given host, in the order they were started */
+static void Bench_StartOrder(const char* host, char* dst, int capacity) {
+	int i, len = 0;
+	dst[0] = '\0';
+
+	pthread_mutex_lock(&server.mutex);
+	for (i = 0; i < server.logCount; i++) {
+		if (host && strcmp(server.hosts[server.log[i].host], host)) continue;
+		len += snprintf(dst + len, capacity - len, "%s%s", len ? " " : "", server.log[i].tag);
+		if (len >= capacity) break;
+	}
+	pthread_mutex_unlock(&server.mutex);
+}
+
+static const char* Bench_Host(int host) {
+	static char buffer[64];
+	snprintf(buffer, sizeof(buffer), "127.0.0.%i:%i", host, server.port);
+	return buffer;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Scenarios--------------------------------------------------------*
+*#########################################################################################################################*/
+#define HOSTS_REQUESTS 8
+#define HOSTS_DELAY 30
+#define HOSTS_COUNT (3 * HOSTS_REQUESTS)
+/* Requests to several hosts at once should use all the workers, but at most maxPerHost for each host */
+static cc_bool Bench_Hosts(void) {
+	struct BenchRequest reqs[HOSTS_COUNT];
+	cc_bool success;
+	cc_uint64 beg;
+	char tag[32];
+	int i, host, maxActive = 0;
+
+	Server_Reset();
+	beg = Stopwatch_Measure();
+	for (i = 0; i < HOSTS_COUNT; i++) {
+		host = 1 + i % 3;
+		snprintf(tag, sizeof(tag), "h%i_%i", host, i / 3);
+		Bench_Request(&reqs[i], host, HOSTS_DELAY, tag, 0);
+	}
+	success = Bench_Wait(reqs, HOSTS_COUNT);
+
+	for (i = 0; i < server.hostsCount; i++) { maxActive = max(maxActive, server.maxActive[i]); }
+	fprintf(stderr, "Hosts: %i requests of %i ms to 3 hosts took %.2f ms (ideal %i ms)\n",
+			HOSTS_COUNT, HOSTS_DELAY, ElapsedMS(Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure())),
+			HOSTS_COUNT * HOSTS_DELAY / BENCH_WORKERS);
+	fprintf(stderr, "  at most %i active at once, at most %i active to one host (limit %i)\n",
+			server.maxTotalActive, maxActive, maxPerHost);
+
+	if (maxActive > maxPerHost) {
+		fprintf(stderr, "  PER-HOST LIMIT WAS EXCEEDED\n"); success = false;
+	}
+	if (server.maxTotalActive <= maxPerHost) {
+		fprintf(stderr, "  REQUESTS TO OTHER HOSTS WERE NOT PERFORMED AT THE SAME TIME\n"); success = false;
+	}
+	return success;
+}
+
+/* Once every worker is busy, queued requests should be started in priority order */
+static cc_bool Bench_Priorities(void) {
+	static const char* expected = "high1 high2 normal1 normal2 bg1 bg2";
+	struct BenchRequest blockers[BENCH_WORKERS], reqs[6];
+	char order[256], tag[32];
+	cc_bool success;
+	int i;
+
+	Server_Reset();
+	/* Workers become free again one at a time */
+	for (i = 0; i < BENCH_WORKERS; i++) {
+		snprintf(tag, sizeof(tag), "block%i", i);
+		Bench_Request(&blockers[i], 1 + i / BENCH_MAX_PER_HOST, 100 + 40 * i, tag, 0);
+	}
+	Bench_WaitStarted(BENCH_WORKERS);
+
+	Bench_Request(&reqs[0], 4, 0, "bg1",     HTTP_FLAG_BACKGROUND);
+	Bench_Request(&reqs[1], 4, 0, "bg2",     HTTP_FLAG_BACKGROUND);
+	Bench_Request(&reqs[2], 4, 0, "normal1", 0);
+	Bench_Request(&reqs[3], 4, 0, "normal2", 0);
+	Bench_Request(&reqs[4], 4, 0, "high1",   HTTP_FLAG_PRIORITY);
+	Bench_Request(&reqs[5], 4, 0, "high2",   HTTP_FLAG_PRIORITY);
+
+	success  = Bench_Wait(blockers, BENCH_WORKERS);
+	success &= Bench_Wait(reqs, Array_Elems(reqs));
+	Bench_StartOrder(Bench_Host(4), order, sizeof(order));
+	fprintf(stderr, "Priorities: started in order %s\n", order);
+
+	if (strcmp(order, expected)) {
+		fprintf(stderr, "  EXPECTED ORDER %s\n", expected); success = false;
+	}
+	return success;
+}
+
+/* A background request to a host with a free slot is started before a request to a host at its limit */
+/*  (see HTTP_FLAG_BACKGROUND in src/Http.h) */
+static cc_bool Bench_HostLimitOrder(void) {
+	static const char* expected = "slow1 slow2 bg normal";
+	struct BenchRequest slow[BENCH_MAX_PER_HOST], reqs[2];
+	char order[256], tag[32];
+	cc_bool success;
+	int i;
+
+	Server_Reset();
+	for (i = 0; i < BENCH_MAX_PER_HOST; i++) {
+		snprintf(tag, sizeof(tag), "slow%i", i + 1);
+		Bench_Request(&slow[i], 1, 150, tag, 0);
+		Bench_WaitStarted(i + 1);
+	}
+	Bench_Request(&reqs[0], 1, 0, "normal", 0);
+	Bench_Request(&reqs[1], 2, 0, "bg",     HTTP_FLAG_BACKGROUND);
+
+	success  = Bench_Wait(slow, BENCH_MAX_PER_HOST);
+	success &= Bench_Wait(reqs, Array_Elems(reqs));
+	Bench_StartOrder(NULL, order, sizeof(order));
+	fprintf(stderr, "Host limit: started in order %s\n", order);
+
+	if (strcmp(order, expected)) {
+		fprintf(stderr, "  EXPECTED ORDER %s\n", expected); success = false;
+	}
+	return success;
+}
+
+#define SHARE_ROUNDS 5
+/* Returns the number of connections made to the host, when performing several rounds of requests to it */
+static int Bench_Connections(int host, cc_bool* success) {
+	struct BenchRequest reqs[BENCH_WORKERS];
+	char tag[32];
+	int i, round;
+
+	Server_Reset();
+	for (round = 0; round < SHARE_ROUNDS; round++) {
+		for (i = 0; i < BENCH_WORKERS; i++) {
+			snprintf(tag, sizeof(tag), "r%i_%i", round, i);
+			Bench_Request(&reqs[i], host, 10, tag, 0);
+		}
+		*success &= Bench_Wait(reqs, BENCH_WORKERS);
+	}
+	return server.conns[Server_HostIndex(Bench_Host(host))];
+}
+
+static void Bench_SetShare(CURLSH* share) {
+	int i;
+	for (i = 0; i < workersCount; i++) {
+		_curl_easy_setopt(workers[i].backend, CURLOPT_SHARE, share);
+	}
+}
+
+/* Workers should reuse connections that other workers made to the same host */
+static cc_bool Bench_Share(void) {
+	cc_bool success = true;
+	int shared, unshared;
+
+	if (!curlShare) {
+		fprintf(stderr, "Share: curl does not support share handles, skipped\n"); return true;
+	}
+	shared = Bench_Connections(5, &success);
+
+	/* Compare against each worker only reusing its own connections */
+	Bench_SetShare(NULL);
+	unshared = Bench_Connections(6, &success);
+	Bench_SetShare(curlShare);
+
+	fprintf(stderr, "Share: %i requests made %i connections (%i without share handle)\n",
+			SHARE_ROUNDS * BENCH_WORKERS, shared, unshared);
+	if (shared > maxPerHost) {
+		fprintf(stderr, "  CONNECTIONS WERE NOT REUSED BETWEEN WORKERS\n"); success = false;
+	}
+	return success;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Asset cache-------------------------------------------------------*
+*#########################################################################################################################*/
+static void Bench_DeleteFile(const cc_string* path, void* obj) { (void)File_Delete(path); }
+
+static void Bench_CountTemp(const cc_string* path, void* obj) {
+	static const cc_string tmp = String_FromConst(".tmp");
+	if (String_CaselessEnds(path, &tmp)) (*(int*)obj)++;
+}
+
+static void Bench_CacheUrl(cc_string* url, const char* tag) {
+	int host = 7, delay = 0;
+	String_Format4(url, "http://127.0.0.%i:%i/%i/%c", &host, &server.port, &delay, tag);
+}
+
+/* Returns the index of the cache entry for the request with the given tag, or -1 if not cached */
+static int Bench_CacheFind(const char* tag) {
+	cc_string url; char urlBuffer[URL_MAX_SIZE];
+	int i;
+	String_InitArray(url, urlBuffer);
+	Bench_CacheUrl(&url, tag);
+
+	Mutex_Lock(assetMutex);
+	i = AssetCache_Find(&url);
+	Mutex_Unlock(assetMutex);
+	return i;
+}
+
+static cc_bool Bench_CacheFileExists(const char* tag) {
+	cc_string url;  char urlBuffer[URL_MAX_SIZE];
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	String_InitArray(url,  urlBuffer);
+	String_InitArray(path, pathBuffer);
+
+	Bench_CacheUrl(&url, tag);
+	AssetCache_MakePath(&path, AssetCache_Hash(&url));
+	return File_Exists(&path);
+}
+
+/* Performs a cached request, and checks the response is the tag (even if it was a 304 response) */
+static cc_bool Bench_CacheRequest(const char* tag, int expectedStatus) {
+	cc_string url; char urlBuffer[URL_MAX_SIZE];
+	struct BenchRequest req;
+	struct HttpRequest item;
+	cc_bool success;
+	String_InitArray(url, urlBuffer);
+
+	Bench_CacheUrl(&url, tag);
+	snprintf(req.tag, sizeof(req.tag), "%s", tag);
+	req.id = Http_AsyncGetData(&url, HTTP_FLAG_CACHE);
+	while (!Http_GetResult(req.id, &item)) { Thread_Sleep(1); }
+
+	success = item.success && item.statusCode == expectedStatus
+		&& item.size == strlen(tag) && !memcmp(item.data, tag, item.size);
+	if (!success) {
+		fprintf(stderr, "  Cached request %s failed (result %x, status %i, expected %i)\n",
+				tag, item.result, item.statusCode, expectedStatus);
+	}
+	HttpRequest_Free(&item);
+	return success;
+}
+
+/* The index should be saved and loaded again exactly, and cached responses revalidated with 304 responses */
+static cc_bool Bench_CacheRevalidate(void) {
+	struct AssetCacheEntry saved;
+	cc_bool success;
+	int i, temps = 0;
+
+	Server_Reset();
+	success = Bench_CacheRequest("revalidate", 200);
+	if ((i = Bench_CacheFind("revalidate")) == -1) {
+		fprintf(stderr, "  RESPONSE WAS NOT CACHED\n"); return false;
+	}
+	saved = assetEntries[i];
+
+	/* Load the index again from disc */
+	assetDirty = true;
+	AssetCache_SaveIndex();
+	assetCount = 0; assetTotalSize = 0;
+	AssetCache_LoadIndex();
+
+	if ((i = Bench_CacheFind("revalidate")) == -1 || memcmp(&saved, &assetEntries[i], sizeof(saved))) {
+		fprintf(stderr, "  INDEX ENTRY WAS NOT LOADED AGAIN EXACTLY\n"); success = false;
+	}
+	fprintf(stderr, "Cache: index entry has ETag %s and Last-Modified %s\n", saved.etag, saved.lastModified);
+	if (strcmp(saved.etag, "\"revalidate v1\"") || strcmp(saved.lastModified, SERVER_LAST_MODIFIED)) {
+		fprintf(stderr, "  ETAG OR LAST-MODIFIED WAS NOT STORED\n"); success = false;
+	}
+
+	success &= Bench_CacheRequest("revalidate", 304);
+	fprintf(stderr, "  %i requests revalidated with 304\n", server.notModified);
+	if (server.notModified != 1) {
+		fprintf(stderr, "  CACHED RESPONSE WAS NOT REVALIDATED\n"); success = false;
+	}
+
+	Directory_Enum(&assetDir, &temps, Bench_CountTemp);
+	if (temps) {
+		fprintf(stderr, "  %i TEMP FILES WERE LEFT BEHIND\n", temps); success = false;
+	}
+	return success;
+}
+
+static void Bench_CacheSetLastUsed(const char* tag, cc_uint32 lastUsed) {
+	int i = Bench_CacheFind(tag);
+	if (i >= 0) assetEntries[i].lastUsed = lastUsed;
+}
+
+/* Writes a response cached by older versions, which kept ETags and Last-Modified in separate lists */
+static void Bench_CacheWriteLegacy(const char* tag) {
+	static const cc_string etags   = String_FromConst(LEGACY_ETAGS_TXT);
+	static const cc_string lastMod = String_FromConst(LEGACY_LASTMOD_TXT);
+	cc_string url;  char urlBuffer[URL_MAX_SIZE];
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string line; char lineBuffer[STRING_SIZE];
+	cc_uint32 hash;
+	String_InitArray(url,  urlBuffer);
+	String_InitArray(path, pathBuffer);
+
+	Bench_CacheUrl(&url, tag);
+	hash = AssetCache_Hash(&url);
+	AssetCache_MakePath(&path, hash);
+	Stream_WriteAllTo(&path, (const cc_uint8*)tag, String_Length(tag));
+
+	String_InitArray(line, lineBuffer);
+	String_AppendUInt32(&line, hash);
+	String_Format1(&line, " \"%c v1\"" _NL, tag);
+	Stream_WriteAllTo(&etags, (const cc_uint8*)line.buffer, line.length);
+	/* Old format of C# DateTime ticks, which should be ignored */
+	String_InitArray(line, lineBuffer);
+	String_AppendUInt32(&line, hash);
+	String_AppendConst(&line, " 635000000000000000" _NL);
+	Stream_WriteAllTo(&lastMod, (const cc_uint8*)line.buffer, line.length);
+}
+
+/* Responses cached by older versions should be imported into the index, then revalidated */
+static cc_bool Bench_CacheLegacy(void) {
+	static const cc_string etags = String_FromConst(LEGACY_ETAGS_TXT);
+	cc_bool success = true;
+	int i;
+
+	Server_Reset();
+	if ((i = Bench_CacheFind("legacy")) == -1) {
+		fprintf(stderr, "  LEGACY RESPONSE WAS NOT IMPORTED\n"); return false;
+	}
+	fprintf(stderr, "Cache legacy: imported entry has ETag %s and Last-Modified '%s'\n",
+			assetEntries[i].etag, assetEntries[i].lastModified);
+	if (strcmp(assetEntries[i].etag, "\"legacy v1\"") || assetEntries[i].lastModified[0]) {
+		fprintf(stderr, "  ETAG OR LAST-MODIFIED WAS NOT IMPORTED CORRECTLY\n"); success = false;
+	}
+	if (File_Exists(&etags)) {
+		fprintf(stderr, "  LEGACY LISTS WERE NOT DELETED\n"); success = false;
+	}
+
+	success &= Bench_CacheRequest("legacy", 304);
+	if (server.notModified != 1) {
+		fprintf(stderr, "  LEGACY RESPONSE WAS NOT REVALIDATED\n"); success = false;
+	}
+	return success;
+}
+
+/* Only the least recently used responses should be deleted once the cache is full */
+static cc_bool Bench_CacheEvict(void) {
+	static const char* tags[]     = { "evict0", "evict1", "evict2", "evict3", "evict4", "evict5" };
+	static const cc_bool kept[]   = { false,    false,    true,     false,    true,     true     };
+	cc_uint64 oldMaxSize = assetMaxSize;
+	cc_bool success = true, cached;
+	int i;
+
+	Server_Reset();
+	Mutex_Lock(assetMutex);
+	{
+		/* Start with an empty cache, that only 3 responses fit in */
+		assetMaxSize = 0;
+		AssetCache_Evict(0);
+		assetMaxSize = 3 * 6;
+	}
+	Mutex_Unlock(assetMutex);
+
+	for (i = 0; i < 5; i++) {
+		success &= Bench_CacheRequest(tags[i], 200);
+		Bench_CacheSetLastUsed(tags[i], i + 1);
+	}
+	/* Using evict2 again should mean evict3 is the least recently used instead */
+	success &= Bench_CacheRequest(tags[2], 304);
+	success &= Bench_CacheRequest(tags[5], 200);
+
+	fprintf(stderr, "Cache evict: cached");
+	for (i = 0; i < Array_Elems(tags); i++) {
+		cached = Bench_CacheFind(tags[i]) >= 0;
+		if (cached) fprintf(stderr, " %s", tags[i]);
+
+		if (cached != kept[i] || Bench_CacheFileExists(tags[i]) != kept[i]) {
+			fprintf(stderr, "\n  %s SHOULD %sHAVE BEEN EVICTED", tags[i], kept[i] ? "NOT " : ""); success = false;
+		}
+	}
+	fprintf(stderr, "\n");
+
+	assetMaxSize = oldMaxSize;
+	return success;
+}
+
+int main(int argc, char** argv) {
+	cc_bool success = true;
+	Logger_Hook();
+	Platform_Init();
+
+	if (!Server_Start()) { fprintf(stderr, "Failed to start stand-in server\n"); return 1; }
+	Directory_Enum(&assetDir, NULL, Bench_DeleteFile);
+	Bench_CacheWriteLegacy("legacy");
+	Options_SetInt(OPT_HTTP_WORKERS,      BENCH_WORKERS);
+	Options_SetInt(OPT_HTTP_MAX_PER_HOST, BENCH_MAX_PER_HOST);
+	Http_Component.Init();
+	if (!curlSupported) { fprintf(stderr, "Failed to load libcurl\n"); return 1; }
+
+	success &= Bench_Hosts();
+	success &= Bench_Priorities();
+	success &= Bench_HostLimitOrder();
+	success &= Bench_Share();
+	success &= Bench_CacheLegacy();
+	success &= Bench_CacheRevalidate();
+	success &= Bench_CacheEvict();
+	return success ? 0 : 1;
+}
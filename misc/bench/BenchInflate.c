@@ -0,0 +1,144 @@
+/* Headless benchmark of how quickly GZIP compressed data is decompressed (see Inflate in src/Deflate.c) */
+/* Usage: BenchInflate [iterations] [gzip files...] */
+/* If no files are given, maps/bench-level.gz is used instead (which is generated with a fixed seed if missing) */
+/* NOTE: Any GZIP file can be used, e.g. .cw/.lvl maps or level data streams captured from a server */
+#include "../../src/Deflate.h"
+#include "../../src/Funcs.h"
+#include "../../src/Generator.h"
+#include "../../src/Platform.h"
+#include "../../src/Logger.h"
+#include "../../src/Stream.h"
+#include "../../src/String.h"
+#include "../../src/Utils.h"
+#include "../../src/World.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+struct BenchFile {
+	cc_uint8* data;   cc_uint32 size;
+	cc_uint8* output; cc_uint32 outputSize, capacity;
+};
+static struct InflateState state;
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+/* Decompresses the whole file into its output buffer, growing the output buffer if necessary */
+static cc_result Decompress(struct BenchFile* f) {
+	struct Stream mem, compStream;
+	struct GZipHeader gzHeader;
+	cc_uint32 read, total = 0;
+	cc_result res;
+
+	Stream_ReadonlyMemory(&mem, f->data, f->size);
+	GZipHeader_Init(&gzHeader);
+	while (!gzHeader.done) {
+		if ((res = GZipHeader_Read(&mem, &gzHeader))) return res;
+	}
+	Inflate_MakeStream2(&compStream, &state, &mem);
+
+	for (;;) {
+		if (total == f->capacity) {
+			f->capacity = f->capacity ? f->capacity * 2 : 1024 * 1024;
+			f->output   = (cc_uint8*)Mem_Realloc(f->output, f->capacity, 1, "bench output");
+		}
+
+		res = compStream.Read(&compStream, f->output + total, f->capacity - total, &read);
+		if (res)   return res;
+		if (!read) break;
+		total += read;
+	}
+	f->outputSize = total;
+	return 0;
+}
+
+static cc_result LoadFile(const cc_string* path, struct BenchFile* f) {
+	struct Stream stream;
+	cc_result res;
+	if ((res = Stream_OpenFile(&stream, path))) return res;
+
+	if (!(res = stream.Length(&stream, &f->size))) {
+		f->data = (cc_uint8*)Mem_Alloc(f->size, 1, "bench input");
+		res     = Stream_Read(&stream, f->data, f->size);
+	}
+	(void)stream.Close(&stream);
+	return res;
+}
+
+static void RunInflate(const char* name, struct BenchFile* f, int iterations) {
+	cc_uint64 beg, end, total = 0;
+	cc_result res;
+	int i;
+
+	/* Decompress once first, so that the output buffer is already big enough */
+	if ((res = Decompress(f))) { printf("Failed to decompress %s (error %x)\n", name, res); return; }
+	printf("%s: %u -> %u bytes (CRC32 %08x)\n", name, f->size, f->outputSize,
+											Utils_CRC32(f->output, f->outputSize));
+
+	for (i = 0; i < iterations; i++) {
+		beg = Stopwatch_Measure();
+		Decompress(f);
+		end = Stopwatch_Measure();
+		total += Stopwatch_ElapsedMicroseconds(beg, end);
+	}
+	printf("  %i iterations in %.2f ms (%.1f MB/s output)\n", iterations, ElapsedMS(total),
+											(double)f->outputSize * iterations / total);
+}
+
+/* Generates the same data that a server sends when joining, i.e. GZIP compressed volume then blocks */
+static cc_result GenerateLevel(const cc_string* path) {
+	struct Stream stream, compStream;
+	struct GZipState gzState;
+	cc_uint8 volume[4];
+	cc_result res;
+	World_SetDimensions(256, 64, 256);
+
+	Gen_Seed    = 1234;
+	Gen_Vanilla = true;
+	Gen_Blocks  = (BlockRaw*)Mem_Alloc(World.Volume, 1, "bench map blocks");
+	NotchyGen_Generate();
+	Stream_SetU32_BE(volume, World.Volume);
+
+	Utils_EnsureDirectory("maps");
+	if ((res = Stream_CreateFile(&stream, path))) return res;
+	GZip_MakeStream(&compStream, &gzState, &stream);
+
+	if (!(res = Stream_Write(&compStream, volume, 4))
+		&& !(res = Stream_Write(&compStream, Gen_Blocks, World.Volume))) {
+		res = compStream.Close(&compStream);
+	}
+	(void)stream.Close(&stream);
+	Mem_Free(Gen_Blocks);
+	Gen_Blocks = NULL;
+	return res;
+}
+
+int main(int argc, char** argv) {
+	static const cc_string defPath = String_FromConst("maps/bench-level.gz");
+	struct BenchFile file = { 0 };
+	cc_string path;
+	int i, iterations;
+	cc_result res;
+
+	Logger_Hook();
+	Platform_Init();
+	iterations = argc > 1 ? atoi(argv[1]) : 20;
+	iterations = max(1, iterations);
+
+	if (argc <= 2 && !File_Exists(&defPath) && (res = GenerateLevel(&defPath))) {
+		printf("Failed to generate %.*s (error %x)\n", defPath.length, defPath.buffer, res); return 1;
+	}
+
+	for (i = 2; i < max(argc, 3); i++) {
+		path = argc > 2 ? String_FromReadonly(argv[i]) : defPath;
+		if ((res = LoadFile(&path, &file))) {
+			printf("Failed to load %.*s (error %x)\n", path.length, path.buffer, res); continue;
+		}
+
+		RunInflate(argc > 2 ? argv[i] : "maps/bench-level.gz", &file, iterations);
+		Mem_Free(file.data);
+		file.data = NULL;
+	}
+
+	Mem_Free(file.output);
+	return 0;
+}
@@ -0,0 +1,161 @@
+/* Headless benchmark that replays recorded level data packets (see Classic_LevelDataChunk in src/Protocol.c) */
+/* Usage: BenchLevelData [recording] */
+/* A recording is the raw packets a server sends for a map, i.e. a LevelInit packet, then */
+/*  LevelDataChunk packets, then a LevelFinalise packet (other packets are not supported) */
+/* If no recording is given, maps/bench-level.dat is generated from a map with a fixed seed and then replayed */
+/* NOTE: Protocol.c is included directly, so that the packet handlers can be called */
+#include "../../src/Protocol.c"
+#include "../../src/Generator.h"
+#include "../../src/Camera.h"
+#include <stdio.h>
+
+static struct Stream* recording;
+static cc_uint8 packet[1028];
+static int packetLen;
+static cc_uint32 expectedCRC;
+
+/* Writes the pending map data as a LevelDataChunk packet */
+static cc_result FlushPacket(void) {
+	if (!packetLen) return 0;
+	packet[0] = OPCODE_LEVEL_DATA;
+	Stream_SetU16_BE(&packet[1], packetLen);
+	Mem_Set(&packet[3 + packetLen], 0, 1025 - packetLen);
+
+	packetLen = 0;
+	return Stream_Write(recording, packet, sizeof(packet));
+}
+
+static cc_result PacketStream_Write(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	cc_uint32 len = min(count, 1024 - packetLen);
+	Mem_Copy(&packet[3 + packetLen], data, len);
+	packetLen += len;
+	*modified  = len;
+
+	return packetLen == 1024 ? FlushPacket() : 0;
+}
+
+/* Records the packets that a server sends for a map, with map data in the same format as the original classic server */
+static cc_result GenerateRecording(const cc_string* path) {
+	struct Stream stream, packets, compStream;
+	struct GZipState gzState;
+	cc_uint8 tmp[7];
+	cc_result res;
+	World_SetDimensions(256, 64, 256);
+
+	Gen_Seed    = 1234;
+	Gen_Vanilla = true;
+	Gen_Blocks  = (BlockRaw*)Mem_Alloc(World.Volume, 1, "bench map blocks");
+	NotchyGen_Generate();
+	expectedCRC = Utils_CRC32(Gen_Blocks, World.Volume);
+
+	Utils_EnsureDirectory("maps");
+	if ((res = Stream_CreateFile(&stream, path))) return res;
+	recording = &stream;
+	tmp[0]    = OPCODE_LEVEL_BEGIN;
+	if ((res = Stream_Write(&stream, tmp, 1))) goto finished;
+
+	Stream_Init(&packets);
+	packets.Write = PacketStream_Write;
+	GZip_MakeStream(&compStream, &gzState, &packets);
+	Stream_SetU32_BE(tmp, World.Volume);
+
+	if ((res = Stream_Write(&compStream, tmp, 4)))                    goto finished;
+	if ((res = Stream_Write(&compStream, Gen_Blocks, World.Volume))) goto finished;
+	if ((res = compStream.Close(&compStream)))                       goto finished;
+	if ((res = FlushPacket()))                                       goto finished;
+
+	tmp[0] = OPCODE_LEVEL_END;
+	Stream_SetU16_BE(&tmp[1], World.Width);
+	Stream_SetU16_BE(&tmp[3], World.Height);
+	Stream_SetU16_BE(&tmp[5], World.Length);
+	res = Stream_Write(&stream, tmp, 7);
+
+finished:
+	(void)stream.Close(&stream);
+	Mem_Free(Gen_Blocks);
+	Gen_Blocks = NULL;
+	return res;
+}
+
+static cc_result LoadRecording(const cc_string* path, cc_uint8** data, cc_uint32* size) {
+	struct Stream stream;
+	cc_result res;
+	if ((res = Stream_OpenFile(&stream, path))) return res;
+
+	if (!(res = stream.Length(&stream, size))) {
+		*data = (cc_uint8*)Mem_Alloc(*size, 1, "level data recording");
+		res   = Stream_Read(&stream, *data, *size);
+	}
+	(void)stream.Close(&stream);
+	return res;
+}
+
+static void Replay(cc_uint8* data, cc_uint32 size) {
+	cc_uint64 beg, end, chunksTime = 0, finaliseTime = 0;
+	cc_uint64 start = Stopwatch_Measure();
+	cc_uint32 i, crc;
+	int chunks = 0;
+
+	/* Time spent in LevelDataChunk is time that the network tick can't read from the socket */
+	for (i = 0; i < size; ) {
+		beg = Stopwatch_Measure();
+		switch (data[i]) {
+		case OPCODE_LEVEL_BEGIN:
+			Classic_LevelInit(&data[i + 1]); i += 1; break;
+		case OPCODE_LEVEL_DATA:
+			if (i + 1028 > size) { i = size; break; }
+			Classic_LevelDataChunk(&data[i + 1]);
+			chunksTime += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+			i += 1028; chunks++; break;
+		case OPCODE_LEVEL_END:
+			if (i + 7 > size) { i = size; break; }
+			Classic_LevelFinalise(&data[i + 1]);
+			finaliseTime = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+			i += 7; break;
+		default:
+			printf("Unsupported packet %i at offset %u\n", data[i], i); return;
+		}
+	}
+	end = Stopwatch_Measure();
+
+	if (!World.Blocks) { printf("Map failed to load\n"); return; }
+	crc = Utils_CRC32(World.Blocks, World.Volume);
+	printf("Map: %i x %i x %i from %i LevelDataChunk packets (CRC32 %08x)\n", World.Width, World.Height,
+											World.Length, chunks, crc);
+	if (expectedCRC) printf("  %s\n", crc == expectedCRC ? "Matches generated map" : "DOES NOT MATCH GENERATED MAP");
+
+	printf("  Total: %.2f ms, in LevelDataChunk: %.2f ms, in LevelFinalise: %.2f ms\n",
+		Stopwatch_ElapsedMicroseconds(start, end) / 1000.0f, chunksTime / 1000.0f, finaliseTime / 1000.0f);
+}
+
+int main(int argc, char** argv) {
+	static const cc_string defPath = String_FromConst("maps/bench-level.dat");
+	cc_string path = defPath;
+	cc_uint8* data;
+	cc_uint32 size;
+	cc_result res;
+
+	Logger_Hook();
+	Platform_Init();
+	/* Only the components needed to load a map (the loading screen is also shown) */
+	Game_AddComponent(&World_Component);
+	Game_AddComponent(&Camera_Component);
+	World_Component.Init();
+	Camera_Component.Init();
+	Classic_Reset();
+
+	if (argc > 1) {
+		path = String_FromReadonly(argv[1]);
+	} else if ((res = GenerateRecording(&path))) {
+		printf("Failed to generate %.*s (error %x)\n", path.length, path.buffer, res); return 1;
+	}
+
+	if ((res = LoadRecording(&path, &data, &size))) {
+		printf("Failed to load %.*s (error %x)\n", path.length, path.buffer, res); return 1;
+	}
+	Replay(data, size);
+
+	Mem_Free(data);
+	OnFree();
+	return 0;
+}
@@ -0,0 +1,216 @@
+/* Headless benchmark of how quickly sounds are mixed together (see Mixer_Render in src/Audio.c) */
+/* Usage: BenchMixer [iterations] [wav files...] */
+/* Sounds are played at random rates and volumes as if blocks were being rapidly broken, then the mixed */
+/*  output is written to bench-mixer.wav and checked to be exactly the same as a simple reference mixer */
+/* If no files are given, mono and stereo sounds with various sample rates are generated instead */
+/* NOTE: Audio.c is included directly, so that the mixer can be run without an audio backend */
+#include "../../src/Audio.c"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_SECONDS 10
+#define BENCH_FRAMES  (MIXER_SAMPLE_RATE * BENCH_SECONDS)
+/* A new sound every 25 ms, so usually around 20 to 40 sounds are playing at once */
+#define BENCH_INTERVAL (MIXER_SAMPLE_RATE / 40)
+#define BENCH_EVENTS   (BENCH_FRAMES / BENCH_INTERVAL)
+#define BENCH_MAX_SOUNDS 16
+
+struct BenchEvent { int frame; struct AudioData data; };
+static struct BenchEvent events[BENCH_EVENTS];
+static struct Sound sounds[BENCH_MAX_SOUNDS];
+static int soundsCount;
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+/* Noise that fades out, which is roughly what dig and step sounds are like */
+static void MakeSound(int channels, int sampleRate, int frames, int seed) {
+	struct Sound* snd = &sounds[soundsCount++];
+	cc_int16* data;
+	RNGState rnd;
+	int i, decay;
+
+	data = (cc_int16*)Mem_Alloc(frames * channels, 2, "bench sound");
+	Random_Seed(&rnd, seed);
+
+	for (i = 0; i < frames * channels; i++) {
+		decay   = 32767 - (int)((cc_uint64)i * 32767 / (frames * channels));
+		data[i] = (cc_int16)((Random_Next(&rnd, 65536) - 32768) * decay / 32768);
+	}
+	snd->channels   = channels;
+	snd->sampleRate = sampleRate;
+	snd->data       = data;
+	snd->size       = frames * channels * 2;
+}
+
+static void MakeEvents(void) {
+	static const int rates[] = { 80, 100, 120, 140 };
+	struct AudioData* data;
+	struct Sound* snd;
+	RNGState rnd;
+	int i;
+	Random_Seed(&rnd, 1234);
+
+	for (i = 0; i < BENCH_EVENTS; i++) {
+		snd  = &sounds[Random_Next(&rnd, soundsCount)];
+		data = &events[i].data;
+		events[i].frame = i * BENCH_INTERVAL;
+
+		data->data       = snd->data;
+		data->size       = snd->size;
+		data->channels   = snd->channels;
+		data->sampleRate = snd->sampleRate;
+		data->rate       = rates[Random_Next(&rnd, Array_Elems(rates))];
+		data->volume     = Random_Range(&rnd, 20, 101);
+	}
+}
+
+/* Plays the sounds in the same way as the mixer thread, i.e. new sounds start at the next buffer */
+static int RenderMixer(cc_int16* output) {
+	int frame, i = 0, maxVoices = 0;
+
+	for (frame = 0; frame < BENCH_FRAMES; frame += MIXER_BUFFER_FRAMES) {
+		for (; i < BENCH_EVENTS && events[i].frame <= frame; i++) {
+			Mixer_Play(&events[i].data);
+		}
+		maxVoices = max(maxVoices, mixer_voicesCount);
+
+		Mutex_Lock(mixer_mutex);
+		Mixer_Render(&output[frame * 2], min(MIXER_BUFFER_FRAMES, BENCH_FRAMES - frame));
+		Mutex_Unlock(mixer_mutex);
+	}
+	return maxVoices;
+}
+
+/* Mixes each sound by itself and one frame at a time, using the same fixed point maths as the mixer */
+static void RenderReference(cc_int16* output) {
+	cc_int32* accum = (cc_int32*)Mem_AllocCleared(BENCH_FRAMES * 2, 4, "bench accumulator");
+	const cc_int16* src;
+	struct AudioData* data;
+	int i, frame, c, s, channels, frames, volume, w0, w1;
+	cc_uint64 pos, step;
+
+	for (i = 0; i < BENCH_EVENTS; i++) {
+		data     = &events[i].data;
+		src      = (const cc_int16*)data->data;
+		channels = data->channels;
+		frames   = data->size / (2 * channels);
+		volume   = data->volume * 32767 / 100;
+		step     = ((cc_uint64)data->sampleRate * data->rate << 16) / (100 * MIXER_SAMPLE_RATE);
+		frame    = (events[i].frame + MIXER_BUFFER_FRAMES - 1) / MIXER_BUFFER_FRAMES * MIXER_BUFFER_FRAMES;
+
+		for (pos = 0; frame < BENCH_FRAMES && (pos >> 16) < (cc_uint64)(frames - 1); frame++, pos += step) {
+			s  = (int)(pos >> 16) * channels;
+			w1 = (int)((pos & 0xFFFF) >> 1) * volume >> 15;
+			w0 = volume - w1;
+
+			for (c = 0; c < 2; c++) {
+				accum[frame * 2 + c] += (src[s] * w0 + src[s + channels] * w1) >> 15;
+				if (channels == 2) s++;
+			}
+		}
+	}
+
+	for (i = 0; i < BENCH_FRAMES * 2; i++) {
+		Math_Clamp(accum[i], -32768, 32767);
+		output[i] = accum[i];
+	}
+	Mem_Free(accum);
+}
+
+static cc_result WriteWave(const cc_string* path, const cc_int16* samples) {
+	cc_uint32 dataSize = BENCH_FRAMES * 4;
+	cc_uint8* data = (cc_uint8*)Mem_Alloc(44 + dataSize, 1, "bench wav");
+	struct Stream stream;
+	cc_result res;
+	int i;
+
+	Stream_SetU32_BE(&data[0],  WAV_FourCC('R','I','F','F'));
+	Stream_SetU32_LE(&data[4],  36 + dataSize);
+	Stream_SetU32_BE(&data[8],  WAV_FourCC('W','A','V','E'));
+	Stream_SetU32_BE(&data[12], WAV_FourCC('f','m','t',' '));
+	Stream_SetU32_LE(&data[16], WAV_FMT_SIZE);
+	Stream_SetU16_LE(&data[20], 1); /* PCM */
+	Stream_SetU16_LE(&data[22], 2);
+	Stream_SetU32_LE(&data[24], MIXER_SAMPLE_RATE);
+	Stream_SetU32_LE(&data[28], MIXER_SAMPLE_RATE * 4);
+	Stream_SetU16_LE(&data[32], 4);
+	Stream_SetU16_LE(&data[34], 16);
+	Stream_SetU32_BE(&data[36], WAV_FourCC('d','a','t','a'));
+	Stream_SetU32_LE(&data[40], dataSize);
+
+	for (i = 0; i < BENCH_FRAMES * 2; i++) {
+		Stream_SetU16_LE(&data[44 + i * 2], (cc_uint16)samples[i]);
+	}
+
+	if (!(res = Stream_CreateFile(&stream, path))) {
+		res = Stream_Write(&stream, data, 44 + dataSize);
+		(void)stream.Close(&stream);
+	}
+	Mem_Free(data);
+	return res;
+}
+
+static void RunMixer(int iterations) {
+	static const cc_string path = String_FromConst("bench-mixer.wav");
+	cc_int16* output   = (cc_int16*)Mem_Alloc(BENCH_FRAMES * 2, 2, "bench output");
+	cc_int16* expected = (cc_int16*)Mem_Alloc(BENCH_FRAMES * 2, 2, "bench output");
+	cc_uint64 beg, end, total = 0;
+	int i, maxVoices;
+	cc_result res;
+
+	maxVoices = RenderMixer(output);
+	RenderReference(expected);
+	printf("%i sounds over %i seconds, up to %i playing at once (CRC32 %08x)\n", BENCH_EVENTS, BENCH_SECONDS,
+											maxVoices, Utils_CRC32((cc_uint8*)output, BENCH_FRAMES * 4));
+	printf("  %s\n", Mem_Equal(output, expected, BENCH_FRAMES * 4) ? "Matches reference mixer"
+											: "DOES NOT MATCH REFERENCE MIXER");
+
+	if ((res = WriteWave(&path, output))) {
+		printf("  Failed to write %s (error %x)\n", path.buffer, res);
+	} else {
+		printf("  Mixed output written to %s\n", path.buffer);
+	}
+
+	for (i = 0; i < iterations; i++) {
+		beg = Stopwatch_Measure();
+		RenderMixer(output);
+		end = Stopwatch_Measure();
+		total += Stopwatch_ElapsedMicroseconds(beg, end);
+	}
+	printf("  Mixer_Render: %i iterations in %.2f ms (%.0fx realtime)\n", iterations, ElapsedMS(total),
+											(double)BENCH_SECONDS * iterations * 1000000 / total);
+	Mem_Free(output);
+	Mem_Free(expected);
+}
+
+int main(int argc, char** argv) {
+	cc_string path;
+	int i, iterations;
+	cc_result res;
+
+	Logger_Hook();
+	Platform_Init();
+	mixer_mutex = Mutex_Create();
+	iterations  = argc > 1 ? atoi(argv[1]) : 20;
+	iterations  = max(1, iterations);
+
+	for (i = 2; i < argc && soundsCount < BENCH_MAX_SOUNDS; i++) {
+		path = String_FromReadonly(argv[i]);
+		if ((res = Sound_ReadWave(&path, &sounds[soundsCount]))) {
+			printf("Failed to load %s (error %x)\n", argv[i], res); continue;
+		}
+		soundsCount++;
+	}
+
+	if (argc <= 2) {
+		MakeSound(1, 44100, 20000, 1);
+		MakeSound(1, 44100, 12000, 2);
+		MakeSound(1, 22050, 8000,  3);
+		MakeSound(2, 48000, 16000, 4);
+	}
+	if (!soundsCount) { printf("No sounds to mix\n"); return 1; }
+
+	MakeEvents();
+	RunMixer(iterations);
+	return 0;
+}
@@ -0,0 +1,196 @@
+/* Headless test of how well decoding music ahead of time hides a slow source (see Music_DecodeLoop in src/Audio.c) */
+/* Usage: BenchMusic [speedup] [ogg file] */
+/* The file is read through a stream that regularly stalls for 2.5 seconds as if the disc was very slow, */
+/*  while playback takes a chunk of decoded samples whenever one of the audio buffers would be free */
+/* This is repeated for various decode-ahead buffer sizes, to show how large the buffer needs to be */
+/* Everything is simulated [speedup] times faster than real time (default 8), so the test finishes sooner */
+/* The played samples are also checked to be exactly the same as when decoding straight from memory */
+/* If no file is given, music.ogg in the bench folder is used instead (20 seconds of generated stereo music) */
+/* NOTE: Audio.c is included directly, so that music can be decoded and played without an audio backend */
+#include "../../src/Audio.c"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Roughly 6 seconds of music is read between each stall */
+#define BENCH_STALL_SECS 6
+#define BENCH_STALL_MS   2500
+/* Relative to the src folder, which the bench is built and run from */
+#define BENCH_MUSIC_OGG  "../misc/bench/music.ogg"
+
+static struct Stream memStream;
+static cc_uint32 stallBytes, bytesSinceStall;
+static int speedup, stalls;
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+static cc_result SlowStream_Read(struct Stream* s, cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	cc_result res;
+	if (bytesSinceStall >= stallBytes) {
+		Thread_Sleep(BENCH_STALL_MS / speedup);
+		bytesSinceStall = 0;
+		stalls++;
+	}
+
+	res = memStream.Read(&memStream, data, count, modified);
+	bytesSinceStall += *modified;
+	return res;
+}
+
+static void SlowStream_Open(struct Stream* s, cc_uint8* data, cc_uint32 size) {
+	Stream_ReadonlyMemory(&memStream, data, size);
+	Stream_Init(s);
+	s->Read = SlowStream_Read;
+	bytesSinceStall = 0;
+	stalls = 0;
+}
+
+static cc_result LoadFile(const cc_string* path, cc_uint8** data, cc_uint32* size) {
+	struct Stream stream;
+	cc_result res;
+	if ((res = Stream_OpenFile(&stream, path))) return res;
+
+	if (!(res = stream.Length(&stream, size))) {
+		*data = (cc_uint8*)Mem_Alloc(*size, 1, "bench input");
+		res   = Stream_Read(&stream, *data, *size);
+	}
+	(void)stream.Close(&stream);
+	return res;
+}
+
+/* Decodes the whole file straight from memory, in the same way as BenchVorbis */
+static cc_result DecodeReference(cc_uint8* data, cc_uint32 size, cc_int16** output, int* count, int* perSecond) {
+	static struct OggState ogg;
+	static struct VorbisState vorbis;
+	struct Stream mem;
+	int capacity = 0, maxFrame;
+	cc_result res;
+
+	Stream_ReadonlyMemory(&mem, data, size);
+	Ogg_Init(&ogg, &mem);
+	Mem_Set(&vorbis, 0, sizeof(vorbis));
+	vorbis.source = &ogg;
+	*output = NULL;
+	*count  = 0;
+
+	if ((res = Vorbis_DecodeHeaders(&vorbis))) goto finished;
+	maxFrame   = vorbis.blockSizes[1] * vorbis.channels;
+	*perSecond = vorbis.sampleRate * vorbis.channels;
+
+	for (;;) {
+		if (*count + maxFrame > capacity) {
+			capacity = max(capacity * 2, *count + maxFrame);
+			*output  = (cc_int16*)Mem_Realloc(*output, capacity, 2, "bench output");
+		}
+
+		if ((res = Vorbis_DecodeFrame(&vorbis))) break;
+		*count += Vorbis_OutputFrame(&vorbis, *output + *count);
+	}
+	if (res == ERR_END_OF_STREAM) res = 0;
+
+finished:
+	Vorbis_Free(&vorbis);
+	return res;
+}
+
+/* Plays the music in the same way as Music_PlayBuffer, except that the audio backend is simulated */
+/*  by keeping track of when the audio buffers that have been queued so far will finish playing */
+/* Returns whether the played samples are exactly the same as the expected samples */
+static cc_bool SimulatePlayback(cc_uint8* data, cc_uint32 size, int bufferSecs, const cc_int16* expected, int expectedCount) {
+	static struct OggState ogg;
+	static struct VorbisState vorbis;
+	struct Stream slow;
+	cc_int16* output;
+	cc_uint64 beg, now, start;
+	cc_uint64 queuedEnd = 0, silence = 0, chunkTime;
+	int chunkSize, count = 0, samples, gaps = 0;
+	cc_bool finished = false, success;
+	cc_result res;
+
+	SlowStream_Open(&slow, data, size);
+	Ogg_Init(&ogg, &slow);
+	Mem_Set(&vorbis, 0, sizeof(vorbis));
+	vorbis.source = &ogg;
+
+	if ((res = Vorbis_DecodeHeaders(&vorbis))) { printf("Failed to decode headers (error %x)\n", res); return false; }
+	if ((res = Music_StartDecoder(&vorbis, bufferSecs, 0))) { printf("Failed to start decoder (error %x)\n", res); return false; }
+
+	chunkSize = vorbis.channels * (vorbis.sampleRate / MUSIC_CHUNKS_PER_SEC);
+	chunkTime = 1000000 / MUSIC_CHUNKS_PER_SEC / speedup;
+	output    = (cc_int16*)Mem_Alloc(expectedCount + chunkSize, 2, "bench output");
+
+	beg = Stopwatch_Measure();
+	while (!Music_BufferFilled()) { Thread_Sleep(1); }
+	start = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+	for (;;) {
+		now = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		/* all the audio buffers are still in use */
+		if (queuedEnd > now + chunkTime * (AUDIO_MAX_BUFFERS - 1)) { Thread_Sleep(1); continue; }
+
+		samples = Music_ReadSamples(&output[count], min(chunkSize, expectedCount + chunkSize - count), &finished);
+		if (!samples) {
+			if (finished) break;
+			Thread_Sleep(1); continue;
+		}
+
+		/* all of the queued audio finished playing before this chunk was ready */
+		if (queuedEnd && now > queuedEnd) {
+			gaps++; silence += now - queuedEnd;
+		}
+		queuedEnd = max(queuedEnd, now) + (cc_uint64)chunkTime * samples / chunkSize;
+		count    += samples;
+	}
+	Music_StopDecoder();
+	Vorbis_Free(&vorbis);
+
+	printf("%2i second buffer: %i stalls, started after %.0f ms, ran out %i times, %i gaps (%.0f ms of silence)\n",
+			bufferSecs, stalls, ElapsedMS(start) * speedup, music_buf.underruns, gaps, ElapsedMS(silence) * speedup);
+	if (music_buf.res) printf("  Failed to decode (error %x)\n", music_buf.res);
+
+	success = count == expectedCount && Mem_Equal(output, expected, count * 2);
+	if (!success) {
+		printf("  PLAYED SAMPLES DO NOT MATCH DECODED SAMPLES (%i samples, expected %i)\n", count, expectedCount);
+	}
+	Mem_Free(output);
+	return success;
+}
+
+int main(int argc, char** argv) {
+	static const int bufferSecs[] = { 1, 2, 4, 8 };
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_int16* expected;
+	cc_uint8* data;
+	cc_uint32 size;
+	int i, expectedCount, perSecond;
+	cc_bool success = true;
+	float seconds;
+	cc_result res;
+
+	Logger_Hook();
+	Platform_Init();
+	music_bufMutex    = Mutex_Create();
+	music_bufWaitable = Waitable_Create();
+	speedup = argc > 1 ? atoi(argv[1]) : 8;
+	speedup = max(1, speedup);
+
+	String_InitArray(path, pathBuffer);
+	String_AppendConst(&path, argc > 2 ? argv[2] : BENCH_MUSIC_OGG);
+
+	if ((res = LoadFile(&path, &data, &size))) {
+		printf("Failed to load %.*s (error %x)\n", path.length, path.buffer, res); return 1;
+	}
+	if ((res = DecodeReference(data, size, &expected, &expectedCount, &perSecond))) {
+		printf("Failed to decode %.*s (error %x)\n", path.length, path.buffer, res); return 1;
+	}
+
+	/* Stall roughly every BENCH_STALL_SECS seconds of audio */
+	seconds    = (float)expectedCount / perSecond;
+	stallBytes = (cc_uint32)(size / seconds * BENCH_STALL_SECS);
+	printf("%.*s: %.1f seconds, stalls for %i ms every %u bytes, %ix real time\n", path.length, path.buffer, seconds,
+											BENCH_STALL_MS, stallBytes, speedup);
+
+	for (i = 0; i < Array_Elems(bufferSecs); i++) {
+		success &= SimulatePlayback(data, size, bufferSecs[i], expected, expectedCount);
+	}
+	return success ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+/* Headless benchmark of how much texture churn is caused by drawing nametags (see DrawName in src/Entity.c) */
+/* Usage: BenchNametags [frames] [nametags] [renamed per frame] */
+/* Every frame, all the nametags are drawn and some of the names are changed (e.g. by a server that */
+/*  recolors names by team or rank), first by drawing each name into its own texture like nametags */
+/*  used to be drawn, and then by using quads from the glyph atlas that all nametags share */
+/*  (each nametag's quads are only rebuilt when its name changes, and all nametags are drawn at once) */
+/* Each texture is made from a newly allocated bitmap, so textures created = bitmaps allocated */
+/* NOTE: Entity.c is included directly, so that nametags can be drawn without the rest of the game */
+#include "../../src/Entity.c"
+#include "../../src/Window.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_MAX_NAMES 256
+extern cc_uint64 null_texCreates, null_texBytes, null_vertexBytes, null_drawCalls;
+
+static struct Entity entities[BENCH_MAX_NAMES];
+static struct Texture textures[BENCH_MAX_NAMES];
+static struct Model benchModel;
+static int namesCount, renamesCount;
+
+struct BenchStats { cc_uint64 texCreates, texBytes, vertexBytes, drawCalls, time; };
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+static float Bench_GetNameY(struct Entity* e) { return 2.0f; }
+
+/* Characters with random widths and gray pixels, which is close enough to what default.png is like */
+static void MakeFont(void) {
+	struct Bitmap bmp;
+	RNGState rnd;
+	int c, x, y, width, gray;
+
+	Bitmap_Allocate(&bmp, 128, 128);
+	Mem_Set(bmp.scan0, 0, Bitmap_DataSize(128, 128));
+	Random_Seed(&rnd, 1234);
+
+	for (c = 0; c < 256; c++) {
+		if (c == ' ') continue;
+		width = Random_Range(&rnd, 2, 9);
+
+		for (y = 0; y < 7; y++) {
+			for (x = 0; x < width; x++) {
+				if (!Random_Next(&rnd, 3)) continue;
+				gray = Random_Range(&rnd, 160, 256);
+				Bitmap_GetRow(&bmp, (c >> 4) * 8 + y)[(c & 0x0F) * 8 + x] = BitmapCol_Make(gray, gray, gray, 255);
+			}
+		}
+	}
+	Font_SetBitmapAtlas(&bmp);
+}
+
+static void SetName(int i, int frame, cc_bool atlas) {
+	static const char colors[] = "0123456789abcdef";
+	cc_string name; char nameBuffer[STRING_SIZE];
+	char rank = colors[(i + frame) & 0x0F];
+
+	String_InitArray(name, nameBuffer);
+	String_Format3(&name, "&%r[&fRank&%r] &7Player%i", &rank, &rank, &i);
+
+	if (atlas) {
+		Entity_SetName(&entities[i], &name);
+	} else {
+		Gfx_DeleteTexture(&textures[i].ID);
+		String_CopyToRawArray(entities[i].NameRaw, &name);
+	}
+}
+
+/* Draws the name into its own texture, in the same way as MakeNameTexture used to */
+static void MakeNameTexture(struct Entity* e, struct Texture* tex) {
+	cc_string colorlessName; char colorlessBuffer[STRING_SIZE];
+	BitmapCol shadowColor = BitmapCol_Make(80, 80, 80, 255);
+	BitmapCol origWhiteColor;
+	struct DrawTextArgs args;
+	struct FontDesc font;
+	struct Context2D ctx;
+	int width, height;
+	cc_string name;
+
+	Font_MakeBitmapped(&font, 24, FONT_FLAGS_NONE);
+	font.size = 24; font.height = 24;
+
+	name = String_FromRawArray(e->NameRaw);
+	DrawTextArgs_Make(&args, &name, &font, false);
+	width = Drawer2D_TextWidth(&args);
+
+	String_InitArray(colorlessName, colorlessBuffer);
+	width  += 3;
+	height = Drawer2D_TextHeight(&args) + 3;
+
+	Context2D_Alloc(&ctx, width, height);
+	{
+		origWhiteColor = Drawer2D.Colors['f'];
+
+		Drawer2D.Colors['f'] = shadowColor;
+		Drawer2D_WithoutColors(&colorlessName, &name);
+		args.text = colorlessName;
+		Context2D_DrawText(&ctx, &args, 3, 3);
+
+		Drawer2D.Colors['f'] = origWhiteColor;
+		args.text = name;
+		Context2D_DrawText(&ctx, &args, 0, 0);
+	}
+	Context2D_MakeTexture(tex, &ctx);
+	Context2D_Free(&ctx);
+}
+
+/* Draws the nametag as a single textured billboard, in the same way as DrawName used to */
+static void DrawNameTexture(struct Entity* e, struct Texture* tex) {
+	struct VertexTextured vertices[4], *v = vertices;
+	struct Matrix* view = &Gfx.View;
+	const TextureRec* rec = &tex->uv;
+	PackedCol col = PACKEDCOL_WHITE;
+	Vec3 pos, a, b;
+	float sX, sY;
+
+	if (!tex->ID) MakeNameTexture(e, tex);
+	Gfx_BindTexture(tex->ID);
+
+	Vec3_TransformY(&pos, e->Model->GetNameY(e), &e->Transform);
+	sX = tex->Width / 70.0f * 0.5f; sY = tex->Height / 70.0f * 0.5f;
+	pos.Y += sY;
+
+	/* Camera's right and up directions, scaled to half the size of the billboard */
+	a.X = view->row1.X * sX; a.Y = view->row2.X * sX; a.Z = view->row3.X * sX;
+	b.X = view->row1.Y * sY; b.Y = view->row2.Y * sY; b.Z = view->row3.Y * sY;
+
+	v->X = pos.X - a.X - b.X; v->Y = pos.Y - a.Y - b.Y; v->Z = pos.Z - a.Z - b.Z; v->Col = col; v->U = rec->U1; v->V = rec->V2; v++;
+	v->X = pos.X - a.X + b.X; v->Y = pos.Y - a.Y + b.Y; v->Z = pos.Z - a.Z + b.Z; v->Col = col; v->U = rec->U1; v->V = rec->V1; v++;
+	v->X = pos.X + a.X + b.X; v->Y = pos.Y + a.Y + b.Y; v->Z = pos.Z + a.Z + b.Z; v->Col = col; v->U = rec->U2; v->V = rec->V1; v++;
+	v->X = pos.X + a.X - b.X; v->Y = pos.Y + a.Y - b.Y; v->Z = pos.Z + a.Z - b.Z; v->Col = col; v->U = rec->U2; v->V = rec->V2; v++;
+	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	Gfx_UpdateDynamicVb_IndexedTris(Gfx_texVb, vertices, 4);
+}
+
+static void DrawFrame(int frame, cc_bool atlas) {
+	int i, j;
+	for (j = 0; frame && j < renamesCount; j++) {
+		i = (frame * renamesCount + j) % namesCount;
+		SetName(i, frame, atlas);
+	}
+
+	for (i = 0; i < namesCount; i++) {
+		if (atlas) {
+			DrawName(&entities[i]);
+		} else {
+			DrawNameTexture(&entities[i], &textures[i]);
+		}
+	}
+	/* Same as Entities_RenderNames after every entity's RenderName */
+	if (atlas) FlushNames();
+}
+
+static void TakeStats(struct BenchStats* stats) {
+	stats->texCreates  = null_texCreates;  null_texCreates  = 0;
+	stats->texBytes    = null_texBytes;    null_texBytes    = 0;
+	stats->vertexBytes = null_vertexBytes; null_vertexBytes = 0;
+	stats->drawCalls   = null_drawCalls;   null_drawCalls   = 0;
+}
+
+static void RunFrames(const char* name, int frames, cc_bool atlas) {
+	struct BenchStats first, rest;
+	cc_uint64 beg;
+	int i;
+	double n = frames - 1;
+
+	for (i = 0; i < namesCount; i++) { SetName(i, 0, atlas); }
+	TakeStats(&first);
+	DrawFrame(0, atlas);
+	TakeStats(&first);
+
+	beg = Stopwatch_Measure();
+	for (i = 1; i < frames; i++) { DrawFrame(i, atlas); }
+	rest.time = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	TakeStats(&rest);
+
+	printf("%s:\n", name);
+	printf("  First frame: %i bitmaps allocated, %.1f KB of texture data uploaded\n",
+			(int)first.texCreates, first.texBytes / 1024.0);
+	printf("  Per frame after: %.1f bitmaps allocated, %.1f KB of texture data and %.1f KB of vertices uploaded,"
+			" %.1f draw calls, %.1f us\n", rest.texCreates / n, rest.texBytes / 1024.0 / n,
+			rest.vertexBytes / 1024.0 / n, rest.drawCalls / n, rest.time / n);
+}
+
+int main(int argc, char** argv) {
+	int i, frames;
+
+	Logger_Hook();
+	Platform_Init();
+	Window_Init();
+	Gfx_Create();
+	Drawer2D_Component.Reset();
+	MakeFont();
+
+	frames       = argc > 1 ? atoi(argv[1]) : 600;
+	namesCount   = argc > 2 ? atoi(argv[2]) : 200;
+	renamesCount = argc > 3 ? atoi(argv[3]) : 5;
+	frames       = max(2, frames);
+	namesCount   = max(1, min(namesCount, BENCH_MAX_NAMES));
+	renamesCount = max(0, min(renamesCount, namesCount));
+
+	benchModel.GetNameY  = Bench_GetNameY;
+	benchModel.nameScale = 1.0f;
+	for (i = 0; i < namesCount; i++) {
+		entities[i].Model     = &benchModel;
+		entities[i].Transform = Matrix_Identity;
+		entities[i].Transform.row4.X = (float)i;
+		Vec3_Set(entities[i].ModelScale, 1,1,1);
+	}
+	printf("%i nametags, %i renamed every frame, %i frames\n", namesCount, renamesCount, frames);
+
+	RunFrames("Texture per nametag", frames, false);
+	RunFrames("Glyph atlas", frames, true);
+	return 0;
+}
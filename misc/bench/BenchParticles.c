@@ -0,0 +1,511 @@
+/* Headless benchmark of how quickly many particles are ticked and drawn (see src/Particle.c) */
+/* Usage: BenchParticles [ticks] [max particles] */
+/* Every tick, blocks are broken, rain falls and several custom effects are spawned (e.g. by a server using */
+/*  the DefineEffect/SpawnEffect CPE packets), so that thousands of particles are in flight at once */
+/* One of the effects is also redefined with the opposite gravity every so often, while its particles are in flight */
+/* The same particles are ticked and drawn both in the same way as particles used to be (as an array of */
+/*  structs, removed by moving every later particle down) and as arrays of fields, removed by swapping */
+/* The particles and their vertices are checked to be exactly the same, ignoring the order they are in */
+/* NOTE: Particle.c is included directly, so that the particles can be compared against the old way */
+#include "../../src/Particle.c"
+#include "../../src/Logger.h"
+#include "../../src/Utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_SIZE 128
+#define BENCH_FRAMES_PER_TICK 3
+#define BENCH_TICK_DELTA (1.0f / 20.0f)
+
+static RNGState benchRnd;
+static struct VertexTextured* oldVertices;
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Old way of particles-------------------------------------------------*
+*#########################################################################################################################*/
+struct OldParticle { Vec3 velocity; float lifetime; Vec3 lastPos, nextPos; float size; };
+struct OldTerrainParticle { struct OldParticle base; TextureRec rec; TextureLoc texLoc; BlockID block; };
+struct OldCustomParticle  { struct OldParticle base; int effectId; float totalLifespan; };
+
+static struct OldParticle* oldRain;
+static struct OldTerrainParticle* oldTerrain;
+static struct OldCustomParticle* oldCustom;
+static int oldRainCount, oldTerrainCount, oldCustomCount;
+
+/* Draws a particle in the same way as the now removed Particle_DoRender did */
+static void Old_DoRender(const Vec2* size, const Vec3* pos, const TextureRec* rec, PackedCol col, struct VertexTextured* v) {
+	struct Matrix* view;
+	float sX, sY;
+	Vec3 centre;
+	float aX, aY, aZ, bX, bY, bZ;
+
+	sX = size->X * 0.5f; sY = size->Y * 0.5f;
+	centre = *pos; centre.Y += sY;
+	view   = &Gfx.View;
+
+	aX = view->row1.X * sX; aY = view->row2.X * sX; aZ = view->row3.X * sX;
+	bX = view->row1.Y * sY; bY = view->row2.Y * sY; bZ = view->row3.Y * sY;
+
+	v->X = centre.X - aX - bX; v->Y = centre.Y - aY - bY; v->Z = centre.Z - aZ - bZ; v->Col = col; v->U = rec->U1; v->V = rec->V2; v++;
+	v->X = centre.X - aX + bX; v->Y = centre.Y - aY + bY; v->Z = centre.Z - aZ + bZ; v->Col = col; v->U = rec->U1; v->V = rec->V1; v++;
+	v->X = centre.X + aX + bX; v->Y = centre.Y + aY + bY; v->Z = centre.Z + aZ + bZ; v->Col = col; v->U = rec->U2; v->V = rec->V1; v++;
+	v->X = centre.X + aX - bX; v->Y = centre.Y + aY - bY; v->Z = centre.Z + aZ - bZ; v->Col = col; v->U = rec->U2; v->V = rec->V2; v++;
+}
+
+static cc_bool Old_ClipY(struct OldParticle* p, int y, cc_bool topFace, CanPassThroughFunc canPassThrough) {
+	BlockID block;
+	float collideY;
+	cc_bool collideVer;
+
+	if (y < 0) {
+		p->nextPos.Y = ENTITY_ADJUSTMENT;
+		p->lastPos.Y = ENTITY_ADJUSTMENT;
+		Vec3_Set(p->velocity, 0,0,0);
+		hitTerrain = true;
+		return false;
+	}
+
+	block = GetBlock((int)p->nextPos.X, y, (int)p->nextPos.Z);
+	if (canPassThrough(block)) return true;
+
+	collideY   = y + (topFace ? Blocks.MaxBB[block].Y : Blocks.MinBB[block].Y);
+	collideVer = topFace ? (p->nextPos.Y < collideY) : (p->nextPos.Y > collideY);
+
+	if (collideVer && CollidesHor(p->nextPos.X, p->nextPos.Z, block)) {
+		float adjust = topFace ? ENTITY_ADJUSTMENT : -ENTITY_ADJUSTMENT;
+		p->lastPos.Y = collideY + adjust;
+		p->nextPos.Y = p->lastPos.Y;
+		Vec3_Set(p->velocity, 0,0,0);
+		hitTerrain = true;
+		return false;
+	}
+	return true;
+}
+
+static cc_bool Old_PhysicsTick(struct OldParticle* p, float gravity, CanPassThroughFunc canPassThrough, float delta) {
+	Vec3 velocity;
+	int y, begY, endY;
+
+	p->lastPos = p->nextPos;
+	if (IntersectsBlock(p->nextPos.X, p->nextPos.Y, p->nextPos.Z, canPassThrough)) return true;
+
+	p->velocity.Y -= gravity * delta;
+	begY = Math_Floor(p->nextPos.Y);
+
+	Vec3_Mul1(&velocity, &p->velocity, delta * 3.0f);
+	Vec3_Add(&p->nextPos, &p->nextPos, &velocity);
+	endY = Math_Floor(p->nextPos.Y);
+
+	if (p->velocity.Y > 0.0f) {
+		for (y = begY + 1; y <= endY && Old_ClipY(p, y, false, canPassThrough); y++) {}
+	} else {
+		for (y = begY; y >= endY && Old_ClipY(p, y, true, canPassThrough); y--) {}
+	}
+
+	p->lifetime -= delta;
+	return p->lifetime < 0.0f;
+}
+
+/* Ticks particles in the same way as Particles_Tick used to, i.e. removing by moving every later particle down */
+static void Old_Tick(float delta) {
+	struct CustomParticleEffect* e;
+	int i, j;
+
+	for (i = 0; i < oldTerrainCount; i++) {
+		if (!Old_PhysicsTick(&oldTerrain[i].base, Blocks.ParticleGravity[oldTerrain[i].block], TerrainParticle_CanPass, delta)) continue;
+		for (j = i; j < oldTerrainCount - 1; j++) { oldTerrain[j] = oldTerrain[j + 1]; }
+		oldTerrainCount--; i--;
+	}
+
+	for (i = 0; i < oldRainCount; i++) {
+		hitTerrain = false;
+		if (!Old_PhysicsTick(&oldRain[i], 3.5f, RainParticle_CanPass, delta) && !hitTerrain) continue;
+		for (j = i; j < oldRainCount - 1; j++) { oldRain[j] = oldRain[j + 1]; }
+		oldRainCount--; i--;
+	}
+
+	for (i = 0; i < oldCustomCount; i++) {
+		e = &Particles_CustomEffects[oldCustom[i].effectId];
+		hitTerrain   = false;
+		collideFlags = e->collideFlags;
+
+		if (!Old_PhysicsTick(&oldCustom[i].base, e->gravity, CustomParticle_CanPass, delta)
+			&& !(hitTerrain && (e->collideFlags & EXPIRES_UPON_TOUCHING_GROUND))) continue;
+		for (j = i; j < oldCustomCount - 1; j++) { oldCustom[j] = oldCustom[j + 1]; }
+		oldCustomCount--; i--;
+	}
+}
+
+static void Old_RenderRain(float t, struct VertexTextured* v) {
+	Vec3 pos; Vec2 size;
+	int i;
+	for (i = 0; i < oldRainCount; i++, v += 4) {
+		Vec3_Lerp(&pos, &oldRain[i].lastPos, &oldRain[i].nextPos, t);
+		size.X = oldRain[i].size * 0.015625f; size.Y = size.X;
+		Old_DoRender(&size, &pos, &rain_rec, Lighting.Color(Math_Floor(pos.X), Math_Floor(pos.Y), Math_Floor(pos.Z)), v);
+	}
+}
+
+static void Old_RenderTerrain(float t, struct VertexTextured* v, int* counts) {
+	struct OldTerrainParticle* p;
+	int indices[ATLAS1D_MAX_ATLASES];
+	int i, index;
+	PackedCol col;
+	Vec3 pos; Vec2 size;
+
+	for (i = 0; i < ATLAS1D_MAX_ATLASES; i++) { counts[i] = 0; indices[i] = 0; }
+	for (i = 0; i < oldTerrainCount; i++) { counts[Atlas1D_Index(oldTerrain[i].texLoc)] += 4; }
+	for (i = 1; i < Atlas1D.Count; i++)   { indices[i] = indices[i - 1] + counts[i - 1]; }
+
+	for (i = 0; i < oldTerrainCount; i++) {
+		p     = &oldTerrain[i];
+		index = Atlas1D_Index(p->texLoc);
+		col   = PACKEDCOL_WHITE;
+
+		Vec3_Lerp(&pos, &p->base.lastPos, &p->base.nextPos, t);
+		size.X = p->base.size * 0.015625f; size.Y = size.X;
+		if (!Blocks.FullBright[p->block]) col = Lighting.Color_XSide(Math_Floor(pos.X), Math_Floor(pos.Y), Math_Floor(pos.Z));
+
+		Block_Tint(col, p->block);
+		Old_DoRender(&size, &pos, &p->rec, col, v + indices[index]);
+		indices[index] += 4;
+	}
+}
+
+static void Old_RenderCustom(float t, struct VertexTextured* v) {
+	struct CustomParticleEffect* e;
+	struct OldCustomParticle* p;
+	TextureRec rec;
+	PackedCol col;
+	Vec3 pos; Vec2 size;
+	float shiftU;
+	int i;
+
+	for (i = 0; i < oldCustomCount; i++, v += 4) {
+		p   = &oldCustom[i];
+		e   = &Particles_CustomEffects[p->effectId];
+		rec = e->rec;
+
+		shiftU  = Math_Floor(e->frameCount * ((p->totalLifespan - p->base.lifetime) / p->totalLifespan)) * (rec.U2 - rec.U1);
+		rec.U1 += shiftU;
+		rec.U2 += shiftU;
+
+		Vec3_Lerp(&pos, &p->base.lastPos, &p->base.nextPos, t);
+		size.X = p->base.size; size.Y = size.X;
+
+		col = e->fullBright ? PACKEDCOL_WHITE : Lighting.Color(Math_Floor(pos.X), Math_Floor(pos.Y), Math_Floor(pos.Z));
+		col = PackedCol_Tint(col, e->tintCol);
+		Old_DoRender(&size, &pos, &rec, col, v);
+	}
+}
+
+static void Old_Render(float t) {
+	int counts[ATLAS1D_MAX_ATLASES];
+	Old_RenderTerrain(t, oldVertices, counts);
+	Old_RenderRain(t,    oldVertices);
+	Old_RenderCustom(t,  oldVertices);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Checking-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Every field of a particle, so that particles can be sorted and compared regardless of their order */
+struct BenchParticle { float last[3], next[3], vel[3], lifetime, size, rec[4]; int extra; };
+static struct BenchParticle* oldState;
+static struct BenchParticle* newState;
+
+static int CompareParticles(const void* a, const void* b) { return memcmp(a, b, sizeof(struct BenchParticle)); }
+static int CompareQuads(const void* a, const void* b)     { return memcmp(a, b, 4 * sizeof(struct VertexTextured)); }
+
+static void MakeOld(struct BenchParticle* dst, struct OldParticle* p, const TextureRec* rec, int extra) {
+	Mem_Set(dst, 0, sizeof(*dst));
+	dst->last[0] = p->lastPos.X;  dst->last[1] = p->lastPos.Y;  dst->last[2] = p->lastPos.Z;
+	dst->next[0] = p->nextPos.X;  dst->next[1] = p->nextPos.Y;  dst->next[2] = p->nextPos.Z;
+	dst->vel[0]  = p->velocity.X; dst->vel[1]  = p->velocity.Y; dst->vel[2]  = p->velocity.Z;
+	dst->lifetime = p->lifetime;  dst->size = p->size;
+	if (rec) { dst->rec[0] = rec->U1; dst->rec[1] = rec->V1; dst->rec[2] = rec->U2; dst->rec[3] = rec->V2; }
+	dst->extra = extra;
+}
+
+static void MakeNew(struct BenchParticle* dst, struct ParticleList* l, int i, const TextureRec* rec, int extra) {
+	Mem_Set(dst, 0, sizeof(*dst));
+	dst->last[0] = l->lastX[i]; dst->last[1] = l->lastY[i]; dst->last[2] = l->lastZ[i];
+	dst->next[0] = l->nextX[i]; dst->next[1] = l->nextY[i]; dst->next[2] = l->nextZ[i];
+	dst->vel[0]  = l->velX[i];  dst->vel[1]  = l->velY[i];  dst->vel[2]  = l->velZ[i];
+	dst->lifetime = l->lifetime[i]; dst->size = l->size[i];
+	if (rec) { dst->rec[0] = rec->U1; dst->rec[1] = rec->V1; dst->rec[2] = rec->U2; dst->rec[3] = rec->V2; }
+	dst->extra = extra;
+}
+
+static cc_bool SameParticles(int count) {
+	qsort(oldState, count, sizeof(struct BenchParticle), CompareParticles);
+	qsort(newState, count, sizeof(struct BenchParticle), CompareParticles);
+	return Mem_Equal(oldState, newState, count * sizeof(struct BenchParticle));
+}
+
+static cc_bool SameQuads(struct VertexTextured* a, struct VertexTextured* b, int count) {
+	qsort(a, count, 4 * sizeof(struct VertexTextured), CompareQuads);
+	qsort(b, count, 4 * sizeof(struct VertexTextured), CompareQuads);
+	return Mem_Equal(a, b, count * 4 * sizeof(struct VertexTextured));
+}
+
+static struct VertexTextured* DrawnVertices(void) {
+	/* NullBackend just returns the same memory whenever a vertex buffer is locked */
+	return (struct VertexTextured*)Gfx_LockDynamicVb(Particles_VB, VERTEX_FORMAT_TEXTURED, 0);
+}
+
+static cc_bool CheckParticles(void) {
+	struct ParticleList* l;
+	int i;
+
+	if (oldTerrainCount != terrain_particles.count) return false;
+	for (i = 0, l = &terrain_particles; i < l->count; i++) {
+		MakeOld(&oldState[i], &oldTerrain[i].base, &oldTerrain[i].rec, oldTerrain[i].block | (oldTerrain[i].texLoc << 16));
+		MakeNew(&newState[i], l, i, &terrain_data[i].rec, terrain_data[i].block | (terrain_data[i].texLoc << 16));
+	}
+	if (!SameParticles(i)) return false;
+
+	if (oldRainCount != rain_particles.count) return false;
+	for (i = 0, l = &rain_particles; i < l->count; i++) {
+		MakeOld(&oldState[i], &oldRain[i], NULL, 0);
+		MakeNew(&newState[i], l, i, NULL, 0);
+	}
+	if (!SameParticles(i)) return false;
+
+	if (oldCustomCount != custom_particles.count) return false;
+	for (i = 0, l = &custom_particles; i < l->count; i++) {
+		MakeOld(&oldState[i], &oldCustom[i].base, NULL, oldCustom[i].effectId);
+		MakeNew(&newState[i], l, i, NULL, custom_data[i].effectId);
+		oldState[i].rec[0] = oldCustom[i].totalLifespan;
+		newState[i].rec[0] = custom_data[i].totalLifespan;
+	}
+	return SameParticles(i);
+}
+
+static cc_bool CheckVertices(float t) {
+	int counts[ATLAS1D_MAX_ATLASES];
+	int i, offset = 0;
+	Billboard_Begin();
+
+	Old_RenderTerrain(t, oldVertices, counts);
+	Terrain_Render(t);
+	for (i = 0; i < Atlas1D.Count; i++) {
+		if (counts[i] != terrain_1DCount[i]) return false;
+		if (!SameQuads(oldVertices + offset, DrawnVertices() + offset, counts[i] / 4)) return false;
+		offset += counts[i];
+	}
+
+	Old_RenderRain(t, oldVertices);
+	Rain_Render(t);
+	if (!SameQuads(oldVertices, DrawnVertices(), oldRainCount)) return false;
+
+	Old_RenderCustom(t, oldVertices);
+	Custom_Render(t);
+	return SameQuads(oldVertices, DrawnVertices(), oldCustomCount);
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Spawning-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Hills of grass with some slabs, leaves and pools of water, so that every kind of collision happens */
+static void MakeMap(void) {
+	BlockRaw* blocks = (BlockRaw*)Mem_AllocCleared(BENCH_SIZE * BENCH_SIZE, BENCH_SIZE, "bench map blocks");
+	int x, y, z, height;
+	BlockRaw top;
+
+	for (z = 0; z < BENCH_SIZE; z++) {
+		for (x = 0; x < BENCH_SIZE; x++) {
+			height = 40 + (int)(20 * Math_SinF(x / 13.0f) * Math_CosF(z / 17.0f)) + Random_Next(&benchRnd, 3);
+			top    = BLOCK_GRASS;
+			if (height < 30) { top = BLOCK_WATER; height = 30; }
+			else if (!Random_Next(&benchRnd, 8))  top = BLOCK_SLAB;
+			else if (!Random_Next(&benchRnd, 12)) top = BLOCK_LEAVES;
+
+			for (y = 0; y < height; y++) {
+				blocks[(y * BENCH_SIZE + z) * BENCH_SIZE + x] = y == height - 1 ? top : BLOCK_STONE;
+			}
+		}
+	}
+
+	World_NewMap();
+	World_SetNewMap(blocks, BENCH_SIZE, BENCH_SIZE, BENCH_SIZE);
+	Lighting_Component.OnNewMapLoaded();
+}
+
+static void MakeEffects(void) {
+	static const cc_uint8 collide[3] = { SOLID_COLLIDES | LEAF_COLLIDES, SOLID_COLLIDES | LIQUID_COLLIDES | EXPIRES_UPON_TOUCHING_GROUND, 0 };
+	static const float gravity[3]    = { 1.0f, 4.0f, -0.5f };
+	struct CustomParticleEffect* e;
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		e = &Particles_CustomEffects[i];
+		e->rec.U1 = i / 16.0f; e->rec.V1 = 0.0f; e->rec.U2 = e->rec.U1 + 1 / 128.0f; e->rec.V2 = 1 / 128.0f;
+		e->tintCol       = PackedCol_Make(255, 128 + i * 40, 64, 255);
+		e->frameCount    = 4;
+		e->particleCount = 60;
+		e->collideFlags  = collide[i];
+		e->fullBright    = i == 2;
+		e->size          = 0.25f;
+		e->sizeVariation = 0.5f;
+		e->spread        = 2.0f;
+		e->speed         = 1.5f;
+		e->gravity       = gravity[i];
+		e->baseLifetime  = 3.0f;
+		e->lifetimeVariation = 0.5f;
+	}
+}
+
+/* Copies a particle that was just spawned into the old particles as well */
+static void CopyNew(struct ParticleList* l, int i, struct OldParticle* p) {
+	p->lastPos  = Vec3_Create3(l->lastX[i], l->lastY[i], l->lastZ[i]);
+	p->nextPos  = Vec3_Create3(l->nextX[i], l->nextY[i], l->nextZ[i]);
+	p->velocity = Vec3_Create3(l->velX[i],  l->velY[i],  l->velZ[i]);
+	p->lifetime = l->lifetime[i];
+	p->size     = l->size[i];
+}
+
+/* Returns false if particles had to be replaced, in which case old and new particles can no longer be compared */
+static cc_bool Spawn(void) {
+	int i, j, x, y, z, beg;
+	IVec3 coords;
+	BlockID block;
+
+	for (j = 0; j < 4; j++) {
+		x = Random_Next(&benchRnd, BENCH_SIZE); z = Random_Next(&benchRnd, BENCH_SIZE);
+		for (y = BENCH_SIZE - 1; y > 0 && World_GetBlock(x, y, z) == BLOCK_AIR; y--) {}
+		block = World_GetBlock(x, y, z);
+		coords.X = x; coords.Y = y; coords.Z = z;
+
+		beg = terrain_particles.count;
+		if (beg + 64 > particles_max) return false;
+		Particles_BreakBlockEffect(coords, block, BLOCK_AIR);
+
+		for (i = beg; i < terrain_particles.count; i++) {
+			oldTerrain[oldTerrainCount + i - beg].rec    = terrain_data[i].rec;
+			oldTerrain[oldTerrainCount + i - beg].texLoc = terrain_data[i].texLoc;
+			oldTerrain[oldTerrainCount + i - beg].block  = terrain_data[i].block;
+			CopyNew(&terrain_particles, i, &oldTerrain[oldTerrainCount + i - beg].base);
+		}
+		oldTerrainCount += terrain_particles.count - beg;
+		/* the block is only removed from the map afterwards, like the game does */
+		if (y > 1) World_SetBlock(x, y, z, BLOCK_AIR);
+	}
+
+	for (j = 0; j < 60; j++) {
+		beg = rain_particles.count;
+		if (beg + 2 > particles_max) return false;
+		Particles_RainSnowEffect((float)Random_Next(&benchRnd, 32) + 48, 100.0f, (float)Random_Next(&benchRnd, 32) + 48);
+
+		for (i = beg; i < rain_particles.count; i++) {
+			CopyNew(&rain_particles, i, &oldRain[oldRainCount++]);
+		}
+	}
+
+	for (j = 0; j < 3; j++) {
+		x = Random_Next(&benchRnd, BENCH_SIZE); z = Random_Next(&benchRnd, BENCH_SIZE);
+		beg = custom_particles.count;
+		if (beg + Particles_CustomEffects[j].particleCount > particles_max) return false;
+		Particles_CustomEffect(j, (float)x, 60.0f, (float)z, (float)x, 58.0f, (float)z);
+
+		for (i = beg; i < custom_particles.count; i++) {
+			oldCustom[oldCustomCount + i - beg].effectId      = custom_data[i].effectId;
+			oldCustom[oldCustomCount + i - beg].totalLifespan = custom_data[i].totalLifespan;
+			CopyNew(&custom_particles, i, &oldCustom[oldCustomCount + i - beg].base);
+		}
+		oldCustomCount += custom_particles.count - beg;
+	}
+	return true;
+}
+
+
+int main(int argc, char** argv) {
+	cc_uint64 beg, oldTick = 0, newTick = 0, oldDraw = 0, newDraw = 0;
+	int i, j, ticks, count, maxCount = 0;
+	cc_bool same = true;
+	float t;
+
+	Logger_Hook();
+	Platform_Init();
+	Gfx_Create();
+	GameVersion_Load();
+	Blocks_Component.Init();
+	Lighting_Component.Init();
+
+	ticks         = argc > 1 ? atoi(argv[1]) : 1000;
+	particles_max = argc > 2 ? atoi(argv[2]) : PARTICLES_MAX_LIMIT;
+	ticks         = max(1, ticks);
+	particles_max = max(100, min(particles_max, PARTICLES_MAX_LIMIT));
+
+	/* A view matrix that is neither axis aligned nor identity */
+	Matrix_RotateY(&Gfx.View, 0.7f);
+	Atlas1D.TilesPerAtlas = 64; Atlas1D.Count = 4;
+	Atlas1D.Mask = 63; Atlas1D.Shift = 6; Atlas1D.InvTileSize = 1.0f / 64;
+
+	AllocParticles();
+	OnContextRecreated(NULL);
+	oldRain     = (struct OldParticle*)Mem_Alloc(particles_max, sizeof(struct OldParticle), "old rain");
+	oldTerrain  = (struct OldTerrainParticle*)Mem_Alloc(particles_max, sizeof(struct OldTerrainParticle), "old terrain");
+	oldCustom   = (struct OldCustomParticle*)Mem_Alloc(particles_max, sizeof(struct OldCustomParticle), "old custom");
+	oldVertices = (struct VertexTextured*)Mem_Alloc(particles_max * 4, sizeof(struct VertexTextured), "old vertices");
+	oldState    = (struct BenchParticle*)Mem_Alloc(particles_max, sizeof(struct BenchParticle), "old state");
+	newState    = (struct BenchParticle*)Mem_Alloc(particles_max, sizeof(struct BenchParticle), "new state");
+
+	Random_Seed(&benchRnd, 1234);
+	Random_Seed(&rnd, 1234);
+	MakeMap();
+	MakeEffects();
+
+	for (i = 0; i < ticks; i++) {
+		if (!Spawn()) {
+			printf("  Tick %i: more than %i particles, so stopped early\n", i, particles_max); break;
+		}
+		/* A server may redefine an effect while its particles are still in flight */
+		if (i % 50 == 25) Particles_CustomEffects[0].gravity = -Particles_CustomEffects[0].gravity;
+
+		beg = Stopwatch_Measure();
+		Old_Tick(BENCH_TICK_DELTA);
+		oldTick += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+		beg = Stopwatch_Measure();
+		Terrain_Tick(BENCH_TICK_DELTA);
+		Rain_Tick(BENCH_TICK_DELTA);
+		Custom_Tick(BENCH_TICK_DELTA);
+		newTick += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+		for (j = 0; j < BENCH_FRAMES_PER_TICK; j++) {
+			t = (float)j / BENCH_FRAMES_PER_TICK;
+
+			beg = Stopwatch_Measure();
+			Old_Render(t);
+			oldDraw += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+			beg = Stopwatch_Measure();
+			Particles_Render(t);
+			newDraw += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		}
+
+		count    = terrain_particles.count + rain_particles.count + custom_particles.count;
+		maxCount = max(maxCount, count);
+		if (same && !(CheckParticles() && CheckVertices(0.5f))) {
+			same = false;
+			printf("  Tick %i: PARTICLES DO NOT MATCH THE OLD WAY\n", i);
+		}
+	}
+
+	ticks = max(1, i);
+	printf("%i ticks, up to %i particles in flight (%i terrain, %i rain, %i custom at the end)\n", ticks, maxCount,
+			terrain_particles.count, rain_particles.count, custom_particles.count);
+	printf("Array of structs: %.3f ms per tick, %.3f ms per frame\n",
+			ElapsedMS(oldTick) / ticks, ElapsedMS(oldDraw) / ticks / BENCH_FRAMES_PER_TICK);
+	printf("Arrays of fields: %.3f ms per tick, %.3f ms per frame (ticks %.2fx and frames %.2fx as fast)\n",
+			ElapsedMS(newTick) / ticks, ElapsedMS(newDraw) / ticks / BENCH_FRAMES_PER_TICK,
+			(double)oldTick / newTick, (double)oldDraw / newDraw);
+	return 0;
+}
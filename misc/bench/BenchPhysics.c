@@ -0,0 +1,145 @@
+/* Headless benchmark of how quickly liquid physics is ticked during a large flood (see src/BlockPhysics.c) */
+/* Usage: BenchPhysics [ticks] [physics threads] */
+/* Water is poured over the whole of a 256x256x256 map with hilly terrain, and then physics is ticked */
+/* This is done without any threads and then with the given number of threads (default 4), with the same */
+/*  seed each time, and the resulting maps are checked to be exactly the same */
+/* NOTE: BlockPhysics.c is included directly, so that physics can be ticked with a fixed seed */
+#include "../../src/BlockPhysics.c"
+#include "../../src/Bitmap.h"
+#include "../../src/Entity.h"
+#include "../../src/Camera.h"
+#include "../../src/Model.h"
+#include "../../src/Builder.h"
+#include "../../src/MapRenderer.h"
+#include "../../src/Graphics.h"
+#include "../../src/Utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_SIZE 256
+#define BENCH_WATER_Y 120
+
+/* Only the components needed to load a map and change blocks in it */
+static struct IGameComponent* const components[] = {
+	&World_Component,    &Blocks_Component,   &Camera_Component,  &Models_Component,
+	&Entities_Component, &Lighting_Component, &Builder_Component, &MapRenderer_Component
+};
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+static void HandleNewMap(void* obj) {
+	int i;
+	for (i = 0; i < Array_Elems(components); i++) {
+		if (components[i]->OnNewMap) components[i]->OnNewMap();
+	}
+}
+
+static void HandleMapLoaded(void* obj) {
+	int i;
+	for (i = 0; i < Array_Elems(components); i++) {
+		if (components[i]->OnNewMapLoaded) components[i]->OnNewMapLoaded();
+	}
+}
+
+static void InitComponents(void) {
+	int i;
+	Event_Register_(&WorldEvents.NewMap,    NULL, HandleNewMap);
+	Event_Register_(&WorldEvents.MapLoaded, NULL, HandleMapLoaded);
+
+	for (i = 0; i < Array_Elems(components); i++) {
+		Game_AddComponent(components[i]);
+		if (components[i]->Init) components[i]->Init();
+	}
+}
+
+static int QueuedTicks(void) {
+	int i, j, count = 0;
+	for (i = 0; i < regionsCount; i++) {
+		for (j = 0; j < PHYSICS_WHEEL_SIZE; j++) {
+			count += regions[i].lavaQ[j].count + regions[i].waterQ[j].count;
+		}
+	}
+	return count;
+}
+
+/* Hills of stone, with a sheet of water sources above them that floods the whole map */
+static void MakeMap(void) {
+	BlockRaw* blocks = (BlockRaw*)Mem_AllocCleared(BENCH_SIZE * BENCH_SIZE, BENCH_SIZE, "bench map blocks");
+	int x, y, z, height, index;
+	RNGState rnd;
+
+	Random_Seed(&rnd, 1234);
+	for (z = 0; z < BENCH_SIZE; z++) {
+		for (x = 0; x < BENCH_SIZE; x++) {
+			height = 60 + (int)(40 * Math_SinF(x / 23.0f) * Math_CosF(z / 31.0f)) + Random_Next(&rnd, 4);
+
+			for (y = 0; y < height; y++) {
+				blocks[(y * BENCH_SIZE + z) * BENCH_SIZE + x] = BLOCK_STONE;
+			}
+		}
+	}
+
+	World_NewMap();
+	World_SetNewMap(blocks, BENCH_SIZE, BENCH_SIZE, BENCH_SIZE);
+	Random_Seed(&physics_rnd, 1234);
+	Physics_InitRegions();
+
+	for (z = 0; z < BENCH_SIZE; z += 4) {
+		for (x = 0; x < BENCH_SIZE; x += 4) {
+			index = World_Pack(x, BENCH_WATER_Y, z);
+			World.Blocks[index] = BLOCK_WATER;
+			Physics_PlaceWater(index, BLOCK_WATER);
+		}
+	}
+}
+
+static cc_uint32 RunFlood(int threads, int ticks) {
+	cc_uint64 beg, end, total = 0;
+	int i, queued, maxQueued = 0;
+	cc_uint32 crc;
+	float queueKB;
+
+	Options_SetInt(OPT_PHYSICS_THREADS, threads);
+	Physics_Init();
+	MakeMap();
+
+	for (i = 0; i < ticks; i++) {
+		beg = Stopwatch_Measure();
+		Physics_Tick();
+		end = Stopwatch_Measure();
+		total += Stopwatch_ElapsedMicroseconds(beg, end);
+
+		queued    = QueuedTicks();
+		maxQueued = max(maxQueued, queued);
+	}
+
+	/* Pages are only freed along with the regions, so pagesCount is the most that were ever used */
+	crc     = Utils_CRC32(World.Blocks, World.Volume);
+	queueKB = pagesCount * sizeof(struct TickPage) / 1024.0f;
+	printf("%2i threads: %i ticks in %.2f ms (%.1f ticks/s), up to %i queued liquid ticks in %.1f KB (CRC32 %08x)\n",
+			threads, ticks, ElapsedMS(total), ticks / (total / 1000000.0), maxQueued, queueKB, crc);
+	Physics_Free();
+	return crc;
+}
+
+int main(int argc, char** argv) {
+	int ticks, threads;
+	cc_uint32 expected;
+
+	Logger_Hook();
+	Platform_Init();
+	ticks   = argc > 1 ? atoi(argv[1]) : 300;
+	threads = argc > 2 ? atoi(argv[2]) : 4;
+	ticks   = max(1, ticks);
+
+	Gfx_Create();
+	GameVersion_Load();
+	InitComponents();
+	printf("Map: %i x %i x %i, water poured at y = %i\n", BENCH_SIZE, BENCH_SIZE, BENCH_SIZE, BENCH_WATER_Y);
+
+	expected = RunFlood(0, ticks);
+	if (threads > 0 && RunFlood(threads, ticks) != expected) {
+		printf("  MAP DOES NOT MATCH TICKING WITHOUT THREADS\n");
+	}
+	return 0;
+}
@@ -0,0 +1,257 @@
+/* Headless benchmark of how quickly PNG images are decoded (see Png_Decode in src/Bitmap.c) */
+/* Usage: BenchPng [iterations] [png files...] */
+/* If no files are given, RGB and RGBA images are generated that use each filter type for every row, */
+/*  and the decoded pixels are checked to be exactly the same as the pixels that were encoded */
+/* NOTE: Bitmap.c is included directly, so that unfiltering and row expansion can be measured by themselves */
+#include "../../src/Bitmap.c"
+#include "../../src/ExtMath.h"
+#include "../../src/Funcs.h"
+#include "../../src/String.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Not a multiple of 16 pixels wide, so that the end of each row is handled separately */
+#define BENCH_WIDTH  509
+#define BENCH_HEIGHT 512
+
+struct MemSink { cc_uint8* data; cc_uint32 len, capacity; };
+static struct MemSink sink;
+static struct MemSink idat;
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+static void MemSink_Append(struct MemSink* dst, const cc_uint8* data, cc_uint32 count) {
+	if (dst->len + count > dst->capacity) {
+		dst->capacity = max(dst->capacity * 2, dst->len + count);
+		dst->data     = (cc_uint8*)Mem_Realloc(dst->data, dst->capacity, 1, "bench output");
+	}
+	Mem_Copy(dst->data + dst->len, data, count);
+	dst->len += count;
+}
+
+static cc_result MemSink_Write(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	MemSink_Append((struct MemSink*)s->Meta.Inflate, data, count);
+	*modified = count;
+	return 0;
+}
+
+static void WriteChunk(cc_uint32 fourCC, const cc_uint8* data, cc_uint32 len) {
+	cc_uint8 tmp[8];
+	cc_uint32 beg;
+
+	Stream_SetU32_BE(&tmp[0], len);
+	Stream_SetU32_BE(&tmp[4], fourCC);
+	MemSink_Append(&sink, tmp, 8);
+
+	beg = sink.len - 4;
+	MemSink_Append(&sink, data, len);
+	Stream_SetU32_BE(&tmp[0], Utils_CRC32(&sink.data[beg], sink.len - beg));
+	MemSink_Append(&sink, tmp, 4);
+}
+
+/* Encodes the bitmap as a PNG in sink, with every row using the given filter */
+/* (unlike Png_Encode, which picks whichever filter is estimated to compress best) */
+static void EncodePng(struct Bitmap* bmp, cc_bool alpha, cc_uint8 filter) {
+	cc_uint8 hdr[PNG_IHDR_SIZE];
+	struct ZLibState zlState;
+	struct Stream s, zlStream;
+	cc_uint8* rows[2];
+	cc_uint8* best;
+	int y, bpp = alpha ? 4 : 3, lineLen = bmp->width * bpp;
+
+	rows[0] = (cc_uint8*)Mem_AllocCleared(lineLen, 1, "bench rows");
+	rows[1] = (cc_uint8*)Mem_AllocCleared(lineLen, 1, "bench rows");
+	best    = (cc_uint8*)Mem_Alloc(lineLen + 1, 1, "bench rows");
+	Stream_Init(&s);
+	s.Write        = MemSink_Write;
+	s.Meta.Inflate = &idat;
+	idat.len       = 0;
+	ZLib_MakeStream(&zlStream, &zlState, &s);
+
+	for (y = 0; y < bmp->height; y++) {
+		cc_uint8* cur   = rows[y & 1];
+		cc_uint8* prior = rows[(y & 1) ^ 1];
+
+		Png_MakeRow(Bitmap_GetRow(bmp, y), cur, lineLen, alpha);
+		best[0] = filter;
+		if (filter == PNG_FILTER_NONE) {
+			Mem_Copy(best + 1, cur, lineLen);
+		} else {
+			Png_Filter(filter, cur, prior, best + 1, lineLen, bpp);
+		}
+		Stream_Write(&zlStream, best, lineLen + 1);
+	}
+	zlStream.Close(&zlStream);
+
+	sink.len = 0;
+	Stream_SetU32_BE(&hdr[0], bmp->width);
+	Stream_SetU32_BE(&hdr[4], bmp->height);
+	hdr[8]  = 8;
+	hdr[9]  = alpha ? PNG_COLOR_RGB_A : PNG_COLOR_RGB;
+	hdr[10] = 0; hdr[11] = 0; hdr[12] = 0;
+
+	MemSink_Append(&sink, pngSig, PNG_SIG_SIZE);
+	WriteChunk(PNG_FourCC('I','H','D','R'), hdr, PNG_IHDR_SIZE);
+	WriteChunk(PNG_FourCC('I','D','A','T'), idat.data, idat.len);
+	WriteChunk(PNG_FourCC('I','E','N','D'), NULL, 0);
+
+	Mem_Free(rows[0]); Mem_Free(rows[1]); Mem_Free(best);
+}
+
+/* Smooth gradients with some noise, which is roughly what textures in texture packs look like */
+static void MakeImage(struct Bitmap* bmp, cc_bool alpha) {
+	RNGState rnd;
+	int x, y, r, g, b, a;
+	Random_Seed(&rnd, 1234);
+
+	for (y = 0; y < bmp->height; y++) {
+		for (x = 0; x < bmp->width; x++) {
+			r = (x + Random_Next(&rnd, 24)) & 0xFF;
+			g = (y + Random_Next(&rnd, 24)) & 0xFF;
+			b = ((x ^ y) + Random_Next(&rnd, 8)) & 0xFF;
+			a = alpha ? ((x + y) & 0xFF) : 0xFF;
+			Bitmap_GetRow(bmp, y)[x] = BitmapCol_Make(r, g, b, a);
+		}
+	}
+}
+
+static cc_result Decode(cc_uint8* data, cc_uint32 size, struct Bitmap* bmp) {
+	struct Stream mem;
+	Stream_ReadonlyMemory(&mem, data, size);
+	return Png_Decode(bmp, &mem);
+}
+
+static void RunDecode(const char* name, cc_uint8* data, cc_uint32 size, struct Bitmap* expected, int iterations) {
+	cc_uint64 beg, end, total = 0;
+	struct Bitmap bmp;
+	cc_uint32 pixels;
+	cc_result res;
+	int i, x, y;
+
+	if ((res = Decode(data, size, &bmp))) { printf("Failed to decode %s (error %x)\n", name, res); return; }
+	pixels = bmp.width * bmp.height;
+	printf("%s: %i x %i, %u bytes (CRC32 %08x)", name, bmp.width, bmp.height, size,
+											Utils_CRC32((cc_uint8*)bmp.scan0, pixels * 4));
+
+	for (y = 0; expected && y < bmp.height; y++) {
+		for (x = 0; x < bmp.width; x++) {
+			if (Bitmap_GetRow(&bmp, y)[x] == Bitmap_GetRow(expected, y)[x]) continue;
+			printf(" - DOES NOT MATCH ENCODED PIXELS at %i,%i", x, y); y = bmp.height; break;
+		}
+	}
+	printf("\n");
+	Mem_Free(bmp.scan0);
+
+	for (i = 0; i < iterations; i++) {
+		beg = Stopwatch_Measure();
+		Decode(data, size, &bmp);
+		end = Stopwatch_Measure();
+		total += Stopwatch_ElapsedMicroseconds(beg, end);
+		Mem_Free(bmp.scan0);
+	}
+	printf("  Png_Decode: %i iterations in %.2f ms (%.1f MB/s output)\n", iterations, ElapsedMS(total),
+											(double)pixels * 4 * iterations / total);
+}
+
+/* Measures Png_Reconstruct and the row expander by themselves, using the raw scanlines from idat */
+static void RunUnfilter(struct Bitmap* bmp, cc_bool alpha, int iterations) {
+	cc_uint64 beg, end, total = 0;
+	cc_uint8* work;
+	cc_uint8* prior;
+	cc_uint8* line;
+	struct Stream mem, compStream;
+	struct InflateState inflate;
+	cc_uint32 lineLen, rawLen;
+	Png_RowExpander expander = Png_GetExpander(alpha ? PNG_COLOR_RGB_A : PNG_COLOR_RGB, 8);
+	cc_uint8* zeroes;
+	int i, y, bpp = alpha ? 4 : 3;
+
+	lineLen = bmp->width * bpp + 1;
+	rawLen  = lineLen * bmp->height;
+	work    = (cc_uint8*)Mem_Alloc(rawLen * 2, 1, "bench scanlines");
+	zeroes  = (cc_uint8*)Mem_AllocCleared(lineLen, 1, "bench scanlines");
+
+	/* idat is a ZLib stream, skip the 2 byte header */
+	Stream_ReadonlyMemory(&mem, idat.data + 2, idat.len - 2);
+	Inflate_MakeStream2(&compStream, &inflate, &mem);
+	Stream_Read(&compStream, work + rawLen, rawLen);
+
+	for (i = 0; i < iterations; i++) {
+		Mem_Copy(work, work + rawLen, rawLen);
+		beg = Stopwatch_Measure();
+
+		for (y = 0; y < bmp->height; y++) {
+			line  = work + y * lineLen;
+			prior = y ? line - lineLen : zeroes;
+			Png_Reconstruct(line[0], bpp, line + 1, prior + 1, lineLen - 1);
+			expander(bmp->width, NULL, line + 1, Bitmap_GetRow(bmp, y));
+		}
+		end = Stopwatch_Measure();
+		total += Stopwatch_ElapsedMicroseconds(beg, end);
+	}
+	printf("  Unfilter and expand only: %.2f ms (%.1f MB/s output)\n", ElapsedMS(total),
+											(double)bmp->width * bmp->height * 4 * iterations / total);
+	Mem_Free(work);
+	Mem_Free(zeroes);
+}
+
+static void RunGenerated(int iterations) {
+	static const char* const filterNames[] = { "None", "Sub", "Up", "Average", "Paeth" };
+	struct Bitmap src, tmp;
+	char name[64];
+	int alpha, filter;
+
+	Bitmap_Allocate(&src, BENCH_WIDTH, BENCH_HEIGHT);
+	Bitmap_Allocate(&tmp, BENCH_WIDTH, BENCH_HEIGHT);
+
+	for (alpha = 0; alpha <= 1; alpha++) {
+		MakeImage(&src, alpha);
+		for (filter = PNG_FILTER_NONE; filter <= PNG_FILTER_PAETH; filter++) {
+			EncodePng(&src, alpha, filter);
+			sprintf(name, "%s, %s filter", alpha ? "RGBA" : "RGB", filterNames[filter]);
+
+			RunDecode(name, sink.data, sink.len, &src, iterations);
+			RunUnfilter(&tmp, alpha, iterations);
+		}
+	}
+	Mem_Free(src.scan0);
+	Mem_Free(tmp.scan0);
+}
+
+static cc_result LoadFile(const cc_string* path, cc_uint8** data, cc_uint32* size) {
+	struct Stream stream;
+	cc_result res;
+	if ((res = Stream_OpenFile(&stream, path))) return res;
+
+	if (!(res = stream.Length(&stream, size))) {
+		*data = (cc_uint8*)Mem_Alloc(*size, 1, "bench input");
+		res   = Stream_Read(&stream, *data, *size);
+	}
+	(void)stream.Close(&stream);
+	return res;
+}
+
+int main(int argc, char** argv) {
+	cc_uint8* data;
+	cc_uint32 size;
+	cc_string path;
+	int i, iterations;
+	cc_result res;
+
+	Logger_Hook();
+	Platform_Init();
+	iterations = argc > 1 ? atoi(argv[1]) : 20;
+	iterations = max(1, iterations);
+
+	if (argc <= 2) { RunGenerated(iterations); return 0; }
+
+	for (i = 2; i < argc; i++) {
+		path = String_FromReadonly(argv[i]);
+		if ((res = LoadFile(&path, &data, &size))) {
+			printf("Failed to load %s (error %x)\n", argv[i], res); continue;
+		}
+		RunDecode(argv[i], data, size, NULL, iterations);
+		Mem_Free(data);
+	}
+	return 0;
+}
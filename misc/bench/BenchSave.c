@@ -0,0 +1,190 @@
+/* Headless benchmark of how quickly maps are saved, and how large the saved files are (see Cw_Save in src/Formats.c) */
+/* Usage: BenchSave [iterations] [threads] [map files...] */
+/* If no map files are given, maps/bench.cw is used instead (which is generated with a fixed seed if missing) */
+/* NOTE: Maps are compressed with every level, both on one thread and with GZip_MakeParallelStream */
+#include "../../src/Deflate.h"
+#include "../../src/Formats.h"
+#include "../../src/Funcs.h"
+#include "../../src/Game.h"
+#include "../../src/Generator.h"
+#include "../../src/Platform.h"
+#include "../../src/Logger.h"
+#include "../../src/Stream.h"
+#include "../../src/String.h"
+#include "../../src/Entity.h"
+#include "../../src/Camera.h"
+#include "../../src/Model.h"
+#include "../../src/Block.h"
+#include "../../src/Utils.h"
+#include "../../src/World.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+struct MemSink { cc_uint8* data; cc_uint32 len, capacity; };
+static struct MemSink sink;
+static cc_uint32 expectedCRC, expectedSize;
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+static cc_result MemSink_Write(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	if (sink.len + count > sink.capacity) {
+		sink.capacity = max(sink.capacity * 2, sink.len + count);
+		sink.data     = (cc_uint8*)Mem_Realloc(sink.data, sink.capacity, 1, "bench output");
+	}
+	Mem_Copy(sink.data + sink.len, data, count);
+	sink.len += count;
+	*modified = count;
+	return 0;
+}
+
+static void MemSink_Init(struct Stream* s) {
+	Stream_Init(s);
+	s->Write = MemSink_Write;
+	sink.len = 0;
+}
+
+/* Saves the current map into memory, returning time taken */
+static cc_uint64 Save(int level, int threads) {
+	struct Stream stream, compStream;
+	struct GZipParallelState parallelState;
+	struct GZipState state;
+	cc_uint64 beg, end;
+	cc_result res;
+
+	MemSink_Init(&stream);
+	beg = Stopwatch_Measure();
+	if (threads) {
+		GZip_MakeParallelStream(&compStream, &parallelState, &stream, level, threads);
+	} else {
+		GZip_MakeStream(&compStream, &state, &stream);
+		Deflate_SetLevel(&state.Base, level);
+	}
+
+	if (!(res = Cw_Save(&compStream))) res = compStream.Close(&compStream);
+	end = Stopwatch_Measure();
+
+	if (res) printf("Failed to save (error %x)\n", res);
+	return Stopwatch_ElapsedMicroseconds(beg, end);
+}
+
+/* Checks that the compressed output decompresses back to the same data as an uncompressed save */
+static cc_bool Verify(void) {
+	static struct InflateState inflate;
+	struct Stream mem, compStream;
+	struct GZipHeader gzHeader;
+	cc_uint8 buffer[16384];
+	cc_uint32 read, size = 0, crc = 0xFFFFFFFFUL, i;
+
+	Stream_ReadonlyMemory(&mem, sink.data, sink.len);
+	GZipHeader_Init(&gzHeader);
+	while (!gzHeader.done) {
+		if (GZipHeader_Read(&mem, &gzHeader)) return false;
+	}
+	Inflate_MakeStream2(&compStream, &inflate, &mem);
+
+	for (;;) {
+		if (compStream.Read(&compStream, buffer, sizeof(buffer), &read)) return false;
+		if (!read) break;
+
+		for (i = 0; i < read; i++) {
+			crc = Utils_Crc32Table[(crc ^ buffer[i]) & 0xFF] ^ (crc >> 8);
+		}
+		size += read;
+	}
+	/* GZip footer has CRC32 and size of the uncompressed data */
+	return (crc ^ 0xFFFFFFFFUL) == expectedCRC && size == expectedSize && sink.len >= 8 &&
+		Stream_GetU32_LE(sink.data + sink.len - 8) == expectedCRC && Stream_GetU32_LE(sink.data + sink.len - 4) == size;
+}
+
+static void RunSave(int level, int threads, int iterations) {
+	cc_uint64 total = 0;
+	int i;
+	for (i = 0; i < iterations; i++) { total += Save(level, threads); }
+
+	printf("  Level %i, %2i threads: %8.2f ms, %8u bytes (%5.2f%%)%s\n", level, threads, ElapsedMS(total) / iterations,
+		sink.len, sink.len * 100.0f / expectedSize, Verify() ? "" : " - OUTPUT IS CORRUPT");
+}
+
+static void RunMap(const char* name, int iterations, int threads) {
+	struct Stream stream;
+	int level;
+
+	/* Save without compression, to find what the decompressed output should be */
+	MemSink_Init(&stream);
+	if (Cw_Save(&stream)) { printf("Failed to save %s\n", name); return; }
+	expectedCRC  = Utils_CRC32(sink.data, sink.len);
+	expectedSize = sink.len;
+
+	printf("%s: %i x %i x %i, %u bytes uncompressed, %i iterations\n", name, World.Width, World.Height,
+											World.Length, expectedSize, iterations);
+	for (level = DEFLATE_MIN_LEVEL; level <= DEFLATE_MAX_LEVEL; level++) {
+		RunSave(level, 0, iterations);
+		if (threads) RunSave(level, threads, iterations);
+	}
+}
+
+static cc_result GenerateMap(const cc_string* path) {
+	struct Stream stream, compStream;
+	struct GZipState state;
+	cc_result res;
+	World_SetDimensions(256, 64, 256);
+
+	Gen_Seed    = 1234;
+	Gen_Vanilla = true;
+	Gen_Blocks  = (BlockRaw*)Mem_Alloc(World.Volume, 1, "bench map blocks");
+	NotchyGen_Generate();
+
+	World_SetNewMap(Gen_Blocks, World.Width, World.Height, World.Length);
+	World.Seed = Gen_Seed;
+	Gen_Blocks = NULL;
+	LocalPlayer_CalcDefaultSpawn();
+
+	Utils_EnsureDirectory("maps");
+	if ((res = Stream_CreateFile(&stream, path))) return res;
+	GZip_MakeStream(&compStream, &state, &stream);
+
+	if (!(res = Cw_Save(&compStream))) res = compStream.Close(&compStream);
+	(void)stream.Close(&stream);
+	return res;
+}
+
+int main(int argc, char** argv) {
+	static const cc_string defPath = String_FromConst("maps/bench.cw");
+	cc_string path;
+	int i, iterations, threads;
+	cc_result res;
+
+	Logger_Hook();
+	Platform_Init();
+	iterations = argc > 1 ? atoi(argv[1]) : 3;
+	iterations = max(1, iterations);
+	threads    = argc > 2 ? atoi(argv[2]) : 4;
+	threads    = max(0, min(threads, GZIP_MAX_THREADS));
+
+	/* Only the components needed to load and save a map */
+	Game_AddComponent(&World_Component);
+	Game_AddComponent(&Blocks_Component);
+	Game_AddComponent(&Camera_Component);
+	Game_AddComponent(&Models_Component);
+	Game_AddComponent(&Entities_Component);
+	World_Component.Init();
+	Blocks_Component.Init();
+	Camera_Component.Init();
+	Models_Component.Init();
+	Entities_Component.Init();
+
+	if (argc <= 3 && !File_Exists(&defPath) && (res = GenerateMap(&defPath))) {
+		printf("Failed to generate %.*s (error %x)\n", defPath.length, defPath.buffer, res); return 1;
+	}
+
+	for (i = 3; i < max(argc, 4); i++) {
+		path = argc > 3 ? String_FromReadonly(argv[i]) : defPath;
+		if ((res = Map_LoadFrom(&path))) {
+			printf("Failed to load %.*s (error %x)\n", path.length, path.buffer, res); continue;
+		}
+		RunMap(argc > 3 ? argv[i] : "maps/bench.cw", iterations, threads);
+	}
+
+	Mem_Free(sink.data);
+	return 0;
+}
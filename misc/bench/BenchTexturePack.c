@@ -0,0 +1,316 @@
+/* Headless benchmark of how quickly texture packs are extracted (see ExtractZip in src/TexturePack.c) */
+/* Usage: BenchTexturePack [iterations] [zip files...] */
+/* Each texture pack is extracted with various numbers of threads, and every file in it is read (and decoded */
+/*  if it is a .png) in the same order as the game would, with the results checked to be the same as when */
+/*  extracting without any threads. Texture packs are read into memory first, like downloaded texture packs */
+/* A small texture pack is generated in memory and always extracted first, so the results are checked */
+/*  even when there are no .zip files. If no files are given, every .zip file in the texpacks folder is also used */
+/* NOTE: TexturePack.c is included directly, so that texture packs can be extracted without the rest of the game */
+#include "../../src/TexturePack.c"
+#include <stdio.h>
+#include <stdlib.h>
+
+static cc_uint32 filesHash;
+static int filesCount;
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+/* Reads the file in the same way as the game's handlers, i.e. most .png files are decoded with Png_Decode */
+static void Bench_FileChanged(void* obj, struct Stream* stream, const cc_string* name) {
+	static const cc_string png = String_FromConst(".png");
+	cc_uint32 crc = Utils_CRC32((const cc_uint8*)name->buffer, name->length);
+	cc_uint8 buffer[4096];
+	struct Bitmap bmp;
+	cc_uint32 read;
+
+	if (String_CaselessEnds(name, &png)) {
+		if (!Png_Decode(&bmp, stream)) crc ^= Utils_CRC32((cc_uint8*)bmp.scan0, Bitmap_DataSize(bmp.width, bmp.height));
+		Mem_Free(bmp.scan0);
+	} else {
+		while (!stream->Read(stream, buffer, sizeof(buffer), &read) && read) {
+			crc ^= Utils_CRC32(buffer, read);
+		}
+	}
+	/* Files must be processed in the same order as well */
+	filesHash = filesHash * 31 + crc;
+	filesCount++;
+}
+
+static cc_result LoadFile(const cc_string* path, cc_uint8** data, cc_uint32* size) {
+	struct Stream stream;
+	cc_result res;
+	if ((res = Stream_OpenFile(&stream, path))) return res;
+
+	if (!(res = stream.Length(&stream, size))) {
+		*data = (cc_uint8*)Mem_Alloc(*size, 1, "bench input");
+		res   = Stream_Read(&stream, *data, *size);
+	}
+	(void)stream.Close(&stream);
+	return res;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Sample zip--------------------------------------------------------*
+*#########################################################################################################################*/
+#define ZIP_SIG_LOCAL   0x04034b50
+#define ZIP_SIG_CENTRAL 0x02014b50
+#define ZIP_SIG_END     0x06054b50
+#define SAMPLE_ENTRIES  24
+
+/* Growable buffer that can be written to like a file (Png_Encode seeks back to fill in the IDAT size) */
+struct MemBuffer { cc_uint8* data; cc_uint32 size, capacity, position; };
+struct SampleEntry { char name[32]; cc_uint32 offset, crc, compressedSize, size; int method; };
+static struct SampleEntry sampleEntries[SAMPLE_ENTRIES];
+static struct DeflateState sampleDeflate;
+
+static cc_result MemBuffer_Write(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct MemBuffer* buf = (struct MemBuffer*)s->Meta.Inflate;
+	cc_uint32 end = buf->position + count;
+
+	if (end > buf->capacity) {
+		buf->capacity = max(buf->capacity * 2, end);
+		buf->data     = (cc_uint8*)Mem_Realloc(buf->data, buf->capacity, 1, "bench buffer");
+	}
+	Mem_Copy(buf->data + buf->position, data, count);
+	buf->position = end;
+	buf->size     = max(buf->size, end);
+	*modified     = count;
+	return 0;
+}
+
+static cc_result MemBuffer_Seek(struct Stream* s, cc_uint32 position) {
+	struct MemBuffer* buf = (struct MemBuffer*)s->Meta.Inflate;
+	if (position > buf->size) return ERR_INVALID_ARGUMENT;
+	buf->position = position; return 0;
+}
+
+static cc_result MemBuffer_Position(struct Stream* s, cc_uint32* position) {
+	*position = ((struct MemBuffer*)s->Meta.Inflate)->position; return 0;
+}
+
+static cc_result MemBuffer_Length(struct Stream* s, cc_uint32* length) {
+	*length = ((struct MemBuffer*)s->Meta.Inflate)->size; return 0;
+}
+
+static void MemBuffer_MakeStream(struct Stream* s, struct MemBuffer* buf) {
+	Stream_Init(s);
+	s->Write        = MemBuffer_Write;
+	s->Seek         = MemBuffer_Seek;
+	s->Position     = MemBuffer_Position;
+	s->Length       = MemBuffer_Length;
+	s->Meta.Inflate = buf;
+}
+
+static void Zip_WriteHeader(struct Stream* s, struct SampleEntry* e, cc_uint32 sig) {
+	cc_uint8 header[46] = { 0 };
+	int nameLen     = String_Length(e->name);
+	cc_bool central = sig == ZIP_SIG_CENTRAL;
+	/* Central directory headers have an extra 'version made by' field after the signature */
+	cc_uint8* h     = central ? header + 2 : header;
+
+	Stream_SetU32_LE(&header[0], sig);
+	Stream_SetU16_LE(&h[4],  20);
+	Stream_SetU16_LE(&h[8],  e->method);
+	Stream_SetU32_LE(&h[14], e->crc);
+	Stream_SetU32_LE(&h[18], e->compressedSize);
+	Stream_SetU32_LE(&h[22], e->size);
+	Stream_SetU16_LE(&h[26], nameLen);
+	if (central) Stream_SetU32_LE(&header[42], e->offset);
+
+	Stream_Write(s, header, central ? 46 : 30);
+	Stream_Write(s, (const cc_uint8*)e->name, nameLen);
+}
+
+static void Zip_AddEntry(struct Stream* s, struct MemBuffer* zip, struct SampleEntry* e,
+						const cc_uint8* data, cc_uint32 size, int method) {
+	struct Stream comp;
+	cc_uint32 beg;
+	e->offset = zip->size;
+	e->crc    = Utils_CRC32(data, size);
+	e->size   = size;
+	e->method = method;
+	Zip_WriteHeader(s, e, ZIP_SIG_LOCAL);
+	beg = zip->size;
+
+	if (method == 8) {
+		Deflate_MakeStream(&comp, &sampleDeflate, s);
+		Stream_Write(&comp, data, size);
+		comp.Close(&comp);
+	} else {
+		Stream_Write(s, data, size);
+	}
+	/* Compressed size is only known once the data has been written */
+	e->compressedSize = zip->size - beg;
+	Stream_SetU32_LE(zip->data + e->offset + 18, e->compressedSize);
+}
+
+/* Makes a .zip with a stored .png, deflated .png, stored .txt and deflated .txt in every 4 entries */
+static void MakeSampleZip(struct MemBuffer* zip) {
+	struct MemBuffer png = { 0 };
+	cc_uint8 text[2048], end[22] = { 0 };
+	struct Stream s, pngStream;
+	struct Bitmap bmp;
+	cc_uint32 dirBeg;
+	int i, x, y, size, method;
+	cc_result res;
+
+	MemBuffer_MakeStream(&s, zip);
+	MemBuffer_MakeStream(&pngStream, &png);
+
+	for (i = 0; i < SAMPLE_ENTRIES; i++) {
+		method = (i & 1) ? 8 : 0;
+
+		if (i & 2) {
+			snprintf(sampleEntries[i].name, sizeof(sampleEntries[i].name), "sample/file%i.txt", i);
+			size = 1024 + i * 40;
+			for (x = 0; x < size; x++) { text[x] = 'a' + (x * 7 + i) % 26; }
+			Zip_AddEntry(&s, zip, &sampleEntries[i], text, size, method);
+		} else {
+			snprintf(sampleEntries[i].name, sizeof(sampleEntries[i].name), "sample/image%i.png", i);
+			size = 16 << (i % 12 / 4 + i / 12);
+			Bitmap_Allocate(&bmp, size, size);
+
+			for (y = 0; y < size; y++)
+				for (x = 0; x < size; x++)
+			{
+				Bitmap_GetPixel(&bmp, x, y) = BitmapCol_Make(x * 255 / size, y * 255 / size, (x * y + i) & 0xFF, 255);
+			}
+
+			png.size = 0; png.position = 0;
+			res = Png_Encode(&bmp, &pngStream, NULL, false);
+			if (res) printf("Failed to encode %s (error %x)\n", sampleEntries[i].name, res);
+
+			Zip_AddEntry(&s, zip, &sampleEntries[i], png.data, png.size, method);
+			Mem_Free(bmp.scan0);
+		}
+	}
+
+	dirBeg = zip->size;
+	for (i = 0; i < SAMPLE_ENTRIES; i++) {
+		Zip_WriteHeader(&s, &sampleEntries[i], ZIP_SIG_CENTRAL);
+	}
+
+	Stream_SetU32_LE(&end[0],  ZIP_SIG_END);
+	Stream_SetU16_LE(&end[8],  SAMPLE_ENTRIES);
+	Stream_SetU16_LE(&end[10], SAMPLE_ENTRIES);
+	Stream_SetU32_LE(&end[12], zip->size - dirBeg);
+	Stream_SetU32_LE(&end[16], dirBeg);
+	Stream_Write(&s, end, sizeof(end));
+	Mem_Free(png.data);
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Benchmark--------------------------------------------------------*
+*#########################################################################################################################*/
+static cc_result Extract(cc_uint8* data, cc_uint32 size, int threads, cc_uint64* elapsed) {
+	struct Stream mem;
+	cc_uint64 beg;
+	cc_result res;
+
+	filesHash  = 0;
+	filesCount = 0;
+	Stream_ReadonlyMemory(&mem, data, size);
+
+	beg = Stopwatch_Measure();
+	res = ExtractZip(&mem, threads);
+	*elapsed += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	return res;
+}
+
+/* Returns whether extracting with threads read the same files in the same order as without threads */
+static cc_bool RunExtract(const cc_string* name, cc_uint8* data, cc_uint32 size, int iterations) {
+	static const int threadCounts[] = { 0, 1, 2, 4, 8, 16 };
+	cc_uint64 total, serial = 0;
+	cc_uint32 expectedHash;
+	int i, j, expectedCount;
+	cc_bool success = true;
+	cc_result res;
+
+	total = 0;
+	if ((res = Extract(data, size, 0, &total))) {
+		printf("Failed to extract %.*s (error %x)\n", name->length, name->buffer, res); return false;
+	}
+	expectedHash  = filesHash;
+	expectedCount = filesCount;
+	printf("%.*s: %u bytes, %i files\n", name->length, name->buffer, size, filesCount);
+
+	for (i = 0; i < Array_Elems(threadCounts); i++) {
+		total = 0;
+		for (j = 0; j < iterations; j++) { Extract(data, size, threadCounts[i], &total); }
+		if (!threadCounts[i]) serial = total;
+
+		printf("  %2i threads: %.2f ms per extract (%.2fx as fast as without threads)\n", threadCounts[i],
+				ElapsedMS(total) / iterations, (double)serial / total);
+		if (filesHash != expectedHash || filesCount != expectedCount) {
+			printf("  FILES DO NOT MATCH EXTRACTING WITHOUT THREADS (%i files, expected %i)\n", filesCount, expectedCount);
+			success = false;
+		}
+	}
+	return success;
+}
+
+static cc_bool RunSample(int iterations) {
+	static const cc_string name = String_FromConst("(generated sample)");
+	struct MemBuffer zip = { 0 };
+	cc_bool success;
+
+	MakeSampleZip(&zip);
+	success = RunExtract(&name, zip.data, zip.size, iterations);
+	if (filesCount != SAMPLE_ENTRIES) {
+		printf("  ONLY %i OF %i FILES WERE EXTRACTED\n", filesCount, SAMPLE_ENTRIES);
+		success = false;
+	}
+	Mem_Free(zip.data);
+	return success;
+}
+
+static cc_bool RunFile(const cc_string* path, int iterations) {
+	cc_uint8* data;
+	cc_uint32 size;
+	cc_bool success;
+	cc_result res;
+
+	if ((res = LoadFile(path, &data, &size))) {
+		printf("Failed to load %.*s (error %x)\n", path->length, path->buffer, res); return false;
+	}
+	success = RunExtract(path, data, size, iterations);
+	Mem_Free(data);
+	return success;
+}
+
+static void AddZipFile(const cc_string* path, void* obj) {
+	static const cc_string zip = String_FromConst(".zip");
+	if (String_CaselessEnds(path, &zip)) StringsBuffer_Add((struct StringsBuffer*)obj, path);
+}
+
+int main(int argc, char** argv) {
+	static const cc_string texpacksDir = String_FromConst("texpacks");
+	struct StringsBuffer files;
+	cc_bool success;
+	cc_string path;
+	int i, iterations;
+
+	Logger_Hook();
+	Platform_Init();
+	Event_Register_(&TextureEvents.FileChanged, NULL, Bench_FileChanged);
+	iterations = argc > 1 ? atoi(argv[1]) : 5;
+	iterations = max(1, iterations);
+
+	StringsBuffer_SetLengthBits(&files, STRINGSBUFFER_DEF_LEN_SHIFT);
+	StringsBuffer_Init(&files);
+	for (i = 2; i < argc; i++) {
+		path = String_FromReadonly(argv[i]);
+		StringsBuffer_Add(&files, &path);
+	}
+	if (argc <= 2) Directory_Enum(&texpacksDir, &files, AddZipFile);
+
+	success = RunSample(iterations);
+	for (i = 0; i < files.count; i++) {
+		path     = StringsBuffer_UNSAFE_Get(&files, i);
+		success &= RunFile(&path, iterations);
+	}
+	StringsBuffer_Clear(&files);
+	return success ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+/* Headless benchmark of how quickly Ogg Vorbis music is decoded (see src/Vorbis.c) */
+/* Usage: BenchVorbis [iterations] [ogg files...] */
+/* music.ogg in the bench folder is always decoded first, and its samples are checked against the CRC32 */
+/*  of every second of the output from the original scalar decoder (before codewords were table driven) */
+/* If no files are given, every .ogg file in the audio folder is also used */
+/* Decoded samples of other files are compared to [file].pcm if it exists, and are otherwise saved to [file].pcm */
+/*  (so running an older build first saves its output, for checking a newer build is sample exact) */
+#include "../../src/Vorbis.h"
+#include "../../src/Funcs.h"
+#include "../../src/Platform.h"
+#include "../../src/Logger.h"
+#include "../../src/Stream.h"
+#include "../../src/String.h"
+#include "../../src/Utils.h"
+#include "../../src/Errors.h"
+#include "../../src/ExtMath.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Relative to the src folder, which the bench is built and run from */
+#define BENCH_MUSIC_OGG "../misc/bench/music.ogg"
+#define BENCH_MUSIC_SAMPLES 1765760
+#define BENCH_MUSIC_PER_CRC (44100 * 2)
+/* CRC32 of each second of samples that the original decoder output for music.ogg */
+static const cc_uint32 musicCRCs[] = {
+	0xeec919d3, 0x31501056, 0x92127c03, 0xb8128cd6, 0xf5cdf036, 0xce39a681, 0x98afcedf,
+	0xcf3e598f, 0x461692e6, 0x1c87a75e, 0x44e83993, 0x99eea32b, 0x8983ce4d, 0xf3ece032,
+	0xa1c6fc79, 0x0856e1c7, 0x2cb4ff3f, 0x3fbe3ea5, 0x864ad6d0, 0x774d2b81, 0xc9f99d77
+};
+
+struct BenchFile {
+	cc_uint8* data;   cc_uint32 size;
+	cc_int16* output; cc_uint32 samples, capacity;
+	int channels, sampleRate;
+};
+static struct OggState ogg;
+static struct VorbisState vorbis;
+
+static float ElapsedMS(cc_uint64 time) { return time / 1000.0f; }
+
+/* Decodes the whole file into its output buffer, in the same way as Music_PlayOgg in src/Audio.c */
+static cc_result Decode(struct BenchFile* f) {
+	struct Stream mem;
+	cc_uint32 maxFrame;
+	cc_result res;
+
+	Stream_ReadonlyMemory(&mem, f->data, f->size);
+	Ogg_Init(&ogg, &mem);
+	Mem_Set(&vorbis, 0, sizeof(vorbis));
+	vorbis.source = &ogg;
+	f->samples    = 0;
+
+	if ((res = Vorbis_DecodeHeaders(&vorbis))) goto finished;
+	f->channels   = vorbis.channels;
+	f->sampleRate = vorbis.sampleRate;
+	maxFrame      = vorbis.blockSizes[1] * vorbis.channels;
+
+	for (;;) {
+		if (f->samples + maxFrame > f->capacity) {
+			f->capacity = max(f->capacity * 2, f->samples + maxFrame);
+			f->output   = (cc_int16*)Mem_Realloc(f->output, f->capacity, 2, "bench output");
+		}
+
+		if ((res = Vorbis_DecodeFrame(&vorbis))) break;
+		f->samples += Vorbis_OutputFrame(&vorbis, f->output + f->samples);
+	}
+	if (res == ERR_END_OF_STREAM) res = 0;
+
+finished:
+	Vorbis_Free(&vorbis);
+	return res;
+}
+
+static cc_result LoadFile(const cc_string* path, cc_uint8** data, cc_uint32* size) {
+	struct Stream stream;
+	cc_result res;
+	if ((res = Stream_OpenFile(&stream, path))) return res;
+
+	if (!(res = stream.Length(&stream, size))) {
+		*data = (cc_uint8*)Mem_Alloc(*size, 1, "bench input");
+		res   = Stream_Read(&stream, *data, *size);
+	}
+	(void)stream.Close(&stream);
+	return res;
+}
+
+static cc_bool CompareMusicCRCs(struct BenchFile* f) {
+	cc_uint32 i, count;
+	if (f->samples != BENCH_MUSIC_SAMPLES) {
+		printf("  DOES NOT MATCH ORIGINAL DECODER (%u samples, expected %u)\n", f->samples, BENCH_MUSIC_SAMPLES);
+		return false;
+	}
+
+	for (i = 0; i < Array_Elems(musicCRCs); i++) {
+		count = min(BENCH_MUSIC_PER_CRC, f->samples - i * BENCH_MUSIC_PER_CRC);
+		if (Utils_CRC32((cc_uint8*)(f->output + i * BENCH_MUSIC_PER_CRC), count * 2) == musicCRCs[i]) continue;
+
+		printf("  DOES NOT MATCH ORIGINAL DECODER (first difference is in second %u)\n", i);
+		return false;
+	}
+	printf("  Matches original decoder exactly\n");
+	return true;
+}
+
+/* Returns false if the decoded samples differ from [file].pcm */
+static cc_bool CompareReference(const cc_string* path, struct BenchFile* f) {
+	cc_string refPath; char refBuffer[FILENAME_SIZE + 8];
+	cc_uint8* ref;
+	cc_uint32 refSize, i, diffs = 0;
+	int diff, maxDiff = 0;
+	cc_bool success = false;
+	struct Stream stream;
+	cc_result res;
+
+	String_InitArray(refPath, refBuffer);
+	String_Format1(&refPath, "%s.pcm", path);
+
+	if (LoadFile(&refPath, &ref, &refSize)) {
+		/* No reference output yet, so save this output as the reference */
+		if (!(res = Stream_CreateFile(&stream, &refPath))) {
+			res = Stream_Write(&stream, (cc_uint8*)f->output, f->samples * 2);
+			(void)stream.Close(&stream);
+		}
+		if (res) { printf("  Failed to save reference output (error %x)\n", res); return true; }
+		printf("  Saved reference output to %.*s\n", refPath.length, refPath.buffer); return true;
+	}
+
+	if (refSize != f->samples * 2) {
+		printf("  DOES NOT MATCH REFERENCE OUTPUT (%u samples, reference has %u)\n", f->samples, refSize / 2);
+	} else {
+		for (i = 0; i < f->samples; i++) {
+			diff = f->output[i] - ((cc_int16*)ref)[i];
+			if (!diff) continue;
+			diffs++; maxDiff = max(maxDiff, Math_AbsI(diff));
+		}
+
+		success = !diffs;
+		if (success) printf("  Matches reference output exactly\n");
+		else printf("  DOES NOT MATCH REFERENCE OUTPUT (%u samples differ, by at most %i)\n", diffs, maxDiff);
+	}
+	Mem_Free(ref);
+	return success;
+}
+
+static cc_bool RunDecode(const cc_string* path, int iterations, cc_bool bundled) {
+	struct BenchFile f = { 0 };
+	cc_uint64 beg, end, total = 0;
+	cc_bool success = false;
+	float seconds;
+	cc_result res;
+	int i;
+
+	if ((res = LoadFile(path, &f.data, &f.size))) {
+		printf("Failed to load %.*s (error %x)\n", path->length, path->buffer, res); return false;
+	}
+	/* Decode once first, so that the output buffer is already big enough */
+	if ((res = Decode(&f))) {
+		printf("Failed to decode %.*s (error %x)\n", path->length, path->buffer, res); goto cleanup;
+	}
+
+	seconds = (float)f.samples / f.channels / f.sampleRate;
+	printf("%.*s: %i channels at %i hz, %.1f seconds (CRC32 %08x)\n", path->length, path->buffer, f.channels,
+										f.sampleRate, seconds, Utils_CRC32((cc_uint8*)f.output, f.samples * 2));
+	success = bundled ? CompareMusicCRCs(&f) : CompareReference(path, &f);
+
+	for (i = 0; i < iterations; i++) {
+		beg = Stopwatch_Measure();
+		Decode(&f);
+		end = Stopwatch_Measure();
+		total += Stopwatch_ElapsedMicroseconds(beg, end);
+	}
+	printf("  %i iterations in %.2f ms (%.0fx realtime)\n", iterations, ElapsedMS(total),
+										seconds * iterations * 1000000 / total);
+cleanup:
+	Mem_Free(f.data);
+	Mem_Free(f.output);
+	return success;
+}
+
+static void AddMusicFile(const cc_string* path, void* obj) {
+	static const cc_string ogg = String_FromConst(".ogg");
+	if (String_CaselessEnds(path, &ogg)) StringsBuffer_Add((struct StringsBuffer*)obj, path);
+}
+
+int main(int argc, char** argv) {
+	static const cc_string audioDir = String_FromConst("audio");
+	static const cc_string music    = String_FromConst(BENCH_MUSIC_OGG);
+	struct StringsBuffer files;
+	cc_bool success;
+	cc_string path;
+	int i, iterations;
+
+	Logger_Hook();
+	Platform_Init();
+	iterations = argc > 1 ? atoi(argv[1]) : 5;
+	iterations = max(1, iterations);
+
+	StringsBuffer_SetLengthBits(&files, STRINGSBUFFER_DEF_LEN_SHIFT);
+	StringsBuffer_Init(&files);
+	for (i = 2; i < argc; i++) {
+		path = String_FromReadonly(argv[i]);
+		StringsBuffer_Add(&files, &path);
+	}
+	if (argc <= 2) Directory_Enum(&audioDir, &files, AddMusicFile);
+
+	success = RunDecode(&music, iterations, true);
+	for (i = 0; i < files.count; i++) {
+		path     = StringsBuffer_UNSAFE_Get(&files, i);
+		success &= RunDecode(&path, iterations, false);
+	}
+	StringsBuffer_Clear(&files);
+	return success ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+/* Headless window and graphics backend, which lets parts of the game be run without a display or GPU */
+/* NOTE: Only used by the benchmarks in this folder, vertex buffers are just plain memory */
+#include "../../src/_GraphicsBase.h"
+#include "../../src/Window.h"
+#include "../../src/Input.h"
+#include "../../src/Errors.h"
+
+/*########################################################################################################################*
+*------------------------------------------------------Null graphics------------------------------------------------------*
+*#########################################################################################################################*/
+struct NullBuffer { int size; cc_uint8* data; };
+/* Totals of what would have been uploaded to and drawn by the GPU, so benchmarks can report them */
+cc_uint64 null_texCreates, null_texBytes, null_vertexBytes, null_drawCalls;
+static VertexFormat null_format;
+
+static void Gfx_FreeState(void) { FreeDefaultResources(); }
+static void Gfx_RestoreState(void) { InitDefaultResources(); }
+
+void Gfx_Create(void) {
+	Gfx.MaxTexWidth  = 16384;
+	Gfx.MaxTexHeight = 16384;
+	Gfx.Created      = true;
+	Gfx.LostContext  = false;
+	Gfx_RestoreState();
+}
+
+void Gfx_Free(void) { Gfx_FreeState(); }
+cc_bool Gfx_TryRestoreContext(void) { return true; }
+
+GfxResourceID Gfx_CreateTexture(struct Bitmap* bmp, cc_uint8 flags, cc_bool mipmaps) {
+	null_texCreates++;
+	null_texBytes += (cc_uint64)bmp->width * bmp->height * 4;
+	return 1;
+}
+void Gfx_UpdateTexturePart(GfxResourceID texId, int x, int y, struct Bitmap* part, cc_bool mipmaps) {
+	null_texBytes += (cc_uint64)part->width * part->height * 4;
+}
+void Gfx_UpdateTexture(GfxResourceID texId, int x, int y, struct Bitmap* part, int rowWidth, cc_bool mipmaps) {
+	null_texBytes += (cc_uint64)part->width * part->height * 4;
+}
+void Gfx_BindTexture(GfxResourceID texId) { }
+void Gfx_DeleteTexture(GfxResourceID* texId) { *texId = 0; }
+void Gfx_SetTexturing(cc_bool enabled) { }
+void Gfx_EnableMipmaps(void)  { }
+void Gfx_DisableMipmaps(void) { }
+
+void Gfx_SetFog(cc_bool enabled)      { gfx_fogEnabled = enabled; }
+void Gfx_SetFogCol(PackedCol col)     { }
+void Gfx_SetFogDensity(float value)   { }
+void Gfx_SetFogEnd(float value)       { }
+void Gfx_SetFogMode(FogFunc func)     { }
+void Gfx_SetFaceCulling(cc_bool enabled)   { }
+void Gfx_SetAlphaTest(cc_bool enabled)     { }
+void Gfx_SetAlphaBlending(cc_bool enabled) { }
+void Gfx_SetAlphaArgBlend(cc_bool enabled) { }
+
+void Gfx_Clear(void) { }
+void Gfx_ClearCol(PackedCol col) { }
+void Gfx_SetDepthTest(cc_bool enabled)  { }
+void Gfx_SetDepthWrite(cc_bool enabled) { }
+void Gfx_SetColWriteMask(cc_bool r, cc_bool g, cc_bool b, cc_bool a) { }
+void Gfx_DepthOnlyRendering(cc_bool depthOnly) { }
+
+GfxResourceID Gfx_CreateIb(void* indices, int indicesCount) { return 1; }
+void Gfx_BindIb(GfxResourceID ib) { }
+void Gfx_DeleteIb(GfxResourceID* ib) { *ib = 0; }
+
+GfxResourceID Gfx_CreateVb(VertexFormat fmt, int count) {
+	struct NullBuffer* vb = (struct NullBuffer*)Mem_Alloc(1, sizeof(struct NullBuffer), "null vb");
+	vb->size = count * strideSizes[fmt];
+	vb->data = (cc_uint8*)Mem_Alloc(vb->size, 1, "null vb data");
+	return (GfxResourceID)vb;
+}
+
+void Gfx_BindVb(GfxResourceID vb) { }
+void Gfx_DeleteVb(GfxResourceID* vb) {
+	struct NullBuffer* buffer = (struct NullBuffer*)(*vb);
+	if (!buffer) return;
+
+	Mem_Free(buffer->data);
+	Mem_Free(buffer);
+	*vb = 0;
+}
+
+void* Gfx_LockVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	null_vertexBytes += (cc_uint64)count * strideSizes[fmt];
+	return ((struct NullBuffer*)vb)->data;
+}
+void Gfx_UnlockVb(GfxResourceID vb) { }
+
+GfxResourceID Gfx_CreateDynamicVb(VertexFormat fmt, int maxVertices) {
+	return Gfx_CreateVb(fmt, maxVertices);
+}
+void* Gfx_LockDynamicVb(GfxResourceID vb, VertexFormat fmt, int count) {
+	return ((struct NullBuffer*)vb)->data;
+}
+void Gfx_UnlockDynamicVb(GfxResourceID vb) { }
+
+void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
+	null_vertexBytes += (cc_uint64)vCount * strideSizes[null_format];
+}
+void Gfx_SetVertexFormat(VertexFormat fmt) { null_format = fmt; }
+void Gfx_DrawVb_Lines(int verticesCount) { null_drawCalls++; }
+void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex) { null_drawCalls++; }
+void Gfx_DrawVb_IndexedTris(int verticesCount) { null_drawCalls++; }
+void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) { null_drawCalls++; }
+
+void Gfx_LoadMatrix(MatrixType type, const struct Matrix* matrix) { }
+void Gfx_LoadIdentityMatrix(MatrixType type) { }
+void Gfx_EnableTextureOffset(float x, float y) { }
+void Gfx_DisableTextureOffset(void) { }
+
+void Gfx_CalcOrthoMatrix(float width, float height, struct Matrix* matrix) {
+	Matrix_Orthographic(matrix, 0.0f, width, 0.0f, height, ORTHO_NEAR, ORTHO_FAR);
+}
+void Gfx_CalcPerspectiveMatrix(float fov, float aspect, float zFar, struct Matrix* matrix) {
+	Matrix_PerspectiveFieldOfView(matrix, fov, aspect, 0.1f, zFar);
+}
+
+cc_result Gfx_TakeScreenshot(struct Stream* output) { return ERR_NOT_SUPPORTED; }
+cc_bool Gfx_WarnIfNecessary(void) { return false; }
+void Gfx_BeginFrame(void) { }
+void Gfx_EndFrame(void)   { }
+void Gfx_OnWindowResize(void) { }
+
+void Gfx_SetFpsLimit(cc_bool vsync, float minFrameMs) {
+	gfx_minFrameMs = minFrameMs;
+	gfx_vsync      = vsync;
+}
+
+void Gfx_GetApiInfo(cc_string* info) {
+	String_AppendConst(info, "-- Using null graphics backend --\n");
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Null window-------------------------------------------------------*
+*#########################################################################################################################*/
+struct _DisplayData DisplayInfo;
+struct _WinData WindowInfo;
+
+int Display_ScaleX(int x) { return (int)(x * DisplayInfo.ScaleX); }
+int Display_ScaleY(int y) { return (int)(y * DisplayInfo.ScaleY); }
+
+void Window_Init(void) {
+	DisplayInfo.Depth  = 32;
+	DisplayInfo.ScaleX = 1.0f;
+	DisplayInfo.ScaleY = 1.0f;
+	DisplayInfo.Width  = 640;
+	DisplayInfo.Height = 480;
+}
+
+static void DoCreateWindow(int width, int height) {
+	WindowInfo.Width  = width;
+	WindowInfo.Height = height;
+	WindowInfo.Exists = true;
+}
+void Window_Create2D(int width, int height) { DoCreateWindow(width, height); }
+void Window_Create3D(int width, int height) { DoCreateWindow(width, height); }
+
+void Window_SetTitle(const cc_string* title) { }
+void Clipboard_GetText(cc_string* value) { }
+void Clipboard_SetText(const cc_string* value) { }
+
+int Window_GetWindowState(void) { return WINDOW_STATE_NORMAL; }
+cc_result Window_EnterFullscreen(void) { return ERR_NOT_SUPPORTED; }
+cc_result Window_ExitFullscreen(void)  { return ERR_NOT_SUPPORTED; }
+int Window_IsObscured(void) { return 0; }
+
+void Window_Show(void) { }
+void Window_SetSize(int width, int height) { DoCreateWindow(width, height); }
+void Window_Close(void) { WindowInfo.Exists = false; }
+void Window_ProcessEvents(void) { }
+void Cursor_SetPosition(int x, int y) { }
+
+void Window_ShowDialog(const char* title, const char* msg) {
+	Platform_LogConst(title);
+	Platform_LogConst(msg);
+}
+
+cc_result Window_OpenFileDialog(const struct OpenFileDialogArgs* args) { return ERR_NOT_SUPPORTED; }
+cc_result Window_SaveFileDialog(const struct SaveFileDialogArgs* args) { return ERR_NOT_SUPPORTED; }
+
+void Window_AllocFramebuffer(struct Bitmap* bmp) {
+	bmp->scan0 = (BitmapCol*)Mem_Alloc(bmp->width * bmp->height, 4, "window pixels");
+}
+void Window_DrawFramebuffer(Rect2D r) { }
+void Window_FreeFramebuffer(struct Bitmap* bmp) { Mem_Free(bmp->scan0); }
+
+void OpenKeyboardArgs_Init(struct OpenKeyboardArgs* args, STRING_REF const cc_string* text, int type) {
+	args->text   = text;
+	args->type   = type;
+	args->placeholder = "";
+	args->opaque = false;
+}
+void Window_OpenKeyboard(struct OpenKeyboardArgs* args) { }
+void Window_SetKeyboardText(const cc_string* text) { }
+void Window_CloseKeyboard(void) { }
+void Window_LockLandscapeOrientation(cc_bool lock) { }
+
+void Window_EnableRawMouse(void)  { Input_RawMode = true;  }
+void Window_UpdateRawMouse(void)  { }
+void Window_DisableRawMouse(void) { Input_RawMode = false; }
@@ -242,13 +242,9 @@ static void Animations_ReadDescription(struct Stream* stream, const cc_string* p
 	}
 }
 
+/* Changed tiles are only uploaded at the end of Animations_Tick, so all the animations are uploaded together */
 static void Animations_Update(int texLoc, struct Bitmap* bmp, int stride) {
-	int dstX = Atlas1D_Index(texLoc);
-	int dstY = Atlas1D_RowId(texLoc) * Atlas2D.TileSize;
-	GfxResourceID tex;
-
-	tex = Atlas1D.TexIds[dstX];
-	if (tex) Gfx_UpdateTexture(tex, 0, dstY, bmp, stride, Gfx.Mipmaps);
+	Atlas1D_UpdateTile(texLoc, bmp, stride);
 }
 
 static void Animations_Apply(struct AnimationData* data) {
@@ -326,13 +322,8 @@ static void Animations_Validate(void) {
 	}
 }
 
-static void Animations_Tick(struct ScheduledTask* task) {
+static void Animations_TickCustom(void) {
 	int i;
-#ifndef CC_BUILD_WEB
-	if (useLavaAnim)  LavaAnimation_Tick();
-	if (useWaterAnim) WaterAnimation_Tick();
-#endif
-
 	if (!anims_count) return;
 	if (!anims_bmp.scan0) {
 		Chat_AddRaw("&cCurrent texture pack specifies it uses animations,");
@@ -347,6 +338,16 @@ static void Animations_Tick(struct ScheduledTask* task) {
 	}
 }
 
+static void Animations_Tick(struct ScheduledTask* task) {
+#ifndef CC_BUILD_WEB
+	if (useLavaAnim)  LavaAnimation_Tick();
+	if (useWaterAnim) WaterAnimation_Tick();
+#endif
+
+	Animations_TickCustom();
+	Atlas1D_UploadDirty();
+}
+
 
 /*########################################################################################################################*
 *--------------------------------------------------Animations component---------------------------------------------------*
@@ -1,4 +1,11 @@
 #include "Audio.h"
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_SSE2
+#elif defined __ARM_NEON
+#include <arm_neon.h>
+#define AUDIO_NEON
+#endif
 #include "String.h"
 #include "Logger.h"
 #include "Event.h"
@@ -12,6 +19,8 @@
 #include "Stream.h"
 #include "Utils.h"
 #include "Options.h"
+#include "Profiler.h"
+#include "Camera.h"
 #ifdef CC_BUILD_ANDROID
 /* TODO: Refactor maybe to not rely on checking WinInfo.Handle != NULL */
 #include "Window.h"
@@ -846,6 +855,323 @@ static cc_bool AudioBase_AdjustSound(struct AudioContext* ctx, struct AudioData*
 #endif
 
 
+/*########################################################################################################################*
+*---------------------------------------------------------Mixer-----------------------------------------------------------*
+*#########################################################################################################################*/
+#if defined AUDIO_HAS_BACKEND && !defined CC_BUILD_NOSOUNDS
+/* Sounds are mixed together in software and played on a single output stream, */
+/*  instead of each sound needing its own backend context (which may need to be recreated) */
+#define AUDIO_HAS_MIXER
+#define MIXER_SAMPLE_RATE   44100
+#define MIXER_BUFFER_FRAMES 512
+#define MIXER_POLL_DELAY    2
+#define MIXER_DEF_VOICES    16
+
+struct MixerVoice {
+	const cc_int16* samples;
+	int frames, channels;
+	/* Current sample in the source, with frac being the fractional part (16.16 fixed point) */
+	int pos; cc_uint32 frac;
+	/* How far the position advances for each output frame (16.16 fixed point) */
+	cc_uint32 step;
+	/* Volume from 0 to 32767 */
+	int volume;
+};
+
+static struct MixerVoice* mixer_voices;
+static int mixer_voicesCount, mixer_voicesCapacity;
+static cc_int32 mixer_accum[MIXER_BUFFER_FRAMES * 2];
+
+static struct AudioContext mixer_ctx;
+static void* mixer_thread;
+static void* mixer_mutex;
+static void* mixer_waitable;
+static volatile cc_bool mixer_stopping, mixer_joining;
+
+#define Mixer_Advance(v) v->frac += v->step; v->pos += v->frac >> 16; v->frac &= 0xFFFF;
+
+#if defined AUDIO_SSE2
+#define Mixer_Pair(src, i) ((cc_uint16)(src)[i] | ((cc_uint32)(cc_uint16)(src)[(i) + 1] << 16))
+
+/* Computes the weights for 4 positions at once, given the position relative to the current sample in each lane */
+/* w1 is put in the upper 16 bits and w0 in the lower 16 bits of each lane, ready for _mm_madd_epi16 */
+static CC_INLINE __m128i Mixer_Weights(__m128i rel, __m128i volume) {
+	__m128i w1 = _mm_mulhi_epu16(_mm_and_si128(_mm_slli_epi32(rel, 16), _mm_set1_epi32((int)0xFFFE0000)), volume);
+	return _mm_or_si128(_mm_sub_epi16(_mm_srli_epi32(volume, 16), _mm_srli_epi32(w1, 16)), w1);
+}
+#elif defined AUDIO_NEON
+/* Resamples 4 frames at once, with a/b being the samples either side of each frame and f the fractions */
+static void Mixer_Mix4(cc_int32* dst, const cc_int16* a, const cc_int16* b, const cc_uint16* f, int volume) {
+	uint16x4_t vol = vdup_n_u16((cc_uint16)volume);
+	int16x4_t  w1  = vreinterpret_s16_u16(vshrn_n_u32(vmull_u16(vld1_u16(f), vol), 16));
+	int16x4_t  w0  = vsub_s16(vreinterpret_s16_u16(vol), w1);
+	int32x4_t  v   = vshrq_n_s32(vmlal_s16(vmull_s16(vld1_s16(a), w0), vld1_s16(b), w1), 15);
+	int32x4x2_t s  = vzipq_s32(v, v);
+
+	vst1q_s32(dst + 0, vaddq_s32(vld1q_s32(dst + 0), s.val[0]));
+	vst1q_s32(dst + 4, vaddq_s32(vld1q_s32(dst + 4), s.val[1]));
+}
+#endif
+
+/* Linearly interpolates between the two nearest samples, with volume folded into the weights */
+/* i.e. w1 = frac * volume, w0 = volume - w1, output = (a * w0 + b * w1) >> 15 */
+static void Mixer_MixMono(struct MixerVoice* v, cc_int32* dst, int count) {
+	const cc_int16* src = v->samples;
+	int i = 0, w0, w1, value;
+#if defined AUDIO_SSE2
+	const cc_int16* cur;
+	cc_uint32 frac, step = v->step;
+	__m128i vol  = _mm_set1_epi16((short)v->volume);
+	__m128i offs = _mm_setr_epi32(0, step, step * 2, step * 3);
+	__m128i ab, mixed;
+	__m128i* d;
+
+	/* Each lane has the pair of samples either side of a frame */
+	for (; i + 4 <= count; i += 4, dst += 8) {
+		cur  = &src[v->pos];
+		frac = v->frac;
+		ab   = _mm_setr_epi32(Mixer_Pair(cur, 0),                       Mixer_Pair(cur, (frac + step)     >> 16),
+							  Mixer_Pair(cur, (frac + step * 2) >> 16), Mixer_Pair(cur, (frac + step * 3) >> 16));
+		mixed = _mm_srai_epi32(_mm_madd_epi16(ab, Mixer_Weights(_mm_add_epi32(_mm_set1_epi32(frac), offs), vol)), 15);
+
+		d = (__m128i*)dst;
+		_mm_storeu_si128(d + 0, _mm_add_epi32(_mm_loadu_si128(d + 0), _mm_unpacklo_epi32(mixed, mixed)));
+		_mm_storeu_si128(d + 1, _mm_add_epi32(_mm_loadu_si128(d + 1), _mm_unpackhi_epi32(mixed, mixed)));
+		v->frac += step * 4; v->pos += v->frac >> 16; v->frac &= 0xFFFF;
+	}
+#elif defined AUDIO_NEON
+	cc_int16 a[4], b[4];
+	cc_uint16 f[4];
+	int j;
+
+	for (; i + 4 <= count; i += 4, dst += 8) {
+		for (j = 0; j < 4; j++) {
+			a[j] = src[v->pos]; b[j] = src[v->pos + 1];
+			f[j] = (cc_uint16)(v->frac & 0xFFFE);
+			Mixer_Advance(v);
+		}
+		Mixer_Mix4(dst, a, b, f, v->volume);
+	}
+#endif
+	for (; i < count; i++, dst += 2) {
+		w1    = (int)(v->frac >> 1) * v->volume >> 15;
+		w0    = v->volume - w1;
+		value = (src[v->pos] * w0 + src[v->pos + 1] * w1) >> 15;
+
+		dst[0] += value; dst[1] += value;
+		Mixer_Advance(v);
+	}
+}
+
+static void Mixer_MixStereo(struct MixerVoice* v, cc_int32* dst, int count) {
+	const cc_int16* src;
+	int i = 0, w0, w1;
+#if defined AUDIO_SSE2
+	cc_uint32 frac, step = v->step;
+	__m128i vol  = _mm_set1_epi16((short)v->volume);
+	__m128i offs = _mm_setr_epi32(0, 0, step, step);
+	__m128i lr, mixed;
+
+	/* 2 frames at once, with the samples either side of a frame shuffled from L0 R0 L1 R1 to L0 L1 R0 R1 */
+	for (; i + 2 <= count; i += 2, dst += 4) {
+		src  = &v->samples[v->pos * 2];
+		frac = v->frac;
+		lr   = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)src),
+								  _mm_loadl_epi64((const __m128i*)&src[((frac + step) >> 16) * 2]));
+		lr   = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lr, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		mixed = _mm_srai_epi32(_mm_madd_epi16(lr, Mixer_Weights(_mm_add_epi32(_mm_set1_epi32(frac), offs), vol)), 15);
+
+		_mm_storeu_si128((__m128i*)dst, _mm_add_epi32(_mm_loadu_si128((const __m128i*)dst), mixed));
+		v->frac += step * 2; v->pos += v->frac >> 16; v->frac &= 0xFFFF;
+	}
+#endif
+	for (; i < count; i++, dst += 2) {
+		src = &v->samples[v->pos * 2];
+		w1  = (int)(v->frac >> 1) * v->volume >> 15;
+		w0  = v->volume - w1;
+
+		dst[0] += (src[0] * w0 + src[2] * w1) >> 15;
+		dst[1] += (src[1] * w0 + src[3] * w1) >> 15;
+		Mixer_Advance(v);
+	}
+}
+
+/* Mixes up to count frames of the given voice, returning whether the voice has finished */
+static cc_bool Mixer_MixVoice(struct MixerVoice* v, cc_int32* dst, int count) {
+	/* Interpolating also reads the next sample, so stop once the last sample is reached */
+	cc_uint64 cur = ((cc_uint64)v->pos << 16) | v->frac;
+	cc_uint64 end = (cc_uint64)(v->frames - 1) << 16;
+	cc_uint64 left;
+	if (cur >= end) return true;
+
+	left = (end - cur + v->step - 1) / v->step;
+	if (left < (cc_uint64)count) count = (int)left;
+
+	if (v->channels == 1) {
+		Mixer_MixMono(v, dst, count);
+	} else {
+		Mixer_MixStereo(v, dst, count);
+	}
+	return left <= (cc_uint64)count;
+}
+
+/* Converts mixed samples back to 16 bit, clamping any that are out of range */
+static void Mixer_Output(cc_int16* dst, const cc_int32* src, int count) {
+	int i = 0, value;
+#if defined AUDIO_SSE2
+	for (; i + 8 <= count; i += 8) {
+		__m128i lo = _mm_loadu_si128((const __m128i*)&src[i]);
+		__m128i hi = _mm_loadu_si128((const __m128i*)&src[i + 4]);
+		_mm_storeu_si128((__m128i*)&dst[i], _mm_packs_epi32(lo, hi));
+	}
+#elif defined AUDIO_NEON
+	for (; i + 8 <= count; i += 8) {
+		vst1q_s16(&dst[i], vcombine_s16(vqmovn_s32(vld1q_s32(&src[i])), vqmovn_s32(vld1q_s32(&src[i + 4]))));
+	}
+#endif
+	for (; i < count; i++) {
+		value = src[i];
+		Math_Clamp(value, -32768, 32767);
+		dst[i] = value;
+	}
+}
+
+/* Mixes all active voices together into the given number of stereo frames */
+/* NOTE: mixer_mutex must be locked before calling this */
+static void Mixer_Render(cc_int16* dst, int frames) {
+	int i, count;
+
+	for (; frames > 0; frames -= count, dst += count * 2) {
+		count = min(frames, MIXER_BUFFER_FRAMES);
+		Mem_Set(mixer_accum, 0, count * 2 * sizeof(cc_int32));
+
+		for (i = 0; i < mixer_voicesCount; ) {
+			if (!Mixer_MixVoice(&mixer_voices[i], mixer_accum, count)) { i++; continue; }
+			/* Replace finished voice with the last voice, which hasn't been mixed yet */
+			mixer_voices[i] = mixer_voices[--mixer_voicesCount];
+		}
+		Mixer_Output(dst, mixer_accum, count * 2);
+	}
+}
+
+/* Starts playing the given sound data (which must not be freed while playing) */
+static void Mixer_Play(const struct AudioData* data) {
+	struct MixerVoice* v;
+	int frames;
+	if (data->channels != 1 && data->channels != 2) return;
+
+	frames = data->size / (2 * data->channels);
+	if (frames < 2 || data->volume <= 0) return;
+
+	Mutex_Lock(mixer_mutex);
+	{
+		if (mixer_voicesCount == mixer_voicesCapacity) {
+			Utils_Resize((void**)&mixer_voices, &mixer_voicesCapacity,
+				sizeof(struct MixerVoice), MIXER_DEF_VOICES, MIXER_DEF_VOICES);
+		}
+		v = &mixer_voices[mixer_voicesCount++];
+
+		v->samples  = (const cc_int16*)data->data;
+		v->frames   = frames;
+		v->channels = data->channels;
+		v->pos      = 0;
+		v->frac     = 0;
+		/* e.g. 22050 hz at 120% rate advances 0.6 samples per output frame */
+		v->step     = (cc_uint32)(((cc_uint64)data->sampleRate * data->rate << 16) / (100 * MIXER_SAMPLE_RATE));
+		v->step     = max(1, v->step);
+		v->volume   = min(data->volume, 100) * 32767 / 100;
+	}
+	Mutex_Unlock(mixer_mutex);
+	if (mixer_waitable) Waitable_Signal(mixer_waitable);
+}
+
+/* OpenAL backend only releases one finished buffer per poll */
+static cc_result Mixer_Poll(int* inUse) {
+	int prev = AUDIO_MAX_BUFFERS + 1;
+	cc_result res;
+
+	for (;;) {
+		if ((res = Audio_Poll(&mixer_ctx, inUse))) return res;
+		if (*inUse == 0 || *inUse >= prev) return 0;
+		prev = *inUse;
+	}
+}
+
+static void Mixer_RunLoop(void) {
+	int inUse, playing, cur = 0;
+	cc_int16* data;
+	cc_int16* buffer;
+	cc_result res;
+
+	Audio_Init(&mixer_ctx, AUDIO_MAX_BUFFERS);
+	data = (cc_int16*)Mem_TryAlloc(MIXER_BUFFER_FRAMES * 2 * AUDIO_MAX_BUFFERS, 2);
+	res  = data ? Audio_SetFormat(&mixer_ctx, 2, MIXER_SAMPLE_RATE) : ERR_OUT_OF_MEMORY;
+
+	while (!res && !mixer_stopping) {
+		if ((res = Mixer_Poll(&inUse))) break;
+		if (inUse >= AUDIO_MAX_BUFFERS) {
+			Thread_Sleep(MIXER_POLL_DELAY); continue;
+		}
+		buffer = &data[MIXER_BUFFER_FRAMES * 2 * cur];
+
+		Mutex_Lock(mixer_mutex);
+		playing = mixer_voicesCount;
+		if (playing) Mixer_Render(buffer, MIXER_BUFFER_FRAMES);
+		Mutex_Unlock(mixer_mutex);
+
+		if (!playing) {
+			/* Let queued audio finish playing, then sleep until another sound is played */
+			if (inUse) Thread_Sleep(MIXER_POLL_DELAY);
+			else Waitable_Wait(mixer_waitable);
+			continue;
+		}
+
+		if ((res = Audio_QueueData(&mixer_ctx, buffer, MIXER_BUFFER_FRAMES * 4))) break;
+		/* Output stream stops once it runs out of queued audio, so needs to be restarted */
+		if (!inUse && (res = Audio_Play(&mixer_ctx))) break;
+		cur = (cur + 1) % AUDIO_MAX_BUFFERS;
+	}
+
+	if (res) {
+		AudioWarn(res, "playing sounds");
+		Chat_AddRaw("&cDisabling sounds");
+		Audio_SoundsVolume = 0;
+	}
+	/* Backend may still be reading from data, so must close context first */
+	Audio_Close(&mixer_ctx);
+	Mem_Free(data);
+
+	if (mixer_joining) return;
+	Thread_Detach(mixer_thread);
+	mixer_thread = NULL;
+}
+
+static void Mixer_Start(void) {
+	if (mixer_thread) return;
+	mixer_joining  = false;
+	mixer_stopping = false;
+
+	mixer_thread = Thread_Create(Mixer_RunLoop);
+	Thread_Start2(mixer_thread, Mixer_RunLoop);
+}
+
+static void Mixer_Stop(void) {
+	mixer_joining  = true;
+	mixer_stopping = true;
+	if (mixer_waitable) Waitable_Signal(mixer_waitable);
+
+	if (mixer_thread) Thread_Join(mixer_thread);
+	mixer_thread = NULL;
+	if (!mixer_mutex) return;
+
+	/* Sounds that were playing shouldn't resume when sounds are next enabled */
+	Mutex_Lock(mixer_mutex);
+	mixer_voicesCount = 0;
+	Mutex_Unlock(mixer_mutex);
+}
+#endif
+
+
 /*########################################################################################################################*
 *--------------------------------------------------------Sounds-----------------------------------------------------------*
 *#########################################################################################################################*/
@@ -874,6 +1200,9 @@ struct Soundboard { struct SoundGroup groups[SOUND_COUNT]; };
 static struct Soundboard digBoard, stepBoard;
 static struct AudioContext sound_contexts[SOUND_MAX_CONTEXTS];
 static RNGState sounds_rnd;
+#ifdef AUDIO_HAS_MIXER
+static cc_bool sounds_mixer;
+#endif
 
 #define WAV_FourCC(a, b, c, d) (((cc_uint32)a << 24) | ((cc_uint32)b << 16) | ((cc_uint32)c << 8) | (cc_uint32)d)
 #define WAV_FMT_SIZE 16
@@ -1031,10 +1360,21 @@ static void Sounds_Play(cc_uint8 type, struct Soundboard* board) {
 		if (type == SOUND_METAL) data.rate = 140;
 	}
 
+#ifdef AUDIO_HAS_MIXER
+	if (sounds_mixer) {
+		Profiler_Begin(PROFILER_AUDIO);
+		Mixer_Play(&data);
+		Profiler_End(PROFILER_AUDIO);
+		return;
+	}
+#endif
+
 	/* Try to play on a context that doesn't need to be recreated */
 	for (i = 0; i < SOUND_MAX_CONTEXTS; i++) {
 		ctx = &sound_contexts[i];
+		Profiler_Begin(PROFILER_AUDIO);
 		res = Audio_Poll(ctx, &inUse);
+		Profiler_End(PROFILER_AUDIO);
 
 		if (res) { Sounds_Fail(res); return; }
 		if (inUse > 0) continue;
@@ -1048,7 +1388,9 @@ static void Sounds_Play(cc_uint8 type, struct Soundboard* board) {
 	/* Try again with all contexts, even if need to recreate one (expensive) */
 	for (i = 0; i < SOUND_MAX_CONTEXTS; i++) {
 		ctx = &sound_contexts[i];
+		Profiler_Begin(PROFILER_AUDIO);
 		res = Audio_Poll(ctx, &inUse);
+		Profiler_End(PROFILER_AUDIO);
 
 		if (res) { Sounds_Fail(res); return; }
 		if (inUse > 0) continue;
@@ -1061,11 +1403,11 @@ static void Sounds_Play(cc_uint8 type, struct Soundboard* board) {
 
 static void Audio_PlayBlockSound(void* obj, IVec3 coords, BlockID old, BlockID now) {
 	if (now == BLOCK_AIR) {
-		Audio_PlayDigSound(Blocks.DigSounds[old]);
+		Sounds_Play(Blocks.DigSounds[old], &digBoard);
 	} else if (!Game_ClassicMode) {
 		/* use StepSounds instead when placing, as don't want */
 		/*  to play glass break sound when placing glass */
-		Audio_PlayDigSound(Blocks.StepSounds[now]);
+		Sounds_Play(Blocks.StepSounds[now], &digBoard);
 	}
 }
 
@@ -1128,6 +1470,9 @@ static void Sounds_Start(void) {
 	for (i = 0; i < SOUND_MAX_CONTEXTS; i++) {
 		Audio_Init(&sound_contexts[i], 1);
 	}
+#ifdef AUDIO_HAS_MIXER
+	if (sounds_mixer) Mixer_Start();
+#endif
 
 	if (sounds_loaded) return;
 	sounds_loaded = true;
@@ -1140,6 +1485,9 @@ static void Sounds_Start(void) {
 
 static void Sounds_Stop(void) {
 	int i;
+#ifdef AUDIO_HAS_MIXER
+	Mixer_Stop();
+#endif
 	for (i = 0; i < SOUND_MAX_CONTEXTS; i++) {
 		Audio_Close(&sound_contexts[i]);
 	}
@@ -1147,10 +1495,31 @@ static void Sounds_Stop(void) {
 
 static void Sounds_Init(void) {
 	int volume = Options_GetInt(OPT_SOUND_VOLUME, 0, 100, DEFAULT_SOUNDS_VOLUME);
+#ifdef AUDIO_HAS_MIXER
+	sounds_mixer = Options_GetBool(OPT_AUDIO_MIXER, true);
+	if (sounds_mixer) {
+		mixer_mutex    = Mutex_Create();
+		mixer_waitable = Waitable_Create();
+	}
+#endif
 	Audio_SetSounds(volume);
 	Event_Register_(&UserEvents.BlockChanged, NULL, Audio_PlayBlockSound);
 }
-static void Sounds_Free(void) { Sounds_Stop(); }
+
+static void Sounds_Free(void) {
+	Sounds_Stop();
+#ifdef AUDIO_HAS_MIXER
+	if (!sounds_mixer) return;
+	Mutex_Free(mixer_mutex);
+	Waitable_Free(mixer_waitable);
+	Mem_Free(mixer_voices);
+
+	mixer_mutex    = NULL;
+	mixer_waitable = NULL;
+	mixer_voices   = NULL;
+	mixer_voicesCapacity = 0;
+#endif
+}
 
 void Audio_PlayDigSound(cc_uint8 type)  { Sounds_Play(type, &digBoard); }
 void Audio_PlayStepSound(cc_uint8 type) { Sounds_Play(type, &stepBoard); }
@@ -1175,61 +1544,217 @@ static void* music_thread;
 static void* music_waitable;
 static volatile cc_bool music_stopping, music_joining;
 static int music_minDelay, music_maxDelay;
+static int music_bufferSecs, music_cacheSecs;
+/* Decoded audio is queued in chunks of a quarter of a second */
+#define MUSIC_CHUNKS_PER_SEC 4
+
+/* Ring buffer of samples that are decoded ahead of being played by a separate thread, */
+/*  so that slow disc reads or CPU spikes while decoding don't cause any audible gaps */
+static struct MusicBuffer {
+	cc_int16* data;
+	int capacity, available; /* number of samples */
+	int readPos, writePos;
+	cc_bool finished; /* whether decoding has stopped, due to reaching end of track or an error */
+	cc_bool starved;  /* whether buffer is currently empty even though decoding has not finished */
+	int underruns;    /* number of times buffer became empty before decoding finished */
+	cc_result res;
+} music_buf;
+static void* music_bufMutex;
+static void* music_bufWaitable; /* signalled when samples are read from music_buf */
+
+/* Copy of a whole track's decoded samples, kept if the track is short enough */
+static struct MusicCache { cc_int16* data; int count, capacity, max; } music_cache;
+
+static void* music_decoder;
+static struct VorbisState* music_vorbis;
+static cc_int16* music_frame;
+static int music_frameSize;
+static volatile cc_bool music_decodeStop;
+
+static void Music_ResetBuffer(cc_int16* data, int capacity, int available) {
+	music_buf.data      = data;
+	music_buf.capacity  = capacity;
+	music_buf.available = available;
+	music_buf.readPos   = 0;
+	music_buf.writePos  = 0;
+	music_buf.finished  = false;
+	music_buf.starved   = false;
+	music_buf.underruns = 0;
+	music_buf.res       = 0;
+}
+
+/* Copies up to count samples out of the decode-ahead buffer, returning number of samples copied */
+/* finished is set to whether there are no more samples left to play */
+static int Music_ReadSamples(cc_int16* dst, int count, cc_bool* finished) {
+	int part;
+	Mutex_Lock(music_bufMutex);
+	{
+		count = min(count, music_buf.available);
+		part  = min(count, music_buf.capacity - music_buf.readPos);
+
+		Mem_Copy(dst,        &music_buf.data[music_buf.readPos], part * 2);
+		Mem_Copy(dst + part, music_buf.data,                     (count - part) * 2);
+		music_buf.readPos    = (music_buf.readPos + count) % music_buf.capacity;
+		music_buf.available -= count;
+
+		if (count) {
+			music_buf.starved = false;
+		} else if (!music_buf.finished && !music_buf.starved) {
+			music_buf.starved = true;
+			music_buf.underruns++;
+		}
+		*finished = music_buf.finished && !music_buf.available;
+	}
+	Mutex_Unlock(music_bufMutex);
 
-static cc_result Music_Buffer(cc_int16* data, int maxSamples, struct VorbisState* ctx) {
-	int samples = 0;
-	cc_int16* cur;
-	cc_result res = 0, res2;
+	if (count) Waitable_Signal(music_bufWaitable);
+	return count;
+}
 
-	while (samples < maxSamples) {
-		if ((res = Vorbis_DecodeFrame(ctx))) break;
+static void Music_WriteSamples(const cc_int16* src, int count) {
+	int part;
+	Mutex_Lock(music_bufMutex);
+	{
+		part = min(count, music_buf.capacity - music_buf.writePos);
 
-		cur = &data[samples];
-		samples += Vorbis_OutputFrame(ctx, cur);
+		Mem_Copy(&music_buf.data[music_buf.writePos], src,        part * 2);
+		Mem_Copy(music_buf.data,                      src + part, (count - part) * 2);
+		music_buf.writePos   = (music_buf.writePos + count) % music_buf.capacity;
+		music_buf.available += count;
 	}
-	if (Audio_MusicVolume < 100) { ApplyVolume(data, samples, Audio_MusicVolume); }
+	Mutex_Unlock(music_bufMutex);
+}
 
-	res2 = Audio_QueueData(&music_ctx, data, samples * 2);
-	if (res2) { music_stopping = true; return res2; }
-	return res;
+/* Whether the decode-ahead buffer is full (or can't be filled any further) */
+static cc_bool Music_BufferFilled(void) {
+	cc_bool filled;
+	Mutex_Lock(music_bufMutex);
+	{
+		filled = music_buf.finished || music_buf.capacity - music_buf.available < music_frameSize;
+	}
+	Mutex_Unlock(music_bufMutex);
+	return filled;
 }
 
-static cc_result Music_PlayOgg(struct Stream* source) {
-	struct OggState ogg;
-	struct VorbisState vorbis = { 0 };
-	int channels, sampleRate;
+static void Music_FreeCache(void) {
+	Mem_Free(music_cache.data);
+	music_cache.data     = NULL;
+	music_cache.count    = 0;
+	music_cache.capacity = 0;
+	music_cache.max      = 0;
+}
 
-	int chunkSize, samplesPerSecond;
-	cc_int16* data = NULL;
-	int inUse, i, cur;
-	cc_result res;
+/* Appends a decoded frame to the copy of the whole track, unless the track is too long to cache */
+static void Music_CacheFrame(const cc_int16* samples, int count) {
+	int total = music_cache.count + count, capacity;
+	cc_int16* data;
+	if (!music_cache.max) return;
 
-	Ogg_Init(&ogg, source);
-	vorbis.source = &ogg;
-	if ((res = Vorbis_DecodeHeaders(&vorbis))) goto cleanup;
-	
-	channels   = vorbis.channels;
-	sampleRate = vorbis.sampleRate;
-	if ((res = Audio_SetFormat(&music_ctx, channels, sampleRate))) goto cleanup;
+	if (total > music_cache.max) { Music_FreeCache(); return; }
+	if (total > music_cache.capacity) {
+		capacity = min(max(music_cache.capacity * 2, total), music_cache.max);
+		data     = (cc_int16*)Mem_TryRealloc(music_cache.data, capacity, 2);
+
+		if (!data) { Music_FreeCache(); return; }
+		music_cache.data     = data;
+		music_cache.capacity = capacity;
+	}
+
+	Mem_Copy(&music_cache.data[music_cache.count], samples, count * 2);
+	music_cache.count = total;
+}
+
+static void Music_DecodeLoop(void) {
+	struct VorbisState* ctx = music_vorbis;
+	int samples, space;
+	cc_result res = 0;
+
+	while (!music_decodeStop) {
+		Mutex_Lock(music_bufMutex);
+		{
+			space = music_buf.capacity - music_buf.available;
+		}
+		Mutex_Unlock(music_bufMutex);
+
+		/* Wait for some samples to be played when buffer is full */
+		if (space < music_frameSize) {
+			Waitable_Wait(music_bufWaitable); continue;
+		}
 
-	/* largest possible vorbis frame decodes to blocksize1 * channels samples, */
-	/*  so can end up decoding slightly over a second of audio */
-	chunkSize        = channels * (sampleRate + vorbis.blockSizes[1]);
-	samplesPerSecond = channels * sampleRate;
+		if ((res = Vorbis_DecodeFrame(ctx))) break;
+		samples = Vorbis_OutputFrame(ctx, music_frame);
+
+		Music_CacheFrame(music_frame, samples);
+		Music_WriteSamples(music_frame, samples);
+	}
 
-	cur  = 0;
+	Mutex_Lock(music_bufMutex);
+	{
+		music_buf.res      = res == ERR_END_OF_STREAM ? 0 : res;
+		music_buf.finished = true;
+	}
+	Mutex_Unlock(music_bufMutex);
+}
+
+/* Starts decoding the given vorbis audio ahead of time on a separate thread */
+/* If cacheSecs is non-zero, tracks at most that long are also entirely kept in music_cache */
+static cc_result Music_StartDecoder(struct VorbisState* ctx, int bufferSecs, int cacheSecs) {
+	int channels   = ctx->channels;
+	int sampleRate = ctx->sampleRate;
+	cc_int16* data;
+	int capacity;
+
+	/* largest possible vorbis frame decodes to blocksize1 * channels samples */
+	music_frameSize = channels * ctx->blockSizes[1];
+	capacity        = channels * sampleRate * bufferSecs + music_frameSize;
+
+	data        = (cc_int16*)Mem_TryAlloc(capacity, 2);
+	music_frame = (cc_int16*)Mem_TryAlloc(music_frameSize, 2);
+	if (!data || !music_frame) {
+		Mem_Free(data); Mem_Free(music_frame);
+		music_frame = NULL;
+		return ERR_OUT_OF_MEMORY;
+	}
+
+	Music_ResetBuffer(data, capacity, 0);
+	music_cache.max  = channels * sampleRate * cacheSecs;
+	music_vorbis     = ctx;
+	music_decodeStop = false;
+
+	music_decoder = Thread_Create(Music_DecodeLoop);
+	Thread_Start2(music_decoder, Music_DecodeLoop);
+	return 0;
+}
+
+static void Music_StopDecoder(void) {
+	/* decoder might be waiting for space in the buffer */
+	music_decodeStop = true;
+	Waitable_Signal(music_bufWaitable);
+	Thread_Join(music_decoder);
+
+	Mem_Free(music_buf.data);
+	Mem_Free(music_frame);
+	music_buf.data = NULL;
+	music_frame    = NULL;
+	music_decoder  = NULL;
+}
+
+/* Plays the samples in music_buf as they are decoded, until the whole track has been played */
+static cc_result Music_PlayBuffer(int channels, int sampleRate) {
+	int chunkSize = channels * (sampleRate / MUSIC_CHUNKS_PER_SEC);
+	cc_int16* data;
+	cc_bool finished = false;
+	int inUse, samples, cur = 0;
+	cc_result res;
+
+	if ((res = Audio_SetFormat(&music_ctx, channels, sampleRate))) return res;
 	data = (cc_int16*)Mem_TryAlloc(chunkSize * AUDIO_MAX_BUFFERS, 2);
-	if (!data) { res = ERR_OUT_OF_MEMORY; goto cleanup; }
+	if (!data) return ERR_OUT_OF_MEMORY;
 
 	/* fill up with some samples before playing */
-	for (i = 0; i < AUDIO_MAX_BUFFERS && !res; i++) {
-		res = Music_Buffer(&data[chunkSize * cur], samplesPerSecond, &vorbis);
-		cur = (cur + 1) % AUDIO_MAX_BUFFERS;
+	while (!music_stopping && !Music_BufferFilled()) {
+		Thread_Sleep(10);
 	}
-	if (music_stopping) goto cleanup;
-
-	res  = Audio_Play(&music_ctx);
-	if (res) goto cleanup;
 
 	while (!music_stopping) {
 #ifdef CC_BUILD_ANDROID
@@ -1251,11 +1776,21 @@ static cc_result Music_PlayOgg(struct Stream* source) {
 			Thread_Sleep(10); continue;
 		}
 
-		res = Music_Buffer(&data[chunkSize * cur], samplesPerSecond, &vorbis);
+		samples = Music_ReadSamples(&data[chunkSize * cur], chunkSize, &finished);
+		if (!samples) {
+			if (finished) break;
+			Thread_Sleep(10); continue;
+		}
+
+		if (Audio_MusicVolume < 100) { ApplyVolume(&data[chunkSize * cur], samples, Audio_MusicVolume); }
+		res = Audio_QueueData(&music_ctx, &data[chunkSize * cur], samples * 2);
+		if (res) { music_stopping = true; break; }
 		cur = (cur + 1) % AUDIO_MAX_BUFFERS;
 
-		/* need to specially handle last bit of audio */
-		if (res) break;
+		/* need to start playing again if all the queued audio ran out */
+		if (inUse) continue;
+		res = Audio_Play(&music_ctx);
+		if (res) { music_stopping = true; break; }
 	}
 
 	if (music_stopping) {
@@ -1271,10 +1806,48 @@ static cc_result Music_PlayOgg(struct Stream* source) {
 		}
 	}
 
-cleanup:
 	Mem_Free(data);
+	return res;
+}
+
+static cc_result Music_PlayOgg(struct Stream* source, struct AudioData* cached) {
+	struct OggState ogg;
+	struct VorbisState vorbis = { 0 };
+	cc_result res;
+
+	Ogg_Init(&ogg, source);
+	vorbis.source = &ogg;
+	if ((res = Vorbis_DecodeHeaders(&vorbis))) goto cleanup;
+
+	res = Music_StartDecoder(&vorbis, music_bufferSecs, cached ? music_cacheSecs : 0);
+	if (res) goto cleanup;
+
+	res = Music_PlayBuffer(vorbis.channels, vorbis.sampleRate);
+	Music_StopDecoder();
+	if (!res) res = music_buf.res;
+
+	/* keep the decoded samples around if the whole track was decoded */
+	if (!res && !music_stopping && music_cache.data) {
+		cached->data       = music_cache.data;
+		cached->size       = music_cache.count * 2;
+		cached->channels   = vorbis.channels;
+		cached->sampleRate = vorbis.sampleRate;
+		cached->volume     = 100;
+		cached->rate       = 100;
+		music_cache.data   = NULL;
+	}
+
+cleanup:
+	Music_FreeCache();
 	Vorbis_Free(&vorbis);
-	return res == ERR_END_OF_STREAM ? 0 : res;
+	return res;
+}
+
+static cc_result Music_PlayCached(struct AudioData* data) {
+	/* the whole track is already decoded, so just play directly from the cached samples */
+	Music_ResetBuffer((cc_int16*)data->data, data->size / 2, data->size / 2);
+	music_buf.finished = true;
+	return Music_PlayBuffer(data->channels, data->sampleRate);
 }
 
 static void Music_AddFile(const cc_string* path, void* obj) {
@@ -1287,10 +1860,11 @@ static void Music_AddFile(const cc_string* path, void* obj) {
 
 static void Music_RunLoop(void) {
 	struct StringsBuffer files;
+	struct AudioData* cached = NULL;
 	cc_string path;
 	RNGState rnd;
 	struct Stream stream;
-	int idx, delay;
+	int i, idx, delay;
 	cc_result res = 0;
 
 	StringsBuffer_SetLengthBits(&files, STRINGSBUFFER_DEF_LEN_SHIFT);
@@ -1299,21 +1873,33 @@ static void Music_RunLoop(void) {
 
 	Random_SeedFromCurrentTime(&rnd);
 	Audio_Init(&music_ctx, AUDIO_MAX_BUFFERS);
+	if (music_cacheSecs && files.count) {
+		cached = (struct AudioData*)Mem_TryAllocCleared(files.count, sizeof(struct AudioData));
+	}
 
 	while (!music_stopping && files.count) {
 		idx  = Random_Next(&rnd, files.count);
 		path = StringsBuffer_UNSAFE_Get(&files, idx);
-		Platform_Log1("playing music file: %s", &path);
 
-		res = Stream_OpenFile(&stream, &path);
-		if (res) { Logger_SysWarn2(res, "opening", &path); break; }
+		if (cached && cached[idx].data) {
+			Platform_Log1("playing cached music file: %s", &path);
+			res = Music_PlayCached(&cached[idx]);
+			if (res) { Logger_SimpleWarn2(res, "playing", &path); }
+		} else {
+			Platform_Log1("playing music file: %s", &path);
+			res = Stream_OpenFile(&stream, &path);
+			if (res) { Logger_SysWarn2(res, "opening", &path); break; }
 
-		res = Music_PlayOgg(&stream);
-		if (res) { Logger_SimpleWarn2(res, "playing", &path); }
+			res = Music_PlayOgg(&stream, cached ? &cached[idx] : NULL);
+			if (res) { Logger_SimpleWarn2(res, "playing", &path); }
 
-		/* No point logging error for closing readonly file */
-		(void)stream.Close(&stream);
+			/* No point logging error for closing readonly file */
+			(void)stream.Close(&stream);
+		}
 
+		if (!res && music_buf.underruns) {
+			Platform_Log2("music ran out of decoded audio %i times while playing %s", &music_buf.underruns, &path);
+		}
 		if (music_stopping) break;
 		delay = Random_Range(&rnd, music_minDelay, music_maxDelay);
 		Waitable_WaitFor(music_waitable, delay);
@@ -1324,6 +1910,11 @@ static void Music_RunLoop(void) {
 		Audio_MusicVolume = 0;
 	}
 	Audio_Close(&music_ctx);
+
+	for (i = 0; cached && i < files.count; i++) {
+		Mem_Free(cached[i].data);
+	}
+	Mem_Free(cached);
 	StringsBuffer_Clear(&files);
 
 	if (music_joining) return;
@@ -1362,6 +1953,11 @@ static void Music_Init(void) {
 	music_maxDelay = Options_GetInt(OPT_MAX_MUSIC_DELAY, 0, 3600, 420) * MILLIS_PER_SEC;
 	music_waitable = Waitable_Create();
 
+	music_bufferSecs  = Options_GetInt(OPT_MUSIC_BUFFER, 1, 60,  5);
+	music_cacheSecs   = Options_GetInt(OPT_MUSIC_CACHE,  0, 600, 0);
+	music_bufMutex    = Mutex_Create();
+	music_bufWaitable = Waitable_Create();
+
 	volume = Options_GetInt(OPT_MUSIC_VOLUME, 0, 100, DEFAULT_MUSIC_VOLUME);
 	Audio_SetMusic(volume);
 }
@@ -1369,6 +1965,8 @@ static void Music_Init(void) {
 static void Music_Free(void) {
 	Music_Stop();
 	Waitable_Free(music_waitable);
+	Mutex_Free(music_bufMutex);
+	Waitable_Free(music_bufWaitable);
 }
 #endif
 
@@ -1,4 +1,11 @@
 #include "Bitmap.h"
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PNG_SSE2
+#elif defined __ARM_NEON
+#include <arm_neon.h>
+#define PNG_NEON
+#endif
 #include "Platform.h"
 #include "ExtMath.h"
 #include "Deflate.h"
@@ -85,24 +92,16 @@ cc_bool Png_Detect(const cc_uint8* data, cc_uint32 len) {
 	return len >= PNG_SIG_SIZE && Mem_Equal(data, pngSig, PNG_SIG_SIZE);
 }
 
-static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
+/* Generic byte by byte reconstruction, for any number of bytes per pixel */
+static void Png_ReconstructBytes(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
 	cc_uint32 i, j;
 	switch (type) {
-	case PNG_FILTER_NONE:
-		return;
-
 	case PNG_FILTER_SUB:
 		for (i = bytesPerPixel, j = 0; i < lineLen; i++, j++) {
 			line[i] += line[j];
 		}
 		return;
 
-	case PNG_FILTER_UP:
-		for (i = 0; i < lineLen; i++) {
-			line[i] += prior[i];
-		}
-		return;
-
 	case PNG_FILTER_AVERAGE:
 		for (i = 0; i < bytesPerPixel; i++) {
 			line[i] += (prior[i] >> 1);
@@ -113,7 +112,6 @@ static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* lin
 		return;
 
 	case PNG_FILTER_PAETH:
-		/* TODO: verify this is right */
 		for (i = 0; i < bytesPerPixel; i++) {
 			line[i] += prior[i];
 		}
@@ -132,6 +130,98 @@ static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* lin
 	}
 }
 
+static void Png_ReconstructUp(cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
+	cc_uint32 i = 0;
+#if defined PNG_SSE2
+	for (; i + 16 <= lineLen; i += 16) {
+		__m128i cur = _mm_loadu_si128((const __m128i*)&line[i]);
+		__m128i up  = _mm_loadu_si128((const __m128i*)&prior[i]);
+		_mm_storeu_si128((__m128i*)&line[i], _mm_add_epi8(cur, up));
+	}
+#elif defined PNG_NEON
+	for (; i + 16 <= lineLen; i += 16) {
+		vst1q_u8(&line[i], vaddq_u8(vld1q_u8(&line[i]), vld1q_u8(&prior[i])));
+	}
+#endif
+	for (; i < lineLen; i++) { line[i] += prior[i]; }
+}
+
+#ifdef PNG_SSE2
+/* Sub/Average/Paeth depend on the previous pixel, so each pixel is reconstructed in turn, */
+/*  but all of the 3 or 4 samples in a pixel are reconstructed at once (as 16 bit lanes for Paeth) */
+#define Png_Load3(p)     _mm_cvtsi32_si128((p)[0] | ((p)[1] << 8) | ((p)[2] << 16))
+#define Png_Load4(p)     _mm_cvtsi32_si128((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((cc_uint32)(p)[3] << 24))
+#define Png_Store3(p, v) { int v_ = _mm_cvtsi128_si32(v); (p)[0] = v_; (p)[1] = v_ >> 8; (p)[2] = v_ >> 16; }
+#define Png_Store4(p, v) { int v_ = _mm_cvtsi128_si32(v); (p)[0] = v_; (p)[1] = v_ >> 8; (p)[2] = v_ >> 16; (p)[3] = v_ >> 24; }
+
+#define PNG_SSE2_RECONSTRUCT(bpp, load, store) \
+static void Png_Reconstruct##bpp(cc_uint8 type, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) { \
+	__m128i zero = _mm_setzero_si128(), one = _mm_set1_epi8(1); \
+	__m128i a = zero, b, c = zero, d, pa, pb, pc, smallest, nearest; \
+	cc_uint32 i; \
+	\
+	switch (type) { \
+	case PNG_FILTER_SUB: \
+		for (i = 0; i < lineLen; i += bpp) { \
+			a = _mm_add_epi8(load(&line[i]), a); store(&line[i], a); \
+		} \
+		return; \
+	\
+	case PNG_FILTER_AVERAGE: \
+		for (i = 0; i < lineLen; i += bpp) { \
+			/* (a + b) >> 1 is the rounded up average, minus 1 when a + b is odd */ \
+			b = load(&prior[i]); \
+			d = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one)); \
+			a = _mm_add_epi8(load(&line[i]), d); store(&line[i], a); \
+		} \
+		return; \
+	\
+	case PNG_FILTER_PAETH: \
+		for (i = 0; i < lineLen; i += bpp) { \
+			b = _mm_unpacklo_epi8(load(&prior[i]), zero); \
+			d = _mm_unpacklo_epi8(load(&line[i]),  zero); \
+			\
+			/* p - a = b - c, p - b = a - c, p - c = (b - c) + (a - c) */ \
+			pa = _mm_sub_epi16(b, c); pb = _mm_sub_epi16(a, c); pc = _mm_add_epi16(pa, pb); \
+			pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa)); \
+			pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb)); \
+			pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc)); \
+			smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb)); \
+			\
+			/* a if pa is smallest, otherwise b if pb is smallest, otherwise c */ \
+			pb = _mm_cmpeq_epi16(pb, smallest); \
+			nearest = _mm_or_si128(_mm_and_si128(pb, b), _mm_andnot_si128(pb, c)); \
+			pa = _mm_cmpeq_epi16(pa, smallest); \
+			nearest = _mm_or_si128(_mm_and_si128(pa, a), _mm_andnot_si128(pa, nearest)); \
+			\
+			/* lanes are 16 bit, but only the lower 8 bits matter */ \
+			a = _mm_and_si128(_mm_add_epi16(d, nearest), _mm_set1_epi16(0xFF)); \
+			c = b; \
+			store(&line[i], _mm_packus_epi16(a, a)); \
+		} \
+		return; \
+	} \
+}
+PNG_SSE2_RECONSTRUCT(3, Png_Load3, Png_Store3)
+PNG_SSE2_RECONSTRUCT(4, Png_Load4, Png_Store4)
+#endif
+
+static void Png_Reconstruct(cc_uint8 type, cc_uint8 bytesPerPixel, cc_uint8* line, cc_uint8* prior, cc_uint32 lineLen) {
+	switch (type) {
+	case PNG_FILTER_NONE:
+		return;
+	case PNG_FILTER_UP:
+		Png_ReconstructUp(line, prior, lineLen); return;
+	}
+
+#ifdef PNG_SSE2
+	/* 8 bit RGB and RGBA are by far the most common formats */
+	if (bytesPerPixel == 3) { Png_Reconstruct3(type, line, prior, lineLen); return; }
+	if (bytesPerPixel == 4) { Png_Reconstruct4(type, line, prior, lineLen); return; }
+#endif
+	Png_ReconstructBytes(type, bytesPerPixel, line, prior, lineLen);
+}
+
 #define Bitmap_Set(dst, r,g,b,a) dst = BitmapCol_Make(r, g, b, a);
 
 #define PNG_Do_Grayscale(dstI, src, scale)  rgb = (src) * scale; Bitmap_Set(dst[dstI], rgb, rgb, rgb, 255);
@@ -184,10 +274,36 @@ static void Png_Expand_GRAYSCALE_16(int width, BitmapCol* palette, cc_uint8* src
 	}
 }
 
+#ifdef PNG_SSE2
+/* Converts 4 pixels stored as R,G,B,A bytes into native BitmapCol order */
+static CC_INLINE __m128i Png_RGBAToNative(__m128i x) {
+#if BITMAPCOLOR_R_SHIFT == 0 && BITMAPCOLOR_B_SHIFT == 16
+	return x;
+#else
+	__m128i ga = _mm_and_si128(x, _mm_set1_epi32(0xFF00FF00));
+	__m128i rb = _mm_and_si128(x, _mm_set1_epi32(0x00FF00FF));
+	/* swap R and B (only BGRA is supported) */
+	rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+	return _mm_or_si128(ga, rb);
+#endif
+}
+#endif
+
 static void Png_Expand_RGB_8(int width, BitmapCol* palette, cc_uint8* src, BitmapCol* dst) {
-	int i, j;
+	int i = 0, j = 0;
+#ifdef PNG_SSE2
+	__m128i alpha = _mm_set1_epi32(BITMAPCOLOR_A_MASK), x, lo, hi;
+	/* Reads 16 bytes at a time, so stop before reading past the end of the row */
+	for (; i + 6 <= width; i += 4, j += 12) {
+		x  = _mm_loadu_si128((const __m128i*)&src[j]);
+		lo = _mm_unpacklo_epi32(x, _mm_srli_si128(x, 3));
+		hi = _mm_unpacklo_epi32(_mm_srli_si128(x, 6), _mm_srli_si128(x, 9));
+		x  = _mm_and_si128(_mm_unpacklo_epi64(lo, hi), _mm_set1_epi32(0x00FFFFFF));
+		_mm_storeu_si128((__m128i*)&dst[i], _mm_or_si128(Png_RGBAToNative(x), alpha));
+	}
+#endif
 
-	for (i = 0, j = 0; i < (width & ~0x03); i += 4, j += 12) {
+	for (; i < (width & ~0x03); i += 4, j += 12) {
 		PNG_Do_RGB__8(i    , j    ); PNG_Do_RGB__8(i + 1, j + 3);
 		PNG_Do_RGB__8(i + 2, j + 6); PNG_Do_RGB__8(i + 3, j + 9);
 	}
@@ -251,9 +367,15 @@ static void Png_Expand_GRAYSCALE_A_16(int width, BitmapCol* palette, cc_uint8* s
 }
 
 static void Png_Expand_RGB_A_8(int width, BitmapCol* palette, cc_uint8* src, BitmapCol* dst) {
-	int i, j;
+	int i = 0, j = 0;
+#ifdef PNG_SSE2
+	for (; i + 4 <= width; i += 4, j += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i*)&src[j]);
+		_mm_storeu_si128((__m128i*)&dst[i], Png_RGBAToNative(x));
+	}
+#endif
 
-	for (i = 0, j = 0; i < (width & ~0x3); i += 4, j += 16) {
+	for (; i < (width & ~0x3); i += 4, j += 16) {
 		PNG_Do_RGB_A__8(i    , j    ); PNG_Do_RGB_A__8(i + 1, j + 4 );
 		PNG_Do_RGB_A__8(i + 2, j + 8); PNG_Do_RGB_A__8(i + 3, j + 12);
 	}
@@ -330,6 +452,55 @@ static void ComputeTransparency(struct Bitmap* bmp, BitmapCol col) {
 /* Need to store both current and prior row, per PNG specification. */
 #define PNG_BUFFER_SIZE ((PNG_MAX_DIMS * 2 * 4 + 1) * 2)
 
+static cc_result PngDecoded_Read(struct Stream* s, cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct Stream* source = ((struct PngDecodedState*)s->Meta.Inflate)->source;
+	return source->Read(source, data, count, modified);
+}
+static cc_result PngDecoded_Skip(struct Stream* s, cc_uint32 count) {
+	struct Stream* source = ((struct PngDecodedState*)s->Meta.Inflate)->source;
+	return source->Skip(source, count);
+}
+static cc_result PngDecoded_Seek(struct Stream* s, cc_uint32 position) {
+	struct Stream* source = ((struct PngDecodedState*)s->Meta.Inflate)->source;
+	return source->Seek(source, position);
+}
+static cc_result PngDecoded_Position(struct Stream* s, cc_uint32* position) {
+	struct Stream* source = ((struct PngDecodedState*)s->Meta.Inflate)->source;
+	return source->Position(source, position);
+}
+static cc_result PngDecoded_Length(struct Stream* s, cc_uint32* length) {
+	struct Stream* source = ((struct PngDecodedState*)s->Meta.Inflate)->source;
+	return source->Length(source, length);
+}
+
+void Png_MakeDecodedStream(struct Stream* stream, struct PngDecodedState* state, struct Stream* source) {
+	Stream_Init(stream);
+	state->source        = source;
+	stream->Meta.Inflate = state;
+
+	stream->Read     = PngDecoded_Read;
+	stream->Skip     = PngDecoded_Skip;
+	stream->Seek     = PngDecoded_Seek;
+	stream->Position = PngDecoded_Position;
+	stream->Length   = PngDecoded_Length;
+}
+
+/* Takes the already decoded bitmap, if the stream was made by Png_MakeDecodedStream */
+static cc_bool PngDecoded_Take(struct Bitmap* bmp, struct Stream* stream, cc_result* res) {
+	struct PngDecodedState* state;
+	if (stream->Read != PngDecoded_Read) return false;
+
+	state = (struct PngDecodedState*)stream->Meta.Inflate;
+	/* Already taken, so just decode the data again */
+	if (!state->decoded) return false;
+
+	*bmp = state->bmp;
+	*res = state->res;
+	state->bmp.scan0 = NULL;
+	state->decoded   = false;
+	return true;
+}
+
 /* TODO: Test a lot of .png files and ensure output is right */
 cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 	cc_uint8 tmp[PNG_PALETTE * 3];
@@ -360,6 +531,7 @@ cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream) {
 
 	bmp->width = 0; bmp->height = 0;
 	bmp->scan0 = NULL;
+	if (PngDecoded_Take(bmp, stream, &res)) return res;
 
 	res = Stream_Read(stream, tmp, PNG_SIG_SIZE);
 	if (res) return res;
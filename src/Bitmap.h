@@ -85,6 +85,13 @@ typedef BitmapCol* (*Png_RowGetter)(struct Bitmap* bmp, int row);
      https://github.com/nothings/stb/blob/master/stb_image.h
 */
 CC_API cc_result Png_Decode(struct Bitmap* bmp, struct Stream* stream);
+
+/* State for PNG data that has already been decoded (e.g. on a background thread) */
+struct PngDecodedState { struct Stream* source; struct Bitmap bmp; cc_result res; cc_bool decoded; };
+/* Wraps a stream of PNG data, so that Png_Decode on the wrapped stream returns the already decoded */
+/*  bitmap and result in state, instead of decoding the data again. Reads still read from source. */
+/* NOTE: Png_Decode takes ownership of state->bmp, so bmp.scan0 must be freed if Png_Decode was never called */
+void Png_MakeDecodedStream(struct Stream* stream, struct PngDecodedState* state, struct Stream* source);
 /* Encodes a bitmap in PNG format. */
 /* getRow is optional. Can be used to modify how rows are encoded. (e.g. flip image) */
 /* if alpha is non-zero, RGBA channels are saved, otherwise only RGB channels are. */
@@ -13,96 +13,175 @@
 #include "Logger.h"
 #include "Vectors.h"
 #include "Chat.h"
-
-/* Data for a resizable queue, used for liquid physic tick entries. */
-struct TickQueue {
-	cc_uint32* entries; /* Buffer holding the items in the tick queue */
-	int capacity; /* Max number of elements in the buffer */
-	int mask;     /* capacity - 1, as capacity is always a power of two */
-	int count;    /* Number of used elements */
-	int head;     /* Head index into the buffer */
-	int tail;     /* Tail index into the buffer */
+#include "WorkerPool.h"
+
+/* Small pages waste less space at the end of each tick list (256 byte pages on 64 bit platforms) */
+#define TICKPAGE_ENTRIES 60
+/* Fixed size page of entries in a tick list */
+struct TickPage {
+	struct TickPage* next;
+	int count;
+	cc_uint32 entries[TICKPAGE_ENTRIES];
 };
+/* List of the world indices of blocks to tick, made from pages that are shared by all tick lists. */
+/* Unlike a resizable buffer, growing never copies the entries or reserves more space than is needed. */
+struct TickList {
+	struct TickPage* head;
+	struct TickPage* tail;
+	int count;
+};
+static struct TickPage* freePages;
+static int pagesCount;
+
+/* Appends an entry to the end of the list, taking a page from the free pages if necessary. */
+static void TickList_Add(struct TickList* list, cc_uint32 index) {
+	struct TickPage* page = list->tail;
+
+	if (!page || page->count == TICKPAGE_ENTRIES) {
+		if (freePages) {
+			page      = freePages;
+			freePages = page->next;
+		} else {
+			page = (struct TickPage*)Mem_Alloc(1, sizeof(struct TickPage), "physics tick page");
+			pagesCount++;
+		}
+		page->next  = NULL;
+		page->count = 0;
 
-static void TickQueue_Init(struct TickQueue* queue) {
-	queue->entries  = NULL;
-	queue->capacity = 0;
-	queue->mask  = 0;
-	queue->count = 0;
-	queue->head  = 0;
-	queue->tail  = 0;
-}
-
-static void TickQueue_Clear(struct TickQueue* queue) {
-	if (!queue->entries) return;
-	Mem_Free(queue->entries);
-	TickQueue_Init(queue);
+		if (list->tail) { list->tail->next = page; } else { list->head = page; }
+		list->tail = page;
+	}
+	page->entries[page->count++] = index;
+	list->count++;
 }
 
-static void TickQueue_Resize(struct TickQueue* queue) {
-	cc_uint32* entries;
-	int i, idx, capacity;
-
-	if (queue->capacity >= (Int32_MaxValue / 4)) {
-		Chat_AddRaw("&cToo many physics entries, clearing");
-		TickQueue_Clear(queue);
-	}
+/* Empties the list, returning all of its pages to the free pages. */
+static void TickList_Reset(struct TickList* list) {
+	if (!list->head) return;
+	list->tail->next = freePages;
+	freePages = list->head;
 
-	capacity = queue->capacity * 2;
-	if (capacity < 32) capacity = 32;
-	entries = (cc_uint32*)Mem_Alloc(capacity, 4, "physics tick queue");
+	list->head  = NULL;
+	list->tail  = NULL;
+	list->count = 0;
+}
 
-	/* Elements must be readjusted to avoid index wrapping issues */
-	/* https://stackoverflow.com/questions/55343683/resizing-of-the-circular-queue-using-dynamic-array */
-	for (i = 0; i < queue->count; i++) {
-		idx = (queue->head + i) & queue->mask;
-		entries[i] = queue->entries[idx];
+static void TickPages_Free(void) {
+	struct TickPage* page;
+	while ((page = freePages)) {
+		freePages = page->next;
+		Mem_Free(page);
 	}
-	Mem_Free(queue->entries);
-
-	queue->entries  = entries;
-	queue->capacity = capacity;
-	queue->mask     = capacity - 1; /* capacity is power of two */
-	queue->head = 0;
-	queue->tail = queue->count;
+	pagesCount = 0;
 }
 
-/* Appends an entry to the end of the queue, resizing if necessary. */
-static void TickQueue_Enqueue(struct TickQueue* queue, cc_uint32 item) {
-	if (queue->count == queue->capacity)
-		TickQueue_Resize(queue);
 
-	queue->entries[queue->tail] = item;
-	queue->tail = (queue->tail + 1) & queue->mask;
-	queue->count++;
-}
-
-/* Retrieves the entry from the front of the queue. */
-static cc_uint32 TickQueue_Dequeue(struct TickQueue* queue) {
-	cc_uint32 result = queue->entries[queue->head];
-	queue->head = (queue->head + 1) & queue->mask;
-	queue->count--;
-	return result;
-}
+/* Neighbour that liquid at src could flow into, found while ticking a region's queue */
+struct PhysicsFlow { int src, dst; };
+/* Data for a resizable list of flows */
+struct FlowList {
+	struct PhysicsFlow* flows;
+	int count, capacity;
+};
 
+static void FlowList_Add(struct FlowList* list, int src, int dst) {
+	if (list->count == list->capacity) {
+		list->capacity = max(32, list->capacity * 2);
+		list->flows    = (struct PhysicsFlow*)Mem_Realloc(list->flows, list->capacity,
+															sizeof(struct PhysicsFlow), "physics flows");
+	}
+	list->flows[list->count].src = src;
+	list->flows[list->count].dst = dst;
+	list->count++;
+}
+
+static void FlowList_Clear(struct FlowList* list) {
+	Mem_Free(list->flows);
+	list->flows    = NULL;
+	list->count    = 0;
+	list->capacity = 0;
+}
+
+/* The world is split into regions of columns of chunks, which each have their own tick queues. */
+/* Liquid physics is then ticked in two steps: */
+/*  1) The tick queue of each region is ticked by itself (on worker threads, if there are any) */
+/*     This only reads the world, and records which neighbours the liquid could flow into */
+/*  2) The flows are checked again and applied on the main thread, in order of region */
+/* Since the world does not change in step 1, results are the same for any number of threads */
+/* Liquids are ticked after a delay, so each region has a timing wheel of tick lists, with */
+/*  the list for a liquid tick found from its number modulo the number of lists in the wheel */
+#define PHYSICS_REGION_SHIFT 6
+#define PHYSICS_WHEEL_SIZE 32
+#define PHYSICS_WHEEL_MASK (PHYSICS_WHEEL_SIZE - 1)
+struct PhysicsRegion {
+	struct TickList lavaQ[PHYSICS_WHEEL_SIZE], waterQ[PHYSICS_WHEEL_SIZE];
+	struct FlowList lavaFlows, waterFlows;
+	RNGState rnd; /* Used for random block ticks in this region */
+};
 
 struct Physics_ Physics;
 static RNGState physics_rnd;
 static int physics_tickCount;
 static int physics_maxWaterX, physics_maxWaterY, physics_maxWaterZ;
-static struct TickQueue lavaQ, waterQ;
+static struct PhysicsRegion* regions;
+static int regionsX, regionsZ, regionsCount;
+static cc_uint32 physics_liquidTick; /* Number of the next liquid tick */
+
+/* NOTE: Delays must be less than PHYSICS_WHEEL_SIZE - 1 */
+#define PHYSICS_ONE_DELAY    1
+#define PHYSICS_LAVA_DELAY  30
+#define PHYSICS_WATER_DELAY  5
+
+static struct PhysicsRegion* Physics_GetRegion(int index) {
+	int x = index % World.Width;
+	int z = (index / World.Width) % World.Length;
+	return &regions[(z >> PHYSICS_REGION_SHIFT) * regionsX + (x >> PHYSICS_REGION_SHIFT)];
+}
+
+static void Physics_FreeRegions(void) {
+	int i, j;
+	for (i = 0; i < regionsCount; i++) {
+		for (j = 0; j < PHYSICS_WHEEL_SIZE; j++) {
+			TickList_Reset(&regions[i].lavaQ[j]);
+			TickList_Reset(&regions[i].waterQ[j]);
+		}
+		FlowList_Clear(&regions[i].lavaFlows);
+		FlowList_Clear(&regions[i].waterFlows);
+	}
+	TickPages_Free();
+	Mem_Free(regions);
+	regions      = NULL;
+	regionsCount = 0;
+}
+
+/* Each region's random number generator is seeded from physics_rnd, so ticks only depend on its seed */
+static void Physics_InitRegions(void) {
+	int i;
+	Physics_FreeRegions();
+	regionsX     = (World.Width  + (1 << PHYSICS_REGION_SHIFT) - 1) >> PHYSICS_REGION_SHIFT;
+	regionsZ     = (World.Length + (1 << PHYSICS_REGION_SHIFT) - 1) >> PHYSICS_REGION_SHIFT;
+	regionsCount = regionsX * regionsZ;
+	physics_liquidTick = 0;
+	if (!regionsCount) return;
+
+	regions = (struct PhysicsRegion*)Mem_AllocCleared(regionsCount, sizeof(struct PhysicsRegion), "physics regions");
+	for (i = 0; i < regionsCount; i++) {
+		Random_Seed(&regions[i].rnd, Random_Next(&physics_rnd, Int32_MaxValue));
+	}
+}
+
+/* Delayed ticks are scheduled by adding them to the list that will be ticked after the delay */
+static void Physics_EnqueueLava(int index, int delay) {
+	int slot = (physics_liquidTick + delay) & PHYSICS_WHEEL_MASK;
+	TickList_Add(&Physics_GetRegion(index)->lavaQ[slot], index);
+}
 
-#define PHYSICS_DELAY_MASK 0xF8000000UL
-#define PHYSICS_POS_MASK   0x07FFFFFFUL
-#define PHYSICS_DELAY_SHIFT 27
-#define PHYSICS_ONE_DELAY   (1U << PHYSICS_DELAY_SHIFT)
-#define PHYSICS_LAVA_DELAY (30U << PHYSICS_DELAY_SHIFT)
-#define PHYSICS_WATER_DELAY (5U << PHYSICS_DELAY_SHIFT)
+static void Physics_EnqueueWater(int index, int delay) {
+	int slot = (physics_liquidTick + delay) & PHYSICS_WHEEL_MASK;
+	TickList_Add(&Physics_GetRegion(index)->waterQ[slot], index);
+}
 
 static void Physics_OnNewMapLoaded(void* obj) {
-	TickQueue_Clear(&lavaQ);
-	TickQueue_Clear(&waterQ);
-
 	physics_maxWaterX = World.MaxX - 2;
 	physics_maxWaterY = World.MaxY - 2;
 	physics_maxWaterZ = World.MaxZ - 2;
@@ -110,6 +189,7 @@ static void Physics_OnNewMapLoaded(void* obj) {
 	Tree_Blocks = World.Blocks;
 	Random_SeedFromCurrentTime(&physics_rnd);
 	Tree_Rnd = &physics_rnd;
+	Physics_InitRegions();
 }
 
 void Physics_SetEnabled(cc_bool enabled) {
@@ -162,34 +242,36 @@ void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now) {
 	Physics_ActivateNeighbours(x, y, z, index);
 }
 
-static void Physics_TickRandomBlocks(void) {
+static void Physics_TickRandomBlocks(struct PhysicsRegion* r, int minX, int minZ) {
 	int lo, hi, index;
 	BlockID block;
 	PhysicsHandler tick;
 	int x, y, z, x2, y2, z2;
+	int maxX = min(World.Width,  minX + (1 << PHYSICS_REGION_SHIFT));
+	int maxZ = min(World.Length, minZ + (1 << PHYSICS_REGION_SHIFT));
 
 	for (y = 0; y < World.Height; y += CHUNK_SIZE) {
 		y2 = min(y + CHUNK_MAX, World.MaxY);
-		for (z = 0; z < World.Length; z += CHUNK_SIZE) {
+		for (z = minZ; z < maxZ; z += CHUNK_SIZE) {
 			z2 = min(z + CHUNK_MAX, World.MaxZ);
-			for (x = 0; x < World.Width; x += CHUNK_SIZE) {
+			for (x = minX; x < maxX; x += CHUNK_SIZE) {
 				x2 = min(x + CHUNK_MAX, World.MaxX);
 
 				/* Inlined 3 random ticks for this chunk */
 				lo = World_Pack( x,  y,  z);
 				hi = World_Pack(x2, y2, z2);
 				
-				index = Random_Range(&physics_rnd, lo, hi);
+				index = Random_Range(&r->rnd, lo, hi);
 				block = World.Blocks[index];
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 
-				index = Random_Range(&physics_rnd, lo, hi);
+				index = Random_Range(&r->rnd, lo, hi);
 				block = World.Blocks[index];
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
 
-				index = Random_Range(&physics_rnd, lo, hi);
+				index = Random_Range(&r->rnd, lo, hi);
 				block = World.Blocks[index];
 				tick = Physics.OnRandomTick[block];
 				if (tick) tick(index, block);
@@ -198,7 +280,6 @@ static void Physics_TickRandomBlocks(void) {
 	}
 }
 
-
 static void Physics_DoFalling(int index, BlockID block) {
 	int found = -1, start = index;
 	BlockID other;
@@ -224,18 +305,6 @@ static void Physics_DoFalling(int index, BlockID block) {
 	Physics_ActivateNeighbours(x, y, z, start);
 }
 
-static cc_bool Physics_CheckItem(struct TickQueue* queue, int* posIndex) {
-	cc_uint32 item = TickQueue_Dequeue(queue);
-	*posIndex     = (int)(item & PHYSICS_POS_MASK);
-
-	if (item >= PHYSICS_ONE_DELAY) {
-		item -= PHYSICS_ONE_DELAY;
-		TickQueue_Enqueue(queue, item);
-		return false;
-	}
-	return true;
-}
-
 
 static void Physics_HandleSapling(int index, BlockID block) {
 	IVec3 coords[TREE_MAX_COUNT];
@@ -322,7 +391,11 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 
 
 static void Physics_PlaceLava(int index, BlockID block) {
-	TickQueue_Enqueue(&lavaQ, PHYSICS_LAVA_DELAY | index);
+	Physics_EnqueueLava(index, PHYSICS_LAVA_DELAY);
+}
+
+static cc_bool Physics_CanLavaFlow(BlockID block) {
+	return block == BLOCK_WATER || block == BLOCK_STILL_WATER || Blocks.Collide[block] == COLLIDE_NONE;
 }
 
 static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
@@ -330,7 +403,7 @@ static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
 	if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
 		Game_UpdateBlock(x, y, z, BLOCK_STONE);
 	} else if (Blocks.Collide[block] == COLLIDE_NONE) {
-		TickQueue_Enqueue(&lavaQ, PHYSICS_LAVA_DELAY | posIndex);
+		Physics_EnqueueLava(posIndex, PHYSICS_LAVA_DELAY);
 		Game_UpdateBlock(x, y, z, BLOCK_LAVA);
 	}
 }
@@ -346,45 +419,74 @@ static void Physics_ActivateLava(int index, BlockID block) {
 	if (y > 0)          Physics_PropagateLava(index - World.OneY, x, y - 1, z);
 }
 
-static void Physics_TickLava(void) {
-	int i, count = lavaQ.count;
-	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&lavaQ, &index)) {
-			BlockID block = World.Blocks[index];
+/* Same as Physics_ActivateLava, except that only which neighbours the lava could flow into is recorded */
+static void Physics_FindLavaFlows(struct FlowList* list, int index) {
+	int x, y, z;
+	World_Unpack(index, x, y, z);
+
+	if (x > 0          && Physics_CanLavaFlow(World.Blocks[index - 1]))           FlowList_Add(list, index, index - 1);
+	if (x < World.MaxX && Physics_CanLavaFlow(World.Blocks[index + 1]))           FlowList_Add(list, index, index + 1);
+	if (z > 0          && Physics_CanLavaFlow(World.Blocks[index - World.Width])) FlowList_Add(list, index, index - World.Width);
+	if (z < World.MaxZ && Physics_CanLavaFlow(World.Blocks[index + World.Width])) FlowList_Add(list, index, index + World.Width);
+	if (y > 0          && Physics_CanLavaFlow(World.Blocks[index - World.OneY]))  FlowList_Add(list, index, index - World.OneY);
+}
+
+static void Physics_TickLava(struct PhysicsRegion* r) {
+	struct TickPage* page = r->lavaQ[physics_liquidTick & PHYSICS_WHEEL_MASK].head;
+	int i, index;
+	BlockID block;
+
+	for (; page; page = page->next) {
+		for (i = 0; i < page->count; i++) {
+			index = page->entries[i];
+			block = World.Blocks[index];
 			if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
-			Physics_ActivateLava(index, block);
+			Physics_FindLavaFlows(&r->lavaFlows, index);
 		}
 	}
 }
 
 
 static void Physics_PlaceWater(int index, BlockID block) {
-	TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | index);
+	Physics_EnqueueWater(index, PHYSICS_WATER_DELAY);
 }
 
-static void Physics_PropagateWater(int posIndex, int x, int y, int z) {
-	BlockID block = World.Blocks[posIndex];
+static cc_bool Physics_IsNearSponge(int x, int y, int z) {
 	int xx, yy, zz;
+	for (yy = (y < 2 ? 0 : y - 2); yy <= (y > physics_maxWaterY ? World.MaxY : y + 2); yy++) {
+		for (zz = (z < 2 ? 0 : z - 2); zz <= (z > physics_maxWaterZ ? World.MaxZ : z + 2); zz++) {
+			for (xx = (x < 2 ? 0 : x - 2); xx <= (x > physics_maxWaterX ? World.MaxX : x + 2); xx++) {
+				if (World_GetBlock(xx, yy, zz) == BLOCK_SPONGE) return true;
+			}
+		}
+	}
+	return false;
+}
+
+static cc_bool Physics_CanWaterFlow(int posIndex, int x, int y, int z) {
+	BlockID block = World.Blocks[posIndex];
+	if (block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) return true;
+	return Blocks.Collide[block] == COLLIDE_NONE && block != BLOCK_ROPE && !Physics_IsNearSponge(x, y, z);
+}
+
+/* NOTE: Sponges must have already been checked for */
+static void Physics_FlowWater(int posIndex, int x, int y, int z) {
+	BlockID block = World.Blocks[posIndex];
 
 	if (block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) {
 		Game_UpdateBlock(x, y, z, BLOCK_STONE);
 	} else if (Blocks.Collide[block] == COLLIDE_NONE && block != BLOCK_ROPE) {
-		/* Sponge check */		
-		for (yy = (y < 2 ? 0 : y - 2); yy <= (y > physics_maxWaterY ? World.MaxY : y + 2); yy++) {
-			for (zz = (z < 2 ? 0 : z - 2); zz <= (z > physics_maxWaterZ ? World.MaxZ : z + 2); zz++) {
-				for (xx = (x < 2 ? 0 : x - 2); xx <= (x > physics_maxWaterX ? World.MaxX : x + 2); xx++) {
-					block = World_GetBlock(xx, yy, zz);
-					if (block == BLOCK_SPONGE) return;
-				}
-			}
-		}
-
-		TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | posIndex);
+		Physics_EnqueueWater(posIndex, PHYSICS_WATER_DELAY);
 		Game_UpdateBlock(x, y, z, BLOCK_WATER);
 	}
 }
 
+static void Physics_PropagateWater(int posIndex, int x, int y, int z) {
+	BlockID block = World.Blocks[posIndex];
+	if (Blocks.Collide[block] == COLLIDE_NONE && block != BLOCK_ROPE && Physics_IsNearSponge(x, y, z)) return;
+	Physics_FlowWater(posIndex, x, y, z);
+}
+
 static void Physics_ActivateWater(int index, BlockID block) {
 	int x, y, z;
 	World_Unpack(index, x, y, z);
@@ -396,14 +498,29 @@ static void Physics_ActivateWater(int index, BlockID block) {
 	if (y > 0)          Physics_PropagateWater(index - World.OneY,  x,     y - 1, z);
 }
 
-static void Physics_TickWater(void) {
-	int i, count = waterQ.count;
-	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&waterQ, &index)) {
-			BlockID block = World.Blocks[index];
+/* Same as Physics_ActivateWater, except that only which neighbours the water could flow into is recorded */
+static void Physics_FindWaterFlows(struct FlowList* list, int index) {
+	int x, y, z;
+	World_Unpack(index, x, y, z);
+
+	if (x > 0          && Physics_CanWaterFlow(index - 1,           x - 1, y,     z))     FlowList_Add(list, index, index - 1);
+	if (x < World.MaxX && Physics_CanWaterFlow(index + 1,           x + 1, y,     z))     FlowList_Add(list, index, index + 1);
+	if (z > 0          && Physics_CanWaterFlow(index - World.Width, x,     y,     z - 1)) FlowList_Add(list, index, index - World.Width);
+	if (z < World.MaxZ && Physics_CanWaterFlow(index + World.Width, x,     y,     z + 1)) FlowList_Add(list, index, index + World.Width);
+	if (y > 0          && Physics_CanWaterFlow(index - World.OneY,  x,     y - 1, z))     FlowList_Add(list, index, index - World.OneY);
+}
+
+static void Physics_TickWater(struct PhysicsRegion* r) {
+	struct TickPage* page = r->waterQ[physics_liquidTick & PHYSICS_WHEEL_MASK].head;
+	int i, index;
+	BlockID block;
+
+	for (; page; page = page->next) {
+		for (i = 0; i < page->count; i++) {
+			index = page->entries[i];
+			block = World.Blocks[index];
 			if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
-			Physics_ActivateWater(index, block);
+			Physics_FindWaterFlows(&r->waterFlows, index);
 		}
 	}
 }
@@ -440,7 +557,7 @@ static void Physics_DeleteSponge(int index, BlockID block) {
 					index = World_Pack(xx, yy, zz);
 					block = World.Blocks[index];
 					if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
-						TickQueue_Enqueue(&waterQ, index | PHYSICS_ONE_DELAY);
+						Physics_EnqueueWater(index, PHYSICS_ONE_DELAY);
 					}
 				}
 			}
@@ -507,11 +624,142 @@ static void Physics_HandleTnt(int index, BlockID block) {
 	}
 }
 
+static struct WorkerPool physicsPool;
+static int regionsNext, regionsDone;
+static void* regionsMutex;
+static void* regionsFinished;
+
+static void Physics_TickRegion(struct PhysicsRegion* r) {
+	Physics_TickLava(r);
+	Physics_TickWater(r);
+}
+
+/* Keeps claiming and ticking regions, until there are no more regions left */
+static void Physics_TickRegions(void) {
+	cc_bool finished;
+	int i;
+
+	for (;;) {
+		Mutex_Lock(regionsMutex);
+		i = regionsNext < regionsCount ? regionsNext++ : -1;
+		Mutex_Unlock(regionsMutex);
+		if (i == -1) return;
+
+		Physics_TickRegion(&regions[i]);
+
+		Mutex_Lock(regionsMutex);
+		finished = ++regionsDone == regionsCount;
+		Mutex_Unlock(regionsMutex);
+		if (finished) Waitable_Signal(regionsFinished);
+	}
+}
+
+static void Physics_Work(int index) { Physics_TickRegions(); }
+static void Physics_Thread(void)     { WorkerPool_RunWorker(&physicsPool); }
+
+static void Physics_TickAllRegions(void) {
+	cc_bool finished;
+	int i;
+
+	if (!physicsPool.Count) {
+		for (i = 0; i < regionsCount; i++) { Physics_TickRegion(&regions[i]); }
+		return;
+	}
+
+	/* NOTE: The world must not be modified until all the regions have been ticked */
+	Mutex_Lock(regionsMutex);
+	regionsNext = 0; regionsDone = 0;
+	Mutex_Unlock(regionsMutex);
+
+	WorkerPool_WakeAll(&physicsPool);
+	Physics_TickRegions();
+
+	for (;;) {
+		Mutex_Lock(regionsMutex);
+		finished = regionsDone == regionsCount;
+		Mutex_Unlock(regionsMutex);
+
+		if (finished) break;
+		Waitable_Wait(regionsFinished);
+	}
+}
+
+/* Flows are checked again, because earlier flows may have changed the source or the neighbour */
+static void Physics_ApplyLavaFlows(struct FlowList* list) {
+	struct PhysicsFlow* flow;
+	BlockID block;
+	int i, x, y, z;
+
+	for (i = 0; i < list->count; i++) {
+		flow  = &list->flows[i];
+		block = World.Blocks[flow->src];
+		if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
+
+		World_Unpack(flow->dst, x, y, z);
+		Physics_PropagateLava(flow->dst, x, y, z);
+	}
+	list->count = 0;
+}
+
+static void Physics_ApplyWaterFlows(struct FlowList* list) {
+	struct PhysicsFlow* flow;
+	BlockID block;
+	int i, x, y, z;
+
+	for (i = 0; i < list->count; i++) {
+		flow  = &list->flows[i];
+		block = World.Blocks[flow->src];
+		if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
+
+		World_Unpack(flow->dst, x, y, z);
+		Physics_FlowWater(flow->dst, x, y, z);
+	}
+	list->count = 0;
+}
+
+static void Physics_TickLiquids(void) {
+	int i, slot = physics_liquidTick & PHYSICS_WHEEL_MASK;
+	Physics_TickAllRegions();
+
+	/* Ticks scheduled from now on are relative to the next liquid tick */
+	physics_liquidTick++;
+	for (i = 0; i < regionsCount; i++) {
+		TickList_Reset(&regions[i].lavaQ[slot]);
+		TickList_Reset(&regions[i].waterQ[slot]);
+	}
+
+	/* Lava is still ticked before water, same as when there was only one queue for each */
+	for (i = 0; i < regionsCount; i++) { Physics_ApplyLavaFlows(&regions[i].lavaFlows); }
+	for (i = 0; i < regionsCount; i++) { Physics_ApplyWaterFlows(&regions[i].waterFlows); }
+}
+
+static void Physics_StartThreads(void) {
+	int count;
+#ifdef CC_BUILD_WEB
+	/* Threads are not supported in the webclient */
+	count = 0;
+#else
+	count = Options_GetInt(OPT_PHYSICS_THREADS, 0, WORKERPOOL_MAX_THREADS, 0);
+#endif
+	if (!count) return;
+
+	regionsMutex    = Mutex_Create();
+	regionsFinished = Waitable_Create();
+	WorkerPool_Start(&physicsPool, count, Physics_Thread, Physics_Work);
+}
+
+static void Physics_StopThreads(void) {
+	if (!physicsPool.Count) return;
+	WorkerPool_Stop(&physicsPool);
+
+	Mutex_Free(regionsMutex);
+	Waitable_Free(regionsFinished);
+}
+
 void Physics_Init(void) {
 	Event_Register_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
 	Physics.Enabled = Options_GetBool(OPT_BLOCK_PHYSICS, true);
-	TickQueue_Init(&lavaQ);
-	TickQueue_Init(&waterQ);
+	Physics_StartThreads();
 
 	Physics.OnPlace[BLOCK_SAND]        = Physics_DoFalling;
 	Physics.OnPlace[BLOCK_GRAVEL]      = Physics_DoFalling;
@@ -552,15 +800,22 @@ void Physics_Init(void) {
 
 void Physics_Free(void) {
 	Event_Unregister_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
+	Physics_StopThreads();
+	Physics_FreeRegions();
 }
 
 void Physics_Tick(void) {
+	int i;
 	if (!Physics.Enabled || !World.Blocks) return;
 
 	/*if ((tickCount % 5) == 0) {*/
-	Physics_TickLava();
-	Physics_TickWater();
+	Physics_TickLiquids();
 	/*}*/
 	physics_tickCount++;
-	Physics_TickRandomBlocks();
+
+	/* Random ticks may call any handler, so are always run on the main thread */
+	for (i = 0; i < regionsCount; i++) {
+		Physics_TickRandomBlocks(&regions[i], (i % regionsX) << PHYSICS_REGION_SHIFT,
+												(i / regionsX) << PHYSICS_REGION_SHIFT);
+	}
 }
@@ -13,6 +13,7 @@
 #include "TexturePack.h"
 #include "Game.h"
 #include "Options.h"
+#include "WorkerPool.h"
 
 int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 16x16x16 count array. Coordinates range from 0 to 15. */
@@ -20,23 +21,8 @@ int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 18x18x18 chunk array. Coordinates range from -1 to 16. */
 #define Builder_PackChunk(xx, yy, zz) (((yy) + 1) * EXTCHUNK_SIZE_2 + ((zz) + 1) * EXTCHUNK_SIZE + ((xx) + 1))
 
-static BlockID* Builder_Chunk;
-static cc_uint8* Builder_Counts;
-static int* Builder_BitFlags;
-static int Builder_X, Builder_Y, Builder_Z;
-static BlockID Builder_Block;
-static int Builder_ChunkIndex;
-static cc_bool Builder_FullBright;
-static int Builder_ChunkEndX, Builder_ChunkEndZ;
 static int Builder_Offsets[FACE_COUNT] = { -1,1, -EXTCHUNK_SIZE,EXTCHUNK_SIZE, -EXTCHUNK_SIZE_2,EXTCHUNK_SIZE_2 };
 
-static int (*Builder_StretchXLiquid)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
-static int (*Builder_StretchX)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static int (*Builder_StretchZ)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static void (*Builder_RenderBlock)(int countsIndex, int x, int y, int z);
-static void (*Builder_PrePrepareChunk)(void);
-static void (*Builder_PostPrepareChunk)(void);
-
 /* Contains state for vertices for a portion of a chunk mesh (vertices that are in a 1D atlas) */
 struct Builder1DPart {
 	struct VertexTextured* fVertices[FACE_COUNT];
@@ -44,10 +30,51 @@ struct Builder1DPart {
 	int sCount, sOffset, sAdvance;
 };
 
-/* Part builder data, for both normal and translucent parts.
-The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
-static struct Builder1DPart Builder_Parts[ATLAS1D_MAX_ATLASES * 2];
-static struct VertexTextured* Builder_Vertices;
+/* Contains all of the state used while building the mesh of a chunk. */
+/* NOTE: Each mesh builder thread has its own state, so multiple chunks can be built at the same time. */
+struct BuilderState {
+	BlockID chunk[EXTCHUNK_SIZE_3];
+	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT];
+	int bitFlags[EXTCHUNK_SIZE_3];
+	int x, y, z;
+	BlockID block;
+	int chunkIndex;
+	cc_bool fullBright;
+	int chunkEndX, chunkEndZ;
+
+	/* Part builder data, for both normal and translucent parts.
+	The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
+	struct Builder1DPart parts[ATLAS1D_MAX_ATLASES * 2];
+	struct VertexTextured* vertices;
+	RNGState spriteRng;
+	struct _DrawerData drawer;
+
+	/* Advanced mesh builder state */
+	Vec3 minBB, maxBB;
+	int initBitFlags, baseOffset;
+	float x1, y1, z1, x2, y2, z2;
+	PackedCol lerp[5], lerpX[5], lerpZ[5], lerpY[5];
+	cc_bool tinted;
+
+	/* Flood fill state for calculating which faces of the chunk are connected */
+	cc_uint16 fillStack[CHUNK_SIZE_3];
+	cc_uint8 fillVisited[CHUNK_SIZE_3];
+
+	/* Vertices of all the chunks built by a worker thread in the current batch */
+	struct VertexTextured* buffer;
+	int bufferCount, bufferCapacity;
+};
+/* State of the mesh builder used by the main thread */
+static struct BuilderState mainState;
+/* Mutex used to ensure only one thread at a time calls Lighting.LightHint (NULL when no mesh builder threads) */
+static void* lightMutex;
+
+static int (*Builder_StretchXLiquid)(struct BuilderState* s, int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
+static int (*Builder_StretchX)(struct BuilderState* s, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+static int (*Builder_StretchZ)(struct BuilderState* s, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+static void (*Builder_RenderBlock)(struct BuilderState* s, int countsIndex, int x, int y, int z);
+static void (*Builder_PrePrepareChunk)(struct BuilderState* s);
+static void (*Builder_PostPrepareChunk)(struct BuilderState* s);
 
 static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	int i, count = part->sCount;
@@ -55,23 +82,23 @@ static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	return count;
 }
 
-static int Builder1DPart_CalcOffsets(struct Builder1DPart* part, int offset) {
+static int Builder1DPart_CalcOffsets(struct BuilderState* s, struct Builder1DPart* part, int offset) {
 	int i;
 	part->sOffset  = offset;
 	part->sAdvance = part->sCount >> 2;
 
 	offset += part->sCount;
 	for (i = 0; i < FACE_COUNT; i++) {
-		part->fVertices[i] = &Builder_Vertices[offset];
+		part->fVertices[i] = &s->vertices[offset];
 		offset += part->fCount[i];
 	}
 	return offset;
 }
 
-static int Builder_TotalVerticesCount(void) {
+static int Builder_TotalVerticesCount(struct BuilderState* s) {
 	int i, count = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES * 2; i++) {
-		count += Builder1DPart_VerticesCount(&Builder_Parts[i]);
+		count += Builder1DPart_VerticesCount(&s->parts[i]);
 	}
 	return count;
 }
@@ -80,28 +107,28 @@ static int Builder_TotalVerticesCount(void) {
 /*########################################################################################################################*
 *----------------------------------------------------Base mesh builder----------------------------------------------------*
 *#########################################################################################################################*/
-static void AddSpriteVertices(BlockID block) {
+static void AddSpriteVertices(struct BuilderState* s, BlockID block) {
 	int i = Atlas1D_Index(Block_Tex(block, FACE_XMAX));
-	struct Builder1DPart* part = &Builder_Parts[i];
+	struct Builder1DPart* part = &s->parts[i];
 	part->sCount += 4 * 4;
 }
 
-static void AddVertices(BlockID block, Face face) {
+static void AddVertices(struct BuilderState* s, BlockID block, Face face) {
 	int baseOffset = (Blocks.Draw[block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
 	int i = Atlas1D_Index(Block_Tex(block, face));
-	struct Builder1DPart* part = &Builder_Parts[baseOffset + i];
+	struct Builder1DPart* part = &s->parts[baseOffset + i];
 	part->fCount[face] += 4;
 }
 
 #ifdef CC_BUILD_GL11
-static void BuildPartVbs(struct ChunkPartInfo* info) {
+static void BuildPartVbs(struct BuilderState* s, struct ChunkPartInfo* info) {
 	/* Sprites vertices are stored before chunk face sides */
 	int i, count, offset = info->Offset + info->SpriteCount;
 	for (i = 0; i < FACE_COUNT; i++) {
 		count = info->Counts[i];
 
 		if (count) {
-			info->Vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+			info->Vbs[i] = Gfx_CreateVb2(&s->vertices[offset], VERTEX_FORMAT_TEXTURED, count);
 			offset += count;
 		} else {
 			info->Vbs[i] = 0;
@@ -111,14 +138,14 @@ static void BuildPartVbs(struct ChunkPartInfo* info) {
 	count  = info->SpriteCount;
 	offset = info->Offset;
 	if (count) {
-		info->Vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+		info->Vbs[i] = Gfx_CreateVb2(&s->vertices[offset], VERTEX_FORMAT_TEXTURED, count);
 	} else {
 		info->Vbs[i] = 0;
 	}
 }
 #endif
 
-static void SetPartInfo(struct Builder1DPart* part, int* offset, struct ChunkPartInfo* info, cc_bool* hasParts) {
+static void SetPartInfo(struct BuilderState* s, struct Builder1DPart* part, int* offset, struct ChunkPartInfo* info, cc_bool* hasParts) {
 	int vCount = Builder1DPart_VerticesCount(part);
 	info->Offset = -1;
 	if (!vCount) return;
@@ -134,14 +161,10 @@ static void SetPartInfo(struct Builder1DPart* part, int* offset, struct ChunkPar
 	info->Counts[FACE_YMIN] = part->fCount[FACE_YMIN];
 	info->Counts[FACE_YMAX] = part->fCount[FACE_YMAX];
 	info->SpriteCount       = part->sCount;
-
-#ifdef CC_BUILD_GL11
-	BuildPartVbs(info);
-#endif
 }
 
 
-static void PrepareChunk(int x1, int y1, int z1) {
+static void PrepareChunk(struct BuilderState* s, int x1, int y1, int z1) {
 	int xMax = min(World.Width,  x1 + CHUNK_SIZE);
 	int yMax = min(World.Height, y1 + CHUNK_SIZE);
 	int zMax = min(World.Length, z1 + CHUNK_SIZE);
@@ -150,89 +173,75 @@ static void PrepareChunk(int x1, int y1, int z1) {
 	BlockID b;
 	int x, y, z, xx, yy, zz;
 
-#ifdef OCCLUSION
-	int flags = ComputeOcclusion();
-#endif
-#ifdef DEBUG_OCCLUSION
-	FastColour col = new FastColour(60, 60, 60, 255);
-	if (flags & 1) col.R = 255; /* x */
-	if (flags & 4) col.G = 255; /* y */
-	if (flags & 2) col.B = 255; /* z */
-	map.Sunlight = map.Shadowlight = col;
-	map.SunlightXSide = map.ShadowlightXSide = col;
-	map.SunlightZSide = map.ShadowlightZSide = col;
-	map.SunlightYBottom = map.ShadowlightYBottom = col;
-#endif
-	
 	for (y = y1, yy = 0; y < yMax; y++, yy++) {
 		for (z = z1, zz = 0; z < zMax; z++, zz++) {
 			cIndex = Builder_PackChunk(0, yy, zz);
 
 			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				b = Builder_Chunk[cIndex];
+				b = s->chunk[cIndex];
 				if (Blocks.Draw[b] == DRAW_GAS) continue;
 				index = Builder_PackCount(xx, yy, zz);
 
 				/* Sprites can't be stretched, nor can then be they hidden by other blocks. */
 				/* Note sprites are drawn using DrawSprite and not with any of the DrawXFace. */
-				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(b); continue; }
+				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(s, b); continue; }
 
-				Builder_X = x; Builder_Y = y; Builder_Z = z;
-				Builder_FullBright = Blocks.FullBright[b];
+				s->x = x; s->y = y; s->z = z;
+				s->fullBright = Blocks.FullBright[b];
 				tileIdx = b * BLOCK_COUNT;
 				/* All of these function calls are inlined as they can be called tens of millions to hundreds of millions of times. */
 
-				if (Builder_Counts[index] == 0 ||
+				if (s->counts[index] == 0 ||
 					(x == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - 1]] & (1 << FACE_XMIN)) != 0)) {
-					Builder_Counts[index] = 0;
+					(x != 0 && (Blocks.Hidden[tileIdx + s->chunk[cIndex - 1]] & (1 << FACE_XMIN)) != 0)) {
+					s->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMIN);
+					s->counts[index] = Builder_StretchZ(s, index, x, y, z, cIndex, b, FACE_XMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (s->counts[index] == 0 ||
 					(x == World.MaxX && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != World.MaxX && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + 1]] & (1 << FACE_XMAX)) != 0)) {
-					Builder_Counts[index] = 0;
+					(x != World.MaxX && (Blocks.Hidden[tileIdx + s->chunk[cIndex + 1]] & (1 << FACE_XMAX)) != 0)) {
+					s->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMAX);
+					s->counts[index] = Builder_StretchZ(s, index, x, y, z, cIndex, b, FACE_XMAX);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (s->counts[index] == 0 ||
 					(z == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE]] & (1 << FACE_ZMIN)) != 0)) {
-					Builder_Counts[index] = 0;
+					(z != 0 && (Blocks.Hidden[tileIdx + s->chunk[cIndex - EXTCHUNK_SIZE]] & (1 << FACE_ZMIN)) != 0)) {
+					s->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMIN);
+					s->counts[index] = Builder_StretchX(s, index, x, y, z, cIndex, b, FACE_ZMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (s->counts[index] == 0 ||
 					(z == World.MaxZ && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != World.MaxZ && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE]] & (1 << FACE_ZMAX)) != 0)) {
-					Builder_Counts[index] = 0;
+					(z != World.MaxZ && (Blocks.Hidden[tileIdx + s->chunk[cIndex + EXTCHUNK_SIZE]] & (1 << FACE_ZMAX)) != 0)) {
+					s->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMAX);
+					s->counts[index] = Builder_StretchX(s, index, x, y, z, cIndex, b, FACE_ZMAX);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 || y == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE_2]] & (1 << FACE_YMIN)) != 0) {
-					Builder_Counts[index] = 0;
+				if (s->counts[index] == 0 || y == 0 ||
+					(Blocks.Hidden[tileIdx + s->chunk[cIndex - EXTCHUNK_SIZE_2]] & (1 << FACE_YMIN)) != 0) {
+					s->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMIN);
+					s->counts[index] = Builder_StretchX(s, index, x, y, z, cIndex, b, FACE_YMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE_2]] & (1 << FACE_YMAX)) != 0) {
-					Builder_Counts[index] = 0;
+				if (s->counts[index] == 0 ||
+					(Blocks.Hidden[tileIdx + s->chunk[cIndex + EXTCHUNK_SIZE_2]] & (1 << FACE_YMAX)) != 0) {
+					s->counts[index] = 0;
 				} else if (b < BLOCK_WATER || b > BLOCK_STILL_LAVA) {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMAX);
+					s->counts[index] = Builder_StretchX(s, index, x, y, z, cIndex, b, FACE_YMAX);
 				} else {
-					Builder_Counts[index] = Builder_StretchXLiquid(index, x, y, z, cIndex, b);
+					s->counts[index] = Builder_StretchXLiquid(s, index, x, y, z, cIndex, b);
 				}
 			}
 		}
@@ -251,12 +260,12 @@ for (yy = -1; yy < 17; ++yy) {\
 			block    = get_block;\
 			allAir   = allAir   && Blocks.Draw[block] == DRAW_GAS;\
 			allSolid = allSolid && Blocks.FullOpaque[block];\
-			Builder_Chunk[cIndex] = block;\
+			s->chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadChunkData(struct BuilderState* s, int x1, int y1, int z1, cc_bool* outAllAir) {
 	BlockRaw* blocks = World.Blocks;
 	BlockRaw* blocks2;
 	cc_bool allAir = true, allSolid = true;
@@ -300,12 +309,12 @@ for (yy = -1; yy < 17; ++yy) {\
 \
 			block  = get_block;\
 			allAir = allAir && Blocks.Draw[block] == DRAW_GAS;\
-			Builder_Chunk[cIndex] = block;\
+			s->chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadBorderChunkData(struct BuilderState* s, int x1, int y1, int z1, cc_bool* outAllAir) {
 	BlockRaw* blocks = World.Blocks;
 	BlockRaw* blocks2;
 	cc_bool allAir = true;
@@ -328,58 +337,115 @@ static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
 	return false;
 }
 
-static cc_bool BuildChunk(int x1, int y1, int z1, struct ChunkInfo* info) {
-	BlockID chunk[EXTCHUNK_SIZE_3]; 
-	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
-	int bitFlags[EXTCHUNK_SIZE_3];
+#define Builder_FillCell(cond, face, offset) \
+if (cond) { \
+	faces |= 1 << face; \
+} else if (!visited[index + (offset)]) { \
+	visited[index + (offset)] = true; stack[count++] = index + (offset); \
+}
+
+/* Calculates which pairs of faces of the chunk can see each other through non-opaque blocks */
+/* (i.e. which faces are connected by flood filling through non-opaque blocks) */
+static cc_uint16 CalcOcclusionFlags(struct BuilderState* s) {
+	cc_uint16* stack  = s->fillStack;
+	cc_uint8* visited = s->fillVisited;
+	cc_uint16 flags   = 0;
+	int i, index, count, faces, a, b;
+	int xx, yy, zz;
+
+	/* Opaque blocks can never be passed through, so treat them as already visited */
+	for (i = 0; i < CHUNK_SIZE_3; i++) {
+		xx = i & CHUNK_MASK; zz = (i >> 4) & CHUNK_MASK; yy = i >> 8;
+		visited[i] = Blocks.FullOpaque[s->chunk[Builder_PackChunk(xx, yy, zz)]];
+	}
+
+	for (i = 0; i < CHUNK_SIZE_3; i++) {
+		if (visited[i]) continue;
+		visited[i] = true;
+		stack[0] = i; count = 1; faces = 0;
+
+		while (count) {
+			index = stack[--count];
+			xx = index & CHUNK_MASK; zz = (index >> 4) & CHUNK_MASK; yy = index >> 8;
+
+			Builder_FillCell(xx == 0,          FACE_XMIN,   -1);
+			Builder_FillCell(xx == CHUNK_MAX,  FACE_XMAX,    1);
+			Builder_FillCell(zz == 0,          FACE_ZMIN,  -16);
+			Builder_FillCell(zz == CHUNK_MAX,  FACE_ZMAX,   16);
+			Builder_FillCell(yy == 0,          FACE_YMIN, -256);
+			Builder_FillCell(yy == CHUNK_MAX,  FACE_YMAX,  256);
+		}
 
+		for (a = 0; a < FACE_COUNT; a++) {
+			if (!(faces & (1 << a))) continue;
+			for (b = a + 1; b < FACE_COUNT; b++) {
+				if (faces & (1 << b)) flags |= Occlusion_Bit(a, b);
+			}
+		}
+	}
+	return flags;
+}
+
+/* Time spent in each stage of building chunk meshes (see misc/bench/BenchBuilder.c) */
+struct BuilderTimes { cc_uint64 read, prepare, render; };
+
+/* Adds the time since beg to the given stage, then sets beg to now */
+static void BuilderTimes_Add(cc_uint64* stage, cc_uint64* beg) {
+	cc_uint64 end = Stopwatch_Measure();
+	*stage += Stopwatch_ElapsedMicroseconds(*beg, end);
+	*beg    = end;
+}
+
+/* Reads the blocks in the chunk and calculates which faces of which blocks need to be drawn */
+/* Returns the total number of vertices in the chunk mesh (0 if chunk has no mesh) */
+/* NOTE: Time spent reading and preparing the chunk is only measured if times is not NULL */
+static int BuildChunk(struct BuilderState* s, int x1, int y1, int z1, struct ChunkInfo* info, struct BuilderTimes* times) {
+	cc_uint64 beg = times ? Stopwatch_Measure() : 0;
 	cc_bool allAir, allSolid, onBorder;
-	int xMax, yMax, zMax, totalVerts;
-	int cIndex, index;
-	int x, y, z, xx, yy, zz;
+	int totalVerts;
 
-	Builder_Chunk  = chunk;
-	Builder_Counts = counts;
-	Builder_BitFlags = bitFlags;
-	Builder_PrePrepareChunk();
-	
+	Builder_PrePrepareChunk(s);
 	onBorder = 
 		x1 == 0 || y1 == 0 || z1 == 0   || x1 + CHUNK_SIZE >= World.Width ||
 		y1 + CHUNK_SIZE >= World.Height || z1 + CHUNK_SIZE >= World.Length;
 
 	if (onBorder) {
 		/* less optimal case here */
-		Mem_Set(chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
-		allSolid = ReadBorderChunkData(x1, y1, z1, &allAir);
+		Mem_Set(s->chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
+		allSolid = ReadBorderChunkData(s, x1, y1, z1, &allAir);
 	} else {
-		allSolid = ReadChunkData(x1, y1, z1, &allAir);
+		allSolid = ReadChunkData(s, x1, y1, z1, &allAir);
 	}
 
 	info->AllAir = allAir;
-	if (allAir || allSolid) return false;
+	info->OcclusionFlags = allAir ? OCCLUSION_ALL_CONNECTED : (allSolid ? 0 : CalcOcclusionFlags(s));
+	if (times) BuilderTimes_Add(&times->read, &beg);
+	if (allAir || allSolid) return 0;
+
+	/* LightHint may calculate and store lighting state, so only one thread can call it at a time */
+	if (lightMutex) Mutex_Lock(lightMutex);
 	Lighting.LightHint(x1 - 1, z1 - 1);
+	if (lightMutex) Mutex_Unlock(lightMutex);
 
-	Mem_Set(counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
-	xMax = min(World.Width,  x1 + CHUNK_SIZE);
-	yMax = min(World.Height, y1 + CHUNK_SIZE);
-	zMax = min(World.Length, z1 + CHUNK_SIZE);
+	Mem_Set(s->counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
+	s->chunkEndX = min(World.Width,  x1 + CHUNK_SIZE);
+	s->chunkEndZ = min(World.Length, z1 + CHUNK_SIZE);
+	PrepareChunk(s, x1, y1, z1);
+	totalVerts = Builder_TotalVerticesCount(s);
 
-	Builder_ChunkEndX = xMax; Builder_ChunkEndZ = zMax;
-	PrepareChunk(x1, y1, z1);
+	if (times) BuilderTimes_Add(&times->prepare, &beg);
+	return totalVerts;
+}
 
-	totalVerts = Builder_TotalVerticesCount();
-	if (!totalVerts) return false;
+/* Generates the vertices of the chunk mesh into s->vertices */
+static void RenderChunk(struct BuilderState* s, int x1, int y1, int z1) {
+	int xMax = min(World.Width,  x1 + CHUNK_SIZE);
+	int yMax = min(World.Height, y1 + CHUNK_SIZE);
+	int zMax = min(World.Length, z1 + CHUNK_SIZE);
+	int cIndex, index;
+	int x, y, z, xx, yy, zz;
 
-#ifndef CC_BUILD_GL11
-	/* add an extra element to fix crashing on some GPUs */
-	Builder_Vertices = (struct VertexTextured*)Gfx_RecreateAndLockVb(&info->Vb,
-													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
-#else
-	/* NOTE: Relies on assumption vb is ignored by GL11 Gfx_LockVb implementation */
-	Builder_Vertices = (struct VertexTextured*)Gfx_LockVb(0, 
-													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
-#endif
-	Builder_PostPrepareChunk();
+	Builder_PostPrepareChunk(s);
 	/* now render the chunk */
 
 	for (y = y1, yy = 0; y < yMax; y++, yy++) {
@@ -387,42 +453,31 @@ static cc_bool BuildChunk(int x1, int y1, int z1, struct ChunkInfo* info) {
 			cIndex = Builder_PackChunk(0, yy, zz);
 
 			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				Builder_Block = chunk[cIndex];
-				if (Blocks.Draw[Builder_Block] == DRAW_GAS) continue;
+				s->block = s->chunk[cIndex];
+				if (Blocks.Draw[s->block] == DRAW_GAS) continue;
 
 				index = Builder_PackCount(xx, yy, zz);
-				Builder_ChunkIndex = cIndex;
-				Builder_RenderBlock(index, x, y, z);
+				s->chunkIndex = cIndex;
+				Builder_RenderBlock(s, index, x, y, z);
 			}
 		}
 	}
-
-#ifndef CC_BUILD_GL11
-	Gfx_UnlockVb(info->Vb);
-#endif
-	return true;
 }
 
-void Builder_MakeChunk(struct ChunkInfo* info) {
+/* Updates the normal and translucent parts of the given chunk */
+static void SetPartInfos(struct BuilderState* s, struct ChunkInfo* info) {
 	int x = info->CentreX - 8, y = info->CentreY - 8, z = info->CentreZ - 8;
-	cc_bool hasMesh, hasNorm, hasTran;
-	int partsIndex;
-	int i, j, curIdx, offset;
-
-	hasMesh = BuildChunk(x, y, z, info);
-	if (!hasMesh) return;
-
+	cc_bool hasNorm = false, hasTran = false;
+	int partsIndex, offset = 0;
+	int i, j, curIdx;
 	partsIndex = World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
-	offset  = 0;
-	hasNorm = false;
-	hasTran = false;
 
 	for (i = 0; i < MapRenderer_1DUsedCount; i++) {
 		j = i + ATLAS1D_MAX_ATLASES;
 		curIdx = partsIndex + i * World.ChunksCount;
 
-		SetPartInfo(&Builder_Parts[i], &offset, &MapRenderer_PartsNormal[curIdx],      &hasNorm);
-		SetPartInfo(&Builder_Parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx], &hasTran);
+		SetPartInfo(s, &s->parts[i], &offset, &MapRenderer_PartsNormal[curIdx],      &hasNorm);
+		SetPartInfo(s, &s->parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx], &hasTran);
 	}
 
 	if (hasNorm) {
@@ -431,40 +486,85 @@ void Builder_MakeChunk(struct ChunkInfo* info) {
 	if (hasTran) {
 		info->TranslucentParts = &MapRenderer_PartsTranslucent[partsIndex];
 	}
+}
+
+#ifdef CC_BUILD_GL11
+/* Creates the vertex buffers for all the parts of the given chunk from s->vertices */
+static void BuildChunkVbs(struct BuilderState* s, struct ChunkInfo* info) {
+	int i;
+	for (i = 0; i < MapRenderer_1DUsedCount; i++) {
+		if (info->NormalParts && info->NormalParts[i * World.ChunksCount].Offset >= 0) {
+			BuildPartVbs(s, &info->NormalParts[i * World.ChunksCount]);
+		}
+		if (info->TranslucentParts && info->TranslucentParts[i * World.ChunksCount].Offset >= 0) {
+			BuildPartVbs(s, &info->TranslucentParts[i * World.ChunksCount]);
+		}
+	}
+}
+#endif
 
-#ifdef OCCLUSION
-	if (info.NormalParts != null || info.TranslucentParts != null)
-		info.occlusionFlags = (cc_uint8)ComputeOcclusion();
+/* Builds the mesh of the given chunk on the calling thread */
+/* Returns the total number of vertices in the chunk mesh (0 if chunk has no mesh) */
+/* NOTE: Time spent in each stage is only measured if times is not NULL */
+static int MakeChunk(struct BuilderState* s, struct ChunkInfo* info, struct BuilderTimes* times) {
+	int x = info->CentreX - 8, y = info->CentreY - 8, z = info->CentreZ - 8;
+	int totalVerts;
+	cc_uint64 beg;
+
+	totalVerts = BuildChunk(s, x, y, z, info, times);
+	if (!totalVerts) return 0;
+
+#ifndef CC_BUILD_GL11
+	/* add an extra element to fix crashing on some GPUs */
+	s->vertices = (struct VertexTextured*)Gfx_RecreateAndLockVb(&info->Vb,
+													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
+#else
+	/* NOTE: Relies on assumption vb is ignored by GL11 Gfx_LockVb implementation */
+	s->vertices = (struct VertexTextured*)Gfx_LockVb(0, 
+													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
 #endif
+	beg = times ? Stopwatch_Measure() : 0;
+	RenderChunk(s, x, y, z);
+	if (times) BuilderTimes_Add(&times->render, &beg);
+
+#ifndef CC_BUILD_GL11
+	Gfx_UnlockVb(info->Vb);
+#endif
+	SetPartInfos(s, info);
+#ifdef CC_BUILD_GL11
+	BuildChunkVbs(s, info);
+#endif
+	return totalVerts;
 }
 
-static cc_bool Builder_OccludedLiquid(int chunkIndex) {
+void Builder_MakeChunk(struct ChunkInfo* info) { MakeChunk(&mainState, info, NULL); }
+
+static cc_bool Builder_OccludedLiquid(struct BuilderState* s, int chunkIndex) {
 	chunkIndex += EXTCHUNK_SIZE_2; /* Checking y above */
 	return
-		Blocks.FullOpaque[Builder_Chunk[chunkIndex]]
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
+		Blocks.FullOpaque[s->chunk[chunkIndex]]
+		&& Blocks.Draw[s->chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
+		&& Blocks.Draw[s->chunk[chunkIndex - 1]] != DRAW_GAS
+		&& Blocks.Draw[s->chunk[chunkIndex + 1]] != DRAW_GAS
+		&& Blocks.Draw[s->chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
 }
 
-static void DefaultPrePrepateChunk(void) {
-	Mem_Set(Builder_Parts, 0, sizeof(Builder_Parts));
+static void DefaultPrePrepateChunk(struct BuilderState* s) {
+	Mem_Set(s->parts, 0, sizeof(s->parts));
 }
 
-static void DefaultPostStretchChunk(void) {
+static void DefaultPostStretchChunk(struct BuilderState* s) {
 	int i, j, offset;
 	offset = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES; i++) {
 		j = i + ATLAS1D_MAX_ATLASES;
 
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[i], offset);
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[j], offset);
+		offset = Builder1DPart_CalcOffsets(s, &s->parts[i], offset);
+		offset = Builder1DPart_CalcOffsets(s, &s->parts[j], offset);
 	}
 }
 
-static RNGState spriteRng;
-static void Builder_DrawSprite(int x, int y, int z) {
+static void Builder_DrawSprite(struct BuilderState* s, int x, int y, int z) {
 	struct Builder1DPart* part;
 	struct VertexTextured v;
 	cc_uint8 offsetType;
@@ -483,54 +583,54 @@ static void Builder_DrawSprite(int x, int y, int z) {
 
 #define s_u1 0.0f
 #define s_u2 UV2_Scale
-	loc = Block_Tex(Builder_Block, FACE_XMAX);
+	loc = Block_Tex(s->block, FACE_XMAX);
 	v1  = Atlas1D_RowId(loc) * Atlas1D.InvTileSize;
 	v2  = v1 + Atlas1D.InvTileSize * UV2_Scale;
 
-	offsetType = Blocks.SpriteOffset[Builder_Block];
+	offsetType = Blocks.SpriteOffset[s->block];
 	if (offsetType >= 6 && offsetType <= 7) {
-		Random_Seed(&spriteRng, (x + 1217 * z) & 0x7fffffff);
-		valX = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
-		valY = Random_Range(&spriteRng, 0,  3 + 1) / 16.0f;
-		valZ = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
+		Random_Seed(&s->spriteRng, (x + 1217 * z) & 0x7fffffff);
+		valX = Random_Range(&s->spriteRng, -3, 3 + 1) / 16.0f;
+		valY = Random_Range(&s->spriteRng, 0,  3 + 1) / 16.0f;
+		valZ = Random_Range(&s->spriteRng, -3, 3 + 1) / 16.0f;
 
 		x1 += valX - 1.7f/16.0f; x2 += valX + 1.7f/16.0f;
 		z1 += valZ - 1.7f/16.0f; z2 += valZ + 1.7f/16.0f;
 		if (offsetType == 7) { y1 -= valY; y2 -= valY; }
 	}
 	
-	bright = Blocks.FullBright[Builder_Block];
-	part   = &Builder_Parts[Atlas1D_Index(loc)];
+	bright = Blocks.FullBright[s->block];
+	part   = &s->parts[Atlas1D_Index(loc)];
 	v.Col  = bright ? PACKEDCOL_WHITE : Lighting.Color_Sprite_Fast(x, y, z);
-	Block_Tint(v.Col, Builder_Block);
+	Block_Tint(v.Col, s->block);
 
 	/* Draw Z axis */
 	index = part->sOffset;
-	v.X = x1; v.Y = y1; v.Z = z1; v.U = s_u2; v.V = v2; Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x2;           v.Z = z2; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x1; v.Y = y1; v.Z = z1; v.U = s_u2; v.V = v2; s->vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; s->vertices[index + 1] = v;
+	v.X = x2;           v.Z = z2; v.U = s_u1;           s->vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; s->vertices[index + 3] = v;
 
 	/* Draw Z axis mirrored */
 	index += part->sAdvance;
-	v.X = x2; v.Y = y1; v.Z = z2; v.U = s_u2;           Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x1;           v.Z = z1; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x2; v.Y = y1; v.Z = z2; v.U = s_u2;           s->vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; s->vertices[index + 1] = v;
+	v.X = x1;           v.Z = z1; v.U = s_u1;           s->vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; s->vertices[index + 3] = v;
 
 	/* Draw X axis */
 	index += part->sAdvance;
-	v.X = x1; v.Y = y1; v.Z = z2; v.U = s_u2;           Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x2;           v.Z = z1; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x1; v.Y = y1; v.Z = z2; v.U = s_u2;           s->vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; s->vertices[index + 1] = v;
+	v.X = x2;           v.Z = z1; v.U = s_u1;           s->vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; s->vertices[index + 3] = v;
 
 	/* Draw X axis mirrored */
 	index += part->sAdvance;
-	v.X = x2; v.Y = y1; v.Z = z1; v.U = s_u2;           Builder_Vertices[index + 0] = v;
-	          v.Y = y2;                       v.V = v1; Builder_Vertices[index + 1] = v;
-	v.X = x1;           v.Z = z2; v.U = s_u1;           Builder_Vertices[index + 2] = v;
-	          v.Y = y1;                       v.V = v2; Builder_Vertices[index + 3] = v;
+	v.X = x2; v.Y = y1; v.Z = z1; v.U = s_u2;           s->vertices[index + 0] = v;
+	          v.Y = y2;                       v.V = v1; s->vertices[index + 1] = v;
+	v.X = x1;           v.Z = z2; v.U = s_u1;           s->vertices[index + 2] = v;
+	          v.Y = y1;                       v.V = v2; s->vertices[index + 3] = v;
 
 	part->sOffset += 4;
 }
@@ -560,72 +660,72 @@ static PackedCol Normal_LightColor(int x, int y, int z, Face face, BlockID block
 	return 0; /* should never happen */
 }
 
-static cc_bool Normal_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
+static cc_bool Normal_CanStretch(struct BuilderState* s, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = s->chunk[chunkIndex];
 
-	if (cur != initial || Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
-	if (Builder_FullBright) return true;
+	if (cur != initial || Block_IsFaceHidden(cur, s->chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
+	if (s->fullBright) return true;
 
-	return Normal_LightColor(Builder_X, Builder_Y, Builder_Z, face, initial) == Normal_LightColor(x, y, z, face, cur);
+	return Normal_LightColor(s->x, s->y, s->z, face, initial) == Normal_LightColor(x, y, z, face, cur);
 }
 
-static int NormalBuilder_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int NormalBuilder_StretchXLiquid(struct BuilderState* s, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
+	if (Builder_OccludedLiquid(s, chunkIndex)) return 0;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < s->chunkEndX && stretchTile && Normal_CanStretch(s, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(s, chunkIndex)) {
+		s->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(s, block, FACE_YMAX);
 	return count;
 }
 
-static int NormalBuilder_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchX(struct BuilderState* s, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < s->chunkEndX && stretchTile && Normal_CanStretch(s, block, chunkIndex, x, y, z, face)) {
+		s->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(s, block, face);
 	return count;
 }
 
-static int NormalBuilder_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchZ(struct BuilderState* s, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < s->chunkEndZ && stretchTile && Normal_CanStretch(s, block, chunkIndex, x, y, z, face)) {
+		s->counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(s, block, face);
 	return count;
 }
 
-static void NormalBuilder_RenderBlock(int index, int x, int y, int z) {	
+static void NormalBuilder_RenderBlock(struct BuilderState* s, int index, int x, int y, int z) {	
 	/* counters */
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
@@ -641,90 +741,90 @@ static void NormalBuilder_RenderBlock(int index, int x, int y, int z) {
 	PackedCol col;
 	int offset;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[s->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(s, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = s->counts[index + FACE_XMIN];
+	count_XMax = s->counts[index + FACE_XMAX];
+	count_ZMin = s->counts[index + FACE_ZMIN];
+	count_ZMax = s->counts[index + FACE_ZMAX];
+	count_YMin = s->counts[index + FACE_YMIN];
+	count_YMax = s->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	fullBright = Blocks.FullBright[Builder_Block];
-	baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	lightFlags = Blocks.LightOffset[Builder_Block];
+	fullBright = Blocks.FullBright[s->block];
+	baseOffset = (Blocks.Draw[s->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	lightFlags = Blocks.LightOffset[s->block];
 
-	Drawer.MinBB = Blocks.MinBB[Builder_Block]; Drawer.MinBB.Y = 1.0f - Drawer.MinBB.Y;
-	Drawer.MaxBB = Blocks.MaxBB[Builder_Block]; Drawer.MaxBB.Y = 1.0f - Drawer.MaxBB.Y;
+	s->drawer.MinBB = Blocks.MinBB[s->block]; s->drawer.MinBB.Y = 1.0f - s->drawer.MinBB.Y;
+	s->drawer.MaxBB = Blocks.MaxBB[s->block]; s->drawer.MaxBB.Y = 1.0f - s->drawer.MaxBB.Y;
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	Drawer.X1 = x + min.X; Drawer.Y1 = y + min.Y; Drawer.Z1 = z + min.Z;
-	Drawer.X2 = x + max.X; Drawer.Y2 = y + max.Y; Drawer.Z2 = z + max.Z;
+	min = Blocks.RenderMinBB[s->block]; max = Blocks.RenderMaxBB[s->block];
+	s->drawer.X1 = x + min.X; s->drawer.Y1 = y + min.Y; s->drawer.Z1 = z + min.Z;
+	s->drawer.X2 = x + max.X; s->drawer.Y2 = y + max.Y; s->drawer.Z2 = z + max.Z;
 
-	Drawer.Tinted  = Blocks.Tinted[Builder_Block];
-	Drawer.TintCol = Blocks.FogCol[Builder_Block];
+	s->drawer.Tinted  = Blocks.Tinted[s->block];
+	s->drawer.TintCol = Blocks.FogCol[s->block];
 
 	if (count_XMin) {
-		loc    = Block_Tex(Builder_Block, FACE_XMIN);
+		loc    = Block_Tex(s->block, FACE_XMIN);
 		offset = (lightFlags >> FACE_XMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &s->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			x >= offset ? Lighting.Color_XSide_Fast(x - offset, y, z) : Env.SunXSide;
-		Drawer_XMin(count_XMin, col, loc, &part->fVertices[FACE_XMIN]);
+		Drawer_XMin2(&s->drawer, count_XMin, col, loc, &part->fVertices[FACE_XMIN]);
 	}
 
 	if (count_XMax) {
-		loc    = Block_Tex(Builder_Block, FACE_XMAX);
+		loc    = Block_Tex(s->block, FACE_XMAX);
 		offset = (lightFlags >> FACE_XMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &s->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			x <= (World.MaxX - offset) ? Lighting.Color_XSide_Fast(x + offset, y, z) : Env.SunXSide;
-		Drawer_XMax(count_XMax, col, loc, &part->fVertices[FACE_XMAX]);
+		Drawer_XMax2(&s->drawer, count_XMax, col, loc, &part->fVertices[FACE_XMAX]);
 	}
 
 	if (count_ZMin) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMIN);
+		loc    = Block_Tex(s->block, FACE_ZMIN);
 		offset = (lightFlags >> FACE_ZMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &s->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			z >= offset ? Lighting.Color_ZSide_Fast(x, y, z - offset) : Env.SunZSide;
-		Drawer_ZMin(count_ZMin, col, loc, &part->fVertices[FACE_ZMIN]);
+		Drawer_ZMin2(&s->drawer, count_ZMin, col, loc, &part->fVertices[FACE_ZMIN]);
 	}
 
 	if (count_ZMax) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMAX);
+		loc    = Block_Tex(s->block, FACE_ZMAX);
 		offset = (lightFlags >> FACE_ZMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &s->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			z <= (World.MaxZ - offset) ? Lighting.Color_ZSide_Fast(x, y, z + offset) : Env.SunZSide;
-		Drawer_ZMax(count_ZMax, col, loc, &part->fVertices[FACE_ZMAX]);
+		Drawer_ZMax2(&s->drawer, count_ZMax, col, loc, &part->fVertices[FACE_ZMAX]);
 	}
 
 	if (count_YMin) {
-		loc    = Block_Tex(Builder_Block, FACE_YMIN);
+		loc    = Block_Tex(s->block, FACE_YMIN);
 		offset = (lightFlags >> FACE_YMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &s->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE : Lighting.Color_YMin_Fast(x, y - offset, z);
-		Drawer_YMin(count_YMin, col, loc, &part->fVertices[FACE_YMIN]);
+		Drawer_YMin2(&s->drawer, count_YMin, col, loc, &part->fVertices[FACE_YMIN]);
 	}
 
 	if (count_YMax) {
-		loc    = Block_Tex(Builder_Block, FACE_YMAX);
+		loc    = Block_Tex(s->block, FACE_YMAX);
 		offset = (lightFlags >> FACE_YMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &s->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE : Lighting.Color_YMax_Fast(x, y + offset, z);
-		Drawer_YMax(count_YMax, col, loc, &part->fVertices[FACE_YMAX]);
+		Drawer_YMax2(&s->drawer, count_YMax, col, loc, &part->fVertices[FACE_YMAX]);
 	}
 }
 
@@ -750,13 +850,6 @@ static void NormalBuilder_SetActive(void) {
 /*########################################################################################################################*
 *-------------------------------------------------Advanced mesh builder---------------------------------------------------*
 *#########################################################################################################################*/
-static Vec3 adv_minBB, adv_maxBB;
-static int adv_initBitFlags, adv_baseOffset;
-static int* adv_bitFlags;
-static float adv_x1, adv_y1, adv_z1, adv_x2, adv_y2, adv_z2;
-static PackedCol adv_lerp[5], adv_lerpX[5], adv_lerpZ[5], adv_lerpY[5];
-static cc_bool adv_tinted;
-
 enum ADV_MASK {
 	/* z-1 cube points */
 	xM1_yM1_zM1, xM1_yCC_zM1, xM1_yP1_zM1,
@@ -780,7 +873,7 @@ enum ADV_MASK {
 /* - bit 0 set: Y-1 is in light */
 /* - bit 1 set: Y   is in light */
 /* - bit 2 set: Y+1 is in light */
-static int Adv_Lit(int x, int y, int z, int cIndex) {
+static int Adv_Lit(struct BuilderState* s, int x, int y, int z, int cIndex) {
 	int flags, offset, lightFlags;
 	BlockID block;
 	if (y < 0 || y >= World.Height) return LIT_M1 | LIT_CC | LIT_P1; /* all faces lit */
@@ -791,7 +884,7 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 	}
 
 	flags = 0;
-	block = Builder_Chunk[cIndex];
+	block = s->chunk[cIndex];
 	lightFlags = Blocks.LightOffset[block];
 
 	/* TODO using LIGHT_FLAG_SHADES_FROM_BELOW is wrong here, */
@@ -809,26 +902,26 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 	flags |= Lighting.IsLit_Fast(x, (y + 1) - offset, z) ? LIT_P1 : 0;
 
 	/* If a block is fullbright, it should also look as if that spot is lit */
-	if (Blocks.FullBright[Builder_Chunk[cIndex - 324]]) flags |= LIT_M1;
+	if (Blocks.FullBright[s->chunk[cIndex - 324]]) flags |= LIT_M1;
 	if (Blocks.FullBright[block])                       flags |= LIT_CC;
-	if (Blocks.FullBright[Builder_Chunk[cIndex + 324]]) flags |= LIT_P1;
+	if (Blocks.FullBright[s->chunk[cIndex + 324]]) flags |= LIT_P1;
 	
 	return flags;
 }
 
-static int Adv_ComputeLightFlags(int x, int y, int z, int cIndex) {
-	if (Builder_FullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
+static int Adv_ComputeLightFlags(struct BuilderState* s, int x, int y, int z, int cIndex) {
+	if (s->fullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
 
 	return
-		Adv_Lit(x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
-		Adv_Lit(x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
-		Adv_Lit(x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
-		Adv_Lit(x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
-		Adv_Lit(x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
-		Adv_Lit(x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
-		Adv_Lit(x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
-		Adv_Lit(x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
-		Adv_Lit(x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
+		Adv_Lit(s, x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
+		Adv_Lit(s, x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
+		Adv_Lit(s, x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
+		Adv_Lit(s, x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
+		Adv_Lit(s, x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
+		Adv_Lit(s, x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
+		Adv_Lit(s, x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
+		Adv_Lit(s, x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
+		Adv_Lit(s, x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
 }
 
 static int adv_masks[FACE_COUNT] = {
@@ -859,384 +952,383 @@ static int adv_masks[FACE_COUNT] = {
 };
 
 
-static cc_bool Adv_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
-	adv_bitFlags[chunkIndex] = Adv_ComputeLightFlags(x, y, z, chunkIndex);
+static cc_bool Adv_CanStretch(struct BuilderState* s, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = s->chunk[chunkIndex];
+	s->bitFlags[chunkIndex] = Adv_ComputeLightFlags(s, x, y, z, chunkIndex);
 
 	return cur == initial
-		&& !Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)
-		&& (adv_initBitFlags == adv_bitFlags[chunkIndex]
+		&& !Block_IsFaceHidden(cur, s->chunk[chunkIndex + Builder_Offsets[face]], face)
+		&& (s->initBitFlags == s->bitFlags[chunkIndex]
 		/* Check that this face is either fully bright or fully in shadow */
-		&& (adv_initBitFlags == 0 || (adv_initBitFlags & adv_masks[face]) == adv_masks[face]));
+		&& (s->initBitFlags == 0 || (s->initBitFlags & adv_masks[face]) == adv_masks[face]));
 }
 
-static int Adv_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int Adv_StretchXLiquid(struct BuilderState* s, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	if (Builder_OccludedLiquid(s, chunkIndex)) return 0;
+	s->initBitFlags = Adv_ComputeLightFlags(s, x, y, z, chunkIndex);
+	s->bitFlags[chunkIndex] = s->initBitFlags;
 
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < s->chunkEndX && stretchTile && Adv_CanStretch(s, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(s, chunkIndex)) {
+		s->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(s, block, FACE_YMAX);
 	return count;
 }
 
-static int Adv_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchX(struct BuilderState* s, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	s->initBitFlags = Adv_ComputeLightFlags(s, x, y, z, chunkIndex);
+	s->bitFlags[chunkIndex] = s->initBitFlags;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < s->chunkEndX && stretchTile && Adv_CanStretch(s, block, chunkIndex, x, y, z, face)) {
+		s->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(s, block, face);
 	return count;
 }
 
-static int Adv_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchZ(struct BuilderState* s, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	s->initBitFlags = Adv_ComputeLightFlags(s, x, y, z, chunkIndex);
+	s->bitFlags[chunkIndex] = s->initBitFlags;
 
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < s->chunkEndZ && stretchTile && Adv_CanStretch(s, block, chunkIndex, x, y, z, face)) {
+		s->counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(s, block, face);
 	return count;
 }
 
 
 #define Adv_CountBits(F, a, b, c, d) (((F >> a) & 1) + ((F >> b) & 1) + ((F >> c) & 1) + ((F >> d) & 1))
 
-static void Adv_DrawXMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMIN);
+static void Adv_DrawXMin(struct BuilderState* s, int count) {
+	TextureLoc texLoc = Block_Tex(s->block, FACE_XMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.Z, u2 = (count - 1) + adv_maxBB.Z * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = s->minBB.Z, u2 = (count - 1) + s->maxBB.Z * UV2_Scale;
+	float v1 = vOrigin + s->maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + s->minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &s->parts[s->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = s->bitFlags[s->chunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xM1_yP1_zCC, xM1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xM1_yP1_zCC, xM1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = s->fullBright ? white : s->lerpX[aY0_Z0], col1_0 = s->fullBright ? white : s->lerpX[aY1_Z0];
+	PackedCol col1_1 = s->fullBright ? white : s->lerpX[aY1_Z1], col0_1 = s->fullBright ? white : s->lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (s->tinted) {
+		tint   = Blocks.FogCol[s->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_XMIN];
-	v.X = adv_x1;
+	v.X = s->x1;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.Y = adv_y2; v.Z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.Z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
-		v.Y = adv_y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.Y = s->y2; v.Z = s->z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.Y = s->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.Z = s->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.Y = s->y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.Y = adv_y2; v.Z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		              v.Z = adv_z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.Z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.Y = s->y2; v.Z = s->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		              v.Z = s->z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
+		v.Y = s->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.Z = s->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
 	}
 	part->fVertices[FACE_XMIN] = vertices;
 }
 
-static void Adv_DrawXMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMAX);
+static void Adv_DrawXMax(struct BuilderState* s, int count) {
+	TextureLoc texLoc = Block_Tex(s->block, FACE_XMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.Z), u2 = (1 - adv_maxBB.Z) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - s->minBB.Z), u2 = (1 - s->maxBB.Z) * UV2_Scale;
+	float v1 = vOrigin + s->maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + s->minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &s->parts[s->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = s->bitFlags[s->chunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xP1_yP1_zCC, xP1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xP1_yP1_zCC, xP1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = s->fullBright ? white : s->lerpX[aY0_Z0], col1_0 = s->fullBright ? white : s->lerpX[aY1_Z0];
+	PackedCol col1_1 = s->fullBright ? white : s->lerpX[aY1_Z1], col0_1 = s->fullBright ? white : s->lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (s->tinted) {
+		tint   = Blocks.FogCol[s->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_XMAX];
-	v.X = adv_x2;
+	v.X = s->x2;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.Y = adv_y2; v.Z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		              v.Z = adv_z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.Z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.Y = s->y2; v.Z = s->z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		              v.Z = s->z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.Y = s->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.Z = s->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
 	} else {
-		v.Y = adv_y2; v.Z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.Y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.Z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		v.Y = adv_y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.Y = s->y2; v.Z = s->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.Y = s->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.Z = s->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.Y = s->y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_XMAX] = vertices;
 }
 
-static void Adv_DrawZMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMIN);
+static void Adv_DrawZMin(struct BuilderState* s, int count) {
+	TextureLoc texLoc = Block_Tex(s->block, FACE_ZMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.X), u2 = (1 - adv_maxBB.X) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - s->minBB.X), u2 = (1 - s->maxBB.X) * UV2_Scale;
+	float v1 = vOrigin + s->maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + s->minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &s->parts[s->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = s->bitFlags[s->chunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col0_0 = s->fullBright ? white : s->lerpZ[aX0_Y0], col1_0 = s->fullBright ? white : s->lerpZ[aX1_Y0];
+	PackedCol col1_1 = s->fullBright ? white : s->lerpZ[aX1_Y1], col0_1 = s->fullBright ? white : s->lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (s->tinted) {
+		tint   = Blocks.FogCol[s->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_ZMIN];
-	v.Z = adv_z1;
+	v.Z = s->z1;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.X = adv_x2 + (count - 1); v.Y = adv_y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.Y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.X = s->x2 + (count - 1); v.Y = s->y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.X = s->x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.Y = s->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.X = s->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.X = adv_x1;               v.Y = adv_y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
-		                            v.Y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.Y = adv_y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.X = s->x1;               v.Y = s->y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
+		                            v.Y = s->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.X = s->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.Y = s->y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_ZMIN] = vertices;
 }
 
-static void Adv_DrawZMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMAX);
+static void Adv_DrawZMax(struct BuilderState* s, int count) {
+	TextureLoc texLoc = Block_Tex(s->block, FACE_ZMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.X, u2 = (count - 1) + adv_maxBB.X * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.Y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = s->minBB.X, u2 = (count - 1) + s->maxBB.X * UV2_Scale;
+	float v1 = vOrigin + s->maxBB.Y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + s->minBB.Y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &s->parts[s->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = s->bitFlags[s->chunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col1_1 = s->fullBright ? white : s->lerpZ[aX1_Y1], col1_0 = s->fullBright ? white : s->lerpZ[aX1_Y0];
+	PackedCol col0_0 = s->fullBright ? white : s->lerpZ[aX0_Y0], col0_1 = s->fullBright ? white : s->lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (s->tinted) {
+		tint   = Blocks.FogCol[s->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_ZMAX];
-	v.Z = adv_z2;
+	v.Z = s->z2;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.X = adv_x1;               v.Y = adv_y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
-		                            v.Y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.Y = adv_y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.X = s->x1;               v.Y = s->y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
+		                            v.Y = s->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.X = s->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.Y = s->y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.X = adv_x2 + (count - 1); v.Y = adv_y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.Y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.X = s->x2 + (count - 1); v.Y = s->y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.X = s->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.Y = s->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.X = s->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_ZMAX] = vertices;
 }
 
-static void Adv_DrawYMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMIN);
+static void Adv_DrawYMin(struct BuilderState* s, int count) {
+	TextureLoc texLoc = Block_Tex(s->block, FACE_YMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.X, u2 = (count - 1) + adv_maxBB.X * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.Z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = s->minBB.X, u2 = (count - 1) + s->maxBB.X * UV2_Scale;
+	float v1 = vOrigin + s->minBB.Z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + s->maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &s->parts[s->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = s->bitFlags[s->chunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_1 = Builder_FullBright ? white : adv_lerpY[aX0_Z1], col1_1 = Builder_FullBright ? white : adv_lerpY[aX1_Z1];
-	PackedCol col1_0 = Builder_FullBright ? white : adv_lerpY[aX1_Z0], col0_0 = Builder_FullBright ? white : adv_lerpY[aX0_Z0];
+	PackedCol col0_1 = s->fullBright ? white : s->lerpY[aX0_Z1], col1_1 = s->fullBright ? white : s->lerpY[aX1_Z1];
+	PackedCol col1_0 = s->fullBright ? white : s->lerpY[aX1_Z0], col0_0 = s->fullBright ? white : s->lerpY[aX0_Z0];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (s->tinted) {
+		tint   = Blocks.FogCol[s->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_YMIN];
-	v.Y = adv_y1;
+	v.Y = s->y1;
 	if (aX0_Z1 + aX1_Z0 > aX0_Z0 + aX1_Z1) {
-		v.X = adv_x2 + (count - 1); v.Z = adv_z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.Z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.X = s->x2 + (count - 1); v.Z = s->z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.X = s->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.Z = s->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.X = s->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	} else {
-		v.X = adv_x1;               v.Z = adv_z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
-		                            v.Z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.Z = adv_z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.X = s->x1;               v.Z = s->z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
+		                            v.Z = s->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.X = s->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.Z = s->z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
 	}
 	part->fVertices[FACE_YMIN] = vertices;
 }
 
-static void Adv_DrawYMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMAX);
+static void Adv_DrawYMax(struct BuilderState* s, int count) {
+	TextureLoc texLoc = Block_Tex(s->block, FACE_YMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.X, u2 = (count - 1) + adv_maxBB.X * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.Z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = s->minBB.X, u2 = (count - 1) + s->maxBB.X * UV2_Scale;
+	float v1 = vOrigin + s->minBB.Z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + s->maxBB.Z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &s->parts[s->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = s->bitFlags[s->chunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerp[aX0_Z0], col1_0 = Builder_FullBright ? white : adv_lerp[aX1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerp[aX1_Z1], col0_1 = Builder_FullBright ? white : adv_lerp[aX0_Z1];
+	PackedCol col0_0 = s->fullBright ? white : s->lerp[aX0_Z0], col1_0 = s->fullBright ? white : s->lerp[aX1_Z0];
+	PackedCol col1_1 = s->fullBright ? white : s->lerp[aX1_Z1], col0_1 = s->fullBright ? white : s->lerp[aX0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (s->tinted) {
+		tint   = Blocks.FogCol[s->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->fVertices[FACE_YMAX];
-	v.Y = adv_y2;
+	v.Y = s->y2;
 	if (aX0_Z0 + aX1_Z1 > aX0_Z1 + aX1_Z0) {
-		v.X = adv_x2 + (count - 1); v.Z = adv_z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.X = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.Z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.X = s->x2 + (count - 1); v.Z = s->z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.X = s->x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.Z = s->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.X = s->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.X = adv_x1;               v.Z = adv_z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
-		                            v.Z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.X = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.Z = adv_z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.X = s->x1;               v.Z = s->z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
+		                            v.Z = s->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.X = s->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.Z = s->z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->fVertices[FACE_YMAX] = vertices;
 }
 
-static void Adv_RenderBlock(int index, int x, int y, int z) {
+static void Adv_RenderBlock(struct BuilderState* s, int index, int x, int y, int z) {
 	Vec3 min, max;
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[s->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(s, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = s->counts[index + FACE_XMIN];
+	count_XMax = s->counts[index + FACE_XMAX];
+	count_ZMin = s->counts[index + FACE_ZMIN];
+	count_ZMax = s->counts[index + FACE_ZMAX];
+	count_YMin = s->counts[index + FACE_YMIN];
+	count_YMax = s->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	Builder_FullBright = Blocks.FullBright[Builder_Block];
-	adv_baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	adv_tinted     = Blocks.Tinted[Builder_Block];
+	s->fullBright = Blocks.FullBright[s->block];
+	s->baseOffset = (Blocks.Draw[s->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	s->tinted     = Blocks.Tinted[s->block];
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	adv_x1 = x + min.X; adv_y1 = y + min.Y; adv_z1 = z + min.Z;
-	adv_x2 = x + max.X; adv_y2 = y + max.Y; adv_z2 = z + max.Z;
+	min = Blocks.RenderMinBB[s->block]; max = Blocks.RenderMaxBB[s->block];
+	s->x1 = x + min.X; s->y1 = y + min.Y; s->z1 = z + min.Z;
+	s->x2 = x + max.X; s->y2 = y + max.Y; s->z2 = z + max.Z;
 
-	adv_minBB = Blocks.MinBB[Builder_Block]; adv_maxBB = Blocks.MaxBB[Builder_Block];
-	adv_minBB.Y = 1.0f - adv_minBB.Y; adv_maxBB.Y = 1.0f - adv_maxBB.Y;
+	s->minBB = Blocks.MinBB[s->block]; s->maxBB = Blocks.MaxBB[s->block];
+	s->minBB.Y = 1.0f - s->minBB.Y; s->maxBB.Y = 1.0f - s->maxBB.Y;
 
-	if (count_XMin) Adv_DrawXMin(count_XMin);
-	if (count_XMax) Adv_DrawXMax(count_XMax);
-	if (count_ZMin) Adv_DrawZMin(count_ZMin);
-	if (count_ZMax) Adv_DrawZMax(count_ZMax);
-	if (count_YMin) Adv_DrawYMin(count_YMin);
-	if (count_YMax) Adv_DrawYMax(count_YMax);
+	if (count_XMin) Adv_DrawXMin(s, count_XMin);
+	if (count_XMax) Adv_DrawXMax(s, count_XMax);
+	if (count_ZMin) Adv_DrawZMin(s, count_ZMin);
+	if (count_ZMax) Adv_DrawZMax(s, count_ZMax);
+	if (count_YMin) Adv_DrawYMin(s, count_YMin);
+	if (count_YMax) Adv_DrawYMax(s, count_YMax);
 }
 
-static void Adv_PrePrepareChunk(void) {
+static void Adv_PrePrepareChunk(struct BuilderState* s) {
 	int i;
-	DefaultPrePrepateChunk();
-	adv_bitFlags = Builder_BitFlags;
+	DefaultPrePrepateChunk(s);
 
 	for (i = 0; i <= 4; i++) {
-		adv_lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
-		adv_lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
-		adv_lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
-		adv_lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
+		s->lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
+		s->lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
+		s->lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
+		s->lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
 	}
 }
 
@@ -1250,6 +1342,170 @@ static void AdvBuilder_SetActive(void) {
 }
 
 
+/*########################################################################################################################*
+*--------------------------------------------------Mesh builder threads---------------------------------------------------*
+*#########################################################################################################################*/
+#define BUILDER_MAX_THREADS WORKERPOOL_MAX_THREADS
+int Builder_ThreadsCount;
+
+struct BuilderJob {
+	struct ChunkInfo* info;
+	struct BuilderState* state; /* State that contains the vertices of the chunk mesh */
+	int offset, count;          /* Location of the chunk mesh's vertices in state's buffer */
+};
+static struct BuilderJob* jobs;
+static int jobsCapacity, jobsCount, jobsNext, jobsDone;
+static void* jobsMutex;
+static void* jobsFinished;
+
+static struct WorkerPool builderPool;
+static struct BuilderState* threadsState[BUILDER_MAX_THREADS];
+
+static void RunJob(struct BuilderState* s, struct BuilderJob* job) {
+	struct ChunkInfo* info = job->info;
+	int x = info->CentreX - 8, y = info->CentreY - 8, z = info->CentreZ - 8;
+	int totalVerts;
+
+	job->state = s;
+	job->count = 0;
+	totalVerts = BuildChunk(s, x, y, z, info, NULL);
+	if (!totalVerts) return;
+
+	if (s->bufferCount + totalVerts > s->bufferCapacity) {
+		s->bufferCapacity = max(s->bufferCapacity * 2, s->bufferCount + totalVerts);
+		s->buffer = (struct VertexTextured*)Mem_Realloc(s->buffer, s->bufferCapacity, 
+														sizeof(struct VertexTextured), "chunk vertices");
+	}
+
+	job->offset  = s->bufferCount;
+	job->count   = totalVerts;
+	s->vertices  = s->buffer + s->bufferCount;
+	s->bufferCount += totalVerts;
+
+	RenderChunk(s, x, y, z);
+	SetPartInfos(s, info);
+}
+
+/* Keeps claiming and running jobs from the current batch, until there are no more jobs left */
+static void RunJobs(struct BuilderState* s) {
+	cc_bool finished;
+	int i;
+
+	for (;;) {
+		Mutex_Lock(jobsMutex);
+		i = jobsNext < jobsCount ? jobsNext++ : -1;
+		Mutex_Unlock(jobsMutex);
+		if (i == -1) return;
+
+		RunJob(s, &jobs[i]);
+
+		Mutex_Lock(jobsMutex);
+		finished = ++jobsDone == jobsCount;
+		Mutex_Unlock(jobsMutex);
+		if (finished) Waitable_Signal(jobsFinished);
+	}
+}
+
+static void BuilderWork(int index) { RunJobs(threadsState[index]); }
+static void BuilderThread(void)     { WorkerPool_RunWorker(&builderPool); }
+
+static void UploadJob(struct BuilderJob* job) {
+	struct VertexTextured* src = job->state->buffer + job->offset;
+#ifndef CC_BUILD_GL11
+	void* dst;
+	/* add an extra element to fix crashing on some GPUs */
+	dst = Gfx_RecreateAndLockVb(&job->info->Vb, VERTEX_FORMAT_TEXTURED, job->count + 1);
+	Mem_Copy(dst, src, job->count * sizeof(struct VertexTextured));
+	Gfx_UnlockVb(job->info->Vb);
+#else
+	job->state->vertices = src;
+	BuildChunkVbs(job->state, job->info);
+#endif
+}
+
+void Builder_MakeChunks(struct ChunkInfo** chunks, int count) {
+	cc_bool finished;
+	int i;
+
+	if (!Builder_ThreadsCount || count <= 1) {
+		for (i = 0; i < count; i++) { Builder_MakeChunk(chunks[i]); }
+		return;
+	}
+
+	if (count > jobsCapacity) {
+		jobsCapacity = count;
+		jobs = (struct BuilderJob*)Mem_Realloc(jobs, count, sizeof(struct BuilderJob), "builder jobs");
+	}
+	for (i = 0; i < count; i++) { jobs[i].info = chunks[i]; }
+
+	/* NOTE: The world and lighting must not be modified until all the jobs have finished */
+	Mutex_Lock(jobsMutex);
+	jobsCount = count; jobsNext = 0; jobsDone = 0;
+	mainState.bufferCount = 0;
+	for (i = 0; i < Builder_ThreadsCount; i++) { threadsState[i]->bufferCount = 0; }
+	Mutex_Unlock(jobsMutex);
+
+	WorkerPool_WakeAll(&builderPool);
+	RunJobs(&mainState);
+
+	for (;;) {
+		Mutex_Lock(jobsMutex);
+		finished = jobsDone == jobsCount;
+		Mutex_Unlock(jobsMutex);
+
+		if (finished) break;
+		Waitable_Wait(jobsFinished);
+	}
+
+	/* Graphics resources can only be created on the main thread */
+	for (i = 0; i < count; i++) {
+		if (jobs[i].count) UploadJob(&jobs[i]);
+	}
+}
+
+static void StartBuilderThreads(void) {
+	int i;
+#ifdef CC_BUILD_WEB
+	/* Threads are not supported in the webclient */
+	Builder_ThreadsCount = 0;
+#else
+	Builder_ThreadsCount = Options_GetInt(OPT_BUILDER_THREADS, 0, BUILDER_MAX_THREADS, 0);
+#endif
+	if (!Builder_ThreadsCount) return;
+
+	lightMutex   = Mutex_Create();
+	jobsMutex    = Mutex_Create();
+	jobsFinished = Waitable_Create();
+
+	for (i = 0; i < Builder_ThreadsCount; i++) {
+		threadsState[i] = (struct BuilderState*)Mem_AllocCleared(1, sizeof(struct BuilderState), "builder state");
+	}
+	WorkerPool_Start(&builderPool, Builder_ThreadsCount, BuilderThread, BuilderWork);
+}
+
+static void StopBuilderThreads(void) {
+	int i;
+	if (!Builder_ThreadsCount) return;
+	WorkerPool_Stop(&builderPool);
+
+	for (i = 0; i < Builder_ThreadsCount; i++) {
+		Mem_Free(threadsState[i]->buffer);
+		Mem_Free(threadsState[i]);
+	}
+
+	Mutex_Free(lightMutex);
+	Mutex_Free(jobsMutex);
+	Waitable_Free(jobsFinished);
+	lightMutex = NULL;
+
+	Mem_Free(mainState.buffer);
+	Mem_Free(jobs);
+	mainState.buffer   = NULL; mainState.bufferCapacity = 0;
+	jobs = NULL; jobsCapacity = 0;
+	Builder_ThreadsCount = 0;
+}
+
+
 /*########################################################################################################################*
 *---------------------------------------------------Builder interface-----------------------------------------------------*
 *#########################################################################################################################*/
@@ -1272,8 +1528,11 @@ static void OnInit(void) {
 
 	if (!Game_ClassicMode) Builder_SmoothLighting = Options_GetBool(OPT_SMOOTH_LIGHTING, false);
 	Builder_ApplyActive();
+	StartBuilderThreads();
 }
 
+static void OnFree(void) { StopBuilderThreads(); }
+
 static void OnNewMapLoaded(void) {
 	Builder_SidesLevel = max(0, Env_SidesHeight);
 	Builder_EdgeLevel  = max(0, Env.EdgeHeight);
@@ -1281,7 +1540,7 @@ static void OnNewMapLoaded(void) {
 
 struct IGameComponent Builder_Component = {
 	OnInit, /* Init */
-	NULL, /* Free */
+	OnFree, /* Free */
 	NULL, /* Reset */
 	NULL, /* OnNewMap */
 	OnNewMapLoaded /* OnNewMapLoaded */
@@ -17,8 +17,15 @@ extern int Builder_SidesLevel, Builder_EdgeLevel;
 /* Whether smooth/advanced lighting mesh builder is used. */
 extern cc_bool Builder_SmoothLighting;
 
+/* Number of extra threads used to build chunk meshes. (0 means only the main thread builds meshes) */
+extern int Builder_ThreadsCount;
+
 /* Builds the mesh of vertices for the given chunk. */
 void Builder_MakeChunk(struct ChunkInfo* info);
+/* Builds the meshes of vertices for the given chunks. */
+/* NOTE: If Builder_ThreadsCount is not 0, the meshes are built in parallel across multiple threads. */
+/* (The world and lighting must not be modified by other threads while this function is running) */
+void Builder_MakeChunks(struct ChunkInfo** chunks, int count);
 
 void Builder_ApplyActive(void);
 #endif
@@ -18,6 +18,8 @@
 #include "TexturePack.h"
 #include "Options.h"
 #include "Drawer2D.h"
+#include "Profiler.h"
+#include "Http.h"
  
 static char status[5][STRING_SIZE];
 static char bottom[3][STRING_SIZE];
@@ -500,6 +502,65 @@ static struct ChatCommand ClearDeniedCommand = {
 	}
 };
 
+static void ProfilerCommand_Execute(const cc_string* args, int argsCount) {
+	static const cc_string csv  = String_FromConst("csv");
+	static const cc_string path = String_FromConst("profiler.csv");
+	cc_result res;
+
+	if (!argsCount || !String_CaselessEquals(args, &csv)) {
+		Profiler_SetEnabled(!Profiler.Enabled);
+		Chat_Add1("&e/client: &fProfiler is now %c.", Profiler.Enabled ? "enabled" : "disabled");
+	} else if (!Profiler.FramesCount) {
+		Chat_AddRaw("&e/client: &cProfiler hasn't measured any frames yet.");
+	} else {
+		res = Profiler_SaveCSV(&path);
+		if (res) { Logger_SysWarn2(res, "saving", &path); return; }
+		Chat_Add1("&e/client: &fSaved timings of the last %i frames to profiler.csv", &Profiler.FramesCount);
+	}
+}
+
+static struct ChatCommand ProfilerCommand = {
+	"Profiler", ProfilerCommand_Execute,
+	COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client profiler [csv]",
+		"&eToggles showing how long each part of a frame takes.",
+		"&e  If csv is given, saves the timings of recent frames",
+		"&e  to profiler.csv instead (one line per frame, in ms)",
+	}
+};
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------HttpCommand------------------------------------------------------*
+*#########################################################################################################################*/
+static void HttpCommand_Execute(const cc_string* args, int argsCount) {
+	int i, ms;
+	Chat_Add1("&e/client: &f%i HTTP requests completed (time waiting in queue / time taken)", &HttpStats.Count);
+
+	for (i = 0; i < HTTP_HISTOGRAM_BUCKETS; i++) {
+		if (!HttpStats.WaitTimes[i] && !HttpStats.Latencies[i]) continue;
+		ms = 1 << i;
+
+		if (i < HTTP_HISTOGRAM_BUCKETS - 1) {
+			Chat_Add3("&e  Under %i ms: &f%i / %i",   &ms, &HttpStats.WaitTimes[i], &HttpStats.Latencies[i]);
+		} else {
+			ms >>= 1;
+			Chat_Add3("&e  %i ms or more: &f%i / %i", &ms, &HttpStats.WaitTimes[i], &HttpStats.Latencies[i]);
+		}
+	}
+}
+
+static struct ChatCommand HttpCommand = {
+	"Http", HttpCommand_Execute,
+	COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client http",
+		"&eShows how long HTTP requests (e.g. skins) waited to be",
+		"&e  started, and how long they then took to complete",
+	}
+};
+
 
 /*########################################################################################################################*
 *-------------------------------------------------------CuboidCommand-----------------------------------------------------*
@@ -510,10 +571,25 @@ static cc_bool cuboid_persist, cuboid_hooked, cuboid_hasMark1;
 static const cc_string cuboid_msg = String_FromConst("&eCuboid: &fPlace or delete a block.");
 static const cc_string yes_string = String_FromConst("yes");
 
+/* Blocks are placed in batches, as that's much faster than placing each block individually */
+#define CUBOID_BATCH_SIZE 256
+static int cuboid_indices[CUBOID_BATCH_SIZE];
+static BlockID cuboid_old[CUBOID_BATCH_SIZE], cuboid_new[CUBOID_BATCH_SIZE];
+
+static void CuboidCommand_PlaceBatch(int count) {
+	int i, x, y, z;
+	Game_UpdateBlocks(cuboid_indices, cuboid_new, count);
+
+	for (i = 0; i < count; i++) {
+		World_Unpack(cuboid_indices[i], x, y, z);
+		Server.SendBlock(x, y, z, cuboid_old[i], cuboid_new[i]);
+	}
+}
+
 static void CuboidCommand_DoCuboid(void) {
 	IVec3 min, max;
 	BlockID toPlace;
-	int x, y, z;
+	int x, y, z, count = 0;
 
 	IVec3_Min(&min, &cuboid_mark1, &cuboid_mark2);
 	IVec3_Max(&max, &cuboid_mark1, &cuboid_mark2);
@@ -526,10 +602,17 @@ static void CuboidCommand_DoCuboid(void) {
 	for (y = min.Y; y <= max.Y; y++) {
 		for (z = min.Z; z <= max.Z; z++) {
 			for (x = min.X; x <= max.X; x++) {
-				Game_ChangeBlock(x, y, z, toPlace);
+				cuboid_indices[count] = World_Pack(x, y, z);
+				cuboid_old[count]     = World_GetBlock(x, y, z);
+				cuboid_new[count]     = toPlace;
+
+				if (++count < CUBOID_BATCH_SIZE) continue;
+				CuboidCommand_PlaceBatch(count);
+				count = 0;
 			}
 		}
 	}
+	if (count) CuboidCommand_PlaceBatch(count);
 }
 
 static void CuboidCommand_BlockChanged(void* obj, IVec3 coords, BlockID old, BlockID now) {
@@ -681,6 +764,8 @@ static void OnInit(void) {
 	Commands_Register(&CuboidCommand);
 	Commands_Register(&TeleportCommand);
 	Commands_Register(&ClearDeniedCommand);
+	Commands_Register(&ProfilerCommand);
+	Commands_Register(&HttpCommand);
 
 #if defined CC_BUILD_MOBILE || defined CC_BUILD_WEB
 	/* Better to not log chat by default on mobile/web, */
@@ -1,4 +1,11 @@
 #include "Deflate.h"
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define Inflate_Copy16(dst, src) _mm_storeu_si128((__m128i*)(dst), _mm_loadu_si128((const __m128i*)(src)))
+#elif defined __ARM_NEON
+#include <arm_neon.h>
+#define Inflate_Copy16(dst, src) vst1q_u8(dst, vld1q_u8(src))
+#endif
 #include "String.h"
 #include "Logger.h"
 #include "Funcs.h"
@@ -162,10 +169,10 @@ enum INFLATE_STATE_ {
 #define Inflate_NextBlockState(state) (state->LastBlock ? INFLATE_STATE_DONE : INFLATE_STATE_HEADER)
 /* Goes to the next state, after having finished reading a compressed entry */
 #define Inflate_NextCompressState(state) ((state->AvailIn >= INFLATE_FASTINF_IN && state->AvailOut >= INFLATE_FASTINF_OUT) ? INFLATE_STATE_FASTCOMPRESSED : INFLATE_STATE_COMPRESSED_LIT)
-/* The maximum amount of bytes that can be output is 258 */
-#define INFLATE_FASTINF_OUT 258
-/* The most input bytes required for huffman codes and extra data is 16 + 5 + 16 + 13 bits. Add 3 extra bytes to account for putting data into the bit buffer. */
-#define INFLATE_FASTINF_IN 10
+/* The maximum amount of bytes that can be output is 2 literals followed by a 258 byte match */
+#define INFLATE_FASTINF_OUT 260
+/* The bit buffer is refilled at most twice, and each refill reads 8 bytes but only consumes up to 7 of them */
+#define INFLATE_FASTINF_IN 16
 
 static cc_uint32 Huffman_ReverseBits(cc_uint32 n, cc_uint8 bits) {
 	n = ((n & 0xAAAA) >> 1) | ((n & 0x5555) << 1);
@@ -296,44 +303,26 @@ static int Huffman_Decode(struct InflateState* state, struct HuffmanTable* table
 	return -1;
 }
 
-/* Inline the common <= 9 bits case */
-#define Huffman_UNSAFE_Decode(state, table, result) \
-{\
-	Inflate_UNSAFE_EnsureBits(state, INFLATE_MAX_BITS);\
-	packed = table.Fast[Inflate_PeekBits(state, INFLATE_FAST_BITS)];\
-	if (packed >= 0) {\
-		consumedBits = packed >> INFLATE_FAST_BITS;\
-		Inflate_ConsumeBits(state, consumedBits);\
-		result = packed & 0x1FF;\
-	} else {\
-		result = Huffman_UNSAFE_Decode_Slow(state, &table);\
-	}\
-}
-
-static int Huffman_UNSAFE_Decode_Slow(struct InflateState* state, struct HuffmanTable* table) {
+/* Decodes a huffman codeword longer than INFLATE_FAST_BITS from the lowest bits of the given bit buffer */
+/* Returns -1 if the bits are not a valid codeword, otherwise sets codeLen to length of the codeword */
+static int Huffman_DecodeSlow(struct HuffmanTable* table, cc_uint64 bits, cc_uint32* codeLen) {
 	cc_uint32 i, j, codeword;
 	int offset;
 
 	/* Slow, bit by bit lookup. Need to reverse order for huffman. */
-	codeword = Inflate_PeekBits(state,       INFLATE_FAST_BITS);
+	codeword = (cc_uint32)bits & ((1 << INFLATE_FAST_BITS) - 1);
 	codeword = Huffman_ReverseBits(codeword, INFLATE_FAST_BITS);
 
 	for (i = INFLATE_FAST_BITS + 1, j = INFLATE_FAST_BITS; i < INFLATE_MAX_BITS; i++, j++) {
-		codeword = (codeword << 1) | ((state->Bits >> j) & 1);
+		codeword = (codeword << 1) | ((bits >> j) & 1);
 
 		if (codeword < table->EndCodewords[i]) {
-			offset = table->FirstOffsets[i] + (codeword - table->FirstCodewords[i]);
-			Inflate_ConsumeBits(state, i);
+			offset   = table->FirstOffsets[i] + (codeword - table->FirstCodewords[i]);
+			*codeLen = i;
 			return table->Values[offset];
 		}
 	}
-
-	Inflate_Fail(state, INF_ERR_INVALID_CODE);
-	/* Need to exit the fast decode loop */
-	/* TODO: This means a few garbage bytes can get written */
-	/* to the output, but it probably doesn't matter */
-	state->AvailIn = 0;
-	return 0;
+	return -1;
 }
 
 void Inflate_Init2(struct InflateState* state, struct Stream* source) {
@@ -389,11 +378,63 @@ static const cc_uint8 codelens_order[INFLATE_MAX_CODELENS] = {
 	16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 
 };
 
+/* Copies a LZ77 match within the window, where src is 'dist' bytes before dst */
+static void Inflate_CopyMatch(cc_uint8* dst, const cc_uint8* src, cc_uint32 len, cc_uint32 dist) {
+	cc_uint32 i = 0;
+	/* Long runs of the same byte (e.g. air in maps) are very common */
+	if (dist == 1) { Mem_Set(dst, *src, len); return; }
+
+#ifdef Inflate_Copy16
+	/* When src is at least 16 bytes behind dst, every byte in a 16 byte chunk */
+	/*  of src has already been written by the time that chunk is copied */
+	if (dist >= 16) {
+		for (; i + 16 <= len; i += 16) { Inflate_Copy16(dst + i, src + i); }
+	}
+#endif
+	for (; i + 4 <= len; i += 4) {
+		dst[i + 0] = src[i + 0]; dst[i + 1] = src[i + 1];
+		dst[i + 2] = src[i + 2]; dst[i + 3] = src[i + 3];
+	}
+	for (; i < len; i++) { dst[i] = src[i]; }
+}
+
+/* Reads 8 bytes as a little endian 64 bit integer (compilers turn this into a single load where possible) */
+#define Inflate_Read64(p) \
+	((cc_uint64)(p)[0]         | ((cc_uint64)(p)[1] <<  8) | ((cc_uint64)(p)[2] << 16) | ((cc_uint64)(p)[3] << 24) | \
+	((cc_uint64)(p)[4] << 32) | ((cc_uint64)(p)[5] << 40) | ((cc_uint64)(p)[6] << 48) | ((cc_uint64)(p)[7] << 56))
+
+/* Tops up the 64 bit bit buffer to at least 56 bits. Always reads 8 bytes, but only consumes the whole bytes that fit */
+/* Bits above numBits are then the same as the next unconsumed bytes, so the next refill ORs in the same bits again */
+#define Inflate_Refill64() \
+	bitbuf  |= Inflate_Read64(in) << numBits; \
+	in      += (63 - numBits) >> 3; \
+	numBits |= 56;
+
+/* Decodes the next huffman encoded value from the 64 bit bit buffer */
+#define Inflate_Decode64(table, result) \
+	packed = table.Fast[bitbuf & ((1 << INFLATE_FAST_BITS) - 1)]; \
+	if (packed >= 0) { \
+		consumedBits = packed >> INFLATE_FAST_BITS; \
+		result = packed & 0x1FF; \
+	} else { \
+		result = Huffman_DecodeSlow(&table, bitbuf, &consumedBits); \
+		if (result < 0) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; } \
+	} \
+	bitbuf >>= consumedBits; numBits -= consumedBits;
+
+#define Inflate_PutLit(lit) window[curIdx] = (cc_uint8)lit; curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK; copyLen++;
+
 static void Inflate_InflateFast(struct InflateState* s) {
+	/* bit buffer variables */
+	cc_uint64 bitbuf;
+	cc_uint32 numBits, consumedBits, unused;
+	cc_uint8* in;
+	cc_uint8* inEnd;
+
 	/* huffman variables */
-	cc_uint32 lit, len, dist;
-	cc_uint32 bits, lenIdx, distIdx;
-	int packed, consumedBits;
+	cc_uint32 len, dist;
+	cc_uint32 bits, lenIdx;
+	int lit, distIdx, packed;
 
 	/* window variables */
 	cc_uint8* window;
@@ -405,51 +446,70 @@ static void Inflate_InflateFast(struct InflateState* s) {
 	copyStart = s->WindowIndex;
 	copyLen   = 0;
 
+	bitbuf  = s->Bits;
+	numBits = s->NumBits;
+	in      = s->NextIn;
+	inEnd   = s->NextIn + s->AvailIn;
+
 #define INFLATE_FAST_COPY_MAX (INFLATE_WINDOW_SIZE - INFLATE_FASTINF_OUT)
-	while (s->AvailOut >= INFLATE_FASTINF_OUT && s->AvailIn >= INFLATE_FASTINF_IN && copyLen < INFLATE_FAST_COPY_MAX) {
-		Huffman_UNSAFE_Decode(s, s->Table.Lits, lit);
+	while (s->AvailOut - copyLen >= INFLATE_FASTINF_OUT && (cc_uint32)(inEnd - in) >= INFLATE_FASTINF_IN && copyLen < INFLATE_FAST_COPY_MAX) {
+		Inflate_Refill64();
+		Inflate_Decode64(s->Table.Lits, lit);
+
+		/* Literals are at most 15 bits, so after a refill up to 3 can be decoded before refilling again */
+		if (lit < 256) {
+			Inflate_PutLit(lit);
+			Inflate_Decode64(s->Table.Lits, lit);
 
-		if (lit <= 256) {
 			if (lit < 256) {
-				window[curIdx] = (cc_uint8)lit;
-				s->AvailOut--; copyLen++;
-				curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
-			} else {
-				s->State = Inflate_NextBlockState(s);
-				break;
+				Inflate_PutLit(lit);
+				Inflate_Decode64(s->Table.Lits, lit);
+				if (lit < 256) { Inflate_PutLit(lit); continue; }
 			}
+			Inflate_Refill64();
+		}
+
+		if (lit == 256) {
+			s->State = Inflate_NextBlockState(s);
+			break;
+		}
+
+		/* Length and distance together are at most 15 + 5 + 15 + 13 bits */
+		lenIdx  = lit - 257;
+		bits    = len_bits[lenIdx];
+		len     = len_base[lenIdx] + ((cc_uint32)bitbuf & ((1 << bits) - 1));
+		bitbuf >>= bits; numBits -= bits;
+
+		Inflate_Decode64(s->TableDists, distIdx);
+		bits    = dist_bits[distIdx];
+		dist    = dist_base[distIdx] + ((cc_uint32)bitbuf & ((1 << bits) - 1));
+		bitbuf >>= bits; numBits -= bits;
+
+		/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
+		/* If start and end don't cross a boundary, can avoid masking index */
+		startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
+		if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
+			Inflate_CopyMatch(&window[curIdx], &window[startIdx], len, dist);
 		} else {
-			lenIdx = lit - 257;
-			bits = len_bits[lenIdx];
-			Inflate_UNSAFE_EnsureBits(s, bits);
-			len  = len_base[lenIdx] + Inflate_ReadBits(s, bits);
-
-			Huffman_UNSAFE_Decode(s, s->TableDists, distIdx);
-			bits = dist_bits[distIdx];
-			Inflate_UNSAFE_EnsureBits(s, bits);
-			dist = dist_base[distIdx] + Inflate_ReadBits(s, bits);
-	
-			/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
-			/* If start and end don't cross a boundary, can avoid masking index */
-			startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
-			if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
-				cc_uint8* src = &window[startIdx]; 
-				cc_uint8* dst = &window[curIdx];
-
-				for (i = 0; i < (len & ~0x3); i += 4) {
-					*dst++ = *src++; *dst++ = *src++; *dst++ = *src++; *dst++ = *src++;
-				}
-				for (; i < len; i++) { *dst++ = *src++; }
-			} else {
-				for (i = 0; i < len; i++) {
-					window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
-				}
+			for (i = 0; i < len; i++) {
+				window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
 			}
-			curIdx = (curIdx + len) & INFLATE_WINDOW_MASK;
-			s->AvailOut -= len; copyLen += len;
 		}
+		curIdx   = (curIdx + len) & INFLATE_WINDOW_MASK;
+		copyLen += len;
 	}
 
+	/* Put whole bytes left in the bit buffer back into the input buffer */
+	/* (only bytes read in this function are guaranteed to still be in the input buffer) */
+	unused   = min(numBits >> 3, (cc_uint32)(in - s->NextIn));
+	in      -= unused;
+	numBits -= unused * 8;
+
+	s->Bits        = (cc_uint32)(bitbuf & (((cc_uint64)1 << numBits) - 1));
+	s->NumBits     = numBits;
+	s->AvailIn    -= (cc_uint32)(in - s->NextIn);
+	s->NextIn      = in;
+	s->AvailOut   -= copyLen;
 	s->WindowIndex = curIdx;
 	if (!copyLen) return;
 
@@ -801,7 +861,9 @@ static const cc_uint16 deflate_dist[31] = {
 /* Number of bytes that match (are the same) from a and b */
 static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
 	int i = 0;
-	while (i < maxLen && *a == *b) { i++; a++; b++; }
+	/* Compare 8 bytes at a time first, since matches in map data are often very long */
+	while (i + 8 <= maxLen && Inflate_Read64(a + i) == Inflate_Read64(b + i)) { i += 8; }
+	while (i < maxLen && a[i] == b[i]) { i++; }
 	return i;
 }
 
@@ -850,7 +912,7 @@ static void Deflate_MoveBlock(struct DeflateState* state) {
 /* Compresses current block of data */
 static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
 	cc_uint32 hash, nextHash;
-	int bestLen, maxLen, matchLen, depth;
+	int bestLen, maxLen, matchLen, niceLen, depth;
 	int bestPos, pos, nextPos;
 	cc_uint16 oldHead;
 	cc_uint8* input;
@@ -871,18 +933,23 @@ static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
 	/* Use > instead of >=, because also try match at one byte after current */
 	while (len > MIN_MATCH_LEN) {
 		hash   = Deflate_Hash(cur);
-		maxLen = min(len, MAX_MATCH_LEN);
+		maxLen  = min(len, MAX_MATCH_LEN);
+		niceLen = min(maxLen, state->NiceLen);
 
 		bestLen = MIN_MATCH_LEN - 1; /* Match must be at least 3 bytes */
 		bestPos = 0;
 
 		/* Find longest match starting at this byte */
-		/* Only explore up to 5 previous matches, to avoid slow performance */
+		/* Only explore a few previous matches (depending on level), to avoid slow performance */
 		/* (i.e prefer quickly saving maps/screenshots to completely optimal filesize) */
 		pos = state->Head[hash];
-		for (depth = 0; pos != 0 && depth < 5; depth++) {
-			matchLen = Deflate_MatchLen(&input[pos], cur, maxLen);
-			if (matchLen > bestLen) { bestLen = matchLen; bestPos = pos; }
+		for (depth = 0; pos != 0 && depth < state->MaxChain; depth++) {
+			/* Can only be a longer match if the byte just past the current longest match is also the same */
+			if (input[pos + bestLen] == cur[bestLen]) {
+				matchLen = Deflate_MatchLen(&input[pos], cur, maxLen);
+				if (matchLen > bestLen) { bestLen = matchLen; bestPos = pos; }
+				if (bestLen >= niceLen) break;
+			}
 			pos = state->Prev[pos];
 		}
 
@@ -894,14 +961,16 @@ static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
 
 		/* Lazy evaluation: Find longest match starting at next byte */
 		/* If that's longer than the longest match at current byte, throwaway this match */
-		if (bestPos) {
+		maxLen = min(len - 1, MAX_MATCH_LEN);
+		if (bestPos && bestLen < state->LazyLen && bestLen < maxLen) {
 			nextHash = Deflate_Hash(cur + 1);
 			nextPos  = state->Head[nextHash];
-			maxLen   = min(len - 1, MAX_MATCH_LEN);
 
-			for (depth = 0; nextPos != 0 && depth < 5; depth++) {
-				matchLen = Deflate_MatchLen(&input[nextPos], cur + 1, maxLen);
-				if (matchLen > bestLen) { bestPos = 0; break; }
+			for (depth = 0; nextPos != 0 && depth < state->MaxChain; depth++) {
+				if (input[nextPos + bestLen] == cur[1 + bestLen]) {
+					matchLen = Deflate_MatchLen(&input[nextPos], cur + 1, maxLen);
+					if (matchLen > bestLen) { bestPos = 0; break; }
+				}
 				nextPos = state->Prev[nextPos];
 			}
 		}
@@ -966,16 +1035,14 @@ static cc_result Deflate_StreamWrite(struct Stream* stream, const cc_uint8* data
 }
 
 /* Flushes any buffered data, then writes terminating symbol */
-static cc_result Deflate_StreamClose(struct Stream* stream) {
-	struct DeflateState* state;
-	cc_result res;
-
-	state = (struct DeflateState*)stream->Meta.Inflate;
-	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE);
+/* If not the final block, an empty stored block is also written, so that the output ends on a byte boundary */
+static cc_result Deflate_EndBlock(struct DeflateState* state, cc_bool final) {
+	cc_result res = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE);
 	if (res) return res;
 
 	/* Write huffman encoded "literal 256" to terminate symbols */
 	Deflate_PushLit(state, 256);
+	if (!final) { Deflate_PushBits(state, 0, 3); } /* final block FALSE, block type STORED */
 	Deflate_FlushBits(state);
 
 	/* In case last byte still has a few extra bits */
@@ -984,9 +1051,19 @@ static cc_result Deflate_StreamClose(struct Stream* stream) {
 		Deflate_FlushBits(state);
 	}
 
+	/* Stored block length (0), then ones complement of length */
+	if (!final) {
+		Deflate_PushBits(state, 0x0000, 16); Deflate_FlushBits(state);
+		Deflate_PushBits(state, 0xFFFF, 16); Deflate_FlushBits(state);
+	}
 	return Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
 }
 
+static cc_result Deflate_StreamClose(struct Stream* stream) {
+	struct DeflateState* state = (struct DeflateState*)stream->Meta.Inflate;
+	return Deflate_EndBlock(state, true);
+}
+
 /* Constructs a huffman encoding table (for values to codewords) */
 static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
 	int i, j, offset, codeword;
@@ -1026,6 +1103,20 @@ void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struc
 	Mem_Set(state->Head, 0, sizeof(state->Head));
 	Mem_Set(state->Prev, 0, sizeof(state->Prev));
 	Deflate_BuildTable(fixed_lits, INFLATE_MAX_LITS, state->LitsCodewords, state->LitsLens);
+	Deflate_SetLevel(state, DEFLATE_DEFAULT_LEVEL);
+}
+
+/* Max chain length, nice length, and lazy match length for each level */
+static const cc_uint16 deflate_levels[DEFLATE_MAX_LEVEL + 1][3] = {
+	{   0,   0,   0 }, {   1,  16,   0 }, {   2,  32,   0 }, {   4,  64,  16 }, {   4, 128,  32 },
+	{   5, 258, 258 }, {   8, 258, 258 }, {  16, 258, 258 }, {  64, 258, 258 }, { 256, 258, 258 }
+};
+
+void Deflate_SetLevel(struct DeflateState* state, int level) {
+	level = max(DEFLATE_MIN_LEVEL, min(level, DEFLATE_MAX_LEVEL));
+	state->MaxChain = deflate_levels[level][0];
+	state->NiceLen  = deflate_levels[level][1];
+	state->LazyLen  = deflate_levels[level][2];
 }
 
 
@@ -1076,6 +1167,248 @@ void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stre
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------GZip (parallel compress)------------------------------------------------*
+*#########################################################################################################################*/
+/* Slices are large enough that the small overhead of each slice doesn't matter much */
+#define GZIP_SLICE_SIZE (128 * 1024)
+enum GZipSliceState { SLICE_FILLING, SLICE_QUEUED, SLICE_COMPRESSING, SLICE_DONE };
+
+struct GZipSlice {
+	cc_uint8* input;  cc_uint32 inputLen, crc32;
+	cc_uint8* output; cc_uint32 outputLen, outputCapacity;
+	int state; cc_bool final;
+};
+/* Thread functions have no arguments, hence only one parallel stream at a time */
+static struct GZipParallelState* gzParallel;
+
+/* Multiplies a and b modulo the (bit reversed) CRC32 polynomial */
+static cc_uint32 Crc32_MultMod(cc_uint32 a, cc_uint32 b) {
+	cc_uint32 m = 1UL << 31, p = 0;
+	for (; m; m >>= 1) {
+		if (a & m) p ^= b;
+		b = (b & 1) ? (b >> 1) ^ 0xEDB88320UL : (b >> 1);
+	}
+	return p;
+}
+
+/* Calculates CRC32 of A followed by B, given CRC32 of A, and CRC32 and length of B */
+/* Based off crc32_combine from zlib, i.e. crcA is multiplied by x^(8 * lenB) */
+static cc_uint32 Crc32_Combine(cc_uint32 crcA, cc_uint32 crcB, cc_uint32 lenB) {
+	cc_uint32 x = 1UL << 30; /* x^1, which is then squared to give x^2, x^4, x^8, ... */
+	cc_uint32 p = 1UL << 31; /* x^0 */
+	int i;
+
+	for (i = 0; i < 3; i++) { x = Crc32_MultMod(x, x); }
+	for (; lenB; lenB >>= 1) {
+		if (lenB & 1) p = Crc32_MultMod(x, p);
+		x = Crc32_MultMod(x, x);
+	}
+	return Crc32_MultMod(p, crcA) ^ crcB;
+}
+
+static cc_result GZipSlice_Write(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct GZipSlice* slice = (struct GZipSlice*)stream->Meta.Inflate;
+
+	if (slice->outputLen + count > slice->outputCapacity) {
+		slice->outputCapacity = max(slice->outputCapacity * 2, slice->outputLen + count);
+		slice->output = (cc_uint8*)Mem_Realloc(slice->output, slice->outputCapacity, 1, "GZip slice output");
+	}
+	Mem_Copy(slice->output + slice->outputLen, data, count);
+	slice->outputLen += count;
+	*modified = count;
+	return 0;
+}
+
+/* Compresses the slice's input into a separate DEFLATE block, that ends on a byte boundary */
+static void GZipSlice_Compress(struct DeflateState* state, struct GZipSlice* slice, int level) {
+	struct Stream stream, output;
+	Stream_Init(&output);
+	output.Write = GZipSlice_Write;
+	output.Meta.Inflate = slice;
+	slice->outputLen    = 0;
+
+	Deflate_MakeStream(&stream, state, &output);
+	Deflate_SetLevel(state, level);
+	state->WroteHeader = true;
+	Deflate_PushBits(state, slice->final ? 3 : 2, 3); /* final block TRUE or FALSE, block type FIXED */
+
+	/* Writing to memory never fails */
+	(void)Stream_Write(&stream, slice->input, slice->inputLen);
+	(void)Deflate_EndBlock(state, slice->final);
+	slice->crc32 = Utils_CRC32(slice->input, slice->inputLen);
+}
+
+/* Keeps claiming and compressing queued slices, until there are no more queued slices left */
+static void GZipParallel_Work(int index) {
+	struct GZipParallelState* s = gzParallel;
+	struct GZipSlice* slice;
+	int i;
+
+	for (;;) {
+		/* Oldest queued slice is compressed first, so slices are written out as soon as possible */
+		slice = NULL;
+		Mutex_Lock(s->Mutex);
+		for (i = s->Written; i < s->Queued; i++) {
+			if (s->Slices[i % s->SlicesCount].state != SLICE_QUEUED) continue;
+			slice = &s->Slices[i % s->SlicesCount];
+			slice->state = SLICE_COMPRESSING;
+			break;
+		}
+		Mutex_Unlock(s->Mutex);
+		if (!slice) return;
+
+		GZipSlice_Compress(s->States[index], slice, s->Level);
+		Mutex_Lock(s->Mutex);
+		slice->state = SLICE_DONE;
+		Mutex_Unlock(s->Mutex);
+		Waitable_Signal(s->SliceDone);
+	}
+}
+static void GZipParallel_Thread(void) { WorkerPool_RunWorker(&gzParallel->Pool); }
+
+static void GZipParallel_Start(struct GZipParallelState* s) {
+	int i;
+	gzParallel = s;
+	s->Mutex     = Mutex_Create();
+	s->SliceDone = Waitable_Create();
+	s->Slices    = (struct GZipSlice*)Mem_AllocCleared(s->SlicesCount, sizeof(struct GZipSlice), "GZip slices");
+
+	for (i = 0; i < s->SlicesCount; i++) {
+		s->Slices[i].input = (cc_uint8*)Mem_Alloc(GZIP_SLICE_SIZE, 1, "GZip slice input");
+	}
+	for (i = 0; i < s->ThreadsCount; i++) {
+		s->States[i] = (struct DeflateState*)Mem_Alloc(1, sizeof(struct DeflateState), "GZip deflate state");
+	}
+	WorkerPool_Start(&s->Pool, s->ThreadsCount, GZipParallel_Thread, GZipParallel_Work);
+}
+
+static void GZipParallel_Stop(struct GZipParallelState* s) {
+	int i;
+	if (!s->Slices) return;
+	WorkerPool_Stop(&s->Pool);
+
+	for (i = 0; i < s->ThreadsCount; i++) {
+		Mem_Free(s->States[i]);
+	}
+	for (i = 0; i < s->SlicesCount; i++) {
+		Mem_Free(s->Slices[i].input);
+		Mem_Free(s->Slices[i].output);
+	}
+
+	Mutex_Free(s->Mutex);
+	Waitable_Free(s->SliceDone);
+	Mem_Free(s->Slices);
+	s->Slices  = NULL;
+	gzParallel = NULL;
+}
+
+static void GZipParallel_Queue(struct GZipParallelState* s, cc_bool final) {
+	if (!s->Slices) GZipParallel_Start(s);
+
+	Mutex_Lock(s->Mutex);
+	s->Slices[s->Queued % s->SlicesCount].final = final;
+	s->Slices[s->Queued % s->SlicesCount].state = SLICE_QUEUED;
+	s->Queued++;
+	Mutex_Unlock(s->Mutex);
+	WorkerPool_WakeAll(&s->Pool);
+}
+
+/* Writes compressed slices in order to the destination, until at most maxPending slices are left */
+static cc_result GZipParallel_Drain(struct GZipParallelState* s, int maxPending) {
+	static cc_uint8 header[10] = { 0x1F, 0x8B, 0x08 }; /* GZip header */
+	struct GZipSlice* slice;
+	cc_bool done;
+	cc_result res;
+
+	if (!s->WroteHeader) {
+		s->WroteHeader = true;
+		if ((res = Stream_Write(s->Dest, header, sizeof(header)))) return res;
+	}
+
+	while (s->Written < s->Queued) {
+		slice = &s->Slices[s->Written % s->SlicesCount];
+		Mutex_Lock(s->Mutex);
+		done = slice->state == SLICE_DONE;
+		Mutex_Unlock(s->Mutex);
+
+		if (!done) {
+			if (s->Queued - s->Written <= maxPending) break;
+			Waitable_Wait(s->SliceDone); continue;
+		}
+
+		if ((res = Stream_Write(s->Dest, slice->output, slice->outputLen))) return res;
+		s->Crc32 = Crc32_Combine(s->Crc32, slice->crc32, slice->inputLen);
+		s->Size += slice->inputLen;
+
+		Mutex_Lock(s->Mutex);
+		slice->inputLen = 0;
+		slice->state    = SLICE_FILLING;
+		s->Written++;
+		Mutex_Unlock(s->Mutex);
+	}
+	return 0;
+}
+
+static cc_result GZipParallel_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct GZipParallelState* s = (struct GZipParallelState*)stream->Meta.Inflate;
+	struct GZipSlice* slice;
+	cc_uint32 len;
+	*modified = 0;
+	if (s->Res) return s->Res;
+
+	while (count > 0) {
+		if (!s->Slices) GZipParallel_Start(s);
+		slice = &s->Slices[s->Queued % s->SlicesCount];
+		len   = min(count, GZIP_SLICE_SIZE - slice->inputLen);
+
+		Mem_Copy(slice->input + slice->inputLen, data, len);
+		slice->inputLen += len;
+		*modified += len;
+		data  += len;
+		count -= len;
+		if (slice->inputLen < GZIP_SLICE_SIZE) continue;
+
+		/* Wait for the next slice in the ring buffer to be written out, before it is refilled */
+		GZipParallel_Queue(s, false);
+		if ((s->Res = GZipParallel_Drain(s, s->SlicesCount - 1))) {
+			GZipParallel_Stop(s); return s->Res;
+		}
+	}
+	return 0;
+}
+
+static cc_result GZipParallel_StreamClose(struct Stream* stream) {
+	struct GZipParallelState* s = (struct GZipParallelState*)stream->Meta.Inflate;
+	cc_uint8 data[8];
+	if (s->Res) return s->Res;
+
+	GZipParallel_Queue(s, true);
+	s->Res = GZipParallel_Drain(s, 0);
+	GZipParallel_Stop(s);
+	if (s->Res) return s->Res;
+
+	Stream_SetU32_LE(&data[0], s->Crc32);
+	Stream_SetU32_LE(&data[4], s->Size);
+	return Stream_Write(s->Dest, data, sizeof(data));
+}
+
+void GZip_MakeParallelStream(struct Stream* stream, struct GZipParallelState* state, struct Stream* underlying,
+									int level, int threads) {
+	Stream_Init(stream);
+	stream->Meta.Inflate = state;
+	stream->Write = GZipParallel_StreamWrite;
+	stream->Close = GZipParallel_StreamClose;
+
+	Mem_Set(state, 0, sizeof(*state));
+	state->Dest  = underlying;
+	state->Level = level;
+	/* Two slices per thread, so threads can keep compressing while waiting for slices to be written out */
+	state->ThreadsCount = max(1, min(threads, GZIP_MAX_THREADS));
+	state->SlicesCount  = state->ThreadsCount * 2;
+}
+
+
 /*########################################################################################################################*
 *-----------------------------------------------------ZLib (compress)-----------------------------------------------------*
 *#########################################################################################################################*/
@@ -1134,6 +1467,8 @@ struct ZipState {
 	struct Stream* source;
 	Zip_SelectEntry SelectEntry;
 	Zip_ProcessEntry ProcessEntry;
+	/* Whether entry data is passed to ProcessEntry without decompressing it */
+	cc_bool raw;
 
 	/* Number of entries selected by SelectEntry */
 	int usedEntries;
@@ -1175,8 +1510,15 @@ static cc_result Zip_ReadLocalFileHeader(struct ZipState* state, struct ZipEntry
 	/* Some .zip files don't set these in local file header */
 	if (!compressedSize)   compressedSize   = entry->CompressedSize;
 	if (!uncompressedSize) uncompressedSize = entry->UncompressedSize;
+	entry->Method = method;
 
-	if (method == 0) {
+	if (state->raw && (method == 0 || method == 8)) {
+		entry->CompressedSize   = method == 0 ? uncompressedSize : compressedSize;
+		entry->UncompressedSize = uncompressedSize;
+
+		Stream_ReadonlyPortion(&portion, stream, entry->CompressedSize);
+		return state->ProcessEntry(&path, &portion, entry);
+	} else if (method == 0) {
 		Stream_ReadonlyPortion(&portion, stream, uncompressedSize);
 		return state->ProcessEntry(&path, &portion, entry);
 	} else if (method == 8) {
@@ -1241,7 +1583,7 @@ enum ZipSig {
 	ZIP_SIG_LOCALFILEHEADER = 0x04034b50
 };
 
-cc_result Zip_Extract(struct Stream* source, Zip_SelectEntry selector, Zip_ProcessEntry processor) {
+static cc_result Zip_ExtractEntries(struct Stream* source, Zip_SelectEntry selector, Zip_ProcessEntry processor, cc_bool raw) {
 	struct ZipState state;
 	cc_uint32 stream_len;
 	cc_uint32 sig = 0;
@@ -1263,6 +1605,7 @@ cc_result Zip_Extract(struct Stream* source, Zip_SelectEntry selector, Zip_Proce
 	state.source       = source;
 	state.SelectEntry  = selector;
 	state.ProcessEntry = processor;
+	state.raw          = raw;
 
 	if (sig != ZIP_SIG_ENDOFCENTRALDIR) return ZIP_ERR_NO_END_OF_CENTRAL_DIR;
 	res = Zip_ReadEndOfCentralDirectory(&state);
@@ -1300,3 +1643,11 @@ cc_result Zip_Extract(struct Stream* source, Zip_SelectEntry selector, Zip_Proce
 	}
 	return 0;
 }
+
+cc_result Zip_Extract(struct Stream* source, Zip_SelectEntry selector, Zip_ProcessEntry processor) {
+	return Zip_ExtractEntries(source, selector, processor, false);
+}
+
+cc_result Zip_ExtractRaw(struct Stream* source, Zip_SelectEntry selector, Zip_ProcessEntry processor) {
+	return Zip_ExtractEntries(source, selector, processor, true);
+}
@@ -1,6 +1,7 @@
 #ifndef CC_DEFLATE_H
 #define CC_DEFLATE_H
 #include "Core.h"
+#include "WorkerPool.h"
 /* Decodes data compressed using DEFLATE in a streaming manner.
    Partially based off information from
 	https://handmade.network/forums/wip/t/2363-implementing_a_basic_png_reader_the_handmade_way
@@ -83,6 +84,9 @@ CC_API void Inflate_MakeStream2(struct Stream* stream, struct InflateState* stat
 #define DEFLATE_OUT_SIZE 8192
 #define DEFLATE_HASH_SIZE 0x1000UL
 #define DEFLATE_HASH_MASK 0x0FFFUL
+#define DEFLATE_MIN_LEVEL 1
+#define DEFLATE_MAX_LEVEL 9
+#define DEFLATE_DEFAULT_LEVEL 5
 struct DeflateState {
 	cc_uint32 Bits;         /* Holds bits across byte boundaries */
 	cc_uint32 NumBits;      /* Number of bits in Bits buffer */
@@ -100,23 +104,52 @@ struct DeflateState {
 	int Head[DEFLATE_HASH_SIZE];
 	int Prev[DEFLATE_BUFFER_SIZE];
 	cc_bool WroteHeader;
+	int MaxChain; /* Max number of previous matches that are compared against */
+	int NiceLen;  /* Stop looking for a longer match once a match is at least this long */
+	int LazyLen;  /* Only look for a longer match at the next byte if match is shorter than this */
 };
 /* Compresses input data using DEFLATE, then writes compressed output to another stream. Write only stream. */
 /* DEFLATE compression is pure compressed data, there is no header or footer. */
 CC_API void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying);
+/* Sets how hard the compressor tries to find matches, from DEFLATE_MIN_LEVEL (fastest) */
+/*  to DEFLATE_MAX_LEVEL (smallest output). Deflate_MakeStream uses DEFLATE_DEFAULT_LEVEL. */
+CC_API void Deflate_SetLevel(struct DeflateState* state, int level);
 
 struct GZipState { struct DeflateState Base; cc_uint32 Crc32, Size; };
 /* Compresses input data using GZIP, then writes compressed output to another stream. Write only stream. */
 /* GZIP compression is GZIP header, followed by DEFLATE compressed data, followed by GZIP footer. */
 CC_API void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stream* underlying);
 
+#define GZIP_MAX_THREADS WORKERPOOL_MAX_THREADS
+struct GZipSlice;
+struct GZipParallelState {
+	struct Stream* Dest;
+	cc_uint32 Crc32, Size;
+	int Level, ThreadsCount;
+	struct GZipSlice* Slices; /* Ring buffer of slices, that are compressed in order */
+	int SlicesCount, Queued, Written;
+	struct DeflateState* States[GZIP_MAX_THREADS];
+	struct WorkerPool Pool;
+	void* Mutex;
+	void* SliceDone;
+	cc_bool WroteHeader;
+	cc_result Res;
+};
+/* Compresses input data using GZIP across several threads, then writes compressed output to another stream. Write only stream. */
+/* Input is split into slices that are compressed independently, and then concatenated into one DEFLATE stream. */
+/* NOTE: Output is slightly larger than GZip_MakeStream, since matches cannot refer to data in previous slices. */
+/* NOTE: Only one parallel stream can be used at a time, and it must be closed unless writing to it failed. */
+CC_API void GZip_MakeParallelStream(struct Stream* stream, struct GZipParallelState* state, struct Stream* underlying,
+									int level, int threads);
+
 struct ZLibState { struct DeflateState Base; cc_uint32 Adler32; };
 /* Compresses input data using ZLIB, then writes compressed output to another stream. Write only stream. */
 /* ZLIB compression is ZLIB header, followed by DEFLATE compressed data, followed by ZLIB footer. */
 CC_API void ZLib_MakeStream(struct Stream* stream, struct ZLibState* state, struct Stream* underlying);
 
 /* Minimal data needed to describe an entry in a .zip archive */
-struct ZipEntry { cc_uint32 CompressedSize, UncompressedSize, LocalHeaderOffset, CRC32; };
+/* NOTE: Method is only set once the entry's local file header has been read */
+struct ZipEntry { cc_uint32 CompressedSize, UncompressedSize, LocalHeaderOffset, CRC32, Method; };
 /* Callback function to process the data in a .zip archive entry */
 /* Return non-zero to indicate an error and stop further processing */
 /* NOTE: data stream MAY NOT be seekable (i.e. entry data might be compressed) */
@@ -126,4 +159,9 @@ typedef cc_result (*Zip_ProcessEntry)(const cc_string* path, struct Stream* data
 typedef cc_bool (*Zip_SelectEntry)(const cc_string* path);
 
 CC_API cc_result Zip_Extract(struct Stream* source, Zip_SelectEntry selector, Zip_ProcessEntry processor);
+/* Same as Zip_Extract, except that the data stream is the raw data of the entry (i.e. still compressed) */
+/* NOTE: entry->Method is the compression method (0 = stored, 8 = DEFLATE) of the raw data, and */
+/*  entry->CompressedSize is the length of the raw data (UncompressedSize if data is stored) */
+/* (allows entries to be decompressed later, e.g. on several threads at once) */
+CC_API cc_result Zip_ExtractRaw(struct Stream* source, Zip_SelectEntry selector, Zip_ProcessEntry processor);
 #endif
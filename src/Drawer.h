@@ -35,4 +35,13 @@ CC_API void Drawer_ZMax(int count, PackedCol col, TextureLoc texLoc, struct Vert
 CC_API void Drawer_YMin(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
 /* Draws maximum Y face of the cuboid. (i.e. at Y2) */
 CC_API void Drawer_YMax(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+
+/* Same as Drawer_XMin etc, except that the given state is used instead of the global Drawer state. */
+/* NOTE: This allows cuboids to be drawn from multiple threads at once (e.g. by chunk mesh builders) */
+void Drawer_XMin2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void Drawer_XMax2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void Drawer_ZMin2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void Drawer_ZMax2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void Drawer_YMin2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+void Drawer_YMax2(const struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
 #endif
@@ -631,6 +631,138 @@ void Drawer2D_DrawClippedText(struct Context2D* ctx, struct DrawTextArgs* args,
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------------GlyphAtlas--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Each character has two cells in the atlas: the character itself, and the part of its shadow */
+/*  that is not covered up by the character. As these never overlap, the two can be drawn as */
+/*  separate quads in the same plane (without any depth fighting) and tinted with different colors */
+
+static BitmapCol GlyphAtlas_Sample(int c, int xx, int yy, int point, int dstWidth) {
+	int srcX = (c & 0x0F) * tileSize + xx * tileWidths[c] / dstWidth;
+	int srcY = (c >> 4)   * tileSize + yy * tileSize / point;
+	return Bitmap_GetRow(&fontBitmap, srcY)[srcX];
+}
+
+/* Draws a character in white the same way as DrawBitmappedTextCore, and then its shadow */
+static void GlyphAtlas_DrawChar(struct GlyphAtlas* atlas, struct Bitmap* bmp, int c, int x, int y) {
+	int point = atlas->size, offset = atlas->shadowOffset;
+	int dstWidth = atlas->widths[c], cellSize = atlas->cellSize;
+	BitmapCol* row;
+	int xx, yy;
+
+	for (yy = 0; yy < point; yy++) {
+		row = Bitmap_GetRow(bmp, y + yy) + x;
+		for (xx = 0; xx < dstWidth; xx++) {
+			row[xx] = GlyphAtlas_Sample(c, xx, yy, point, dstWidth);
+		}
+	}
+
+	x += cellSize;
+	for (yy = 0; yy < point; yy++) {
+		row = Bitmap_GetRow(bmp, y + yy + offset) + x + offset;
+		for (xx = 0; xx < dstWidth; xx++) {
+			row[xx] = GlyphAtlas_Sample(c, xx, yy, point, dstWidth);
+		}
+	}
+	/* Remove the parts of the shadow that the character is drawn over */
+	for (yy = 0; yy < point; yy++) {
+		row = Bitmap_GetRow(bmp, y + yy) + x;
+		for (xx = 0; xx < dstWidth; xx++) {
+			if (BitmapCol_A(GlyphAtlas_Sample(c, xx, yy, point, dstWidth))) row[xx] = 0;
+		}
+	}
+}
+
+void GlyphAtlas_Make(struct GlyphAtlas* atlas, int size) {
+	struct Context2D ctx;
+	int c, x, y;
+
+	Gfx_DeleteTexture(&atlas->texID);
+	atlas->size         = size;
+	atlas->shadowOffset = Drawer2D_ShadowOffset(size);
+	atlas->xPadding     = Drawer2D_XPadding(size);
+	/* add 1 pixel of padding */
+	atlas->cellSize     = size + atlas->shadowOffset + 1;
+
+	for (c = 0; c < 256; c++) {
+		atlas->widths[c] = Drawer2D_Width(size, (char)c);
+	}
+
+	Context2D_Alloc(&ctx, (2 << LOG2_CHARS_PER_ROW) * atlas->cellSize, (256 >> LOG2_CHARS_PER_ROW) * atlas->cellSize);
+	{
+		for (c = 0; c < 256; c++) {
+			if (!atlas->widths[c]) continue;
+			x = (c & 0x0F) * 2 * atlas->cellSize;
+			y = (c >> 4)       * atlas->cellSize;
+			GlyphAtlas_DrawChar(atlas, &ctx.bmp, c, x, y);
+		}
+		Gfx_RecreateTexture(&atlas->texID, &ctx.bmp, 0, false);
+	}
+	Context2D_Free(&ctx);
+
+	atlas->uScale = 1.0f / (float)ctx.bmp.width;
+	atlas->vScale = 1.0f / (float)ctx.bmp.height;
+}
+
+void GlyphAtlas_Free(struct GlyphAtlas* atlas) {
+	Gfx_DeleteTexture(&atlas->texID);
+	atlas->size = 0;
+}
+
+int GlyphAtlas_TextWidth(struct GlyphAtlas* atlas, const cc_string* text) {
+	int i, width = 0;
+
+	for (i = 0; i < text->length; i++) {
+		char c = text->buffer[i];
+		if (c == '&' && Drawer2D_ValidColorCodeAt(text, i + 1)) {
+			i++; continue; /* skip over the color code */
+		}
+		width += atlas->widths[(cc_uint8)c] + atlas->xPadding;
+	}
+	if (!width) return 0;
+	return width - atlas->xPadding + atlas->shadowOffset;
+}
+
+int GlyphAtlas_AddText(struct GlyphAtlas* atlas, const cc_string* text, int x, int y,
+						PackedCol shadowColor, struct VertexTextured** vertices) {
+	struct VertexTextured* beg = *vertices;
+	struct Texture part;
+	BitmapCol color = Drawer2D.Colors['f'];
+	int i, c, cellX, cellY, offset = atlas->shadowOffset;
+
+	for (i = 0; i < text->length; i++) {
+		c = (cc_uint8)text->buffer[i];
+		if (c == '&' && Drawer2D_ValidColorCodeAt(text, i + 1)) {
+			color = Drawer2D_GetColor(text->buffer[i + 1]);
+			i++; continue; /* skip over the color code */
+		}
+		/* Spaces are not visible in default.png, so skip drawing them */
+		if (!atlas->widths[c] || c == ' ') { x += atlas->widths[c] + atlas->xPadding; continue; }
+
+		cellX = (c & 0x0F) * 2 * atlas->cellSize;
+		cellY = (c >> 4)       * atlas->cellSize;
+		part.X = x; part.Width  = atlas->widths[c] + offset;
+		part.Y = y; part.Height = atlas->size + offset;
+
+		part.uv.U1 = (cellX + atlas->cellSize) * atlas->uScale;
+		part.uv.V1 = cellY * atlas->vScale;
+		part.uv.U2 = part.uv.U1 + part.Width  * atlas->uScale;
+		part.uv.V2 = part.uv.V1 + part.Height * atlas->vScale;
+		Gfx_Make2DQuad(&part, shadowColor, vertices);
+
+		part.Width  = atlas->widths[c];
+		part.Height = atlas->size;
+		part.uv.U1  = cellX * atlas->uScale;
+		part.uv.U2  = part.uv.U1 + part.Width  * atlas->uScale;
+		part.uv.V2  = part.uv.V1 + part.Height * atlas->vScale;
+		Gfx_Make2DQuad(&part, PackedCol_Make(BitmapCol_R(color), BitmapCol_G(color), BitmapCol_B(color), 255), vertices);
+
+		x += atlas->widths[c] + atlas->xPadding;
+	}
+	return (int)(*vertices - beg);
+}
+
 /*########################################################################################################################*
 *---------------------------------------------------Drawer2D component----------------------------------------------------*
 *#########################################################################################################################*/
@@ -2,6 +2,7 @@
 #define CC_DRAWER2D_H
 #include "Bitmap.h"
 #include "Constants.h"
+#include "PackedCol.h"
 /*  Performs a variety of drawing operations on bitmaps, and converts bitmaps into textures.
 	Copyright 2014-2022 ClassiCube | Licensed under BSD-3
 */
@@ -11,6 +12,7 @@ struct FontDesc { void* handle; cc_uint16 size, flags; int height; };
 struct DrawTextArgs { cc_string text; struct FontDesc* font; cc_bool useShadow; };
 struct Context2D { struct Bitmap bmp; int width, height; void* meta; };
 struct Texture;
+struct VertexTextured;
 struct IGameComponent;
 struct StringsBuffer;
 extern struct IGameComponent Drawer2D_Component;
@@ -113,6 +115,24 @@ void Font_SetPadding(struct FontDesc* desc, int amount);
 /* Initialises the given font for drawing bitmapped text using default.png */
 void Font_MakeBitmapped(struct FontDesc* desc, int size, int flags);
 
+/* Every character from default.png drawn once in white at a given size, so that text can be */
+/*  drawn as colored quads using this texture (instead of needing a new texture for each text) */
+struct GlyphAtlas {
+	GfxResourceID texID;
+	int size, shadowOffset, xPadding, cellSize; /* size is 0 when atlas has not been made yet */
+	float uScale, vScale;
+	cc_uint16 widths[256];
+};
+/* Draws all the characters in default.png into the atlas texture, using the given point size */
+void GlyphAtlas_Make(struct GlyphAtlas* atlas, int size);
+void GlyphAtlas_Free(struct GlyphAtlas* atlas);
+/* Returns how wide the given text would be when drawn using the atlas, including its shadow */
+int  GlyphAtlas_TextWidth(struct GlyphAtlas* atlas, const cc_string* text);
+/* Adds quads for the given text and its shadow, with the top left corner at x,y */
+/*  NOTE: Adds at most 8 vertices per character, and returns how many vertices were added */
+int  GlyphAtlas_AddText(struct GlyphAtlas* atlas, const cc_string* text, int x, int y,
+						PackedCol shadowColor, struct VertexTextured** vertices);
+
 /* Allocates a new system font from the given arguments */
 cc_result SysFont_Make(struct FontDesc* desc, const cc_string* fontName, int size, int flags);
 /* Allocates a new system font from the given arguments using default system font */
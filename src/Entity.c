@@ -14,6 +14,7 @@
 #include "Http.h"
 #include "Chat.h"
 #include "Model.h"
+#include "Profiler.h"
 #include "Input.h"
 #include "Gui.h"
 #include "Stream.h"
@@ -189,93 +190,117 @@ cc_bool Entity_TouchesAnyWater(struct Entity* e) {
 *-----------------------------------------------------Entity nametag------------------------------------------------------*
 *#########################################################################################################################*/
 #define NAME_IS_EMPTY -30000
-#define NAME_OFFSET 3 /* offset of back layer of name above an entity */
-
-static void MakeNameTexture(struct Entity* e) {
-	cc_string colorlessName; char colorlessBuffer[STRING_SIZE];
-	BitmapCol shadowColor = BitmapCol_Make(80, 80, 80, 255);
-	BitmapCol origWhiteColor;
-
-	struct DrawTextArgs args;
-	struct FontDesc font;
-	struct Context2D ctx;
-	int width, height;
+/* Names are always drawn using default.png font, without DPI scaling or padding */
+#define NAME_FONT_SIZE 24
+/* All nametags share one glyph atlas. Each nametag keeps the quads of its glyphs until its name changes, */
+/*  and every frame the quads of all visible nametags are moved into one dynamic VB and drawn at once */
+static struct GlyphAtlas names_atlas;
+static struct VertexTextured* names_vertices;
+static int names_count, names_capacity;
+static GfxResourceID names_vb;
+static int names_vbCapacity;
+
+/* Builds the quads of the entity's nametag, in pixels relative to its top left corner */
+static void MakeNameQuads(struct Entity* e) {
+	static struct VertexTextured quads[STRING_SIZE * 8];
+	PackedCol shadowColor = PackedCol_Make(80, 80, 80, 255);
+	struct VertexTextured* v = quads;
 	cc_string name;
+	int count;
 
-	/* Names are always drawn using default.png font */
-	Font_MakeBitmapped(&font, 24, FONT_FLAGS_NONE);
-	/* Don't want DPI scaling or padding */
-	font.size = 24; font.height = 24;
+	name  = String_FromRawArray(e->NameRaw);
+	count = GlyphAtlas_AddText(&names_atlas, &name, 0, 0, shadowColor, &v);
+	e->NameWidth = GlyphAtlas_TextWidth(&names_atlas, &name);
+	if (!e->NameWidth || !count) { e->NameWidth = NAME_IS_EMPTY; return; }
 
-	name = String_FromRawArray(e->NameRaw);
-	DrawTextArgs_Make(&args, &name, &font, false);
-	width = Drawer2D_TextWidth(&args);
+	e->NameQuads = (struct VertexTextured*)Mem_Alloc(count, SIZEOF_VERTEX_TEXTURED, "nametag quads");
+	Mem_Copy(e->NameQuads, quads, count * SIZEOF_VERTEX_TEXTURED);
+	e->NameVertices = count;
+}
 
-	if (!width) {
-		e->NameTex.ID = 0;
-		e->NameTex.X  = NAME_IS_EMPTY;
-	} else {
-		String_InitArray(colorlessName, colorlessBuffer);
-		width  += NAME_OFFSET; 
-		height = Drawer2D_TextHeight(&args) + NAME_OFFSET;
-
-		Context2D_Alloc(&ctx, width, height);
-		{
-			origWhiteColor = Drawer2D.Colors['f'];
-
-			Drawer2D.Colors['f'] = shadowColor;
-			Drawer2D_WithoutColors(&colorlessName, &name);
-			args.text = colorlessName;
-			Context2D_DrawText(&ctx, &args, NAME_OFFSET, NAME_OFFSET);
-
-			Drawer2D.Colors['f'] = origWhiteColor;
-			args.text = name;
-			Context2D_DrawText(&ctx, &args, 0, 0);
-		}
-		Context2D_MakeTexture(&e->NameTex, &ctx);
-		Context2D_Free(&ctx);
+/* Draws the quads of all the nametags added since the last flush */
+static void FlushNames(void) {
+	if (!names_count) return;
+	if (names_count > names_vbCapacity) {
+		names_vbCapacity = names_capacity;
+		Gfx_RecreateDynamicVb(&names_vb, VERTEX_FORMAT_TEXTURED, names_vbCapacity);
 	}
+
+	Gfx_BindTexture(names_atlas.texID);
+	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	Gfx_UpdateDynamicVb_IndexedTris(names_vb, names_vertices, names_count);
+	names_count = 0;
 }
 
+/* Adds the quads of the entity's nametag to the nametags drawn by the next FlushNames */
 static void DrawName(struct Entity* e) {
-	struct VertexTextured vertices[4];
+	struct VertexTextured* src;
+	struct VertexTextured* v;
 	struct Model* model;
+	struct Matrix* view;
 	struct Matrix mat;
-	Vec3 pos;
-	float scale;
-	Vec2 size;
+	Vec3 pos, right, up;
+	float scale, x, y;
+	int i;
 
-	if (e->NameTex.X == NAME_IS_EMPTY) return;
-	if (!e->NameTex.ID) MakeNameTexture(e);
-	Gfx_BindTexture(e->NameTex.ID);
+	if (e->NameWidth == NAME_IS_EMPTY) return;
+	if (!names_atlas.size) GlyphAtlas_Make(&names_atlas, NAME_FONT_SIZE);
+	if (!e->NameQuads) MakeNameQuads(e);
+	if (!e->NameQuads) return;
 
 	model = e->Model;
 	Vec3_TransformY(&pos, model->GetNameY(e), &e->Transform);
 
-	scale  = model->nameScale * e->ModelScale.Y;
-	scale  = scale > 1.0f ? (1.0f/70.0f) : (scale/70.0f);
-	size.X = e->NameTex.Width * scale; size.Y = e->NameTex.Height * scale;
+	scale = model->nameScale * e->ModelScale.Y;
+	scale = scale > 1.0f ? (1.0f/70.0f) : (scale/70.0f);
 
 	if (Entities.NamesMode == NAME_MODE_ALL_UNSCALED && LocalPlayer_Instance.Hacks.CanSeeAllNames) {			
 		Matrix_Mul(&mat, &Gfx.View, &Gfx.Projection); /* TODO: This mul is slow, avoid it */
 		/* Get W component of transformed position */
-		scale = pos.X * mat.row1.W + pos.Y * mat.row2.W + pos.Z * mat.row3.W + mat.row4.W;
-		size.X *= scale * 0.2f; size.Y *= scale * 0.2f;
+		scale *= (pos.X * mat.row1.W + pos.Y * mat.row2.W + pos.Z * mat.row3.W + mat.row4.W) * 0.2f;
 	}
 
-	Particle_DoRender(&size, &pos, &e->NameTex.uv, PACKEDCOL_WHITE, vertices);
-	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
-	Gfx_UpdateDynamicVb_IndexedTris(Gfx_texVb, vertices, 4);
+	view  = &Gfx.View;
+	right = Vec3_Create3(view->row1.X, view->row2.X, view->row3.X);
+	up    = Vec3_Create3(view->row1.Y, view->row2.Y, view->row3.Y);
+	x     = e->NameWidth * scale;
+	y     = (names_atlas.size + names_atlas.shadowOffset) * scale;
+
+	/* Top left corner of a billboard that faces the camera and is centred above the entity */
+	pos.Y += y * 0.5f;
+	pos.X += (up.X * y - right.X * x) * 0.5f;
+	pos.Y += (up.Y * y - right.Y * x) * 0.5f;
+	pos.Z += (up.Z * y - right.Z * x) * 0.5f;
+
+	if (names_count + e->NameVertices > GFX_MAX_VERTICES) FlushNames();
+	if (names_count + e->NameVertices > names_capacity) {
+		names_capacity = max(names_capacity * 2, names_count + e->NameVertices);
+		names_vertices = (struct VertexTextured*)Mem_Realloc(names_vertices, names_capacity,
+															SIZEOF_VERTEX_TEXTURED, "nametag vertices");
+	}
+
+	/* Transform from pixels in the nametag to world coordinates */
+	src = e->NameQuads;
+	v   = &names_vertices[names_count];
+	for (i = 0; i < e->NameVertices; i++, src++, v++) {
+		x = src->X * scale; y = src->Y * scale;
+		v->X   = pos.X + right.X * x - up.X * y;
+		v->Y   = pos.Y + right.Y * x - up.Y * y;
+		v->Z   = pos.Z + right.Z * x - up.Z * y;
+		v->Col = src->Col; v->U = src->U; v->V = src->V;
+	}
+	names_count += e->NameVertices;
 }
 
-/* Deletes the texture containing the entity's nametag */
-CC_NOINLINE static void DeleteNameTex(struct Entity* e) {
-	Gfx_DeleteTexture(&e->NameTex.ID);
-	e->NameTex.X = 0; /* X is used as an 'empty name' flag */
+/* Frees the quads of the entity's nametag */
+CC_NOINLINE static void DeleteNameQuads(struct Entity* e) {
+	Mem_Free(e->NameQuads);
+	e->NameQuads = NULL;
+	e->NameWidth = 0;
 }
 
 void Entity_SetName(struct Entity* e, const cc_string* name) {
-	DeleteNameTex(e);
+	DeleteNameQuads(e);
 	String_CopyToRawArray(e->NameRaw, name);
 	/* name texture redraw deferred until necessary */
 }
@@ -284,6 +309,39 @@ void Entity_SetName(struct Entity* e, const cc_string* name) {
 /*########################################################################################################################*
 *------------------------------------------------------Entity skins-------------------------------------------------------*
 *#########################################################################################################################*/
+/* Skin textures are shared by all entities whose downloaded skins have the same contents */
+/*  (e.g. bots with different names that all use the same skin), and are freed once unused */
+struct SkinTexture {
+	cc_uint32 hash, size; /* CRC32 and size of the downloaded skin */
+	cc_bool clearedHat;   /* Whether the hat area was cleared (see Entity_ClearHat) */
+	cc_uint8 skinType;
+	int refCount;         /* Number of entities using this texture, 0 if this is unused */
+	float uScale, vScale;
+	GfxResourceID texID;
+};
+/* Each entity only uses one skin texture, so can't be more textures than entities */
+static struct SkinTexture skinTextures[ENTITIES_MAX_COUNT];
+
+static struct SkinTexture* SkinTexture_Find(cc_uint32 hash, cc_uint32 size, cc_bool clearedHat) {
+	struct SkinTexture* t;
+	int i;
+
+	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
+		t = &skinTextures[i];
+		if (!t->refCount || t->hash != hash || t->size != size) continue;
+		if (t->clearedHat == clearedHat) return t;
+	}
+	return NULL;
+}
+
+static struct SkinTexture* SkinTexture_FindID(GfxResourceID texID) {
+	int i;
+	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
+		if (skinTextures[i].refCount && skinTextures[i].texID == texID) return &skinTextures[i];
+	}
+	return NULL;
+}
+
 static struct Entity* Entity_FirstOtherWithSameSkinAndFetchedSkin(struct Entity* except) {
 	struct Entity* e;
 	cc_string skin, eSkin;
@@ -300,15 +358,6 @@ static struct Entity* Entity_FirstOtherWithSameSkinAndFetchedSkin(struct Entity*
 	return NULL;
 }
 
-/* Copies skin data from another entity */
-static void Entity_CopySkin(struct Entity* dst, struct Entity* src) {
-	dst->TextureId    = src->TextureId;	
-	dst->SkinType     = src->SkinType;
-	dst->uScale       = src->uScale;
-	dst->vScale       = src->vScale;
-	dst->MobTextureId = src->MobTextureId;
-}
-
 /* Resets skin data for the given entity */
 static void Entity_ResetSkin(struct Entity* e) {
 	e->uScale = 1.0f; e->vScale = 1.0f;
@@ -317,15 +366,38 @@ static void Entity_ResetSkin(struct Entity* e) {
 	e->SkinType     = SKIN_64x32;
 }
 
-/* Copies or resets skin data for all entity with same skin */
-static void Entity_SetSkinAll(struct Entity* source, cc_bool reset) {
+/* Changes the skin texture used by the given entity, freeing its previous texture if no other entity uses it */
+/* NOTE: texture can be NULL, in which case the entity's skin is just reset */
+static void Entity_SetSkinTexture(struct Entity* e, struct SkinTexture* texture) {
+	struct SkinTexture* prev = e->TextureId ? SkinTexture_FindID(e->TextureId) : NULL;
+	cc_string skin;
+	/* Must be done first, in case the previous texture is the same texture */
+	if (texture) texture->refCount++;
+
+	if (prev && --prev->refCount == 0) Gfx_DeleteTexture(&prev->texID);
+	Entity_ResetSkin(e);
+	if (!texture) return;
+
+	skin = String_FromRawArray(e->SkinRaw);
+	e->TextureId    = texture->texID;
+	e->MobTextureId = Utils_IsUrlPrefix(&skin) ? texture->texID : 0;
+	e->SkinType     = texture->skinType;
+	e->uScale       = texture->uScale;
+	e->vScale       = texture->vScale;
+}
+
+/* Copies skin data from another entity */
+static void Entity_CopySkin(struct Entity* dst, struct Entity* src) {
+	Entity_SetSkinTexture(dst, src->TextureId ? SkinTexture_FindID(src->TextureId) : NULL);
+}
+
+/* Changes skin texture of all entities with same skin (resets skin if texture is NULL) */
+static void Entity_SetSkinAll(struct Entity* source, struct SkinTexture* texture) {
 	struct Entity* e;
 	cc_string skin, eSkin;
 	int i;
 
 	skin = String_FromRawArray(source->SkinRaw);
-	source->MobTextureId = Utils_IsUrlPrefix(&skin) ? source->TextureId : 0;
-
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
 		if (!Entities.List[i]) continue;
 
@@ -333,11 +405,7 @@ static void Entity_SetSkinAll(struct Entity* source, cc_bool reset) {
 		eSkin = String_FromRawArray(e->SkinRaw);
 		if (!String_Equals(&skin, &eSkin)) continue;
 
-		if (reset) {
-			Entity_ResetSkin(e);
-		} else {
-			Entity_CopySkin(e, source);
-		}
+		Entity_SetSkinTexture(e, texture);
 		e->SkinFetchState = SKIN_FETCH_COMPLETED;
 	}
 }
@@ -369,7 +437,7 @@ static void Entity_ClearHat(struct Bitmap* bmp, cc_uint8 skinType) {
 }
 
 /* Ensures skin is a power of two size, resizing if needed. */
-static cc_result EnsurePow2Skin(struct Entity* e, struct Bitmap* bmp) {
+static cc_result EnsurePow2Skin(struct SkinTexture* t, struct Bitmap* bmp) {
 	struct Bitmap scaled;
 	cc_uint32 stride;
 	int width, height;
@@ -382,8 +450,8 @@ static cc_result EnsurePow2Skin(struct Entity* e, struct Bitmap* bmp) {
 	Bitmap_TryAllocate(&scaled, width, height);
 	if (!scaled.scan0) return ERR_OUT_OF_MEMORY;
 
-	e->uScale = (float)bmp->width  / width;
-	e->vScale = (float)bmp->height / height;
+	t->uScale = (float)bmp->width  / width;
+	t->vScale = (float)bmp->height / height;
 	stride = bmp->width * 4;
 
 	for (y = 0; y < bmp->height; y++) {
@@ -397,21 +465,42 @@ static cc_result EnsurePow2Skin(struct Entity* e, struct Bitmap* bmp) {
 	return 0;
 }
 
-static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct Stream* src, cc_string* skin) {
+static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct HttpRequest* item, cc_string* skin) {
+	cc_bool clearHat = e->Model->usesHumanSkin;
+	cc_uint32 hash   = Utils_CRC32(item->data, item->size);
+	struct SkinTexture* t;
+	struct Stream mem;
 	cc_result res;
-	if ((res = Png_Decode(bmp, src))) return res;
+	int i;
+
+	/* No need to decode the skin again if another entity's skin has the same contents */
+	if ((t = SkinTexture_Find(hash, item->size, clearHat))) {
+		Entity_SetSkinAll(e, t); return 0;
+	}
+
+	Stream_ReadonlyMemory(&mem, item->data, item->size);
+	if ((res = Png_Decode(bmp, &mem))) return res;
+	Entity_SetSkinAll(e, NULL);
 
-	Gfx_DeleteTexture(&e->TextureId);
-	Entity_SetSkinAll(e, true);
-	if ((res = EnsurePow2Skin(e, bmp))) return res;
-	e->SkinType = Utils_CalcSkinType(bmp);
+	for (i = 0; i < ENTITIES_MAX_COUNT && skinTextures[i].refCount; i++) { }
+	if (i == ENTITIES_MAX_COUNT) return 0;
+	t = &skinTextures[i];
+
+	t->uScale = 1.0f; t->vScale = 1.0f;
+	if ((res = EnsurePow2Skin(t, bmp))) return res;
+	t->skinType = Utils_CalcSkinType(bmp);
 
 	if (bmp->width > Gfx.MaxTexWidth || bmp->height > Gfx.MaxTexHeight) {
 		Chat_Add1("&cSkin %s is too large", skin);
 	} else {
-		if (e->Model->usesHumanSkin) Entity_ClearHat(bmp, e->SkinType);
-		Gfx_RecreateTexture(&e->TextureId, bmp, TEXTURE_FLAG_MANAGED, false);
-		Entity_SetSkinAll(e, false);
+		if (clearHat) Entity_ClearHat(bmp, t->skinType);
+		t->texID = Gfx_CreateTexture(bmp, TEXTURE_FLAG_MANAGED, false);
+		if (!t->texID) return 0;
+
+		t->hash       = hash;
+		t->size       = item->size;
+		t->clearedHat = clearHat;
+		Entity_SetSkinAll(e, t);
 	}
 	return 0;
 }
@@ -432,7 +521,6 @@ static void LogInvalidSkin(cc_result res, const cc_string* skin, const cc_uint8*
 static void Entity_CheckSkin(struct Entity* e) {
 	struct Entity* first;
 	struct HttpRequest item;
-	struct Stream mem;
 	struct Bitmap bmp;
 	cc_string skin;
 	cc_uint8 flags;
@@ -458,10 +546,10 @@ static void Entity_CheckSkin(struct Entity* e) {
 	}
 
 	if (!Http_GetResult(e->_skinReqID, &item)) return;
-	if (!item.success) { Entity_SetSkinAll(e, true); return; }
+	if (!item.success) { Entity_SetSkinAll(e, NULL); return; }
 
-	Stream_ReadonlyMemory(&mem, item.data, item.size);
-	if ((res = ApplySkin(e, &bmp, &mem, &skin))) {
+	bmp.scan0 = NULL;
+	if ((res = ApplySkin(e, &bmp, &item, &skin))) {
 		LogInvalidSkin(res, &skin, item.data, item.size);
 	}
 
@@ -469,22 +557,8 @@ static void Entity_CheckSkin(struct Entity* e) {
 	Mem_Free(item.data);
 }
 
-/* Returns true if no other entities are sharing this skin texture */
-static cc_bool CanDeleteTexture(struct Entity* except) {
-	int i;
-	if (!except->TextureId) return false;
-
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i] || Entities.List[i] == except)  continue;
-		if (Entities.List[i]->TextureId == except->TextureId) return false;
-	}
-	return true;
-}
-
 CC_NOINLINE static void DeleteSkin(struct Entity* e) {
-	if (CanDeleteTexture(e)) Gfx_DeleteTexture(&e->TextureId);
-
-	Entity_ResetSkin(e);
+	Entity_SetSkinTexture(e, NULL);
 	e->SkinFetchState = 0;
 }
 
@@ -521,10 +595,13 @@ static EntityID entities_closestId;
 
 void Entities_Tick(struct ScheduledTask* task) {
 	int i;
+	Profiler_Begin(PROFILER_ENTITIES);
+
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
 		if (!Entities.List[i]) continue;
 		Entities.List[i]->VTABLE->Tick(Entities.List[i], task->interval);
 	}
+	Profiler_End(PROFILER_ENTITIES);
 }
 
 void Entities_RenderModels(double delta, float t) {
@@ -558,6 +635,7 @@ void Entities_RenderNames(void) {
 			Entities.List[i]->VTABLE->RenderName(Entities.List[i]);
 		}
 	}
+	FlushNames();
 
 	Gfx_SetAlphaTest(false);
 	if (hadFog) Gfx_SetFog(true);
@@ -583,20 +661,19 @@ void Entities_RenderHoveredNames(void) {
 			Entities.List[i]->VTABLE->RenderName(Entities.List[i]);
 		}
 	}
+	FlushNames();
 
 	Gfx_SetAlphaTest(false);
 	Gfx_SetDepthTest(true);
 	if (hadFog) Gfx_SetFog(true);
 }
 
-static void Entity_ContextLost(struct Entity* e) { DeleteNameTex(e); }
-
 static void Entities_ContextLost(void* obj) {
 	int i;
-	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
-		if (!Entities.List[i]) continue;
-		Entity_ContextLost(Entities.List[i]);
-	}
+	/* Nametag quads are kept, as the atlas is drawn the same way again */
+	GlyphAtlas_Free(&names_atlas);
+	Gfx_DeleteDynamicVb(&names_vb);
+	names_vbCapacity = 0;
 	Gfx_DeleteTexture(&ShadowComponent_ShadowTex);
 
 	if (Gfx.ManagedTextures) return;
@@ -609,10 +686,12 @@ static void Entities_ContextLost(void* obj) {
 
 static void Entities_ChatFontChanged(void* obj) {
 	int i;
+	/* default.png might have changed, so need to redraw atlas and remeasure names */
+	GlyphAtlas_Free(&names_atlas);
 	for (i = 0; i < ENTITIES_MAX_COUNT; i++) {
 		if (!Entities.List[i]) continue;
-		DeleteNameTex(Entities.List[i]);
-		/* name redraw is deferred until rendered */
+		DeleteNameQuads(Entities.List[i]);
+		/* atlas and name redraw is deferred until rendered */
 	}
 }
 
@@ -757,7 +836,7 @@ struct IGameComponent TabList_Component = {
 
 static void Player_Despawn(struct Entity* e) {
 	DeleteSkin(e);
-	Entity_ContextLost(e);
+	DeleteNameQuads(e);
 }
 
 
@@ -1204,6 +1283,13 @@ static void Entities_Free(void) {
 		Entities_Remove((EntityID)i);
 	}
 	Gfx_DeleteTexture(&ShadowComponent_ShadowTex);
+	GlyphAtlas_Free(&names_atlas);
+	Gfx_DeleteDynamicVb(&names_vb);
+	names_vbCapacity = 0;
+
+	Mem_Free(names_vertices);
+	names_vertices = NULL;
+	names_capacity = 0;
 }
 
 struct IGameComponent Entities_Component = {
@@ -11,6 +11,7 @@
 struct Model;
 struct IGameComponent;
 struct ScheduledTask;
+struct VertexTextured;
 extern struct IGameComponent TabList_Component;
 extern struct IGameComponent Entities_Component;
 
@@ -105,11 +106,15 @@ struct Entity {
 	struct AnimatedComp Anim;
 	char SkinRaw[STRING_SIZE];
 	char NameRaw[STRING_SIZE];
-	struct Texture NameTex;
+	struct Texture NameTex; /* NOTE: No longer used, nametags are drawn from NameQuads instead */
 
 	/* Previous and next intended location of the entity */
 	/*  Current state is linearly interpolated between prev and next */
 	struct EntityLocation prev, next;
+	/* Quads of the nametag's glyphs in pixels, kept until the name or the names glyph atlas changes */
+	struct VertexTextured* NameQuads;
+	int NameVertices;
+	int NameWidth; /* 0 if not measured yet */
 };
 typedef cc_bool (*Entity_TouchesCondition)(BlockID block);
 
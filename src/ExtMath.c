@@ -38,6 +38,14 @@ int Math_Log2(cc_uint32 value) {
 	return r;
 }
 
+#ifndef __GNUC__
+int Math_LowestBit(cc_uint32 value) {
+	int r = 0;
+	while (!(value & 1)) { value >>= 1; r++; }
+	return r;
+}
+#endif
+
 int Math_CeilDiv(int a, int b) {
 	return a / b + (a % b != 0 ? 1 : 0);
 }
@@ -25,6 +25,13 @@ float Math_AbsF(float x);
 float Math_SqrtF(float x);
 #endif
 
+#ifdef __GNUC__
+#define Math_LowestBit(x) __builtin_ctz(x)
+#else
+/* Returns the index of the lowest set bit (value must not be 0) */
+int Math_LowestBit(cc_uint32 value);
+#endif
+
 float Math_Mod1(float x);
 int   Math_AbsI(int x);
 
@@ -44,9 +44,10 @@ static cc_result Map_SkipGZipHeader(struct Stream* stream) {
 IMapImporter Map_FindImporter(const cc_string* path) {
 	static const cc_string cw   = String_FromConst(".cw"),  lvl = String_FromConst(".lvl");
 	static const cc_string fcm  = String_FromConst(".fcm"), dat = String_FromConst(".dat");
-	static const cc_string mine = String_FromConst(".mine");
+	static const cc_string mine = String_FromConst(".mine"), cwr = String_FromConst(".cwr");
 
 	if (String_CaselessEnds(path,   &cw))  return Cw_Load;
+	if (String_CaselessEnds(path,  &cwr)) return Cwr_Load;
 	if (String_CaselessEnds(path,  &lvl)) return Lvl_Load;
 	if (String_CaselessEnds(path,  &fcm)) return Fcm_Load;
 	if (String_CaselessEnds(path,  &dat)) return Dat_Load;
@@ -55,6 +56,7 @@ IMapImporter Map_FindImporter(const cc_string* path) {
 	return NULL;
 }
 
+static cc_result Cwr_LoadFile(struct Stream* stream);
 cc_result Map_LoadFrom(const cc_string* path) {
 	cc_string relPath, fileName, fileExt;
 	IMapImporter importer;
@@ -67,6 +69,9 @@ cc_result Map_LoadFrom(const cc_string* path) {
 	if (res) { Logger_SysWarn2(res, "opening", path); return res; }
 
 	importer = Map_FindImporter(path);
+	/* Avoid copying the blocks of uncompressed maps where possible */
+	if (importer == Cwr_Load) importer = Cwr_LoadFile;
+
 	if (!importer) {
 		res = ERR_NOT_SUPPORTED;
 	} else if ((res = importer(&stream))) {
@@ -399,6 +404,9 @@ static cc_result Nbt_ReadString(struct Stream* stream, cc_string* str) {
 	return 0;
 }
 
+/* Whether big byte arrays point directly into the memory stream being read, instead of being copied */
+static cc_bool nbt_noCopy;
+
 typedef void (*Nbt_Callback)(struct NbtTag* tag);
 static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream* stream, struct NbtTag* parent, Nbt_Callback callback) {
 	struct NbtTag tag;
@@ -440,6 +448,9 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 
 		if (NbtTag_IsSmall(&tag)) {
 			res = Stream_Read(stream, tag.value.small, tag.dataSize);
+		} else if (nbt_noCopy) {
+			tag.value.big = stream->Meta.Mem.Cur;
+			res = stream->Skip(stream, tag.dataSize);
 		} else {
 			tag.value.big = (cc_uint8*)Mem_TryAlloc(tag.dataSize, 1);
 			if (!tag.value.big) return ERR_OUT_OF_MEMORY;
@@ -481,7 +492,7 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 	tag.result = 0;
 	callback(&tag);
 	/* NOTE: callback must set DataBig to NULL, if doesn't want it to be freed */
-	if (!NbtTag_IsSmall(&tag)) Mem_Free(tag.value.big);
+	if (!NbtTag_IsSmall(&tag) && !nbt_noCopy) Mem_Free(tag.value.big);
 	return tag.result;
 }
 #define IsTag(tag, tagName) (String_CaselessEqualsConst(&tag->name, tagName))
@@ -603,13 +614,15 @@ COMPOUND "ClassicWorld" {
 			}
 		}
 	}
-}*/
+}
+.cwr files contain the same NBT data, but without GZIP compression around it */
 static BlockRaw* Cw_GetBlocks(struct NbtTag* tag) {
 	BlockRaw* ptr;
 	if (NbtTag_IsSmall(tag)) {
 		ptr = (BlockRaw*)Mem_Alloc(tag->dataSize, 1, ".cw map blocks");
 		Mem_Copy(ptr, tag->value.small, tag->dataSize);
 	} else {
+		/* NOTE: With nbt_noCopy, this points into the memory mapped file (see World.MappedData) */
 		ptr = tag->value.big;
 		tag->value.big = NULL; /* So Nbt_ReadTag doesn't call Mem_Free on World.Blocks */
 	}
@@ -834,18 +847,54 @@ static void Cw_Callback(struct NbtTag* tag) {
 	        0             1         2        3          4   */
 }
 
+static cc_result Cw_ReadNbt(struct Stream* stream) {
+	cc_result res;
+	cc_uint8 tag;
+
+	if ((res = stream->ReadU8(stream, &tag))) return res;
+	if (tag != NBT_DICT) return CW_ERR_ROOT_TAG;
+	return Nbt_ReadTag(NBT_DICT, true, stream, NULL, Cw_Callback);
+}
+
 cc_result Cw_Load(struct Stream* stream) {
 	struct Stream compStream;
 	struct InflateState state;
 	cc_result res;
-	cc_uint8 tag;
 
 	Inflate_MakeStream2(&compStream, &state, stream);
 	if ((res = Map_SkipGZipHeader(stream))) return res;
-	if ((res = compStream.ReadU8(&compStream, &tag))) return res;
+	return Cw_ReadNbt(&compStream);
+}
 
-	if (tag != NBT_DICT) return CW_ERR_ROOT_TAG;
-	return Nbt_ReadTag(NBT_DICT, true, &compStream, NULL, Cw_Callback);
+cc_result Cwr_Load(struct Stream* stream) {
+	struct Stream buffered;
+	cc_uint8 buffer[2048];
+	/* NBT tags are mostly read a few bytes at a time */
+	Stream_ReadonlyBuffered(&buffered, stream, buffer, sizeof(buffer));
+	return Cw_ReadNbt(&buffered);
+}
+
+/* Maps the whole file into memory, so the block arrays are used from the file without being copied */
+/* NOTE: stream must be a file stream (i.e. from Stream_OpenFile) */
+static cc_result Cwr_LoadFile(struct Stream* stream) {
+	struct Stream mem;
+	cc_uint32 length;
+	cc_result res;
+	void* data;
+
+	if ((res = File_Length(stream->Meta.File, &length))) return res;
+	/* Fallback to copying, e.g. if the platform doesn't support memory mapped files */
+	if (!length || File_Map(stream->Meta.File, length, &data)) return Cwr_Load(stream);
+
+	/* World_Reset unmaps the file, even if loading fails */
+	World.MappedData = data;
+	World.MappedSize = length;
+	Stream_ReadonlyMemory(&mem, data, length);
+
+	nbt_noCopy = true;
+	res = Cw_ReadNbt(&mem);
+	nbt_noCopy = false;
+	return res;
 }
 
 
@@ -24,6 +24,9 @@ cc_result Fcm_Load(struct Stream* stream);
 /* Imports a world from a .cw ClassicWorld map file. */
 /* Used by ClassiCube/ClassicalSharp. */
 cc_result Cw_Load(struct Stream* stream);
+/* Imports a world from a .cwr uncompressed ClassicWorld map file. */
+/* NOTE: Map_LoadFrom maps .cwr files directly into memory instead, when supported. */
+cc_result Cwr_Load(struct Stream* stream);
 /* Imports a world from a .dat classic map file. */
 /* Used by Minecraft Classic/WoM client. */
 cc_result Dat_Load(struct Stream* stream);
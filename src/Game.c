@@ -2,6 +2,7 @@
 #include "Block.h"
 #include "World.h"
 #include "Lighting.h"
+#include "Profiler.h"
 #include "MapRenderer.h"
 #include "Graphics.h"
 #include "Camera.h"
@@ -36,6 +37,7 @@
 #include "Protocol.h"
 #include "Picking.h"
 #include "Animations.h"
+#include "Physics.h"
 
 struct _GameData Game;
 cc_uint64 Game_FrameStart;
@@ -193,6 +195,28 @@ void Game_UpdateBlock(int x, int y, int z, BlockID block) {
 	}
 	Lighting.OnBlockChanged(x, y, z, old, block);
 	MapRenderer_OnBlockChanged(x, y, z, block);
+	Searcher_OnBlockChanged(x, y, z, block);
+}
+
+void Game_UpdateBlocks(const int* indices, const BlockID* blocks, int count) {
+	cc_bool weather = Weather_Heightmap != NULL;
+	BlockID old, block;
+	int i, x, y, z;
+
+	/* Lighting changes are only applied in Lighting.FlushChanges, and each chunk */
+	/*  is only marked as needing to be rebuilt once, so there's little per block work */
+	for (i = 0; i < count; i++) {
+		World_Unpack(indices[i], x, y, z);
+		old   = World_GetBlock(x, y, z);
+		block = blocks[i];
+		if (old == block) continue;
+
+		World_SetBlock(x, y, z, block);
+		if (weather) EnvRenderer_OnBlockChanged(x, y, z, old, block);
+		Lighting.OnBlockChanged(x, y, z, old, block);
+		MapRenderer_OnBlockChanged(x, y, z, block);
+		Searcher_OnBlockChanged(x, y, z, block);
+	}
 }
 
 void Game_ChangeBlock(int x, int y, int z, BlockID block) {
@@ -394,6 +418,7 @@ static void Game_Load(void) {
 	Game_AddComponent(&TabList_Component);
 	Game_AddComponent(&Models_Component);
 	Game_AddComponent(&Entities_Component);
+	Game_AddComponent(&Searcher_Component);
 	Game_AddComponent(&Http_Component);
 	Game_AddComponent(&Lighting_Component);
 
@@ -456,12 +481,16 @@ static void Game_Render3D(double delta, float t) {
 	Entities_RenderModels(delta, t);
 	Entities_RenderNames();
 
+	Profiler_Begin(PROFILER_PARTICLES);
 	Particles_Render(t);
+	Profiler_End(PROFILER_PARTICLES);
 	Camera.Active->GetPickedBlock(&Game_SelectedPos); /* TODO: only pick when necessary */
 	EnvRenderer_RenderSky();
 	EnvRenderer_RenderClouds();
 
+	Profiler_Begin(PROFILER_MAPRENDERER);
 	MapRenderer_Update(delta);
+	Profiler_End(PROFILER_MAPRENDERER);
 	MapRenderer_RenderNormal(delta);
 	EnvRenderer_RenderMapSides();
 
@@ -582,6 +611,7 @@ static void Game_RenderFrame(double delta) {
 	}
 
 	PerformScheduledTasks(delta);
+	Lighting.FlushChanges();
 	entTask = tasks[entTaskI];
 	t = (float)(entTask.accumulator / entTask.interval);
 	LocalPlayer_SetInterpPosition(t);
@@ -599,17 +629,22 @@ static void Game_RenderFrame(double delta) {
 	Gfx_LoadMatrix(MATRIX_VIEW,       &Gfx.View);
 
 	if (!Gui_GetBlocksWorld()) {
+		Profiler_Begin(PROFILER_RENDER3D);
 		Game_Render3D(delta, t);
+		Profiler_End(PROFILER_RENDER3D);
 	} else {
 		RayTracer_SetInvalid(&Game_SelectedPos);
 	}
 
+	Profiler_Begin(PROFILER_GUI);
 	Gfx_Begin2D(Game.Width, Game.Height);
 	Gui_RenderGui(delta);
 	Gfx_End2D();
+	Profiler_End(PROFILER_GUI);
 
 	if (Game_ScreenshotRequested) Game_TakeScreenshot();
 	Gfx_EndFrame();
+	Profiler_EndFrame(delta);
 }
 
 void Game_Free(void* obj) {
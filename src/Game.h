@@ -77,6 +77,11 @@ void Game_Reset(void);
 /* (updating state means recalculating light, redrawing chunk block is in, etc) */
 /* NOTE: This does NOT notify the server, use Game_ChangeBlock for that. */
 CC_API void Game_UpdateBlock(int x, int y, int z, BlockID block);
+/* Sets multiple blocks in the map, then updates state associated with the blocks that actually changed. */
+/* indices are packed coordinates (see World_Pack), and blocks are the new blocks at those coordinates. */
+/* NOTE: Much faster than calling Game_UpdateBlock for each block, as state is updated once per batch where possible. */
+/* NOTE: This does NOT notify the server, use Game_ChangeBlock for that. */
+CC_API void Game_UpdateBlocks(const int* indices, const BlockID* blocks, int count);
 /* Calls Game_UpdateBlock, then informs server connection of the block change. */
 /* In multiplayer this is sent to the server, in singleplayer just activates physics. */
 CC_API void Game_ChangeBlock(int x, int y, int z, BlockID block);
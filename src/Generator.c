@@ -1,10 +1,15 @@
 #include "Generator.h"
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GEN_SSE2
+#endif
 #include "BlockID.h"
 #include "ExtMath.h"
 #include "Funcs.h"
 #include "Platform.h"
 #include "World.h"
 #include "Utils.h"
+#include "WorkerPool.h"
 
 volatile float Gen_CurrentProgress;
 volatile const char* Gen_CurrentState;
@@ -12,6 +17,7 @@ volatile cc_bool Gen_Done;
 int Gen_Seed;
 cc_bool Gen_Vanilla;
 BlockRaw* Gen_Blocks;
+int Gen_ThreadsCount;
 
 static void Gen_Init(void) {
 	Gen_CurrentProgress = 0.0f;
@@ -20,6 +26,99 @@ static void Gen_Init(void) {
 }
 
 
+/*########################################################################################################################*
+*---------------------------------------------------Generator threads-----------------------------------------------------*
+*#########################################################################################################################*/
+/* The rows of the map are split into bands, which are processed by the generating thread and the extra threads at once */
+#define GEN_BAND_ROWS 16
+typedef void (*GenBandFunc)(int zBeg, int zEnd);
+
+static struct WorkerPool gen_pool;
+static void* gen_mutex;
+static void* gen_finished;
+
+static GenBandFunc gen_bandFunc;
+static cc_bool gen_bandProgress;
+static int gen_nextRow, gen_rowsDone;
+
+/* Keeps claiming and processing bands of rows, until there are no more rows left */
+static void Gen_ProcessBands(void) {
+	cc_bool finished;
+	int zBeg, zEnd;
+
+	for (;;) {
+		Mutex_Lock(gen_mutex);
+		zBeg = gen_nextRow;
+		zEnd = min(zBeg + GEN_BAND_ROWS, World.Length);
+		gen_nextRow = max(zBeg, zEnd);
+		Mutex_Unlock(gen_mutex);
+		if (zBeg >= World.Length) return;
+
+		gen_bandFunc(zBeg, zEnd);
+
+		Mutex_Lock(gen_mutex);
+		gen_rowsDone += zEnd - zBeg;
+		finished      = gen_rowsDone == World.Length;
+		if (gen_bandProgress) Gen_CurrentProgress = (float)gen_rowsDone / World.Length;
+		Mutex_Unlock(gen_mutex);
+		if (finished) Waitable_Signal(gen_finished);
+	}
+}
+
+static void Gen_Work(int index) { Gen_ProcessBands(); }
+static void Gen_Thread(void)     { WorkerPool_RunWorker(&gen_pool); }
+
+/* Calls func for every band of rows in the map, returning once all of the bands have been processed */
+/* NOTE: func must only change blocks in the given rows, so that the result is the same for any number of threads */
+static void Gen_RunBands(GenBandFunc func, cc_bool progress) {
+	cc_bool finished;
+	int z;
+
+	if (!gen_pool.Count) {
+		for (z = 0; z < World.Length; z += GEN_BAND_ROWS) {
+			if (progress) Gen_CurrentProgress = (float)z / World.Length;
+			func(z, min(z + GEN_BAND_ROWS, World.Length));
+		}
+		return;
+	}
+
+	Mutex_Lock(gen_mutex);
+	gen_bandFunc     = func;
+	gen_bandProgress = progress;
+	gen_nextRow = 0; gen_rowsDone = 0;
+	Mutex_Unlock(gen_mutex);
+
+	WorkerPool_WakeAll(&gen_pool);
+	Gen_ProcessBands();
+
+	for (;;) {
+		Mutex_Lock(gen_mutex);
+		finished = gen_rowsDone == World.Length;
+		Mutex_Unlock(gen_mutex);
+
+		if (finished) break;
+		Waitable_Wait(gen_finished);
+	}
+}
+
+static void Gen_StartThreads(void) {
+	int count = min(Gen_ThreadsCount, GEN_MAX_THREADS);
+	if (count <= 0) return;
+
+	gen_mutex    = Mutex_Create();
+	gen_finished = Waitable_Create();
+	WorkerPool_Start(&gen_pool, count, Gen_Thread, Gen_Work);
+}
+
+static void Gen_StopThreads(void) {
+	if (!gen_pool.Count) return;
+	WorkerPool_Stop(&gen_pool);
+
+	Mutex_Free(gen_mutex);
+	Waitable_Free(gen_finished);
+}
+
+
 /*########################################################################################################################*
 *-----------------------------------------------------Flatgrass gen-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -111,6 +210,58 @@ static float ImprovedNoise_Calc(const cc_uint8* p, float x, float y) {
 	return c1 + v * (c2 - c1);
 }
 
+#ifdef GEN_SSE2
+/* x * x * x * (x * (x * 6 - 15) + 10) */
+static __m128 Fade4(__m128 x) {
+	__m128 t = _mm_sub_ps(_mm_mul_ps(x, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f));
+	t = _mm_add_ps(_mm_mul_ps(x, t), _mm_set1_ps(10.0f));
+	return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(x, x), x), t);
+}
+
+/* Same as ImprovedNoise_Calc, but for 4 points at once */
+/* NOTE: Operations are done in exactly the same order, so that results are exactly the same too */
+static __m128 ImprovedNoise_Calc4(const cc_uint8* p, __m128 x, __m128 y) {
+	int X[4], Y[4], gx[16], gy[16];
+	__m128i xFloor, yFloor;
+	__m128 u, v, one, g22, g12, g21, g11, c1, c2;
+	int i, A, B, hash;
+
+	/* (int)x, minus 1 if x is not >= 0 */
+	xFloor = _mm_add_epi32(_mm_cvttps_epi32(x), _mm_castps_si128(_mm_cmpnge_ps(x, _mm_setzero_ps())));
+	yFloor = _mm_add_epi32(_mm_cvttps_epi32(y), _mm_castps_si128(_mm_cmpnge_ps(y, _mm_setzero_ps())));
+	_mm_storeu_si128((__m128i*)X, xFloor);
+	_mm_storeu_si128((__m128i*)Y, yFloor);
+	x = _mm_sub_ps(x, _mm_cvtepi32_ps(xFloor));
+	y = _mm_sub_ps(y, _mm_cvtepi32_ps(yFloor));
+
+	/* Looking up the gradients can't be vectorised, so they are looked up for each point one at a time */
+	for (i = 0; i < 4; i++) {
+		A = p[X[i] & 0xFF] + (Y[i] & 0xFF); B = p[(X[i] & 0xFF) + 1] + (Y[i] & 0xFF);
+
+		hash = (p[p[A]]     & 0xF) << 1; gx[i]      = ((xFlags >> hash) & 3) - 1; gy[i]      = ((yFlags >> hash) & 3) - 1;
+		hash = (p[p[B]]     & 0xF) << 1; gx[i + 4]  = ((xFlags >> hash) & 3) - 1; gy[i + 4]  = ((yFlags >> hash) & 3) - 1;
+		hash = (p[p[A + 1]] & 0xF) << 1; gx[i + 8]  = ((xFlags >> hash) & 3) - 1; gy[i + 8]  = ((yFlags >> hash) & 3) - 1;
+		hash = (p[p[B + 1]] & 0xF) << 1; gx[i + 12] = ((xFlags >> hash) & 3) - 1; gy[i + 12] = ((yFlags >> hash) & 3) - 1;
+	}
+
+	u   = Fade4(x);
+	v   = Fade4(y);
+	one = _mm_set1_ps(1.0f);
+
+#define Grad4(i, gX, gY) _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i*)&gx[i])), gX), \
+									_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((__m128i*)&gy[i])), gY))
+	g22 = Grad4( 0, x, y);
+	g12 = Grad4( 4, _mm_sub_ps(x, one), y);
+	c1  = _mm_add_ps(g22, _mm_mul_ps(u, _mm_sub_ps(g12, g22)));
+
+	g21 = Grad4( 8, x, _mm_sub_ps(y, one));
+	g11 = Grad4(12, _mm_sub_ps(x, one), _mm_sub_ps(y, one));
+	c2  = _mm_add_ps(g21, _mm_mul_ps(u, _mm_sub_ps(g11, g21)));
+
+	return _mm_add_ps(c1, _mm_mul_ps(v, _mm_sub_ps(c2, c1)));
+}
+#endif
+
 
 struct OctaveNoise { cc_uint8 p[8][NOISE_TABLE_SIZE]; int octaves; };
 static void OctaveNoise_Init(struct OctaveNoise* n, RNGState* rnd, int octaves) {
@@ -135,6 +286,22 @@ static float OctaveNoise_Calc(const struct OctaveNoise* n, float x, float y) {
 	return sum;
 }
 
+#ifdef GEN_SSE2
+static __m128 OctaveNoise_Calc4(const struct OctaveNoise* n, __m128 x, __m128 y) {
+	float amplitude = 1, freq = 1;
+	__m128 sum = _mm_setzero_ps(), noise;
+	int i;
+
+	for (i = 0; i < n->octaves; i++) {
+		noise = ImprovedNoise_Calc4(n->p[i], _mm_mul_ps(x, _mm_set1_ps(freq)), _mm_mul_ps(y, _mm_set1_ps(freq)));
+		sum   = _mm_add_ps(sum, _mm_mul_ps(noise, _mm_set1_ps(amplitude)));
+		amplitude *= 2.0f;
+		freq *= 0.5f;
+	}
+	return sum;
+}
+#endif
+
 
 struct CombinedNoise { struct OctaveNoise noise1, noise2; };
 static void CombinedNoise_Init(struct CombinedNoise* n, RNGState* rnd, int octaves1, int octaves2) {
@@ -147,21 +314,37 @@ static float CombinedNoise_Calc(const struct CombinedNoise* n, float x, float y)
 	return OctaveNoise_Calc(&n->noise1, x + offset, y);
 }
 
+#ifdef GEN_SSE2
+static __m128 CombinedNoise_Calc4(const struct CombinedNoise* n, __m128 x, __m128 y) {
+	__m128 offset = OctaveNoise_Calc4(&n->noise2, x, y);
+	return OctaveNoise_Calc4(&n->noise1, _mm_add_ps(x, offset), y);
+}
+
+/* Returns x, x + 1, x + 2, x + 3 as floats */
+static __m128 Gen_Columns4(int x) {
+	return _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x), _mm_set_epi32(3, 2, 1, 0)));
+}
+#endif
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Notchy map gen-------------------------------------------------------*
 *#########################################################################################################################*/
-static int waterLevel, minHeight;
+static int waterLevel, minHeight, minStoneY;
 static cc_int16* Heightmap;
 static RNGState rnd;
+/* Noise used by the steps that are split into bands of rows */
+static struct CombinedNoise heightNoise1, heightNoise2;
+static struct OctaveNoise heightNoise3, strataNoise, surfaceNoise1, surfaceNoise2;
 
-static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, BlockRaw block) {
+/* Only fills in the part of the spheroid that is between rows zMin and zMax */
+static void NotchyGen_FillOblateSpheroid(int x, int y, int z, float radius, BlockRaw block, int zMin, int zMax) {
 	int xBeg = Math_Floor(max(x - radius, 0));
 	int xEnd = Math_Floor(min(x + radius, World.MaxX));
 	int yBeg = Math_Floor(max(y - radius, 0));
 	int yEnd = Math_Floor(min(y + radius, World.MaxY));
-	int zBeg = Math_Floor(max(z - radius, 0));
-	int zEnd = Math_Floor(min(z + radius, World.MaxZ));
+	int zBeg = max(Math_Floor(max(z - radius, 0)), zMin);
+	int zEnd = min(Math_Floor(min(z + radius, World.MaxZ)), zMax);
 
 	float radiusSq = radius * radius;
 	int index;
@@ -216,38 +399,153 @@ static void NotchyGen_FloodFill(int index, BlockRaw block) {
 	if (limit > STACK_FAST) Mem_Free(stack);
 }
 
+/* Spheroids are first recorded, and then filled in bands of rows at once */
+/* NOTE: This only works because spheroids only replace stone, so it doesn't matter what order they are filled in */
+struct GenSpheroid { int x, y, z; float radius; };
+#define GEN_MAX_SPHEROIDS 4096
+static struct GenSpheroid spheroids[GEN_MAX_SPHEROIDS];
+static int spheroidsCount;
+static BlockRaw spheroidsBlock;
+
+/* Spheroids that overlap each band are listed in bandSpheroids, from bandStarts[band] to bandStarts[band + 1] */
+static int* bandStarts;
+static cc_uint16* bandSpheroids;
+static int bandsCount, bandSpheroidsCapacity;
+
+static void NotchyGen_FillSpheroidsBand(int zBeg, int zEnd) {
+	struct GenSpheroid* s;
+	int band = zBeg / GEN_BAND_ROWS, i;
+
+	for (i = bandStarts[band]; i < bandStarts[band + 1]; i++) {
+		s = &spheroids[bandSpheroids[i]];
+		NotchyGen_FillOblateSpheroid(s->x, s->y, s->z, s->radius, spheroidsBlock, zBeg, zEnd - 1);
+	}
+}
 
-static void NotchyGen_CreateHeightmap(void) {
-	float hLow, hHigh, height;
-	int hIndex = 0, adjHeight;
-	int x, z;
-	struct CombinedNoise n1, n2;
-	struct OctaveNoise n3;
+/* Returns the first and last band that the spheroid overlaps */
+static void NotchyGen_GetSpheroidBands(struct GenSpheroid* s, int* first, int* last) {
+	int zBeg = Math_Floor(max(s->z - s->radius, 0));
+	int zEnd = Math_Floor(min(s->z + s->radius, World.MaxZ));
 
-	CombinedNoise_Init(&n1, &rnd, 8, 8);
-	CombinedNoise_Init(&n2, &rnd, 8, 8);	
-	OctaveNoise_Init(&n3, &rnd, 6);
+	*first = zBeg / GEN_BAND_ROWS;
+	*last  = zBeg <= zEnd ? zEnd / GEN_BAND_ROWS : *first - 1;
+}
 
-	Gen_CurrentState = "Building heightmap";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+static void NotchyGen_FlushSpheroids(void) {
+	int i, band, first, last, total = 0;
+	if (!spheroidsCount) return;
+	Mem_Set(bandStarts, 0, (bandsCount + 1) * sizeof(int));
 
-		for (x = 0; x < World.Width; x++) {
-			hLow   = CombinedNoise_Calc(&n1, x * 1.3f, z * 1.3f) / 6 - 4;
-			height = hLow;
+	/* Count how many spheroids overlap each band, then turn the counts into where each band's list ends */
+	for (i = 0; i < spheroidsCount; i++) {
+		NotchyGen_GetSpheroidBands(&spheroids[i], &first, &last);
+		for (band = first; band <= last; band++) { bandStarts[band]++; total++; }
+	}
+	for (band = 1; band <= bandsCount; band++) {
+		bandStarts[band] += bandStarts[band - 1];
+	}
 
-			if (OctaveNoise_Calc(&n3, (float)x, (float)z) <= 0) {
-				hHigh = CombinedNoise_Calc(&n2, x * 1.3f, z * 1.3f) / 5 + 6;
-				height = max(hLow, hHigh);
-			}
+	if (total > bandSpheroidsCapacity) {
+		bandSpheroidsCapacity = total;
+		bandSpheroids = (cc_uint16*)Mem_Realloc(bandSpheroids, total, 2, "gen band spheroids");
+	}
+	/* Filling in backwards keeps the spheroids in each band in the order they were added */
+	for (i = spheroidsCount - 1; i >= 0; i--) {
+		NotchyGen_GetSpheroidBands(&spheroids[i], &first, &last);
+		for (band = first; band <= last; band++) { bandSpheroids[--bandStarts[band]] = i; }
+	}
+
+	Gen_RunBands(NotchyGen_FillSpheroidsBand, false);
+	spheroidsCount = 0;
+}
 
-			height *= 0.5f;
-			if (height < 0) height *= 0.8f;
+static void NotchyGen_AddSpheroid(int x, int y, int z, float radius, BlockRaw block) {
+	struct GenSpheroid* s = &spheroids[spheroidsCount++];
+	s->x = x; s->y = y; s->z = z; s->radius = radius;
+
+	spheroidsBlock = block;
+	if (spheroidsCount == GEN_MAX_SPHEROIDS) NotchyGen_FlushSpheroids();
+}
+
+static void NotchyGen_InitSpheroids(void) {
+	bandsCount = (World.Length + GEN_BAND_ROWS - 1) / GEN_BAND_ROWS;
+	bandStarts = (int*)Mem_Alloc(bandsCount + 1, sizeof(int), "gen band starts");
+	spheroidsCount = 0;
+}
+
+static void NotchyGen_FreeSpheroids(void) {
+	Mem_Free(bandStarts);
+	Mem_Free(bandSpheroids);
+	bandStarts    = NULL;
+	bandSpheroids = NULL;
+	bandSpheroidsCapacity = 0;
+}
+
+
+static int NotchyGen_CalcHeight(float noise1, float noise2, float noise3) {
+	float hLow, hHigh, height;
+	hLow   = noise1 / 6 - 4;
+	height = hLow;
+
+	if (noise3 <= 0) {
+		hHigh  = noise2 / 5 + 6;
+		height = max(hLow, hHigh);
+	}
 
-			adjHeight = (int)(height + waterLevel);
-			minHeight = min(adjHeight, minHeight);
-			Heightmap[hIndex++] = adjHeight;
+	height *= 0.5f;
+	if (height < 0) height *= 0.8f;
+	return (int)(height + waterLevel);
+}
+
+static void NotchyGen_HeightmapBand(int zBeg, int zEnd) {
+	float noise1, noise2, noise3;
+	int hIndex, x, z;
+#ifdef GEN_SSE2
+	float noise[3][4];
+	__m128 xs, zs;
+	int i;
+#endif
+
+	for (z = zBeg; z < zEnd; z++) {
+		hIndex = z * World.Width;
+		x      = 0;
+#ifdef GEN_SSE2
+		for (; x + 4 <= World.Width; x += 4) {
+			xs = Gen_Columns4(x);
+			zs = _mm_set1_ps((float)z);
+			_mm_storeu_ps(noise[2], OctaveNoise_Calc4(&heightNoise3, xs, zs));
+
+			xs = _mm_mul_ps(xs, _mm_set1_ps(1.3f));
+			zs = _mm_set1_ps(z * 1.3f);
+			_mm_storeu_ps(noise[0], CombinedNoise_Calc4(&heightNoise1, xs, zs));
+			_mm_storeu_ps(noise[1], CombinedNoise_Calc4(&heightNoise2, xs, zs));
+
+			for (i = 0; i < 4; i++) {
+				Heightmap[hIndex++] = NotchyGen_CalcHeight(noise[0][i], noise[1][i], noise[2][i]);
+			}
 		}
+#endif
+		for (; x < World.Width; x++) {
+			noise1 = CombinedNoise_Calc(&heightNoise1, x * 1.3f, z * 1.3f);
+			noise3 = OctaveNoise_Calc(&heightNoise3, (float)x, (float)z);
+			noise2 = noise3 <= 0 ? CombinedNoise_Calc(&heightNoise2, x * 1.3f, z * 1.3f) : 0;
+
+			Heightmap[hIndex++] = NotchyGen_CalcHeight(noise1, noise2, noise3);
+		}
+	}
+}
+
+static void NotchyGen_CreateHeightmap(void) {
+	int i;
+	CombinedNoise_Init(&heightNoise1, &rnd, 8, 8);
+	CombinedNoise_Init(&heightNoise2, &rnd, 8, 8);
+	OctaveNoise_Init(&heightNoise3, &rnd, 6);
+
+	Gen_CurrentState = "Building heightmap";
+	Gen_RunBands(NotchyGen_HeightmapBand, true);
+
+	for (i = 0; i < World.Width * World.Length; i++) {
+		minHeight = min(Heightmap[i], minHeight);
 	}
 }
 
@@ -280,43 +578,62 @@ static int NotchyGen_CreateStrataFast(void) {
 	return max(stoneHeight, 1);
 }
 
-static void NotchyGen_CreateStrata(void) {
-	int dirtThickness, dirtHeight;
-	int minStoneY, stoneHeight;
-	int hIndex = 0, maxY = World.MaxY, index = 0;
-	int x, y, z;
-	struct OctaveNoise n;
+static void NotchyGen_FillStrataColumn(int x, int z, float noise) {
+	int dirtThickness, dirtHeight, stoneHeight;
+	int maxY = World.MaxY, index, y;
 
-	/* Try to bulk fill bottom of the map if possible */
-	minStoneY = NotchyGen_CreateStrataFast();
-	OctaveNoise_Init(&n, &rnd, 8);
+	dirtThickness = (int)(noise / 24 - 4);
+	dirtHeight    = Heightmap[z * World.Width + x];
+	stoneHeight   = dirtHeight + dirtThickness;
 
-	Gen_CurrentState = "Creating strata";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+	stoneHeight = min(stoneHeight, maxY);
+	dirtHeight  = min(dirtHeight,  maxY);
 
-		for (x = 0; x < World.Width; x++) {
-			dirtThickness = (int)(OctaveNoise_Calc(&n, (float)x, (float)z) / 24 - 4);
-			dirtHeight    = Heightmap[hIndex++];
-			stoneHeight   = dirtHeight + dirtThickness;
+	index = World_Pack(x, minStoneY, z);
+	for (y = minStoneY; y <= stoneHeight; y++) {
+		Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
+	}
 
-			stoneHeight = min(stoneHeight, maxY);
-			dirtHeight  = min(dirtHeight,  maxY);
+	stoneHeight = max(stoneHeight, 0);
+	index = World_Pack(x, (stoneHeight + 1), z);
+	for (y = stoneHeight + 1; y <= dirtHeight; y++) {
+		Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
+	}
+}
 
-			index = World_Pack(x, minStoneY, z);
-			for (y = minStoneY; y <= stoneHeight; y++) {
-				Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
-			}
+static void NotchyGen_StrataBand(int zBeg, int zEnd) {
+	int x, z;
+#ifdef GEN_SSE2
+	float noise[4];
+	int i;
+#endif
+
+	for (z = zBeg; z < zEnd; z++) {
+		x = 0;
+#ifdef GEN_SSE2
+		for (; x + 4 <= World.Width; x += 4) {
+			_mm_storeu_ps(noise, OctaveNoise_Calc4(&strataNoise, Gen_Columns4(x), _mm_set1_ps((float)z)));
 
-			stoneHeight = max(stoneHeight, 0);
-			index = World_Pack(x, (stoneHeight + 1), z);
-			for (y = stoneHeight + 1; y <= dirtHeight; y++) {
-				Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
+			for (i = 0; i < 4; i++) {
+				NotchyGen_FillStrataColumn(x + i, z, noise[i]);
 			}
 		}
+#endif
+		for (; x < World.Width; x++) {
+			NotchyGen_FillStrataColumn(x, z, OctaveNoise_Calc(&strataNoise, (float)x, (float)z));
+		}
 	}
 }
 
+static void NotchyGen_CreateStrata(void) {
+	/* Try to bulk fill bottom of the map if possible */
+	minStoneY = NotchyGen_CreateStrataFast();
+	OctaveNoise_Init(&strataNoise, &rnd, 8);
+
+	Gen_CurrentState = "Creating strata";
+	Gen_RunBands(NotchyGen_StrataBand, true);
+}
+
 static void NotchyGen_CarveCaves(void) {
 	int cavesCount, caveLen;
 	float caveX, caveY, caveZ;
@@ -357,9 +674,10 @@ static void NotchyGen_CarveCaves(void) {
 			radius = (World.Height - cenY) / (float)World.Height;
 			radius = 1.2f + (radius * 3.5f + 1.0f) * caveRadius;
 			radius = radius * Math_SinF(j * MATH_PI / caveLen);
-			NotchyGen_FillOblateSpheroid(cenX, cenY, cenZ, radius, BLOCK_AIR);
+			NotchyGen_AddSpheroid(cenX, cenY, cenZ, radius, BLOCK_AIR);
 		}
 	}
+	NotchyGen_FlushSpheroids();
 }
 
 static void NotchyGen_CarveOreVeins(float abundance, const char* state, BlockRaw block) {
@@ -393,9 +711,10 @@ static void NotchyGen_CarveOreVeins(float abundance, const char* state, BlockRaw
 			deltaPhi   = deltaPhi   * 0.9f + Random_Float(&rnd) - Random_Float(&rnd);
 
 			radius = abundance * Math_SinF(j * MATH_PI / veinLen) + 1.0f;
-			NotchyGen_FillOblateSpheroid((int)veinX, (int)veinY, (int)veinZ, radius, block);
+			NotchyGen_AddSpheroid((int)veinX, (int)veinY, (int)veinZ, radius, block);
 		}
 	}
+	NotchyGen_FlushSpheroids();
 }
 
 static void NotchyGen_FloodFillWaterBorders(void) {
@@ -457,18 +776,13 @@ static void NotchyGen_FloodFillLava(void) {
 	}
 }
 
-static void NotchyGen_CreateSurfaceLayer(void) {	
-	int hIndex = 0, index;
+static void NotchyGen_SurfaceBand(int zBeg, int zEnd) {
+	int hIndex, index;
 	BlockRaw above;
 	int x, y, z;
-	struct OctaveNoise n1, n2;
 
-	OctaveNoise_Init(&n1, &rnd, 8);
-	OctaveNoise_Init(&n2, &rnd, 8);
-
-	Gen_CurrentState = "Creating surface";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+	for (z = zBeg; z < zEnd; z++) {
+		hIndex = z * World.Width;
 
 		for (x = 0; x < World.Width; x++) {
 			y = Heightmap[hIndex++];
@@ -478,15 +792,23 @@ static void NotchyGen_CreateSurfaceLayer(void) {
 			above = y >= World.MaxY ? BLOCK_AIR : Gen_Blocks[index + World.OneY];
 
 			/* TODO: update heightmap */
-			if (above == BLOCK_STILL_WATER && (OctaveNoise_Calc(&n2, (float)x, (float)z) > 12)) {
+			if (above == BLOCK_STILL_WATER && (OctaveNoise_Calc(&surfaceNoise2, (float)x, (float)z) > 12)) {
 				Gen_Blocks[index] = BLOCK_GRAVEL;
 			} else if (above == BLOCK_AIR) {
-				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&n1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
+				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&surfaceNoise1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
 			}
 		}
 	}
 }
 
+static void NotchyGen_CreateSurfaceLayer(void) {
+	OctaveNoise_Init(&surfaceNoise1, &rnd, 8);
+	OctaveNoise_Init(&surfaceNoise2, &rnd, 8);
+
+	Gen_CurrentState = "Creating surface";
+	Gen_RunBands(NotchyGen_SurfaceBand, true);
+}
+
 static void NotchyGen_PlantFlowers(void) {
 	int numPatches;
 	BlockRaw block;
@@ -612,6 +934,8 @@ void NotchyGen_Generate(void) {
 	Random_Seed(&rnd, Gen_Seed);
 	waterLevel = World.Height / 2;	
 	minHeight  = World.Height;
+	Gen_StartThreads();
+	NotchyGen_InitSpheroids();
 
 	NotchyGen_CreateHeightmap();
 	NotchyGen_CreateStrata();
@@ -629,6 +953,8 @@ void NotchyGen_Generate(void) {
 	NotchyGen_PlantMushrooms();
 	NotchyGen_PlantTrees();
 
+	Gen_StopThreads();
+	NotchyGen_FreeSpheroids();
 	Mem_Free(Heightmap);
 	Heightmap = NULL;
 	Gen_Done  = true;
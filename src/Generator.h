@@ -17,6 +17,10 @@ extern volatile cc_bool Gen_Done;
 extern int Gen_Seed;
 extern cc_bool Gen_Vanilla;
 extern BlockRaw* Gen_Blocks;
+#define GEN_MAX_THREADS 16
+/* Number of extra threads used to generate parts of the map at once */
+/* NOTE: The generated map is exactly the same for any number of threads */
+extern int Gen_ThreadsCount;
 
 void FlatgrassGen_Generate(void);
 void NotchyGen_Generate(void);
@@ -10,10 +10,18 @@ Copyright 2014-2022 ClassiCube | Licensed under BSD-3
 struct IGameComponent;
 struct ScheduledTask;
 struct StringsBuffer;
+struct Stream;
 
 #define URL_MAX_SIZE (STRING_SIZE * 2)
-#define HTTP_FLAG_PRIORITY 0x01
-#define HTTP_FLAG_NOCACHE  0x02
+#define HTTP_FLAG_PRIORITY   0x01
+#define HTTP_FLAG_NOCACHE    0x02
+/* Request has lower priority than other pending requests (e.g. skins) */
+/* NOTE: Only affects queue order, so a background request to a host with a free worker */
+/*  may still be started before a request to a host that already has maxPerHost active */
+#define HTTP_FLAG_BACKGROUND 0x04
+/* Response is stored in the on-disk asset cache, and revalidated against it when requested again */
+/* NOTE: Only supported for GET requests. A 304 response has the cached data instead of being empty */
+#define HTTP_FLAG_CACHE      0x08
 
 extern struct IGameComponent Http_Component;
 
@@ -37,11 +45,15 @@ struct HttpRequest {
 	cc_uint32   size; /* Size of the contents. */
 	cc_uint32 _capacity; /* (private) Maximum size of data buffer */
 	void* meta;          /* Pointer to backend specific data */
+	cc_uint8 _priority;     /* (private) Requests with higher priority are performed first */
+	cc_uint64 _timeAdded;   /* (private) Time request was added to the pending queue */
+	cc_uint64 _timeStarted; /* (private) Time a worker started performing the request */
+	cc_bool _useCache;      /* (private) Whether response is stored in the asset cache */
 
 	char lastModified[STRING_SIZE]; /* Time item cached at (if at all) */
 	char etag[STRING_SIZE];         /* ETag of cached item (if any) */
 	cc_uint8 requestType;           /* See the various REQUEST_TYPE_ */
-	cc_bool success;                /* Whether Result is 0, status is 200, and data is not NULL */
+	cc_bool success;                /* Whether Result is 0, status is 200 (or cached 304), and data is not NULL */
 	struct StringsBuffer* cookies;  /* Cookie list sent in requests. May be modified by the response. */
 };
 
@@ -81,4 +93,16 @@ cc_bool Http_GetCurrent(int* reqID, int* progress);
 int Http_CheckProgress(int reqID);
 /* Clears the list of pending requests. */
 void Http_ClearPending(void);
+/* Attempts to open the response for the given url that is stored in the asset cache. */
+/* Returns false if the response is not cached. (see HTTP_FLAG_CACHE) */
+cc_bool Http_OpenCached(const cc_string* url, struct Stream* stream);
+
+#define HTTP_HISTOGRAM_BUCKETS 14
+/* Times of completed requests. Bucket 0 counts requests that took under 1 ms, */
+/*  and each bucket i after that counts requests that took under 2^i ms (last bucket counts the rest) */
+CC_VAR extern struct _HttpStatsData {
+	int Count;
+	int WaitTimes[HTTP_HISTOGRAM_BUCKETS]; /* Time spent in pending queue before a worker started the request */
+	int Latencies[HTTP_HISTOGRAM_BUCKETS]; /* Time from a worker starting the request until it finished */
+} HttpStats;
 #endif
@@ -63,6 +63,9 @@ static void Http_StartNextDownload(void) {
 	String_InitArray(url, urlBuffer);
 
 	req = &queuedReqs.entries[0];
+	req->_timeStarted = Stopwatch_Measure();
+	/* The browser performs conditional requests itself, so this only marks the cached response as used */
+	AssetCache_Prepare(req);
 	Http_GetUrl(req, &url);
 	Platform_Log1("Fetching %s", &url);
 
@@ -79,7 +82,7 @@ static void Http_StartNextDownload(void) {
 		RequestList_RemoveAt(&queuedReqs, 0);
 		Http_StartNextDownload();
 	} else {
-		RequestList_Append(&workingReqs, req, false);
+		RequestList_Append(&workingReqs, req);
 		RequestList_RemoveAt(&queuedReqs, 0);
 	}
 }
@@ -123,9 +126,11 @@ static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags) {
 		cc_string url = String_FromRawArray(req->url);
 		int lo = (int)(startTime), hi = (int)(startTime >> 32);
 		String_Format2(&url, "?t=%i%i", &hi, &lo);
+		/* Otherwise a new copy would be cached every session */
+		req->_useCache = false;
 	}
 
-	RequestList_Append(&queuedReqs, req, flags);
+	RequestList_Append(&queuedReqs, req);
 	Http_StartNextDownload();
 }
 
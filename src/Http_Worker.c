@@ -1,18 +1,28 @@
 #include "Core.h"
 #ifndef CC_BUILD_WEB
 #include "_HttpBase.h"
-static void* workerWaitable;
-static void* workerThread;
+#define HTTP_MAX_WORKERS 8
+struct HttpWorker {
+	void* thread;
+	void* wake;
+	void* backend; /* Backend specific data (e.g. curl handle) */
+	/* Whether waiting for requests to be added (protected by pendingMutex) */
+	cc_bool idle;
+	/* Host of the request being performed, empty if none (protected by pendingMutex) */
+	cc_string host; char _hostBuffer[STRING_SIZE];
+	/* Request being performed, id is 0 if none (id/progress protected by curRequestMutex) */
+	struct HttpRequest request;
+};
+static struct HttpWorker workers[HTTP_MAX_WORKERS];
+static int workersCount, workersStarted, maxPerHost;
+
 static void* pendingMutex;
 static struct RequestList pendingReqs;
-
 static void* curRequestMutex;
-static struct HttpRequest http_curRequest;
-static volatile int http_curProgress = HTTP_PROGRESS_NOT_WORKING_ON;
 
 /* Allocates initial data buffer to store response contents */
 static void Http_BufferInit(struct HttpRequest* req) {
-	http_curProgress = 0;
+	req->progress  = 0;
 	req->_capacity = req->contentLength ? req->contentLength : 1;
 	req->data      = (cc_uint8*)Mem_Alloc(req->_capacity, 1, "http data");
 	req->size      = 0;
@@ -30,22 +40,24 @@ static void Http_BufferEnsure(struct HttpRequest* req, cc_uint32 amount) {
 /* Increases size and updates current progress */
 static void Http_BufferExpanded(struct HttpRequest* req, cc_uint32 read) {
 	req->size += read;
-	if (req->contentLength) http_curProgress = (int)(100.0f * req->size / req->contentLength);
+	if (req->contentLength) req->progress = (int)(100.0f * req->size / req->contentLength);
 }
 
 
 /*########################################################################################################################*
 *--------------------------------------------------Common downloader code-------------------------------------------------*
 *#########################################################################################################################*/
-/* Sets up state to begin a http request */
-static void Http_BeginRequest(struct HttpRequest* req, cc_string* url) {
+/* Sets up state for a worker to begin a http request */
+static void Http_BeginRequest(struct HttpWorker* w, struct HttpRequest* req, cc_string* url) {
 	Http_GetUrl(req, url);
 	Platform_Log2("Fetching %s (type %b)", url, &req->requestType);
+	req->_timeStarted = Stopwatch_Measure();
+	AssetCache_Prepare(req);
 
 	Mutex_Lock(curRequestMutex);
 	{
-		http_curRequest  = *req;
-		http_curProgress = HTTP_PROGRESS_MAKING_REQUEST;
+		w->request          = *req;
+		w->request.progress = HTTP_PROGRESS_MAKING_REQUEST;
 	}
 	Mutex_Unlock(curRequestMutex);
 }
@@ -121,16 +133,27 @@ static void Http_SetRequestHeaders(struct HttpRequest* req) {
 	Http_AddHeader(req, "Cookie", &cookies);
 }
 
-static void Http_SignalWorker(void) { Waitable_Signal(workerWaitable); }
+/* Wakes up a worker that is waiting for requests to be added (if any are) */
+/* NOTE: pendingMutex must be locked when calling this */
+static void Http_SignalWorker(void) {
+	int i;
+	for (i = 0; i < workersCount; i++) {
+		if (!workers[i].idle) continue;
+
+		workers[i].idle = false;
+		Waitable_Signal(workers[i].wake);
+		return;
+	}
+}
 
-/* Adds a req to the list of pending requests, waking up worker thread if needed */
+/* Adds a req to the list of pending requests, waking up a worker thread if needed */
 static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags) {
 	Mutex_Lock(pendingMutex);
 	{	
-		RequestList_Append(&pendingReqs, req, flags);
+		RequestList_Append(&pendingReqs, req);
+		Http_SignalWorker();
 	}
 	Mutex_Unlock(pendingMutex);
-	Http_SignalWorker();
 }
 
 
@@ -150,20 +173,35 @@ cc_bool Http_GetResult(int reqID, struct HttpRequest* item) {
 }
 
 cc_bool Http_GetCurrent(int* reqID, int* progress) {
+	int i;
+	*reqID    = 0;
+	*progress = HTTP_PROGRESS_NOT_WORKING_ON;
+
 	Mutex_Lock(curRequestMutex);
 	{
-		*reqID    = http_curRequest.id;
-		*progress = http_curProgress;
+		/* Several requests may be in progress, so just use whichever is found first */
+		for (i = 0; i < workersCount; i++) {
+			if (!workers[i].request.id) continue;
+
+			*reqID    = workers[i].request.id;
+			*progress = workers[i].request.progress;
+			break;
+		}
 	}
 	Mutex_Unlock(curRequestMutex);
 	return *reqID != 0;
 }
 
 int Http_CheckProgress(int reqID) {
-	int curReqID, progress;
-	Http_GetCurrent(&curReqID, &progress);
+	int i, progress = HTTP_PROGRESS_NOT_WORKING_ON;
 
-	if (reqID != curReqID) progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	Mutex_Lock(curRequestMutex);
+	{
+		for (i = 0; i < workersCount; i++) {
+			if (workers[i].request.id == reqID) progress = workers[i].request.progress;
+		}
+	}
+	Mutex_Unlock(curRequestMutex);
 	return progress;
 }
 
@@ -198,6 +236,7 @@ void Http_TryCancel(int reqID) {
 #include <stddef.h>
 /* === BEGIN CURL HEADERS === */
 typedef void CURL;
+typedef void CURLSH;
 struct curl_slist;
 typedef int CURLcode;
 
@@ -222,9 +261,19 @@ typedef int CURLcode;
 #define CURLOPT_HTTPGET        (0     + 80)
 #define CURLOPT_SSL_VERIFYHOST (0     + 81)
 #define CURLOPT_HTTP_VERSION   (0     + 84)
+#define CURLOPT_SHARE          (10000 + 100)
+#define CURLOPT_TCP_KEEPALIVE  (0     + 213)
 
 #define CURL_HTTP_VERSION_1_1   2L /* stick to HTTP 1.1 */
 
+#define CURLSHOPT_SHARE      1
+#define CURLSHOPT_LOCKFUNC   3
+#define CURLSHOPT_UNLOCKFUNC 4
+#define CURL_LOCK_DATA_DNS         3
+#define CURL_LOCK_DATA_SSL_SESSION 4
+#define CURL_LOCK_DATA_CONNECT     5
+#define CURL_LOCK_DATA_COUNT       8
+
 #if defined _WIN32
 #define APIENTRY __cdecl
 #else
@@ -240,6 +289,8 @@ static void     (APIENTRY *_curl_easy_cleanup)(CURL* c);
 static void     (APIENTRY *_curl_slist_free_all)(struct curl_slist* l);
 static struct curl_slist* (APIENTRY *_curl_slist_append)(struct curl_slist* l, const char* v);
 static const char* (APIENTRY *_curl_easy_strerror)(CURLcode res);
+static CURLSH*  (APIENTRY *_curl_share_init)(void);
+static int      (APIENTRY *_curl_share_setopt)(CURLSH* s, int opt, ...);
 /* === END CURL HEADERS === */
 
 #if defined CC_BUILD_WIN
@@ -277,14 +328,43 @@ static cc_bool LoadCurlFuncs(void) {
 		success = DynamicLib_LoadAll(&curlAlt, funcs, Array_Elems(funcs), &lib);
 	}
 
-	/* Non-essential function missing in older curl versions */
+	/* Non-essential functions missing in older curl versions */
 	_curl_easy_strerror = DynamicLib_Get2(lib, "curl_easy_strerror");
+	_curl_share_init    = DynamicLib_Get2(lib, "curl_share_init");
+	_curl_share_setopt  = DynamicLib_Get2(lib, "curl_share_setopt");
 	return success;
 }
 
-static CURL* curl;
+static CURLSH* curlShare;
+static void* curlShareMutexes[CURL_LOCK_DATA_COUNT];
 static cc_bool curlSupported, curlVerbose;
 
+static void APIENTRY Http_LockShare(CURL* c, int data, int access, void* userdata) {
+	Mutex_Lock(curlShareMutexes[data % CURL_LOCK_DATA_COUNT]);
+}
+static void APIENTRY Http_UnlockShare(CURL* c, int data, void* userdata) {
+	Mutex_Unlock(curlShareMutexes[data % CURL_LOCK_DATA_COUNT]);
+}
+
+/* Shares open connections (i.e. HTTP keep-alive), DNS lookups, and SSL sessions between all the workers */
+/* NOTE: Sharing connections requires curl 7.57 or later, otherwise each worker just reuses its own connections */
+static void Http_InitShare(void) {
+	int i;
+	if (!_curl_share_init || !_curl_share_setopt) return;
+	curlShare = _curl_share_init();
+	if (!curlShare) return;
+
+	for (i = 0; i < CURL_LOCK_DATA_COUNT; i++) {
+		curlShareMutexes[i] = Mutex_Create();
+	}
+	_curl_share_setopt(curlShare, CURLSHOPT_LOCKFUNC,   Http_LockShare);
+	_curl_share_setopt(curlShare, CURLSHOPT_UNLOCKFUNC, Http_UnlockShare);
+
+	_curl_share_setopt(curlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	_curl_share_setopt(curlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	_curl_share_setopt(curlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+}
+
 cc_bool Http_DescribeError(cc_result res, cc_string* dst) {
 	const char* err;
 	
@@ -299,13 +379,19 @@ cc_bool Http_DescribeError(cc_result res, cc_string* dst) {
 static void HttpBackend_Init(void) {
 	static const cc_string msg = String_FromConst("Failed to init libcurl. All HTTP requests will therefore fail.");
 	CURLcode res;
+	int i;
 
 	if (!LoadCurlFuncs()) { Logger_WarnFunc(&msg); return; }
 	res = _curl_global_init(CURL_GLOBAL_DEFAULT);
 	if (res) { Logger_SimpleWarn(res, "initing curl"); return; }
+	Http_InitShare();
 
-	curl = _curl_easy_init();
-	if (!curl) { Logger_SimpleWarn(res, "initing curl_easy"); return; }
+	/* Each worker needs its own handle, as a handle can only be used by one thread at a time */
+	for (i = 0; i < workersCount; i++) {
+		workers[i].backend = _curl_easy_init();
+		if (!workers[i].backend) { Logger_SimpleWarn(res, "initing curl_easy"); return; }
+		if (curlShare) _curl_easy_setopt(workers[i].backend, CURLOPT_SHARE, curlShare);
+	}
 
 	curlSupported = true;
 	curlVerbose = Options_GetBool("curl-verbose", false);
@@ -347,11 +433,12 @@ static size_t Http_ProcessData(char *buffer, size_t size, size_t nitems, void* u
 }
 
 /* Sets general curl options for a request */
-static void Http_SetCurlOpts(struct HttpRequest* req) {
+static void Http_SetCurlOpts(CURL* curl, struct HttpRequest* req) {
 	_curl_easy_setopt(curl, CURLOPT_USERAGENT,      GAME_APP_NAME);
 	_curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
 	_curl_easy_setopt(curl, CURLOPT_MAXREDIRS,      20L);
 	_curl_easy_setopt(curl, CURLOPT_HTTP_VERSION,   CURL_HTTP_VERSION_1_1);
+	_curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE,  1L);
 
 	_curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, Http_ProcessHeader);
 	_curl_easy_setopt(curl, CURLOPT_HEADERDATA,     req);
@@ -364,7 +451,9 @@ static void Http_SetCurlOpts(struct HttpRequest* req) {
 	_curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
 }
 
-static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
+static cc_result HttpBackend_Do(struct HttpWorker* w, cc_string* url) {
+	struct HttpRequest* req = &w->request;
+	CURL* curl = (CURL*)w->backend;
 	char urlStr[NATIVE_STR_LEN];
 	void* post_data = req->data;
 	CURLcode res;
@@ -374,7 +463,7 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 	Http_SetRequestHeaders(req);
 	_curl_easy_setopt(curl, CURLOPT_HTTPHEADER, req->meta);
 
-	Http_SetCurlOpts(req);
+	Http_SetCurlOpts(curl, req);
 	Platform_EncodeUtf8(urlStr, url);
 	_curl_easy_setopt(curl, CURLOPT_URL, urlStr);
 
@@ -393,10 +482,10 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 		_curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
 	}
 
-	req->_capacity   = 0;
-	http_curProgress = HTTP_PROGRESS_FETCHING_DATA;
+	req->_capacity = 0;
+	req->progress  = HTTP_PROGRESS_FETCHING_DATA;
 	res = _curl_easy_perform(curl);
-	http_curProgress = 100;
+	req->progress  = 100;
 
 	_curl_slist_free_all((struct curl_slist*)req->meta);
 	/* can free now that request has finished */
@@ -461,10 +550,13 @@ struct HttpCacheEntry {
 	cc_string Address; /* Address of server. (e.g. "classicube.net") */
 	cc_uint16 Port;    /* Port server is listening on. (e.g 80) */
 	cc_bool Https;     /* Whether HTTPS or just HTTP protocol. */
+	int Users;         /* Number of workers currently using this connection. */
 	char _addressBuffer[STRING_SIZE + 1];
 };
+/* NOTE: Must be more than HTTP_MAX_WORKERS, so there's always an unused entry that can be evicted */
 #define HTTP_CACHE_ENTRIES 10
 static struct HttpCacheEntry http_cache[HTTP_CACHE_ENTRIES];
+static void* http_cacheMutex;
 static HINTERNET hInternet;
 
 /* Converts characters to UTF8, then calls Http_URlEncode on them. */
@@ -520,6 +612,7 @@ static cc_result HttpCache_Insert(int i, struct HttpCacheEntry* e) {
 	if (!conn) return GetLastError();
 
 	e->Handle     = conn;
+	e->Users      = 1;
 	http_cache[i] = *e;
 
 	/* otherwise address buffer points to stack buffer */
@@ -528,14 +621,15 @@ static cc_result HttpCache_Insert(int i, struct HttpCacheEntry* e) {
 }
 
 /* Finds or inserts the given entry into the cache */
-static cc_result HttpCache_Lookup(struct HttpCacheEntry* e) {
+static cc_result HttpCache_DoLookup(struct HttpCacheEntry* e) {
 	struct HttpCacheEntry* c;
-	int i;
+	int i, j;
 
 	for (i = 0; i < HTTP_CACHE_ENTRIES; i++) {
 		c = &http_cache[i];
 		if (c->Https == e->Https && String_Equals(&c->Address, &e->Address) && c->Port == e->Port) {
 			e->Handle = c->Handle;
+			c->Users++;
 			return 0;
 		}
 	}
@@ -546,9 +640,38 @@ static cc_result HttpCache_Lookup(struct HttpCacheEntry* e) {
 	}
 
 	/* TODO: Should we be consistent in which entry gets evicted? */
-	i = (cc_uint8)Stopwatch_Measure() % HTTP_CACHE_ENTRIES;
-	_InternetCloseHandle(http_cache[i].Handle);
-	return HttpCache_Insert(i, e);
+	j = (cc_uint8)Stopwatch_Measure() % HTTP_CACHE_ENTRIES;
+	/* Connection might still be in use by another worker */
+	for (i = 0; http_cache[j].Users && i < HTTP_CACHE_ENTRIES; i++) {
+		j = (j + 1) % HTTP_CACHE_ENTRIES;
+	}
+
+	_InternetCloseHandle(http_cache[j].Handle);
+	return HttpCache_Insert(j, e);
+}
+
+static cc_result HttpCache_Lookup(struct HttpCacheEntry* e) {
+	cc_result res;
+	Mutex_Lock(http_cacheMutex);
+	{
+		res = HttpCache_DoLookup(e);
+	}
+	Mutex_Unlock(http_cacheMutex);
+	return res;
+}
+
+/* Indicates that a worker is no longer using the given connection */
+static void HttpCache_Release(HINTERNET conn) {
+	int i;
+	if (!conn) return;
+
+	Mutex_Lock(http_cacheMutex);
+	{
+		for (i = 0; i < HTTP_CACHE_ENTRIES; i++) {
+			if (http_cache[i].Handle == conn) http_cache[i].Users--;
+		}
+	}
+	Mutex_Unlock(http_cacheMutex);
 }
 
 static void* wininet_lib;
@@ -569,6 +692,7 @@ static void HttpBackend_Init(void) {
 	static const cc_string wininet = String_FromConst("wininet.dll");
 	DynamicLib_LoadAll(&wininet, funcs, Array_Elems(funcs), &wininet_lib);
 	if (!wininet_lib) return;
+	http_cacheMutex = Mutex_Create();
 
 	/* TODO: Should we use INTERNET_OPEN_TYPE_PRECONFIG instead? */
 	hInternet = _InternetOpenA(GAME_APP_NAME, INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
@@ -585,7 +709,7 @@ static void Http_AddHeader(struct HttpRequest* req, const char* key, const cc_st
 }
 
 /* Creates and sends a HTTP request */
-static cc_result Http_StartRequest(struct HttpRequest* req, cc_string* url) {
+static cc_result Http_StartRequest(struct HttpRequest* req, cc_string* url, HINTERNET* conn) {
 	static const char* verbs[3] = { "GET", "HEAD", "POST" };
 	struct HttpCacheEntry entry;
 	cc_string path; char pathBuffer[URL_MAX_SIZE + 1];
@@ -599,6 +723,7 @@ static cc_result Http_StartRequest(struct HttpRequest* req, cc_string* url) {
 
 	if (!wininet_lib) return ERR_NOT_SUPPORTED;
 	if ((res = HttpCache_Lookup(&entry))) return res;
+	*conn = entry.Handle;
 
 	flags = INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_NO_UI | INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_COOKIES;
 	if (entry.Https) flags |= INTERNET_FLAG_SECURE;
@@ -655,18 +780,13 @@ static cc_result Http_DownloadData(struct HttpRequest* req, HINTERNET handle) {
 		Http_BufferExpanded(req, read);
 	}
 
- 	http_curProgress = 100;
+ 	req->progress = 100;
 	return 0;
 }
 
-static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
-	HINTERNET handle;
-	cc_result res = Http_StartRequest(req, url);
-	HttpRequest_Free(req);
-	if (res) return res;
-
-	handle = req->meta;
-	http_curProgress = HTTP_PROGRESS_FETCHING_DATA;
+static cc_result Http_PerformRequest(struct HttpRequest* req, HINTERNET handle) {
+	cc_result res;
+	req->progress = HTTP_PROGRESS_FETCHING_DATA;
 	res = Http_ProcessHeaders(req, handle);
 	if (res) { _InternetCloseHandle(handle); return res; }
 
@@ -677,6 +797,17 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 
 	return _InternetCloseHandle(handle) ? 0 : GetLastError();
 }
+
+static cc_result HttpBackend_Do(struct HttpWorker* w, cc_string* url) {
+	struct HttpRequest* req = &w->request;
+	HINTERNET conn = NULL;
+	cc_result res = Http_StartRequest(req, url, &conn);
+	HttpRequest_Free(req);
+
+	if (!res) res = Http_PerformRequest(req, req->meta);
+	HttpCache_Release(conn);
+	return res;
+}
 #elif defined CC_BUILD_ANDROID
 /*########################################################################################################################*
 *-----------------------------------------------------Android backend-----------------------------------------------------*
@@ -777,8 +908,9 @@ static cc_result Http_SetData(JNIEnv* env, struct HttpRequest* req) {
 	return res;
 }
 
-static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
+static cc_result HttpBackend_Do(struct HttpWorker* w, cc_string* url) {
 	static const cc_string userAgent = String_FromConst(GAME_APP_NAME);
+	struct HttpRequest* req = &w->request;
 	JNIEnv* env;
 	jint res;
 
@@ -790,10 +922,10 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 	Http_AddHeader(req, "User-Agent", &userAgent);
 	if (req->data && (res = Http_SetData(env, req))) return res;
 
-	req->_capacity   = 0;
-	http_curProgress = HTTP_PROGRESS_FETCHING_DATA;
+	req->_capacity = 0;
+	req->progress  = HTTP_PROGRESS_FETCHING_DATA;
 	res = JavaSCall_Int(env, JAVA_httpPerform, NULL);
-	http_curProgress = 100;
+	req->progress  = 100;
 	return res;
 }
 #elif defined CC_BUILD_CFNETWORK
@@ -852,9 +984,10 @@ static cc_result ParseResponseHeaders(struct HttpRequest* req, CFReadStreamRef s
     return 0;
 }
 
-static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
+static cc_result HttpBackend_Do(struct HttpWorker* w, cc_string* url) {
     static const cc_string userAgent = String_FromConst(GAME_APP_NAME);
     static CFStringRef verbs[] = { CFSTR("GET"), CFSTR("HEAD"), CFSTR("POST") };
+    struct HttpRequest* req = &w->request;
     cc_bool gotHeaders = false;
     char tmp[NATIVE_STR_LEN];
     CFHTTPMessageRef request;
@@ -917,55 +1050,93 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 }
 #endif
 
-static void ClearCurrentRequest(void) {
+static void ClearCurrentRequest(struct HttpWorker* w) {
 	Mutex_Lock(curRequestMutex);
 	{
-		http_curRequest.id = 0;
-		http_curProgress   = HTTP_PROGRESS_NOT_WORKING_ON;
+		w->request.id       = 0;
+		w->request.progress = HTTP_PROGRESS_NOT_WORKING_ON;
 	}
 	Mutex_Unlock(curRequestMutex);
 }
 
+static void Http_GetHost(struct HttpRequest* req, cc_string* host) {
+	cc_string url = String_FromRawArray(req->url);
+	cc_string addr, resource;
+	int idx = String_IndexOfConst(&url, "://");
+
+	if (idx >= 0) url = String_UNSAFE_SubstringAt(&url, idx + 3);
+	String_UNSAFE_Separate(&url, '/', &addr, &resource);
+	String_Copy(host, &addr);
+}
+
+/* Removes the highest priority pending request whose host doesn't already have */
+/*  the maximum number of requests to it being performed by the other workers */
+/* NOTE: pendingMutex must be locked when calling this */
+static cc_bool Http_TakeRequest(struct HttpWorker* w, struct HttpRequest* req) {
+	cc_string host; char hostBuffer[STRING_SIZE];
+	int i, j, active;
+	String_InitArray(host, hostBuffer);
+
+	for (i = 0; i < pendingReqs.count; i++) {
+		host.length = 0;
+		Http_GetHost(&pendingReqs.entries[i], &host);
+
+		for (j = 0, active = 0; j < workersCount; j++) {
+			if (workers[j].host.length && String_Equals(&workers[j].host, &host)) active++;
+		}
+		if (active >= maxPerHost) continue;
+
+		*req = pendingReqs.entries[i];
+		RequestList_RemoveAt(&pendingReqs, i);
+		String_Copy(&w->host, &host);
+		return true;
+	}
+	return false;
+}
+
 static void WorkerLoop(void) {
 	char urlBuffer[URL_MAX_SIZE]; cc_string url;
 	struct HttpRequest request;
+	struct HttpWorker* w;
 	cc_bool hasRequest;
 	cc_uint64 beg, end;
 	int elapsed;
 
-	for (;;) {
-		hasRequest = false;
+	Mutex_Lock(pendingMutex);
+	w = &workers[workersStarted++];
+	Mutex_Unlock(pendingMutex);
 
+	for (;;) {
 		Mutex_Lock(pendingMutex);
 		{
-			if (pendingReqs.count) {
-				request    = pendingReqs.entries[0];
-				hasRequest = true;
-				RequestList_RemoveAt(&pendingReqs, 0);
-			}
+			w->host.length = 0;
+			hasRequest = Http_TakeRequest(w, &request);
+			w->idle    = !hasRequest;
+			/* Get another worker to start on the remaining requests too */
+			if (hasRequest && pendingReqs.count) Http_SignalWorker();
 		}
 		Mutex_Unlock(pendingMutex);
 
 		/* Block until another thread submits a request to do */
 		if (!hasRequest) {
 			Platform_LogConst("Going back to sleep...");
-			Waitable_Wait(workerWaitable);
+			Waitable_Wait(w->wake);
 			continue;
 		}
 
 		String_InitArray(url, urlBuffer);
-		Http_BeginRequest(&request, &url);
+		Http_BeginRequest(w, &request, &url);
 
 		beg = Stopwatch_Measure();
-		request.result = HttpBackend_Do(&request, &url);
+		w->request.result = HttpBackend_Do(w, &url);
 		end = Stopwatch_Measure();
 
 		elapsed = Stopwatch_ElapsedMS(beg, end);
 		Platform_Log4("HTTP: result %i (http %i) in %i ms (%i bytes)",
-					&request.result, &request.statusCode, &elapsed, &request.size);
+					&w->request.result, &w->request.statusCode, &elapsed, &w->request.size);
 
-		Http_FinishRequest(&request);
-		ClearCurrentRequest();
+		Http_FinishRequest(&w->request);
+		ClearCurrentRequest(w);
 	}
 }
 
@@ -974,20 +1145,39 @@ static void WorkerLoop(void) {
 *-----------------------------------------------------Http component------------------------------------------------------*
 *#########################################################################################################################*/
 static void Http_Init(void) {
+	struct HttpWorker* w;
+	int i;
+
 	Http_InitCommon();
 	/* Http component gets initialised multiple times on Android */
-	if (workerThread) return;
+	if (workersCount) return;
+
+#ifdef CC_BUILD_ANDROID
+	/* The java side of the backend only supports performing one request at a time */
+	workersCount = 1;
+#else
+	workersCount = Options_GetInt(OPT_HTTP_WORKERS, 1, HTTP_MAX_WORKERS, 6);
+#endif
+	/* Less than the number of workers by default, so that e.g. skins being */
+	/*  downloaded doesn't delay downloading a texture pack from another host */
+	maxPerHost = Options_GetInt(OPT_HTTP_MAX_PER_HOST, 1, HTTP_MAX_WORKERS, 4);
 
 	HttpBackend_Init();
-	workerWaitable = Waitable_Create();
 	RequestList_Init(&pendingReqs);
 	RequestList_Init(&processedReqs);
 
 	pendingMutex    = Mutex_Create();
 	processedMutex  = Mutex_Create();
 	curRequestMutex = Mutex_Create();
-	workerThread    = Thread_Create(WorkerLoop);
 
-	Thread_Start2(workerThread, WorkerLoop);
+	for (i = 0; i < workersCount; i++) {
+		w = &workers[i];
+		String_InitArray(w->host, w->_hostBuffer);
+		w->request.progress = HTTP_PROGRESS_NOT_WORKING_ON;
+
+		w->wake   = Waitable_Create();
+		w->thread = Thread_Create(WorkerLoop);
+		Thread_Start2(w->thread, WorkerLoop);
+	}
 }
 #endif
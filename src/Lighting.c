@@ -7,6 +7,7 @@
 #include "Logger.h"
 #include "Event.h"
 #include "Game.h"
+#include "Utils.h"
 struct _Lighting Lighting;
 #define Lighting_Pack(x, z) ((x) + World.Width * (z))
 
@@ -102,145 +103,156 @@ static void ClassicLighting_Refresh(void) {
 /*########################################################################################################################*
 *----------------------------------------------------Lighting update------------------------------------------------------*
 *#########################################################################################################################*/
-static void ClassicLighting_UpdateLighting(int x, int y, int z, BlockID oldBlock, BlockID newBlock, int index, int lightH) {
-	cc_bool didBlock  = Blocks.BlocksLight[oldBlock];
-	cc_bool nowBlocks = Blocks.BlocksLight[newBlock];
-	int oldOffset     = (Blocks.LightOffset[oldBlock] >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1;
-	int newOffset     = (Blocks.LightOffset[newBlock] >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1;
-	BlockID above;
-
-	/* Two cases we need to handle here: */
-	if (didBlock == nowBlocks) {
-		if (!didBlock) return;              /* a) both old and new block do not block light */
-		if (oldOffset == newOffset) return; /* b) both blocks blocked light at the same Y coordinate */
-	}
+/* Changed blocks are queued per chunk column, and then applied all at once in ClassicLighting_FlushChanges */
+/* That way when many blocks are changed at once (e.g. a server pasting a large build), the light height */
+/*  of each column is only recalculated once, and each affected chunk is only refreshed once */
+struct QueuedColumns {
+	int cx, cz;
+	/* Lowest and highest Y of the changed blocks in each column (-1 when no blocks in the column changed) */
+	cc_int16 minY[CHUNK_SIZE_2], maxY[CHUNK_SIZE_2];
+};
+static struct QueuedColumns* queued;
+static int queuedCount, queuedCapacity;
+/* 1 + index into queued for each chunk column, 0 if no blocks have been changed in the chunk column */
+static int* queuedIndices;
 
-	if ((y - newOffset) >= lightH) {
-		if (nowBlocks) {
-			classic_heightmap[index] = y - newOffset;
-		} else {
-			/* Part of the column is now visible to light, we don't know how exactly how high it should be though. */
-			/* However, we know that if the old block was above or equal to light height, then the new light height must be <= old block.y */
-			ClassicLighting_CalcHeightAt(x, y, z, index);
-		}
-	} else if (y == lightH && oldOffset == 0) {
-		/* For a solid block on top of an upside down slab, they will both have the same light height. */
-		/* So we need to account for this particular case. */
-		above = y == (World.Height - 1) ? BLOCK_AIR : World_GetBlock(x, y + 1, z);
-		if (Blocks.BlocksLight[above]) return;
-
-		if (nowBlocks) {
-			classic_heightmap[index] = y - newOffset;
-		} else {
-			ClassicLighting_CalcHeightAt(x, y - 1, z, index);
+enum REFRESH_COLUMN { REFRESH_SELF, REFRESH_XMIN, REFRESH_XMAX, REFRESH_ZMIN, REFRESH_ZMAX, REFRESH_COUNT };
+/* Whether each chunk in the chunk column being flushed (and in its 4 neighbouring chunk columns) needs refreshing */
+static cc_uint8* refreshFlags;
+
+static void ClassicLighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID newBlock) {
+	int cx = x >> CHUNK_SHIFT, cz = z >> CHUNK_SHIFT;
+	int cIndex = cx + World.ChunksX * cz;
+	int i = (x & CHUNK_MASK) | ((z & CHUNK_MASK) << CHUNK_SHIFT);
+	struct QueuedColumns* cols;
+
+	/* Since light wasn't checked to begin with, means column never had meshes for any of its chunks built. */
+	/* So we don't need to do anything. */
+	if (classic_heightmap[Lighting_Pack(x, z)] == HEIGHT_UNCALCULATED) return;
+
+	if (!queuedIndices[cIndex]) {
+		if (queuedCount == queuedCapacity) {
+			Utils_Resize((void**)&queued, &queuedCapacity, sizeof(struct QueuedColumns), 0, 16);
 		}
+		cols = &queued[queuedCount++];
+		cols->cx = cx; cols->cz = cz;
+		Mem_Set(cols->maxY, 0xFF, sizeof(cols->maxY));
+		queuedIndices[cIndex] = queuedCount;
 	}
-}
 
-static cc_bool ClassicLighting_Needs(BlockID block, BlockID other) {
-	return Blocks.Draw[block] != DRAW_OPAQUE || Blocks.Draw[other] != DRAW_GAS;
+	cols = &queued[queuedIndices[cIndex] - 1];
+	if (cols->maxY[i] < 0) {
+		cols->minY[i] = y; cols->maxY[i] = y;
+	} else if (y < cols->minY[i]) {
+		cols->minY[i] = y;
+	} else if (y > cols->maxY[i]) {
+		cols->maxY[i] = y;
+	}
 }
 
-#define ClassicLighting_NeedsNeighourBody(get_block)\
-/* Update if any blocks in the chunk are affected by light change. */ \
+#define ClassicLighting_AnyBlocksBody(get_block)\
 for (; y >= minY; y--, i -= World.OneY) {\
-	other    = get_block;\
-	affected = y == nY ? ClassicLighting_Needs(block, other) : Blocks.Draw[other] != DRAW_GAS;\
-	if (affected) return true;\
+	if (Blocks.Draw[get_block] != DRAW_GAS) return true;\
 }
 
-static cc_bool ClassicLighting_NeedsNeighour(BlockID block, int i, int minY, int y, int nY) {
-	BlockID other;
-	cc_bool affected;
-
+/* Whether any blocks in the column from y down to minY are visible */
+static cc_bool ClassicLighting_AnyBlocks(int i, int minY, int y) {
 #ifndef EXTENDED_BLOCKS
-	Lighting_NeedsNeighourBody(World.Blocks[i]);
+	ClassicLighting_AnyBlocksBody(World.Blocks[i]);
 #else
 	if (World.IDMask <= 0xFF) {
-		ClassicLighting_NeedsNeighourBody(World.Blocks[i]);
+		ClassicLighting_AnyBlocksBody(World.Blocks[i]);
 	} else {
-		ClassicLighting_NeedsNeighourBody(World.Blocks[i] | (World.Blocks2[i] << 8));
+		ClassicLighting_AnyBlocksBody(World.Blocks[i] | (World.Blocks2[i] << 8));
 	}
 #endif
 	return false;
 }
 
-static void ClassicLighting_ResetNeighbour(int x, int y, int z, BlockID block, int cx, int cy, int cz, int minCy, int maxCy) {
-	int minY, maxY;
+/* Flags the chunks in a neighbouring column which have blocks that may be affected by the changes */
+static void ClassicLighting_FlagNeighbour(int x, int z, int column, int minCy, int maxCy) {
+	cc_uint8* flags = &refreshFlags[column * World.ChunksY];
+	int cy, minY, maxY;
 
-	if (minCy == maxCy) {
+	for (cy = minCy; cy <= maxCy; cy++) {
+		if (flags[cy]) continue;
 		minY = cy << CHUNK_SHIFT;
-
-		if (ClassicLighting_NeedsNeighour(block, World_Pack(x, y, z), minY, y, y)) {
-			MapRenderer_RefreshChunk(cx, cy, cz);
-		}
-	} else {
-		for (cy = maxCy; cy >= minCy; cy--) {
-			minY = (cy << CHUNK_SHIFT); 
-			maxY = (cy << CHUNK_SHIFT) + CHUNK_MAX;
-			if (maxY > World.MaxY) maxY = World.MaxY;
-
-			if (ClassicLighting_NeedsNeighour(block, World_Pack(x, maxY, z), minY, maxY, y)) {
-				MapRenderer_RefreshChunk(cx, cy, cz);
-			}
-		}
+		maxY = min(World.MaxY, minY + CHUNK_MAX);
+		flags[cy] = ClassicLighting_AnyBlocks(World_Pack(x, maxY, z), minY, maxY);
 	}
 }
 
-static void ClassicLighting_ResetColumn(int cx, int cy, int cz, int minCy, int maxCy) {
-	if (minCy == maxCy) {
-		MapRenderer_RefreshChunk(cx, cy, cz);
-	} else {
-		for (cy = maxCy; cy >= minCy; cy--) {
-			MapRenderer_RefreshChunk(cx, cy, cz);
-		}
-	}
-}
+static void ClassicLighting_ApplyColumn(int x, int z, int minY, int maxY) {
+	int hIndex = Lighting_Pack(x, z);
+	int oldH   = classic_heightmap[hIndex];
+	int newH, minCy, maxCy, cy;
 
-static void ClassicLighting_RefreshAffected(int x, int y, int z, BlockID block, int oldHeight, int newHeight) {
-	int cx = x >> CHUNK_SHIFT, bX = x & CHUNK_MASK;
-	int cy = y >> CHUNK_SHIFT, bY = y & CHUNK_MASK;
-	int cz = z >> CHUNK_SHIFT, bZ = z & CHUNK_MASK;
+	/* Lighting may have been reset after the blocks were changed */
+	if (oldH == HEIGHT_UNCALCULATED) return;
+	/* Blocks above the old light height were not blocking light, so only changed blocks above it need to be checked */
+	newH = ClassicLighting_CalcHeightAt(x, min(World.MaxY, max(oldH + 1, maxY)), z, hIndex);
 
+	minCy = minY >> CHUNK_SHIFT;
+	maxCy = maxY >> CHUNK_SHIFT;
 	/* NOTE: much faster to only update the chunks that are affected by the change in shadows, rather than the entire column. */
-	int newCy = newHeight < 0 ? 0 : newHeight >> 4;
-	int oldCy = oldHeight < 0 ? 0 : oldHeight >> 4;
-	int minCy = min(oldCy, newCy), maxCy = max(oldCy, newCy);
-	ClassicLighting_ResetColumn(cx, cy, cz, minCy, maxCy);
-
-	if (bX == 0 && cx > 0) {
-		ClassicLighting_ResetNeighbour(x - 1, y, z, block, cx - 1, cy, cz, minCy, maxCy);
+	if (newH != oldH) {
+		minCy = min(minCy, max(0, min(oldH, newH)) >> CHUNK_SHIFT);
+		maxCy = max(maxCy, min(World.ChunksY - 1, (max(oldH, newH) + 1) >> CHUNK_SHIFT));
 	}
-	if (bY == 0 && cy > 0 && ClassicLighting_Needs(block, World_GetBlock(x, y - 1, z))) {
-		MapRenderer_RefreshChunk(cx, cy - 1, cz);
+	for (cy = minCy; cy <= maxCy; cy++) { refreshFlags[cy] = true; }
+
+	if ((minY & CHUNK_MASK) == 0 && minY > 0 && Blocks.Draw[World_GetBlock(x, minY - 1, z)] != DRAW_GAS) {
+		refreshFlags[(minY >> CHUNK_SHIFT) - 1] = true;
 	}
-	if (bZ == 0 && cz > 0) {
-		ClassicLighting_ResetNeighbour(x, y, z - 1, block, cx, cy, cz - 1, minCy, maxCy);
+	if ((maxY & CHUNK_MASK) == CHUNK_MASK && maxY < World.MaxY && Blocks.Draw[World_GetBlock(x, maxY + 1, z)] != DRAW_GAS) {
+		refreshFlags[(maxY >> CHUNK_SHIFT) + 1] = true;
 	}
 
-	if (bX == 15 && cx < World.ChunksX - 1) {
-		ClassicLighting_ResetNeighbour(x + 1, y, z, block, cx + 1, cy, cz, minCy, maxCy);
+	if ((x & CHUNK_MASK) == 0 && x > 0) {
+		ClassicLighting_FlagNeighbour(x - 1, z, REFRESH_XMIN, minCy, maxCy);
 	}
-	if (bY == 15 && cy < World.ChunksY - 1 && ClassicLighting_Needs(block, World_GetBlock(x, y + 1, z))) {
-		MapRenderer_RefreshChunk(cx, cy + 1, cz);
+	if ((x & CHUNK_MASK) == CHUNK_MASK && x < World.MaxX) {
+		ClassicLighting_FlagNeighbour(x + 1, z, REFRESH_XMAX, minCy, maxCy);
 	}
-	if (bZ == 15 && cz < World.ChunksZ - 1) {
-		ClassicLighting_ResetNeighbour(x, y, z + 1, block, cx, cy, cz + 1, minCy, maxCy);
+	if ((z & CHUNK_MASK) == 0 && z > 0) {
+		ClassicLighting_FlagNeighbour(x, z - 1, REFRESH_ZMIN, minCy, maxCy);
+	}
+	if ((z & CHUNK_MASK) == CHUNK_MASK && z < World.MaxZ) {
+		ClassicLighting_FlagNeighbour(x, z + 1, REFRESH_ZMAX, minCy, maxCy);
 	}
 }
 
-static void ClassicLighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID newBlock) {
-	int hIndex = Lighting_Pack(x, z);
-	int lightH = classic_heightmap[hIndex];
-	int newHeight;
+static void ClassicLighting_RefreshFlagged(int cx, int cz) {
+	static const cc_int8 offsets[REFRESH_COUNT][2] = { { 0,0 }, { -1,0 }, { 1,0 }, { 0,-1 }, { 0,1 } };
+	cc_uint8* flags = refreshFlags;
+	int column, cy;
 
-	/* Since light wasn't checked to begin with, means column never had meshes for any of its chunks built. */
-	/* So we don't need to do anything. */
-	if (lightH == HEIGHT_UNCALCULATED) return;
+	for (column = 0; column < REFRESH_COUNT; column++) {
+		for (cy = 0; cy < World.ChunksY; cy++, flags++) {
+			if (!(*flags)) continue;
+			MapRenderer_RefreshChunk(cx + offsets[column][0], cy, cz + offsets[column][1]);
+			*flags = false;
+		}
+	}
+}
+
+static void ClassicLighting_FlushChanges(void) {
+	struct QueuedColumns* cols;
+	int i, j, x, z;
 
-	ClassicLighting_UpdateLighting(x, y, z, oldBlock, newBlock, hIndex, lightH);
-	newHeight = classic_heightmap[hIndex] + 1;
-	ClassicLighting_RefreshAffected(x, y, z, newBlock, lightH + 1, newHeight);
+	for (i = 0; i < queuedCount; i++) {
+		cols = &queued[i];
+		queuedIndices[cols->cx + World.ChunksX * cols->cz] = 0;
+
+		for (j = 0; j < CHUNK_SIZE_2; j++) {
+			if (cols->maxY[j] < 0) continue;
+			x = (cols->cx << CHUNK_SHIFT) | (j & CHUNK_MASK);
+			z = (cols->cz << CHUNK_SHIFT) | (j >> CHUNK_SHIFT);
+			ClassicLighting_ApplyColumn(x, z, cols->minY[j], cols->maxY[j]);
+		}
+		ClassicLighting_RefreshFlagged(cols->cx, cols->cz);
+	}
+	queuedCount = 0;
 }
 
 
@@ -363,6 +375,15 @@ static void ClassicLighting_LightHint(int startX, int startZ) {
 static void ClassicLighting_FreeState(void) {
 	Mem_Free(classic_heightmap);
 	classic_heightmap = NULL;
+
+	Mem_Free(queued);
+	Mem_Free(queuedIndices);
+	Mem_Free(refreshFlags);
+	queued        = NULL;
+	queuedIndices = NULL;
+	refreshFlags  = NULL;
+	queuedCount   = 0;
+	queuedCapacity = 0;
 }
 
 static void ClassicLighting_AllocState(void) {
@@ -370,8 +391,11 @@ static void ClassicLighting_AllocState(void) {
 	if (classic_heightmap) {
 		ClassicLighting_Refresh();
 	} else {
-		World_OutOfMemory();
+		World_OutOfMemory(); return;
 	}
+
+	queuedIndices = (int*)Mem_AllocCleared(World.ChunksX * World.ChunksZ, sizeof(int), "lighting queue");
+	refreshFlags  = (cc_uint8*)Mem_AllocCleared(World.ChunksY, REFRESH_COUNT, "lighting refresh flags");
 }
 
 static void ClassicLighting_SetActive(void) {
@@ -391,6 +415,7 @@ static void ClassicLighting_SetActive(void) {
 	Lighting.FreeState  = ClassicLighting_FreeState;
 	Lighting.AllocState = ClassicLighting_AllocState;
 	Lighting.LightHint  = ClassicLighting_LightHint;
+	Lighting.FlushChanges = ClassicLighting_FlushChanges;
 }
 
 
@@ -25,6 +25,7 @@ CC_VAR extern struct _Lighting {
 
 	/* Called when a block is changed to update internal lighting state. */
 	/* NOTE: Implementations ***MUST*** mark all chunks affected by this lighting change as needing to be refreshed. */
+	/*  (although this may be delayed until FlushChanges is called) */
 	void (*OnBlockChanged)(int x, int y, int z, BlockID oldBlock, BlockID newBlock);
 	/* Invalidates/Resets lighting state for all of the blocks in the world */
 	/*  (e.g. because a block changed whether it is full bright or not) */
@@ -48,5 +49,10 @@ CC_VAR extern struct _Lighting {
 	PackedCol (*Color_YMin_Fast)(int x, int y, int z);
 	PackedCol (*Color_XSide_Fast)(int x, int y, int z);
 	PackedCol (*Color_ZSide_Fast)(int x, int y, int z);
+
+	/* Applies any lighting changes from blocks changed since this was last called */
+	/*  (called once per frame, before any chunks are rebuilt) */
+	/* NOTE: Last member, so that plugins using the fields before it are unaffected */
+	void (*FlushChanges)(void);
 } Lighting;
 #endif
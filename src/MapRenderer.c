@@ -14,8 +14,10 @@
 #include "Utils.h"
 #include "World.h"
 #include "Options.h"
+#include "Profiler.h"
 
 int MapRenderer_1DUsedCount;
+int MapRenderer_ChunksCulled;
 struct ChunkPartInfo* MapRenderer_PartsNormal;
 struct ChunkPartInfo* MapRenderer_PartsTranslucent;
 
@@ -40,12 +42,20 @@ static struct ChunkInfo** sortedChunks;
 static struct ChunkInfo** renderChunks;
 /* Number of actually used pointers in the renderChunks array. Entries past this are ignored and skipped. */
 static int renderChunksCount;
+/* Pointers to render info for chunks whose meshes will be built by mesh builder threads this frame. */
+static struct ChunkInfo** buildChunks;
+/* Number of actually used pointers in the buildChunks array. */
+static int buildChunksCount;
 /* Distance of each chunk from the camera. */
 static cc_uint32* distances;
+/* Chunks still to be visited when calculating which chunks are hidden behind other chunks. */
+static struct OcclusionEntry { cc_uint16 x, y, z; cc_uint8 face, dirs; }* occlusionQueue;
 /* Maximum number of chunk updates that can be performed in one frame. */
 static int maxChunkUpdates;
 /* Cached number of chunks in the world */
 static int chunksCount;
+/* Whether chunks hidden behind other chunks are skipped, and whether which chunks are hidden needs recalculating */
+static cc_bool occlusionCulling, occlusionDirty;
 
 static void ChunkInfo_Reset(struct ChunkInfo* chunk, int x, int y, int z) {
 	chunk->CentreX = x + HALF_CHUNK_SIZE; chunk->CentreY = y + HALF_CHUNK_SIZE; 
@@ -56,6 +66,7 @@ static void ChunkInfo_Reset(struct ChunkInfo* chunk, int x, int y, int z) {
 
 	chunk->Visible = true;        chunk->Empty = false;
 	chunk->PendingDelete = false; chunk->AllAir = false;
+	chunk->Occluded = false; chunk->OcclusionFlags = OCCLUSION_ALL_CONNECTED;
 	chunk->DrawXMin = false; chunk->DrawXMax = false; chunk->DrawZMin = false;
 	chunk->DrawZMax = false; chunk->DrawYMin = false; chunk->DrawYMax = false;
 
@@ -91,7 +102,9 @@ static void CheckWeather(double delta) {
 	/* If we are under water, render weather before to blend properly */
 	if (!inTranslucent || Env.Weather == WEATHER_SUNNY) return;
 	Gfx_SetAlphaBlending(true);
+	Profiler_Begin(PROFILER_WEATHER);
 	EnvRenderer_RenderWeather(delta);
+	Profiler_End(PROFILER_WEATHER);
 	Gfx_SetAlphaBlending(false);
 }
 
@@ -202,9 +215,6 @@ void MapRenderer_RenderNormal(double delta) {
 
 	CheckWeather(delta);
 	Gfx_SetAlphaTest(false);
-#if DEBUG_OCCLUSION
-	DebugPickedPos();
-#endif
 }
 
 #define DrawTranslucentFaces(minFace, maxFace) \
@@ -292,7 +302,9 @@ void MapRenderer_RenderTranslucent(double delta) {
 	/* If we weren't under water, render weather after to blend properly */
 	if (!inTranslucent && Env.Weather != WEATHER_SUNNY) {
 		Gfx_SetAlphaTest(true);
+		Profiler_Begin(PROFILER_WEATHER);
 		EnvRenderer_RenderWeather(delta);
+		Profiler_End(PROFILER_WEATHER);
 		Gfx_SetAlphaTest(false);
 	}
 	Gfx_SetAlphaBlending(false);
@@ -313,10 +325,8 @@ static void DeleteChunk(struct ChunkInfo* info) {
 #endif
 
 	info->Empty = false; info->AllAir = false;
-#ifdef OCCLUSION
-	info.OcclusionFlags = 0;
-	info.OccludedFlags = 0;
-#endif
+	/* Unbuilt chunks must not hide anything behind them */
+	info->OcclusionFlags = OCCLUSION_ALL_CONNECTED;
 
 	if (info->NormalParts) {
 		ptr = info->NormalParts;
@@ -343,16 +353,11 @@ static void DeleteChunk(struct ChunkInfo* info) {
 	}
 }
 
-/* Builds the mesh (hence vertex buffer) for the given chunk, and updates internal state */
-static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
+/* Updates internal state after the mesh for the given chunk has been built */
+static void FinishChunk(struct ChunkInfo* info) {
 	struct ChunkPartInfo* ptr;
 	int i;
 
-	Game.ChunkUpdates++;
-	(*chunkUpdates)++;
-	info->PendingDelete = false;
-	Builder_MakeChunk(info);
-
 	if (!info->NormalParts && !info->TranslucentParts) {
 		info->Empty = true; return;
 	}
@@ -372,6 +377,31 @@ static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
 	}
 }
 
+/* Builds the mesh (hence vertex buffer) for the given chunk, and updates internal state */
+/* NOTE: When using mesh builder threads, the chunk is only queued to be built in BuildQueuedChunks */
+static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
+	Game.ChunkUpdates++;
+	(*chunkUpdates)++;
+	info->PendingDelete = false;
+
+	if (Builder_ThreadsCount) {
+		buildChunks[buildChunksCount++] = info; return;
+	}
+	Builder_MakeChunk(info);
+	FinishChunk(info);
+}
+
+/* Builds the meshes for all the queued chunks at once across the mesh builder threads */
+static void BuildQueuedChunks(void) {
+	int i;
+	Builder_MakeChunks(buildChunks, buildChunksCount);
+
+	for (i = 0; i < buildChunksCount; i++) {
+		FinishChunk(buildChunks[i]);
+	}
+	buildChunksCount = 0;
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Chunks mangagement---------------------------------------------------*
@@ -386,12 +416,16 @@ static void FreeChunks(void) {
 	Mem_Free(mapChunks);
 	Mem_Free(sortedChunks);
 	Mem_Free(renderChunks);
+	Mem_Free(buildChunks);
 	Mem_Free(distances);
+	Mem_Free(occlusionQueue);
 
 	mapChunks    = NULL;
 	sortedChunks = NULL;
 	renderChunks = NULL;
+	buildChunks  = NULL;
 	distances    = NULL;
+	occlusionQueue = NULL;
 }
 
 static void AllocateParts(void) {
@@ -407,7 +441,9 @@ static void AllocateChunks(void) {
 	mapChunks    = (struct ChunkInfo*) Mem_Alloc(chunksCount, sizeof(struct ChunkInfo),  "chunk info");
 	sortedChunks = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "sorted chunk info");
 	renderChunks = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "render chunk info");
+	buildChunks  = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "build chunk info");
 	distances    = (cc_uint32*)Mem_Alloc(chunksCount, 4, "chunk distances");
+	occlusionQueue = (struct OcclusionEntry*)Mem_Alloc(chunksCount, sizeof(struct OcclusionEntry), "occlusion queue");
 }
 
 static void ResetPartFlags(void) {
@@ -529,6 +565,68 @@ static int AdjustDist(int dist) {
 static void CalcViewDists(void) {
 	buildDistSquared  = AdjustDist(Game_UserViewDistance);
 	renderDistSquared = AdjustDist(Game_ViewDistance);
+	occlusionDirty    = true;
+}
+
+static const cc_int8 faceDirs[FACE_COUNT][3] = {
+	{ -1, 0, 0 }, { 1, 0, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { 0, -1, 0 }, { 0, 1, 0 }
+};
+
+static cc_bool FacesConnected(int flags, int a, int b) {
+	return a < b ? (flags & Occlusion_Bit(a, b)) != 0 : (flags & Occlusion_Bit(b, a)) != 0;
+}
+
+/* Calculates which chunks cannot be seen from the chunk the camera is in, because every */
+/*  path to them passes through opaque blocks. Walks outwards from the camera chunk, only */
+/*  leaving a chunk through a face that is connected to the face it was entered through, */
+/*  and never moving back towards the camera along an axis already moved along. */
+static void CalcOcclusion(void) {
+	struct OcclusionEntry* queue = occlusionQueue;
+	struct OcclusionEntry cur, next;
+	struct ChunkInfo* info;
+	struct ChunkInfo* adj;
+	int head = 0, tail = 0, i, face;
+	int cx = chunkPos.X >> CHUNK_SHIFT, cy = chunkPos.Y >> CHUNK_SHIFT, cz = chunkPos.Z >> CHUNK_SHIFT;
+	int x, y, z, dx, dy, dz;
+	occlusionDirty = false;
+
+	/* Can't tell what is hidden when camera is outside the map (or when occlusion culling is off) */
+	if (!occlusionCulling || cx < 0 || cy < 0 || cz < 0 
+		|| cx >= World.ChunksX || cy >= World.ChunksY || cz >= World.ChunksZ) {
+		for (i = 0; i < chunksCount; i++) { mapChunks[i].Occluded = false; }
+		return;
+	}
+	/* Occluded also indicates a chunk has not been visited yet */
+	for (i = 0; i < chunksCount; i++) { mapChunks[i].Occluded = true; }
+
+	cur.x = cx; cur.y = cy; cur.z = cz; cur.face = FACE_COUNT; cur.dirs = 0;
+	mapChunks[World_ChunkPack(cx, cy, cz)].Occluded = false;
+	queue[tail++] = cur;
+
+	while (head < tail) {
+		cur  = queue[head++];
+		info = &mapChunks[World_ChunkPack(cur.x, cur.y, cur.z)];
+
+		for (face = 0; face < FACE_COUNT; face++) {
+			/* Don't move back in a direction opposite to one already moved in */
+			if (cur.dirs & (1 << (face ^ 1))) continue;
+			if (cur.face != FACE_COUNT && !FacesConnected(info->OcclusionFlags, cur.face, face)) continue;
+
+			x = cur.x + faceDirs[face][0]; y = cur.y + faceDirs[face][1]; z = cur.z + faceDirs[face][2];
+			if (x < 0 || y < 0 || z < 0 || x >= World.ChunksX || y >= World.ChunksY || z >= World.ChunksZ) continue;
+
+			adj = &mapChunks[World_ChunkPack(x, y, z)];
+			if (!adj->Occluded) continue;
+			/* Chunks past render distance are never drawn, and can't lead back to closer chunks */
+			dx = adj->CentreX - chunkPos.X; dy = adj->CentreY - chunkPos.Y; dz = adj->CentreZ - chunkPos.Z;
+			if (dx * dx + dy * dy + dz * dz > renderDistSquared) continue;
+
+			adj->Occluded = false;
+			next.x = x; next.y = y; next.z = z;
+			next.face = face ^ 1; next.dirs = cur.dirs | (1 << face);
+			queue[tail++] = next;
+		}
+	}
 }
 
 static int UpdateChunksAndVisibility(int* chunkUpdates) {
@@ -536,8 +634,8 @@ static int UpdateChunksAndVisibility(int* chunkUpdates) {
 	int buildDistSqr  = buildDistSquared;
 
 	struct ChunkInfo* info;
-	int i, j = 0, distSqr;
-	cc_bool noData;
+	int i, j = 0, distSqr, culled = 0;
+	cc_bool noData, visible;
 
 	for (i = 0; i < chunksCount; i++) {
 		info = sortedChunks[i];
@@ -557,10 +655,14 @@ static int UpdateChunksAndVisibility(int* chunkUpdates) {
 			BuildChunk(info, chunkUpdates);
 		}
 
-		info->Visible = distSqr <= renderDistSqr &&
+		visible = distSqr <= renderDistSqr &&
 			FrustumCulling_SphereInFrustum(info->CentreX, info->CentreY, info->CentreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
+		if (visible && info->Occluded) { culled++; visible = false; }
+
+		info->Visible = visible;
 		if (info->Visible && !info->Empty) { renderChunks[j] = info; j++; }
 	}
+	MapRenderer_ChunksCulled = culled;
 	return j;
 }
 
@@ -590,7 +692,7 @@ static int UpdateChunksStill(int* chunkUpdates) {
 			BuildChunk(info, chunkUpdates);
 
 			/* only need to update the visibility of chunks in range. */
-			info->Visible = distSqr <= renderDistSqr &&
+			info->Visible = distSqr <= renderDistSqr && !info->Occluded &&
 				FrustumCulling_SphereInFrustum(info->CentreX, info->CentreY, info->CentreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
 			if (info->Visible && !info->Empty) { renderChunks[j] = info; j++; }
 		} else if (info->Visible) {
@@ -600,28 +702,47 @@ static int UpdateChunksStill(int* chunkUpdates) {
 	return j;
 }
 
+/* Removes chunks that turned out to have no mesh after being built from renderChunks */
+static int RemoveEmptyChunks(void) {
+	int i, j = 0;
+	for (i = 0; i < renderChunksCount; i++) {
+		if (!renderChunks[i]->Empty) { renderChunks[j] = renderChunks[i]; j++; }
+	}
+	return j;
+}
+
 static void UpdateChunks(double delta) {
 	struct LocalPlayer* p;
 	cc_bool samePos;
 	int chunkUpdates = 0;
 
 	/* Build more chunks if 30 FPS or over, otherwise slowdown */
+	/* (each mesh builder thread can build up to maxChunkUpdates chunks too) */
 	chunksTarget += delta < CHUNK_TARGET_TIME ? 1 : -1; 
-	Math_Clamp(chunksTarget, 4, maxChunkUpdates);
+	Math_Clamp(chunksTarget, 4, maxChunkUpdates * (Builder_ThreadsCount + 1));
 
 	p = &LocalPlayer_Instance;
 	samePos = Vec3_Equals(&Camera.CurrentPos, &lastCamPos)
 		&& p->Base.Pitch == lastPitch && p->Base.Yaw == lastYaw;
 
+	/* Which chunks are occluded may have changed, so visibility of every chunk must be rechecked */
+	if (occlusionDirty) { CalcOcclusion(); samePos = false; }
 	renderChunksCount = samePos ?
 		UpdateChunksStill(&chunkUpdates) :
 		UpdateChunksAndVisibility(&chunkUpdates);
 
+	if (buildChunksCount) {
+		BuildQueuedChunks();
+		renderChunksCount = RemoveEmptyChunks();
+	}
+
 	lastCamPos = Camera.CurrentPos;
 	lastPitch  = p->Base.Pitch;
 	lastYaw    = p->Base.Yaw;
 
 	if (!samePos || chunkUpdates) ResetPartFlags();
+	/* Newly built chunks may hide or reveal other chunks */
+	if (chunkUpdates && occlusionCulling) occlusionDirty = true;
 }
 
 static void SortMapChunks(int left, int right) {
@@ -680,7 +801,7 @@ static void UpdateSortOrder(void) {
 
 	SortMapChunks(0, chunksCount - 1);
 	ResetPartFlags();
-	/*SimpleOcclusionCulling();*/
+	occlusionDirty = true;
 }
 
 void MapRenderer_Update(double delta) {
@@ -693,14 +814,21 @@ void MapRenderer_Update(double delta) {
 /*########################################################################################################################*
 *---------------------------------------------------------General---------------------------------------------------------*
 *#########################################################################################################################*/
-void MapRenderer_RefreshChunk(int cx, int cy, int cz) {
-	struct ChunkInfo* info;
-	if (cx < 0 || cy < 0 || cz < 0 || cx >= World.ChunksX || cy >= World.ChunksY || cz >= World.ChunksZ) return;
-
-	info = &mapChunks[World_ChunkPack(cx, cy, cz)];
+static void RefreshChunk(struct ChunkInfo* info) {
 	if (info->AllAir) return; /* do not recreate chunks completely air */
+	/* Chunk is already waiting to be rebuilt (e.g. when many blocks in it are changed at once) */
+	if (info->PendingDelete) return;
+
 	info->Empty         = false;
 	info->PendingDelete = true;
+	/* Chunk may no longer hide chunks behind it, but won't be rebuilt until later */
+	info->OcclusionFlags = OCCLUSION_ALL_CONNECTED;
+	occlusionDirty       = true;
+}
+
+void MapRenderer_RefreshChunk(int cx, int cy, int cz) {
+	if (cx < 0 || cy < 0 || cz < 0 || cx >= World.ChunksX || cy >= World.ChunksY || cz >= World.ChunksZ) return;
+	RefreshChunk(&mapChunks[World_ChunkPack(cx, cy, cz)]);
 }
 
 void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block) {
@@ -709,8 +837,7 @@ void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block) {
 
 	chunk = &mapChunks[World_ChunkPack(cx, cy, cz)];
 	chunk->AllAir &= Blocks.Draw[block] == DRAW_GAS;
-	/* TODO: Don't lookup twice, refresh directly using chunk pointer */
-	MapRenderer_RefreshChunk(cx, cy, cz);
+	RefreshChunk(chunk);
 }
 
 static void OnEnvVariableChanged(void* obj, int envVar) {
@@ -790,6 +917,7 @@ static void OnInit(void) {
 	MapRenderer_1DUsedCount = 87; /* Atlas1D_UsedAtlasesCount(); */
 	chunkPos   = IVec3_MaxValue();
 	maxChunkUpdates = Options_GetInt(OPT_MAX_CHUNK_UPDATES, 4, 1024, 30);
+	occlusionCulling = Options_GetBool(OPT_OCCLUSION_CULLING, true);
 	CalcViewDists();
 }
 
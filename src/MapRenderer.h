@@ -12,6 +12,8 @@ extern struct IGameComponent MapRenderer_Component;
 
 /* Max used 1D atlases. (i.e. Atlas1D_Index(maxTextureLoc) + 1) */
 extern int MapRenderer_1DUsedCount;
+/* Number of chunks in view that were skipped due to being hidden behind other chunks */
+extern int MapRenderer_ChunksCulled;
 
 /* Buffer for all chunk parts. There are (MapRenderer_ChunksCount * Atlas1D_Count) parts in the buffer,
 with parts for 'normal' buffer being in lower half. */
@@ -30,6 +32,12 @@ struct ChunkPartInfo {
 	cc_uint16 Counts[FACE_COUNT]; /* Counts per face */
 };
 
+/* Bit in ChunkInfo.OcclusionFlags for whether faces a and b of a chunk can see each other. (a < b) */
+/*  (i.e. whether there is a path between the two faces through non-opaque blocks in the chunk) */
+#define Occlusion_Bit(a, b) (1 << ((a) * (9 - (a)) / 2 + (b) - 1))
+/* All 15 pairs of faces of a chunk can see each other */
+#define OCCLUSION_ALL_CONNECTED 0x7FFF
+
 /* Describes data necessary for rendering a chunk. */
 struct ChunkInfo {	
 	cc_uint16 CentreX, CentreY, CentreZ; /* Centre coordinates of the chunk */
@@ -38,6 +46,7 @@ struct ChunkInfo {
 	cc_uint8 Empty : 1;         /* Whether the chunk is empty of data */
 	cc_uint8 PendingDelete : 1; /* Whether chunk is pending deletion */
 	cc_uint8 AllAir : 1;        /* Whether chunk is completely air */
+	cc_uint8 Occluded : 1;      /* Whether chunk is completely hidden behind other chunks */
 	cc_uint8 : 0;               /* pad to next byte*/
 
 	cc_uint8 DrawXMin : 1;
@@ -47,10 +56,7 @@ struct ChunkInfo {
 	cc_uint8 DrawYMin : 1;
 	cc_uint8 DrawYMax : 1;
 	cc_uint8 : 0;          /* pad to next byte */
-#ifdef OCCLUSION
-	public cc_bool Visited = false, Occluded = false;
-	public byte OcclusionFlags, OccludedFlags, DistanceFlags;
-#endif
+	cc_uint16 OcclusionFlags;   /* Which pairs of faces of the chunk can see each other (see Occlusion_Bit) */
 #ifndef CC_BUILD_GL11
 	GfxResourceID Vb;
 #endif
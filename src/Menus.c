@@ -1305,20 +1305,44 @@ static void SaveLevelScreen_RemoveOverwrites(struct SaveLevelScreen* s) {
 static cc_result SaveLevelScreen_SaveMap(const cc_string* path) {
 	static const cc_string schematic = String_FromConst(".schematic");
 	static const cc_string mine = String_FromConst(".mine");
+	static const cc_string cwr  = String_FromConst(".cwr");
 	struct Stream stream, compStream;
+	struct GZipParallelState parallelState;
 	struct GZipState state;
+	int level, threads;
+	cc_bool compress;
 	cc_result res;
 
+	/* Map might be being saved over the file that its blocks are memory mapped from */
+	res = World_UnmapBlocks();
+	if (res) { Logger_SysWarn2(res, "saving", path); return res; }
+
 	res = Stream_CreateFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "creating", path); return res; }
-	GZip_MakeStream(&compStream, &state, &stream);
+	level = Options_GetInt(OPT_SAVE_LEVEL, DEFLATE_MIN_LEVEL, DEFLATE_MAX_LEVEL, DEFLATE_DEFAULT_LEVEL);
+#ifdef CC_BUILD_WEB
+	/* Threads are not supported in the webclient */
+	threads = 0;
+#else
+	threads = Options_GetInt(OPT_SAVE_THREADS, 0, GZIP_MAX_THREADS, 4);
+#endif
+
+	if (threads) {
+		GZip_MakeParallelStream(&compStream, &parallelState, &stream, level, threads);
+	} else {
+		GZip_MakeStream(&compStream, &state, &stream);
+		Deflate_SetLevel(&state.Base, level);
+	}
+
+	/* .cwr maps are not compressed, so that loading can map the file directly into memory */
+	compress = !String_CaselessEnds(path, &cwr);
 
 	if (String_CaselessEnds(path, &schematic)) {
 		res = Schematic_Save(&compStream);
 	} else if (String_CaselessEnds(path, &mine)) {
 		res = Dat_Save(&compStream);
 	} else {
-		res = Cw_Save(&compStream);
+		res = Cw_Save(compress ? &compStream : &stream);
 	}
 
 	if (res) {
@@ -1326,7 +1350,7 @@ static cc_result SaveLevelScreen_SaveMap(const cc_string* path) {
 		Logger_SysWarn2(res, "encoding", path); return res;
 	}
 
-	if ((res = compStream.Close(&compStream))) {
+	if (compress && (res = compStream.Close(&compStream))) {
 		stream.Close(&stream);
 		Logger_SysWarn2(res, "closing", path); return res;
 	}
@@ -1373,10 +1397,10 @@ static void SaveLevelScreen_UploadCallback(const cc_string* path) {
 
 static void SaveLevelScreen_File(void* screen, void* b) {
 	static const char* const titles[] = {
-		"ClassiCube map", "Minecraft schematic", "Minecraft classic map", NULL
+		"ClassiCube map", "Minecraft schematic", "Minecraft classic map", "Uncompressed ClassiCube map", NULL
 	};
 	static const char* const filters[] = {
-		".cw", ".schematic", ".mine", NULL
+		".cw", ".schematic", ".mine", ".cwr", NULL
 	};
 	struct SaveLevelScreen* s = (struct SaveLevelScreen*)screen;
 	struct SaveFileDialogArgs args;
@@ -1727,7 +1751,7 @@ static void LoadLevelScreen_LoadEntries(struct ListScreen* s) {
 static void LoadLevelScreen_UploadCallback(const cc_string* path) { Map_LoadFrom(path); }
 static void LoadLevelScreen_UploadFunc(void* s, void* w) {
 	static const char* const filters[] = { 
-		".cw", ".dat", ".lvl", ".mine", ".fcm", NULL 
+		".cw", ".dat", ".lvl", ".mine", ".fcm", ".cwr", NULL 
 	};
 	static struct OpenFileDialogArgs args = {
 		"Classic map files", filters,
@@ -11,9 +11,14 @@ Copyright 2014-2022 ClassiCube | Licensed under BSD-3
 #define OPT_FORCE_OPENAL "forceopenal"
 #define OPT_MIN_MUSIC_DELAY "music-mindelay"
 #define OPT_MAX_MUSIC_DELAY "music-maxdelay"
+#define OPT_MUSIC_BUFFER "music-buffer"
+#define OPT_MUSIC_CACHE "music-cache"
+#define OPT_AUDIO_MIXER "audio-mixer"
 
 #define OPT_VIEW_DISTANCE "viewdist"
 #define OPT_BLOCK_PHYSICS "singleplayerphysics"
+#define OPT_PHYSICS_THREADS "physics-threads"
+#define OPT_SOLID_MAP "physics-solidmap"
 #define OPT_NAMES_MODE "namesmode"
 #define OPT_INVERT_MOUSE "invertmouse"
 #define OPT_SENSITIVITY "mousesensitivity"
@@ -65,6 +70,13 @@ Copyright 2014-2022 ClassiCube | Licensed under BSD-3
 #define OPT_CLASSIC_ARM_MODEL "nostalgia-classicarm"
 #define OPT_CLASSIC_CHAT "nostalgia-classicchat"
 #define OPT_MAX_CHUNK_UPDATES "gfx-maxchunkupdates"
+#define OPT_BUILDER_THREADS "gfx-builderthreads"
+#define OPT_OCCLUSION_CULLING "gfx-occlusionculling"
+#define OPT_MAX_PARTICLES "gfx-maxparticles"
+#define OPT_GEN_THREADS "gen-threads"
+#define OPT_SAVE_LEVEL "save-compressionlevel"
+#define OPT_SAVE_THREADS "save-threads"
+#define OPT_TEXPACK_THREADS "texpack-threads"
 #define OPT_CAMERA_MASS "cameramass"
 #define OPT_CAMERA_SMOOTH "camera-smooth"
 #define OPT_GRAB_CURSOR "win-grab-cursor"
@@ -73,6 +85,9 @@ Copyright 2014-2022 ClassiCube | Licensed under BSD-3
 #define OPT_HTTP_ONLY "http-no-https"
 #define OPT_HTTPS_VERIFY "https-verify"
 #define OPT_SKIN_SERVER "http-skinserver"
+#define OPT_HTTP_WORKERS "http-workers"
+#define OPT_HTTP_MAX_PER_HOST "http-maxperhost"
+#define OPT_HTTP_CACHE_SIZE "http-cachesize"
 #define OPT_RAW_INPUT "win-raw-input"
 #define OPT_DPI_SCALING "win-dpi-scaling"
 
@@ -1,4 +1,8 @@
 #include "Particle.h"
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLES_SSE2
+#endif
 #include "Block.h"
 #include "World.h"
 #include "ExtMath.h"
@@ -9,42 +13,170 @@
 #include "Funcs.h"
 #include "Game.h"
 #include "Event.h"
+#include "Options.h"
+#include "Platform.h"
 
 
 /*########################################################################################################################*
 *------------------------------------------------------Particle base------------------------------------------------------*
 *#########################################################################################################################*/
 static GfxResourceID Particles_TexId, Particles_VB;
-#define PARTICLES_MAX 600
+/* All particles of one type are drawn from the same dynamic vertex buffer */
+#define PARTICLES_DEF_MAX 4096
+#define PARTICLES_MAX_LIMIT (GFX_MAX_VERTICES / 4)
+static int particles_max;
 static RNGState rnd;
 static cc_bool hitTerrain;
 typedef cc_bool (*CanPassThroughFunc)(BlockID b);
 
-void Particle_DoRender(const Vec2* size, const Vec3* pos, const TextureRec* rec, PackedCol col, struct VertexTextured* v) {
-	struct Matrix* view;
-	float sX, sY;
-	Vec3 centre;
+/* Particles are stored as a separate array for each field, so that several particles */
+/*  can be moved at once with SIMD. Removing a particle moves the last particle into its place */
+struct ParticleList {
+	float* lastX; float* lastY; float* lastZ;
+	float* nextX; float* nextY; float* nextZ;
+	float* velX;  float* velY;  float* velZ;
+	float* drawX; float* drawY; float* drawZ; /* Position the particle is drawn at this frame */
+	float* lifetime; float* size; float* gravity;
+	float* data;
+	int count, evict;
+};
+#define PARTICLE_FIELDS 15
+
+static void ParticleList_Alloc(struct ParticleList* l, const char* place) {
+	float* data = (float*)Mem_Alloc(PARTICLE_FIELDS * particles_max, sizeof(float), place);
+	int n = particles_max;
+	l->data  = data;
+	l->count = 0; l->evict = 0;
+
+	l->lastX = data + n * 0;  l->lastY = data + n * 1;  l->lastZ = data + n * 2;
+	l->nextX = data + n * 3;  l->nextY = data + n * 4;  l->nextZ = data + n * 5;
+	l->velX  = data + n * 6;  l->velY  = data + n * 7;  l->velZ  = data + n * 8;
+	l->drawX = data + n * 9;  l->drawY = data + n * 10; l->drawZ = data + n * 11;
+	l->lifetime = data + n * 12; l->size = data + n * 13; l->gravity = data + n * 14;
+}
+
+static void ParticleList_Free(struct ParticleList* l) {
+	Mem_Free(l->data);
+	l->data  = NULL;
+	l->count = 0;
+}
+
+/* Returns the index a new particle should be stored at */
+/* Once the list is full, particles are replaced in turn, so the oldest ones tend to be replaced first */
+static int ParticleList_Add(struct ParticleList* l) {
+	int i;
+	if (l->count < particles_max) return l->count++;
+
+	i = l->evict;
+	l->evict = (i + 1) % particles_max;
+	return i;
+}
+
+static void ParticleList_RemoveAt(struct ParticleList* l, int i) {
+	float* field = l->data;
+	int f, last  = --l->count;
+
+	for (f = 0; f < PARTICLE_FIELDS; f++, field += particles_max) {
+		field[i] = field[last];
+	}
+}
+
+/* Applies gravity to every particle, then moves it along its velocity */
+static void ParticleList_Move(struct ParticleList* l, float delta) {
+	float scale = delta * 3.0f;
+	int i = 0;
+#ifdef PARTICLES_SSE2
+	__m128 dt = _mm_set1_ps(delta), dt3 = _mm_set1_ps(scale);
+	__m128 pos, velY;
+
+	for (; i + 4 <= l->count; i += 4) {
+		velY = _mm_sub_ps(_mm_loadu_ps(l->velY + i), _mm_mul_ps(_mm_loadu_ps(l->gravity + i), dt));
+		_mm_storeu_ps(l->velY + i, velY);
+
+		pos = _mm_loadu_ps(l->nextX + i); _mm_storeu_ps(l->lastX + i, pos);
+		_mm_storeu_ps(l->nextX + i, _mm_add_ps(pos, _mm_mul_ps(_mm_loadu_ps(l->velX + i), dt3)));
+		pos = _mm_loadu_ps(l->nextY + i); _mm_storeu_ps(l->lastY + i, pos);
+		_mm_storeu_ps(l->nextY + i, _mm_add_ps(pos, _mm_mul_ps(velY, dt3)));
+		pos = _mm_loadu_ps(l->nextZ + i); _mm_storeu_ps(l->lastZ + i, pos);
+		_mm_storeu_ps(l->nextZ + i, _mm_add_ps(pos, _mm_mul_ps(_mm_loadu_ps(l->velZ + i), dt3)));
+
+		_mm_storeu_ps(l->lifetime + i, _mm_sub_ps(_mm_loadu_ps(l->lifetime + i), dt));
+	}
+#endif
+
+	for (; i < l->count; i++) {
+		l->velY[i] -= l->gravity[i] * delta;
+
+		l->lastX[i] = l->nextX[i]; l->nextX[i] += l->velX[i] * scale;
+		l->lastY[i] = l->nextY[i]; l->nextY[i] += l->velY[i] * scale;
+		l->lastZ[i] = l->nextZ[i]; l->nextZ[i] += l->velZ[i] * scale;
+		l->lifetime[i] -= delta;
+	}
+}
+
+/* Calculates where every particle is drawn, between its last and next position */
+static void ParticleList_Lerp(struct ParticleList* l, float t) {
+	int i = 0;
+#ifdef PARTICLES_SSE2
+	__m128 blend = _mm_set1_ps(t), last;
+
+	for (; i + 4 <= l->count; i += 4) {
+		last = _mm_loadu_ps(l->lastX + i);
+		_mm_storeu_ps(l->drawX + i, _mm_add_ps(_mm_mul_ps(blend, _mm_sub_ps(_mm_loadu_ps(l->nextX + i), last)), last));
+		last = _mm_loadu_ps(l->lastY + i);
+		_mm_storeu_ps(l->drawY + i, _mm_add_ps(_mm_mul_ps(blend, _mm_sub_ps(_mm_loadu_ps(l->nextY + i), last)), last));
+		last = _mm_loadu_ps(l->lastZ + i);
+		_mm_storeu_ps(l->drawZ + i, _mm_add_ps(_mm_mul_ps(blend, _mm_sub_ps(_mm_loadu_ps(l->nextZ + i), last)), last));
+	}
+#endif
+
+	for (; i < l->count; i++) {
+		l->drawX[i] = t * (l->nextX[i] - l->lastX[i]) + l->lastX[i];
+		l->drawY[i] = t * (l->nextY[i] - l->lastY[i]) + l->lastY[i];
+		l->drawZ[i] = t * (l->nextZ[i] - l->lastZ[i]) + l->lastZ[i];
+	}
+}
+
+/* http://www.opengl-tutorial.org/intermediate-tutorials/billboards-particles/billboards/ */
+/* Billboards always face the camera, so they all use the same right and up directions in a frame */
+static Vec3 billboard_right, billboard_up;
+
+static void Billboard_Begin(void) {
+	struct Matrix* view = &Gfx.View;
+	billboard_right.X = view->row1.X; billboard_right.Y = view->row2.X; billboard_right.Z = view->row3.X;
+	billboard_up.X    = view->row1.Y; billboard_up.Y    = view->row2.Y; billboard_up.Z    = view->row3.Y;
+}
+
+static void Billboard_Make(float x, float y, float z, float sX, float sY, const TextureRec* rec, PackedCol col, struct VertexTextured* v) {
+#ifdef PARTICLES_SSE2
+	/* X, Y, Z of each corner are calculated together, and the 4th lane is then overwritten by Col */
+	__m128 centre = _mm_setr_ps(x, y + sY, z, 0.0f);
+	__m128 a = _mm_mul_ps(_mm_setr_ps(billboard_right.X, billboard_right.Y, billboard_right.Z, 0.0f), _mm_set1_ps(sX));
+	__m128 b = _mm_mul_ps(_mm_setr_ps(billboard_up.X,    billboard_up.Y,    billboard_up.Z,    0.0f), _mm_set1_ps(sY));
+	__m128 left = _mm_sub_ps(centre, a), right = _mm_add_ps(centre, a);
+
+	_mm_storeu_ps(&v->X, _mm_sub_ps(left,  b)); v->Col = col; v->U = rec->U1; v->V = rec->V2; v++;
+	_mm_storeu_ps(&v->X, _mm_add_ps(left,  b)); v->Col = col; v->U = rec->U1; v->V = rec->V1; v++;
+	_mm_storeu_ps(&v->X, _mm_add_ps(right, b)); v->Col = col; v->U = rec->U2; v->V = rec->V1; v++;
+	_mm_storeu_ps(&v->X, _mm_sub_ps(right, b)); v->Col = col; v->U = rec->U2; v->V = rec->V2; v++;
+#else
 	float aX, aY, aZ, bX, bY, bZ;
+	y += sY;
 
-	sX = size->X * 0.5f; sY = size->Y * 0.5f;
-	centre = *pos; centre.Y += sY;
-	view   = &Gfx.View;
-	
-	aX = view->row1.X * sX; aY = view->row2.X * sX; aZ = view->row3.X * sX; /* right * size.X * 0.5f */
-	bX = view->row1.Y * sY; bY = view->row2.Y * sY; bZ = view->row3.Y * sY; /* up    * size.Y * 0.5f */
+	aX = billboard_right.X * sX; aY = billboard_right.Y * sX; aZ = billboard_right.Z * sX; /* right * size.X * 0.5f */
+	bX = billboard_up.X    * sY; bY = billboard_up.Y    * sY; bZ = billboard_up.Z    * sY; /* up    * size.Y * 0.5f */
 
-	v->X = centre.X - aX - bX; v->Y = centre.Y - aY - bY; v->Z = centre.Z - aZ - bZ; v->Col = col; v->U = rec->U1; v->V = rec->V2; v++;
-	v->X = centre.X - aX + bX; v->Y = centre.Y - aY + bY; v->Z = centre.Z - aZ + bZ; v->Col = col; v->U = rec->U1; v->V = rec->V1; v++;
-	v->X = centre.X + aX + bX; v->Y = centre.Y + aY + bY; v->Z = centre.Z + aZ + bZ; v->Col = col; v->U = rec->U2; v->V = rec->V1; v++;
-	v->X = centre.X + aX - bX; v->Y = centre.Y + aY - bY; v->Z = centre.Z + aZ - bZ; v->Col = col; v->U = rec->U2; v->V = rec->V2; v++;
+	v->X = x - aX - bX; v->Y = y - aY - bY; v->Z = z - aZ - bZ; v->Col = col; v->U = rec->U1; v->V = rec->V2; v++;
+	v->X = x - aX + bX; v->Y = y - aY + bY; v->Z = z - aZ + bZ; v->Col = col; v->U = rec->U1; v->V = rec->V1; v++;
+	v->X = x + aX + bX; v->Y = y + aY + bY; v->Z = z + aZ + bZ; v->Col = col; v->U = rec->U2; v->V = rec->V1; v++;
+	v->X = x + aX - bX; v->Y = y + aY - bY; v->Z = z + aZ - bZ; v->Col = col; v->U = rec->U2; v->V = rec->V2; v++;
+#endif
 }
 
-static cc_bool CollidesHor(Vec3* nextPos, BlockID block) {
-	Vec3 horPos = Vec3_Create3((float)Math_Floor(nextPos->X), 0.0f, (float)Math_Floor(nextPos->Z));
-	Vec3 min, max;
-	Vec3_Add(&min, &Blocks.MinBB[block], &horPos);
-	Vec3_Add(&max, &Blocks.MaxBB[block], &horPos);
-	return nextPos->X >= min.X && nextPos->Z >= min.Z && nextPos->X < max.X && nextPos->Z < max.Z;
+static cc_bool CollidesHor(float x, float z, BlockID block) {
+	float blockX = (float)Math_Floor(x), blockZ = (float)Math_Floor(z);
+	return x >= Blocks.MinBB[block].X + blockX && z >= Blocks.MinBB[block].Z + blockZ
+		&& x <  Blocks.MaxBB[block].X + blockX && z <  Blocks.MaxBB[block].Z + blockZ;
 }
 
 static BlockID GetBlock(int x, int y, int z) {
@@ -55,79 +187,67 @@ static BlockID GetBlock(int x, int y, int z) {
 	return Env.SidesBlock;
 }
 
-static cc_bool ClipY(struct Particle* p, int y, cc_bool topFace, CanPassThroughFunc canPassThrough) {
+static void ParticleList_Stop(struct ParticleList* l, int i, float y) {
+	l->lastY[i] = y; l->nextY[i] = y;
+	l->velX[i]  = 0; l->velY[i]  = 0; l->velZ[i] = 0;
+	hitTerrain  = true;
+}
+
+static cc_bool ClipY(struct ParticleList* l, int i, int y, cc_bool topFace, CanPassThroughFunc canPassThrough) {
 	BlockID block;
-	Vec3 minBB, maxBB;
 	float collideY;
 	cc_bool collideVer;
 
 	if (y < 0) {
-		p->nextPos.Y = ENTITY_ADJUSTMENT; 
-		p->lastPos.Y = ENTITY_ADJUSTMENT;
-
-		Vec3_Set(p->velocity, 0,0,0);
-		hitTerrain = true;
+		ParticleList_Stop(l, i, ENTITY_ADJUSTMENT);
 		return false;
 	}
 
-	block = GetBlock((int)p->nextPos.X, y, (int)p->nextPos.Z);
+	block = GetBlock((int)l->nextX[i], y, (int)l->nextZ[i]);
 	if (canPassThrough(block)) return true;
-	minBB = Blocks.MinBB[block]; maxBB = Blocks.MaxBB[block];
 
-	collideY   = y + (topFace ? maxBB.Y : minBB.Y);
-	collideVer = topFace ? (p->nextPos.Y < collideY) : (p->nextPos.Y > collideY);
+	collideY   = y + (topFace ? Blocks.MaxBB[block].Y : Blocks.MinBB[block].Y);
+	collideVer = topFace ? (l->nextY[i] < collideY) : (l->nextY[i] > collideY);
 
-	if (collideVer && CollidesHor(&p->nextPos, block)) {
+	if (collideVer && CollidesHor(l->nextX[i], l->nextZ[i], block)) {
 		float adjust = topFace ? ENTITY_ADJUSTMENT : -ENTITY_ADJUSTMENT;
-		p->lastPos.Y = collideY + adjust;
-		p->nextPos.Y = p->lastPos.Y;
-
-		Vec3_Set(p->velocity, 0,0,0);
-		hitTerrain = true;
+		ParticleList_Stop(l, i, collideY + adjust);
 		return false;
 	}
 	return true;
 }
 
-static cc_bool IntersectsBlock(struct Particle* p, CanPassThroughFunc canPassThrough) {
-	BlockID cur = GetBlock((int)p->nextPos.X, (int)p->nextPos.Y, (int)p->nextPos.Z);
-	float minY  = Math_Floor(p->nextPos.Y) + Blocks.MinBB[cur].Y;
-	float maxY  = Math_Floor(p->nextPos.Y) + Blocks.MaxBB[cur].Y;
+static cc_bool IntersectsBlock(float x, float y, float z, CanPassThroughFunc canPassThrough) {
+	BlockID cur = GetBlock((int)x, (int)y, (int)z);
+	float minY  = Math_Floor(y) + Blocks.MinBB[cur].Y;
+	float maxY  = Math_Floor(y) + Blocks.MaxBB[cur].Y;
 
-	return !canPassThrough(cur) && p->nextPos.Y >= minY && p->nextPos.Y < maxY && CollidesHor(&p->nextPos, cur);
+	return !canPassThrough(cur) && y >= minY && y < maxY && CollidesHor(x, z, cur);
 }
 
-static cc_bool PhysicsTick(struct Particle* p, float gravity, CanPassThroughFunc canPassThrough, double delta) {
-	Vec3 velocity;
+/* Stops the particle at the first block it moved into since ParticleList_Move, */
+/*  and returns whether the particle should be removed */
+static cc_bool PhysicsTick(struct ParticleList* l, int i, CanPassThroughFunc canPassThrough) {
 	int y, begY, endY;
+	if (IntersectsBlock(l->lastX[i], l->lastY[i], l->lastZ[i], canPassThrough)) return true;
 
-	p->lastPos = p->nextPos;
-	if (IntersectsBlock(p, canPassThrough)) return true;
-
-	p->velocity.Y -= gravity * (float)delta;
-	begY = Math_Floor(p->nextPos.Y);
-	
-	Vec3_Mul1(&velocity, &p->velocity, (float)delta * 3.0f);
-	Vec3_Add(&p->nextPos, &p->nextPos, &velocity);
-	endY = Math_Floor(p->nextPos.Y);
+	begY = Math_Floor(l->lastY[i]);
+	endY = Math_Floor(l->nextY[i]);
 
-	if (p->velocity.Y > 0.0f) {
+	if (l->velY[i] > 0.0f) {
 		/* don't test block we are already in */
-		for (y = begY + 1; y <= endY && ClipY(p, y, false, canPassThrough); y++) {}
+		for (y = begY + 1; y <= endY && ClipY(l, i, y, false, canPassThrough); y++) {}
 	} else {
-		for (y = begY; y >= endY && ClipY(p, y, true, canPassThrough); y--) {}
+		for (y = begY; y >= endY && ClipY(l, i, y, true, canPassThrough); y--) {}
 	}
-
-	p->lifetime -= (float)delta;
-	return p->lifetime < 0.0f;
+	return l->lifetime[i] < 0.0f;
 }
 
 
 /*########################################################################################################################*
 *-------------------------------------------------------Rain particle-----------------------------------------------------*
 *#########################################################################################################################*/
-static struct Particle rain_Particles[PARTICLES_MAX];
-static int rain_count;
+static struct ParticleList rain_particles;
 static TextureRec rain_rec = { 2.0f/128.0f, 14.0f/128.0f, 5.0f/128.0f, 16.0f/128.0f };
 
 static cc_bool RainParticle_CanPass(BlockID block) {
@@ -135,54 +255,37 @@ static cc_bool RainParticle_CanPass(BlockID block) {
 	return draw == DRAW_GAS || draw == DRAW_SPRITE;
 }
 
-static cc_bool RainParticle_Tick(struct Particle* p, double delta) {
-	hitTerrain = false;
-	return PhysicsTick(p, 3.5f, RainParticle_CanPass, delta) || hitTerrain;
-}
-
-static void RainParticle_Render(struct Particle* p, float t, struct VertexTextured* vertices) {
-	Vec3 pos;
-	Vec2 size;
-	PackedCol col;
-	int x, y, z;
-
-	Vec3_Lerp(&pos, &p->lastPos, &p->nextPos, t);
-	size.X = p->size * 0.015625f; size.Y = size.X;
-
-	x = Math_Floor(pos.X); y = Math_Floor(pos.Y); z = Math_Floor(pos.Z);
-	col = Lighting.Color(x, y, z);
-	Particle_DoRender(&size, &pos, &rain_rec, col, vertices);
-}
-
 static void Rain_Render(float t) {
+	struct ParticleList* l = &rain_particles;
 	struct VertexTextured* data;
+	PackedCol col;
+	float size;
 	int i;
-	if (!rain_count) return;
-	
+	if (!l->count) return;
+
+	ParticleList_Lerp(l, t);
 	data = (struct VertexTextured*)Gfx_LockDynamicVb(Particles_VB, 
-										VERTEX_FORMAT_TEXTURED, rain_count * 4);
-	for (i = 0; i < rain_count; i++) {
-		RainParticle_Render(&rain_Particles[i], t, data);
-		data += 4;
+										VERTEX_FORMAT_TEXTURED, l->count * 4);
+	for (i = 0; i < l->count; i++, data += 4) {
+		size = l->size[i] * 0.015625f * 0.5f;
+		col  = Lighting.Color(Math_Floor(l->drawX[i]), Math_Floor(l->drawY[i]), Math_Floor(l->drawZ[i]));
+		Billboard_Make(l->drawX[i], l->drawY[i], l->drawZ[i], size, size, &rain_rec, col, data);
 	}
 
 	Gfx_BindTexture(Particles_TexId);
 	Gfx_UnlockDynamicVb(Particles_VB);
-	Gfx_DrawVb_IndexedTris(rain_count * 4);
+	Gfx_DrawVb_IndexedTris(l->count * 4);
 }
 
-static void Rain_RemoveAt(int i) {
-	for (; i < rain_count - 1; i++) {
-		rain_Particles[i] = rain_Particles[i + 1];
-	}
-	rain_count--;
-}
-
-static void Rain_Tick(double delta) {
+static void Rain_Tick(float delta) {
 	int i;
-	for (i = 0; i < rain_count; i++) {
-		if (RainParticle_Tick(&rain_Particles[i], delta)) {
-			Rain_RemoveAt(i); i--;
+	ParticleList_Move(&rain_particles, delta);
+
+	/* Removing a particle moves the last one into its place, so go backwards to tick each particle once */
+	for (i = rain_particles.count - 1; i >= 0; i--) {
+		hitTerrain = false;
+		if (PhysicsTick(&rain_particles, i, RainParticle_CanPass) || hitTerrain) {
+			ParticleList_RemoveAt(&rain_particles, i);
 		}
 	}
 }
@@ -191,43 +294,35 @@ static void Rain_Tick(double delta) {
 /*########################################################################################################################*
 *------------------------------------------------------Terrain particle---------------------------------------------------*
 *#########################################################################################################################*/
+/* Per-particle data that is only needed to draw terrain particles */
 struct TerrainParticle {
-	struct Particle base;
 	TextureRec rec;
 	TextureLoc texLoc;
 	BlockID block;
 };
 
-static struct TerrainParticle terrain_particles[PARTICLES_MAX];
-static int terrain_count;
-static cc_uint16 terrain_1DCount[ATLAS1D_MAX_ATLASES];
-static cc_uint16 terrain_1DIndices[ATLAS1D_MAX_ATLASES];
+static struct ParticleList terrain_particles;
+static struct TerrainParticle* terrain_data;
+static int terrain_1DCount[ATLAS1D_MAX_ATLASES];
+static int terrain_1DIndices[ATLAS1D_MAX_ATLASES];
 
 static cc_bool TerrainParticle_CanPass(BlockID block) {
 	cc_uint8 draw = Blocks.Draw[block];
 	return draw == DRAW_GAS || draw == DRAW_SPRITE || Blocks.IsLiquid[block];
 }
 
-static cc_bool TerrainParticle_Tick(struct TerrainParticle* p, double delta) {
-	return PhysicsTick(&p->base, Blocks.ParticleGravity[p->block], TerrainParticle_CanPass, delta);
-}
-
-static void TerrainParticle_Render(struct TerrainParticle* p, float t, struct VertexTextured* vertices) {
+static void TerrainParticle_Render(int i, struct VertexTextured* vertices) {
+	struct ParticleList* l = &terrain_particles;
+	struct TerrainParticle* p = &terrain_data[i];
 	PackedCol col = PACKEDCOL_WHITE;
-	Vec3 pos;
-	Vec2 size;
-	int x, y, z;
+	float size    = l->size[i] * 0.015625f * 0.5f;
 
-	Vec3_Lerp(&pos, &p->base.lastPos, &p->base.nextPos, t);
-	size.X = p->base.size * 0.015625f; size.Y = size.X;
-	
 	if (!Blocks.FullBright[p->block]) {
-		x = Math_Floor(pos.X); y = Math_Floor(pos.Y); z = Math_Floor(pos.Z);
-		col = Lighting.Color_XSide(x, y, z);
+		col = Lighting.Color_XSide(Math_Floor(l->drawX[i]), Math_Floor(l->drawY[i]), Math_Floor(l->drawZ[i]));
 	}
 
 	Block_Tint(col, p->block);
-	Particle_DoRender(&size, &pos, &p->rec, col, vertices);
+	Billboard_Make(l->drawX[i], l->drawY[i], l->drawZ[i], size, size, &p->rec, col, vertices);
 }
 
 static void Terrain_Update1DCounts(void) {
@@ -237,8 +332,8 @@ static void Terrain_Update1DCounts(void) {
 		terrain_1DCount[i]   = 0;
 		terrain_1DIndices[i] = 0;
 	}
-	for (i = 0; i < terrain_count; i++) {
-		index = Atlas1D_Index(terrain_particles[i].texLoc);
+	for (i = 0; i < terrain_particles.count; i++) {
+		index = Atlas1D_Index(terrain_data[i].texLoc);
 		terrain_1DCount[index] += 4;
 	}
 	for (i = 1; i < Atlas1D.Count; i++) {
@@ -251,16 +346,17 @@ static void Terrain_Render(float t) {
 	struct VertexTextured* ptr;
 	int offset = 0;
 	int i, index;
-	if (!terrain_count) return;
+	if (!terrain_particles.count) return;
 
+	ParticleList_Lerp(&terrain_particles, t);
 	data = (struct VertexTextured*)Gfx_LockDynamicVb(Particles_VB, 
-										VERTEX_FORMAT_TEXTURED, terrain_count * 4);
+										VERTEX_FORMAT_TEXTURED, terrain_particles.count * 4);
 	Terrain_Update1DCounts();
-	for (i = 0; i < terrain_count; i++) {
-		index = Atlas1D_Index(terrain_particles[i].texLoc);
+	for (i = 0; i < terrain_particles.count; i++) {
+		index = Atlas1D_Index(terrain_data[i].texLoc);
 		ptr   = data + terrain_1DIndices[index];
 
-		TerrainParticle_Render(&terrain_particles[i], t, ptr);
+		TerrainParticle_Render(i, ptr);
 		terrain_1DIndices[index] += 4;
 	}
 
@@ -276,33 +372,35 @@ static void Terrain_Render(float t) {
 }
 
 static void Terrain_RemoveAt(int i) {
-	for (; i < terrain_count - 1; i++) {
-		terrain_particles[i] = terrain_particles[i + 1];
-	}
-	terrain_count--;
+	terrain_data[i] = terrain_data[terrain_particles.count - 1];
+	ParticleList_RemoveAt(&terrain_particles, i);
 }
 
-static void Terrain_Tick(double delta) {
+static void Terrain_Tick(float delta) {
 	int i;
-	for (i = 0; i < terrain_count; i++) {
-		if (TerrainParticle_Tick(&terrain_particles[i], delta)) {
-			Terrain_RemoveAt(i); i--;
-		}
+	/* Gravity is read every tick, as the block may be redefined while its particles are still in flight */
+	for (i = 0; i < terrain_particles.count; i++) {
+		terrain_particles.gravity[i] = Blocks.ParticleGravity[terrain_data[i].block];
+	}
+	ParticleList_Move(&terrain_particles, delta);
+
+	for (i = terrain_particles.count - 1; i >= 0; i--) {
+		if (PhysicsTick(&terrain_particles, i, TerrainParticle_CanPass)) Terrain_RemoveAt(i);
 	}
 }
 
 /*########################################################################################################################*
 *-------------------------------------------------------Custom particle---------------------------------------------------*
 *#########################################################################################################################*/
+/* Per-particle data that is only needed for custom particles */
 struct CustomParticle {
-	struct Particle base;
 	int effectId;
 	float totalLifespan;
 };
 
 struct CustomParticleEffect Particles_CustomEffects[256];
-static struct CustomParticle custom_particles[PARTICLES_MAX];
-static int custom_count;
+static struct ParticleList custom_particles;
+static struct CustomParticle* custom_data;
 static cc_uint8 collideFlags;
 #define EXPIRES_UPON_TOUCHING_GROUND (1 << 0)
 #define SOLID_COLLIDES  (1 << 1)
@@ -321,70 +419,67 @@ static cc_bool CustomParticle_CanPass(BlockID block) {
 	return true;
 }
 
-static cc_bool CustomParticle_Tick(struct CustomParticle* p, double delta) {
+static void CustomParticle_Render(int i, struct VertexTextured* vertices) {
+	struct ParticleList* l = &custom_particles;
+	struct CustomParticle* p = &custom_data[i];
 	struct CustomParticleEffect* e = &Particles_CustomEffects[p->effectId];
-	hitTerrain   = false;
-	collideFlags = e->collideFlags;
-
-	return PhysicsTick(&p->base, e->gravity, CustomParticle_CanPass, delta)
-		|| (hitTerrain && (e->collideFlags & EXPIRES_UPON_TOUCHING_GROUND));
-}
-
-static void CustomParticle_Render(struct CustomParticle* p, float t, struct VertexTextured* vertices) {
-	struct CustomParticleEffect* e = &Particles_CustomEffects[p->effectId];
-	Vec3 pos;
-	Vec2 size;
 	PackedCol col;
 	TextureRec rec = e->rec;
-	int x, y, z;
+	float size;
 
-	float time_lived = p->totalLifespan - p->base.lifetime;
+	float time_lived = p->totalLifespan - l->lifetime[i];
 	int curFrame = Math_Floor(e->frameCount * (time_lived / p->totalLifespan));
 	float shiftU = curFrame * (rec.U2 - rec.U1);
 
 	rec.U1 += shiftU;/* * 0.0078125f; */
 	rec.U2 += shiftU;/* * 0.0078125f; */
+	size = l->size[i] * 0.5f;
 
-	Vec3_Lerp(&pos, &p->base.lastPos, &p->base.nextPos, t);
-	size.X = p->base.size; size.Y = size.X;
-
-	x = Math_Floor(pos.X); y = Math_Floor(pos.Y); z = Math_Floor(pos.Z);
-	col = e->fullBright ? PACKEDCOL_WHITE : Lighting.Color(x, y, z);
+	col = e->fullBright ? PACKEDCOL_WHITE :
+		Lighting.Color(Math_Floor(l->drawX[i]), Math_Floor(l->drawY[i]), Math_Floor(l->drawZ[i]));
 	col = PackedCol_Tint(col, e->tintCol);
 
-	Particle_DoRender(&size, &pos, &rec, col, vertices);
+	Billboard_Make(l->drawX[i], l->drawY[i], l->drawZ[i], size, size, &rec, col, vertices);
 }
 
 static void Custom_Render(float t) {
 	struct VertexTextured* data;
 	int i;
-	if (!custom_count) return;
+	if (!custom_particles.count) return;
 
+	ParticleList_Lerp(&custom_particles, t);
 	data = (struct VertexTextured*)Gfx_LockDynamicVb(Particles_VB, 
-										VERTEX_FORMAT_TEXTURED, custom_count * 4);
-	for (i = 0; i < custom_count; i++) {
-		CustomParticle_Render(&custom_particles[i], t, data);
-		data += 4;
+										VERTEX_FORMAT_TEXTURED, custom_particles.count * 4);
+	for (i = 0; i < custom_particles.count; i++, data += 4) {
+		CustomParticle_Render(i, data);
 	}
 
 	Gfx_BindTexture(Particles_TexId);
 	Gfx_UnlockDynamicVb(Particles_VB);
-	Gfx_DrawVb_IndexedTris(custom_count * 4);
+	Gfx_DrawVb_IndexedTris(custom_particles.count * 4);
 }
 
 static void Custom_RemoveAt(int i) {
-	for (; i < custom_count - 1; i++) {
-		custom_particles[i] = custom_particles[i + 1];
-	}
-	custom_count--;
+	custom_data[i] = custom_data[custom_particles.count - 1];
+	ParticleList_RemoveAt(&custom_particles, i);
 }
 
-static void Custom_Tick(double delta) {
+static void Custom_Tick(float delta) {
+	struct CustomParticleEffect* e;
 	int i;
-	for (i = 0; i < custom_count; i++) {
-		if (CustomParticle_Tick(&custom_particles[i], delta)) {
-			Custom_RemoveAt(i); i--;
-		}
+	/* Gravity is read every tick, as the effect may be redefined while its particles are still in flight */
+	for (i = 0; i < custom_particles.count; i++) {
+		custom_particles.gravity[i] = Particles_CustomEffects[custom_data[i].effectId].gravity;
+	}
+	ParticleList_Move(&custom_particles, delta);
+
+	for (i = custom_particles.count - 1; i >= 0; i--) {
+		e = &Particles_CustomEffects[custom_data[i].effectId];
+		hitTerrain   = false;
+		collideFlags = e->collideFlags;
+
+		if (PhysicsTick(&custom_particles, i, CustomParticle_CanPass)
+			|| (hitTerrain && (e->collideFlags & EXPIRES_UPON_TOUCHING_GROUND))) Custom_RemoveAt(i);
 	}
 }
 
@@ -393,10 +488,11 @@ static void Custom_Tick(double delta) {
 *--------------------------------------------------------Particles--------------------------------------------------------*
 *#########################################################################################################################*/
 void Particles_Render(float t) {
-	if (!terrain_count && !rain_count && !custom_count) return;
+	if (!terrain_particles.count && !rain_particles.count && !custom_particles.count) return;
 	if (Gfx.LostContext) return;
 
 	Gfx_SetAlphaTest(true);
+	Billboard_Begin();
 
 	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
 	Terrain_Render(t);
@@ -407,13 +503,14 @@ void Particles_Render(float t) {
 }
 
 static void Particles_Tick(struct ScheduledTask* task) {
-	double delta = task->interval;
+	float delta = (float)task->interval;
 	Terrain_Tick(delta);
 	Rain_Tick(delta);
 	Custom_Tick(delta);
 }
 
 void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
+	struct ParticleList* l = &terrain_particles;
 	struct TerrainParticle* p;
 	TextureLoc loc;
 	int texIndex;
@@ -429,7 +526,7 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 	/* per-particle variables */
 	float cellX, cellY, cellZ;
 	Vec3 cell;
-	int x, y, z, type;
+	int x, y, z, i, type;
 
 	if (now != BLOCK_AIR || Blocks.Draw[old] == DRAW_GAS) return;
 	IVec3_ToVec3(&origin, &coords);
@@ -464,13 +561,13 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 				if (cell.X < minBB.X || cell.X > maxBB.X || cell.Y < minBB.Y
 					|| cell.Y > maxBB.Y || cell.Z < minBB.Z || cell.Z > maxBB.Z) continue;
 
-				if (terrain_count == PARTICLES_MAX) Terrain_RemoveAt(0);
-				p = &terrain_particles[terrain_count++];
+				i = ParticleList_Add(l);
+				p = &terrain_data[i];
 
 				/* centre random offset around [-0.2, 0.2] */
-				p->base.velocity.X = CELL_CENTRE + (cellX - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
-				p->base.velocity.Y = CELL_CENTRE + (cellY - 0.0f) + (Random_Float(&rnd) * 0.4f - 0.2f);
-				p->base.velocity.Z = CELL_CENTRE + (cellZ - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
+				l->velX[i] = CELL_CENTRE + (cellX - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
+				l->velY[i] = CELL_CENTRE + (cellY - 0.0f) + (Random_Float(&rnd) * 0.4f - 0.2f);
+				l->velZ[i] = CELL_CENTRE + (cellZ - 0.5f) + (Random_Float(&rnd) * 0.4f - 0.2f);
 
 				rec = baseRec;
 				rec.U1 = baseRec.U1 + Random_Range(&rnd, minU, maxUsedU) * uScale;
@@ -480,56 +577,56 @@ void Particles_BreakBlockEffect(IVec3 coords, BlockID old, BlockID now) {
 				rec.U2 = min(rec.U2, maxU2) - 0.01f * uScale;
 				rec.V2 = min(rec.V2, maxV2) - 0.01f * vScale;
 		
-				Vec3_Add(&p->base.lastPos, &origin, &cell);
-				p->base.nextPos  = p->base.lastPos;
-				p->base.lifetime = 0.3f + Random_Float(&rnd) * 1.2f;
+				l->lastX[i] = origin.X + cell.X; l->nextX[i] = l->lastX[i];
+				l->lastY[i] = origin.Y + cell.Y; l->nextY[i] = l->lastY[i];
+				l->lastZ[i] = origin.Z + cell.Z; l->nextZ[i] = l->lastZ[i];
+				l->lifetime[i] = 0.3f + Random_Float(&rnd) * 1.2f;
 
 				p->rec    = rec;
 				p->texLoc = loc;
 				p->block  = old;
 				type = Random_Next(&rnd, 30);
-				p->base.size = type >= 28 ? 12 : (type >= 25 ? 10 : 8);
+				l->size[i] = type >= 28 ? 12 : (type >= 25 ? 10 : 8);
 			}
 		}
 	}
 }
 
 void Particles_RainSnowEffect(float x, float y, float z) {
-	struct Particle* p;
-	int i, type;
+	struct ParticleList* l = &rain_particles;
+	int i, j, type;
 
-	for (i = 0; i < 2; i++) {
-		if (rain_count == PARTICLES_MAX) Rain_RemoveAt(0);
-		p = &rain_Particles[rain_count++];
+	for (j = 0; j < 2; j++) {
+		i = ParticleList_Add(l);
 
-		p->velocity.X = Random_Float(&rnd) * 0.8f - 0.4f; /* [-0.4, 0.4] */
-		p->velocity.Z = Random_Float(&rnd) * 0.8f - 0.4f;
-		p->velocity.Y = Random_Float(&rnd) + 0.4f;
+		l->velX[i] = Random_Float(&rnd) * 0.8f - 0.4f; /* [-0.4, 0.4] */
+		l->velZ[i] = Random_Float(&rnd) * 0.8f - 0.4f;
+		l->velY[i] = Random_Float(&rnd) + 0.4f;
 
-		p->lastPos.X = x + Random_Float(&rnd); /* [0.0, 1.0] */
-		p->lastPos.Y = y + Random_Float(&rnd) * 0.1f + 0.01f;
-		p->lastPos.Z = z + Random_Float(&rnd);
+		l->lastX[i] = x + Random_Float(&rnd); /* [0.0, 1.0] */
+		l->lastY[i] = y + Random_Float(&rnd) * 0.1f + 0.01f;
+		l->lastZ[i] = z + Random_Float(&rnd);
 
-		p->nextPos  = p->lastPos;
-		p->lifetime = 40.0f;
+		l->nextX[i] = l->lastX[i]; l->nextY[i] = l->lastY[i]; l->nextZ[i] = l->lastZ[i];
+		l->lifetime[i] = 40.0f;
+		l->gravity[i]  = 3.5f;
 
 		type = Random_Next(&rnd, 30);
-		p->size = type >= 28 ? 2 : (type >= 25 ? 4 : 3);
+		l->size[i] = type >= 28 ? 2 : (type >= 25 ? 4 : 3);
 	}
 }
 
 void Particles_CustomEffect(int effectID, float x, float y, float z, float originX, float originY, float originZ) {
-	struct CustomParticle* p;
+	struct ParticleList* l = &custom_particles;
 	struct CustomParticleEffect* e = &Particles_CustomEffects[effectID];
-	int i, count = e->particleCount;
-	Vec3 offset, delta;
-	float d;
+	int i, j, count = e->particleCount;
+	Vec3 offset, delta, pos, origin;
+	float d, lifetime, size;
 
-	for (i = 0; i < count; i++) {
-		if (custom_count == PARTICLES_MAX) Custom_RemoveAt(0);
-		p = &custom_particles[custom_count++];
-		p->effectId = effectID;
+	collideFlags = e->collideFlags;
+	origin = Vec3_Create3(originX, originY, originZ);
 
+	for (j = 0; j < count; j++) {
 		offset.X = Random_Float(&rnd) - 0.5f;
 		offset.Y = Random_Float(&rnd) - 0.5f;
 		offset.Z = Random_Float(&rnd) - 0.5f;
@@ -541,28 +638,29 @@ void Particles_CustomEffect(int effectID, float x, float y, float z, float origi
 		d  = Math_Exp(Math_Log(d) / 3.0); /* d^1/3 for better distribution */
 		d *= e->spread;
 
-		p->base.lastPos.X = x + offset.X * d;
-		p->base.lastPos.Y = y + offset.Y * d;
-		p->base.lastPos.Z = z + offset.Z * d;
-		
-		Vec3 origin = { originX, originY, originZ };
-		Vec3_Sub(&delta, &p->base.lastPos, &origin);
-		Vec3_Normalise(&delta);
-
-		p->base.velocity.X = delta.X * e->speed;
-		p->base.velocity.Y = delta.Y * e->speed;
-		p->base.velocity.Z = delta.Z * e->speed;
+		pos.X = x + offset.X * d;
+		pos.Y = y + offset.Y * d;
+		pos.Z = z + offset.Z * d;
 
-		p->base.nextPos  = p->base.lastPos;
-		p->base.lifetime = e->baseLifetime + (e->baseLifetime * e->lifetimeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
-		p->totalLifespan = p->base.lifetime;
+		Vec3_Sub(&delta, &pos, &origin);
+		Vec3_Normalise(&delta);
 
-		p->base.size = e->size + (e->size * e->sizeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
+		lifetime = e->baseLifetime + (e->baseLifetime * e->lifetimeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
+		size     = e->size + (e->size * e->sizeVariation) * ((Random_Float(&rnd) - 0.5f) * 2);
 
 		/* Don't spawn custom particle inside a block (otherwise it appears */
 		/*   for a few frames, then disappears in first PhysicsTick call)*/
-		collideFlags = e->collideFlags;
-		if (IntersectsBlock(&p->base, CustomParticle_CanPass)) custom_count--;
+		if (IntersectsBlock(pos.X, pos.Y, pos.Z, CustomParticle_CanPass)) continue;
+		i = ParticleList_Add(l);
+
+		l->lastX[i] = pos.X; l->nextX[i] = pos.X; l->velX[i] = delta.X * e->speed;
+		l->lastY[i] = pos.Y; l->nextY[i] = pos.Y; l->velY[i] = delta.Y * e->speed;
+		l->lastZ[i] = pos.Z; l->nextZ[i] = pos.Z; l->velZ[i] = delta.Z * e->speed;
+
+		l->lifetime[i] = lifetime;
+		l->size[i]     = size;
+		custom_data[i].effectId      = effectID;
+		custom_data[i].totalLifespan = lifetime;
 	}
 }
 
@@ -583,13 +681,34 @@ static void OnContextLost(void* obj) {
 	Gfx_DeleteTexture(&Particles_TexId);
 }
 static void OnContextRecreated(void* obj) {
-	Gfx_RecreateDynamicVb(&Particles_VB, VERTEX_FORMAT_TEXTURED, PARTICLES_MAX * 4);
+	Gfx_RecreateDynamicVb(&Particles_VB, VERTEX_FORMAT_TEXTURED, particles_max * 4);
 }
 static void OnBreakBlockEffect_Handler(void* obj, IVec3 coords, BlockID old, BlockID now) {
 	Particles_BreakBlockEffect(coords, old, now);
 }
 
+static void AllocParticles(void) {
+	ParticleList_Alloc(&rain_particles,    "rain particles");
+	ParticleList_Alloc(&terrain_particles, "terrain particles");
+	ParticleList_Alloc(&custom_particles,  "custom particles");
+
+	terrain_data = (struct TerrainParticle*)Mem_Alloc(particles_max, sizeof(struct TerrainParticle), "terrain particles data");
+	custom_data  = (struct CustomParticle*) Mem_Alloc(particles_max, sizeof(struct CustomParticle),  "custom particles data");
+}
+
+static void FreeParticles(void) {
+	ParticleList_Free(&rain_particles);
+	ParticleList_Free(&terrain_particles);
+	ParticleList_Free(&custom_particles);
+
+	Mem_Free(terrain_data); terrain_data = NULL;
+	Mem_Free(custom_data);  custom_data  = NULL;
+}
+
 static void OnInit(void) {
+	particles_max = Options_GetInt(OPT_MAX_PARTICLES, 100, PARTICLES_MAX_LIMIT, PARTICLES_DEF_MAX);
+	AllocParticles();
+
 	ScheduledTask_Add(GAME_DEF_TICKS, Particles_Tick);
 	Random_SeedFromCurrentTime(&rnd);
 	OnContextRecreated(NULL);
@@ -600,9 +719,14 @@ static void OnInit(void) {
 	Event_Register_(&GfxEvents.ContextRecreated, NULL, OnContextRecreated);
 }
 
-static void OnFree(void) { OnContextLost(NULL); }
+static void OnFree(void) {
+	OnContextLost(NULL);
+	FreeParticles();
+}
 
-static void OnReset(void) { rain_count = 0; terrain_count = 0; custom_count = 0; }
+static void OnReset(void) {
+	rain_particles.count = 0; terrain_particles.count = 0; custom_particles.count = 0;
+}
 
 struct IGameComponent Particles_Component = {
 	OnInit,  /* Init  */
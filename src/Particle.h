@@ -8,17 +8,9 @@ Copyright 2014-2022 ClassiCube | Licensed under BSD-3
 */
 
 struct IGameComponent;
-struct VertexTextured;
 struct ScheduledTask;
 extern struct IGameComponent Particles_Component;
 
-struct Particle {
-	Vec3 velocity;
-	float lifetime;
-	Vec3 lastPos, nextPos;
-	float size;
-};
-
 struct CustomParticleEffect {
 	TextureRec rec;
 	PackedCol tintCol;
@@ -37,8 +29,6 @@ struct CustomParticleEffect {
 
 extern struct CustomParticleEffect Particles_CustomEffects[256];
 
-/* http://www.opengl-tutorial.org/intermediate-tutorials/billboards-particles/billboards/ */
-void Particle_DoRender(const Vec2* size, const Vec3* pos, const TextureRec* rec, PackedCol col, struct VertexTextured* vertices);
 void Particles_Render(float t);
 void Particles_BreakBlockEffect(IVec3 coords, BlockID oldBlock, BlockID block);
 void Particles_RainSnowEffect(float x, float y, float z);
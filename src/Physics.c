@@ -7,6 +7,9 @@
 #include "Funcs.h"
 #include "Logger.h"
 #include "Entity.h"
+#include "Event.h"
+#include "Game.h"
+#include "Options.h"
 
 
 /*########################################################################################################################*
@@ -123,10 +126,98 @@ cc_bool Intersection_RayIntersectsBox(Vec3 origin, Vec3 dir, Vec3 min, Vec3 max,
 }
 
 
+/*########################################################################################################################*
+*----------------------------------------------------Solid blocks map-----------------------------------------------------*
+*#########################################################################################################################*/
+/* Stores whether each block in the map is solid (Blocks.Collide is COLLIDE_SOLID) as a single bit */
+/* Each chunk is stored as 16x16 rows of 16 bits (so whole rows of a chunk can be checked at once), */
+/*  along with how many solid blocks are in it (so chunks of only air or water can be skipped entirely) */
+static cc_uint16* solidRows;
+static cc_uint16* solidCounts;
+static cc_bool solidMapEnabled, solidMapDirty;
+
+#define SolidMap_Row(chunk, y, z) solidRows[((chunk) << 8) | (((y) & CHUNK_MASK) << 4) | ((z) & CHUNK_MASK)]
+
+static void SolidMap_Free(void) {
+	Mem_Free(solidRows);
+	Mem_Free(solidCounts);
+	solidRows   = NULL;
+	solidCounts = NULL;
+}
+
+/* Recalculates every row, e.g. after a new map has loaded or blocks have been redefined */
+static void SolidMap_Build(void) {
+	int x, y, z, i = 0, chunk;
+	BlockID block;
+	solidMapDirty = false;
+
+	if (!solidRows) {
+		solidRows   = (cc_uint16*)Mem_TryAlloc(World.ChunksCount, CHUNK_SIZE_2 * 2);
+		solidCounts = (cc_uint16*)Mem_TryAlloc(World.ChunksCount, 2);
+		/* Not enough memory, so just check every block instead */
+		if (!solidRows || !solidCounts) { SolidMap_Free(); return; }
+	}
+	Mem_Set(solidRows,   0, World.ChunksCount * CHUNK_SIZE_2 * 2);
+	Mem_Set(solidCounts, 0, World.ChunksCount * 2);
+
+	for (y = 0; y < World.Height; y++) {
+		for (z = 0; z < World.Length; z++) {
+			for (x = 0; x < World.Width; x++, i++) {
+				block = (BlockID)World_GetRawBlock(i);
+				if (Blocks.Collide[block] != COLLIDE_SOLID) continue;
+
+				chunk = World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+				SolidMap_Row(chunk, y, z) |= 1 << (x & CHUNK_MASK);
+				solidCounts[chunk]++;
+			}
+		}
+	}
+}
+
+void Searcher_OnBlockChanged(int x, int y, int z, BlockID block) {
+	int chunk, bit;
+	cc_bool solid;
+	if (!solidRows || solidMapDirty) return;
+
+	chunk = World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+	bit   = 1 << (x & CHUNK_MASK);
+	solid = Blocks.Collide[block] == COLLIDE_SOLID;
+	if (solid == ((SolidMap_Row(chunk, y, z) & bit) != 0)) return;
+
+	SolidMap_Row(chunk, y, z) ^= bit;
+	if (solid) { solidCounts[chunk]++; } else { solidCounts[chunk]--; }
+}
+
+/* Servers usually define many blocks at once, so only rebuild when next needed */
+static void SolidMap_BlockDefChanged(void* obj) { solidMapDirty = true; }
+
+static void OnInit(void) {
+	solidMapEnabled = Options_GetBool(OPT_SOLID_MAP, true);
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, SolidMap_BlockDefChanged);
+}
+
+static void OnFree(void) {
+	SolidMap_Free();
+	Searcher_Free();
+}
+
+static void OnNewMapLoaded(void) { solidMapDirty = true; }
+
+struct IGameComponent Searcher_Component = {
+	OnInit,        /* Init  */
+	OnFree,        /* Free  */
+	NULL,          /* Reset */
+	SolidMap_Free, /* OnNewMap */
+	OnNewMapLoaded /* OnNewMapLoaded */
+};
+
+
 /*########################################################################################################################*
 *----------------------------------------------------Collisions finder----------------------------------------------------*
 *#########################################################################################################################*/
 #define SEARCHER_STATES_MIN 64
+/* Below this many blocks, checking every block is quicker than using the solid blocks map */
+#define SEARCHER_SOLIDMAP_MIN 32
 static struct SearcherState searcherDefaultStates[SEARCHER_STATES_MIN];
 static cc_uint32 searcherCapacity = SEARCHER_STATES_MIN;
 struct SearcherState* Searcher_States = searcherDefaultStates;
@@ -149,6 +240,118 @@ static void Searcher_QuickSort(int left, int right) {
 	}
 }
 
+static struct SearcherState* Searcher_AddBlock(struct SearcherState* state, int x, int y, int z, BlockID block,
+												Vec3* vel, struct AABB* entityBB, struct AABB* entityExtentBB) {
+	struct AABB blockBB;
+	float xx, yy, zz, tx, ty, tz;
+
+	xx = (float)x; yy = (float)y; zz = (float)z;
+	blockBB.Min = Blocks.MinBB[block];
+	blockBB.Min.X += xx; blockBB.Min.Y += yy; blockBB.Min.Z += zz;
+	blockBB.Max = Blocks.MaxBB[block];
+	blockBB.Max.X += xx; blockBB.Max.Y += yy; blockBB.Max.Z += zz;
+
+	if (!AABB_Intersects(entityExtentBB, &blockBB)) return state; /* necessary for non whole blocks. (slabs) */
+	Searcher_CalcTime(vel, entityBB, &blockBB, &tx, &ty, &tz);
+	if (tx > 1.0f || ty > 1.0f || tz > 1.0f) return state;
+
+	state->X = (x << 3) | (block  & 0x007);
+	state->Y = (y << 4) | ((block & 0x078) >> 3);
+	state->Z = (z << 3) | ((block & 0x380) >> 7);
+	state->tSquared = tx * tx + ty * ty + tz * tz;
+	return state + 1;
+}
+
+/* Finds the solid blocks in the given area by checking every block, which is quicker for small areas */
+static struct SearcherState* Searcher_CheckAll(struct SearcherState* state, IVec3* min, IVec3* max,
+												Vec3* vel, struct AABB* entityBB, struct AABB* entityExtentBB) {
+	BlockID block;
+	int x, y, z;
+
+	/* Order loops so that we minimise cache misses */
+	for (y = min->Y; y <= max->Y; y++) {
+		for (z = min->Z; z <= max->Z; z++) {
+			for (x = min->X; x <= max->X; x++) {
+				block = World_GetPhysicsBlock(x, y, z);
+				if (Blocks.Collide[block] != COLLIDE_SOLID) continue;
+				state = Searcher_AddBlock(state, x, y, z, block, vel, entityBB, entityExtentBB);
+			}
+		}
+	}
+	return state;
+}
+
+/* Finds the solid blocks in a row of the map, using the solid blocks map to skip over non-solid blocks */
+static struct SearcherState* Searcher_CheckRow(struct SearcherState* state, int minX, int maxX, int y, int z,
+												Vec3* vel, struct AABB* entityBB, struct AABB* entityExtentBB) {
+	int x, bx, cx, end, lastX, chunk, index;
+	cc_uint32 bits;
+	BlockID block;
+
+	/* Outside the map is treated as bedrock */
+	for (x = minX; x <= maxX && x < 0; x++) {
+		if (Blocks.Collide[BLOCK_BEDROCK] != COLLIDE_SOLID) continue;
+		state = Searcher_AddBlock(state, x, y, z, BLOCK_BEDROCK, vel, entityBB, entityExtentBB);
+	}
+	lastX = min(maxX, World.MaxX);
+
+	if (y >= World.Height) {
+		/* Above the map is treated as air */
+		for (; x <= lastX && Blocks.Collide[BLOCK_AIR] == COLLIDE_SOLID; x++) {
+			state = Searcher_AddBlock(state, x, y, z, BLOCK_AIR, vel, entityBB, entityExtentBB);
+		}
+	} else {
+		chunk = World_ChunkPack(0, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+		index = World_Pack(0, y, z);
+
+		for (; x <= lastX; x = end + 1) {
+			cx  = x >> CHUNK_SHIFT;
+			end = min(lastX, x | CHUNK_MASK);
+			if (!solidCounts[chunk + cx]) continue;
+
+			/* Only keep the bits between x and end */
+			bits  = SolidMap_Row(chunk + cx, y, z) >> (x & CHUNK_MASK);
+			bits &= (2u << (end - x)) - 1;
+
+			while (bits) {
+				bx    = x + Math_LowestBit(bits);
+				bits &= bits - 1;
+
+				block = (BlockID)World_GetRawBlock(index + bx);
+				state = Searcher_AddBlock(state, bx, y, z, block, vel, entityBB, entityExtentBB);
+			}
+		}
+	}
+
+	for (x = max(x, lastX + 1); x <= maxX; x++) {
+		if (Blocks.Collide[BLOCK_BEDROCK] != COLLIDE_SOLID) continue;
+		state = Searcher_AddBlock(state, x, y, z, BLOCK_BEDROCK, vel, entityBB, entityExtentBB);
+	}
+	return state;
+}
+
+/* Finds the solid blocks in the given area, in the same order as Searcher_CheckAll would */
+static struct SearcherState* Searcher_CheckSolid(struct SearcherState* state, IVec3* min, IVec3* max,
+												Vec3* vel, struct AABB* entityBB, struct AABB* entityExtentBB) {
+	IVec3 rowMin, rowMax;
+	int y, z;
+
+	for (y = min->Y; y <= max->Y; y++) {
+		for (z = min->Z; z <= max->Z; z++) {
+			if (y >= 0 && z >= 0 && z < World.Length) {
+				state = Searcher_CheckRow(state, min->X, max->X, y, z, vel, entityBB, entityExtentBB);
+				continue;
+			}
+
+			/* Rows below or beside the map are rare, so just check every block in them */
+			rowMin.X = min->X; rowMin.Y = y; rowMin.Z = z;
+			rowMax.X = max->X; rowMax.Y = y; rowMax.Z = z;
+			state = Searcher_CheckAll(state, &rowMin, &rowMax, vel, entityBB, entityExtentBB);
+		}
+	}
+	return state;
+}
+
 int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, struct AABB* entityExtentBB) {
 	Vec3 vel = entity->Velocity;
 	IVec3 min, max;
@@ -156,11 +359,6 @@ int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, s
 	struct SearcherState* curState;
 	int count;
 
-	BlockID block;
-	struct AABB blockBB;
-	float xx, yy, zz, tx, ty, tz;
-	int x, y, z;
-
 	Entity_GetBounds(entity, entityBB);
 	/* Exact maximum extent the entity can reach, and the equivalent map coordinates. */
 	entityExtentBB->Min.X = entityBB->Min.X + (vel.X < 0.0f ? vel.X : 0.0f);
@@ -180,32 +378,12 @@ int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, s
 		searcherCapacity = elements;
 		Searcher_States  = (struct SearcherState*)Mem_Alloc(elements, sizeof(struct SearcherState), "collision search states");
 	}
-	curState = Searcher_States;
+	if (solidMapDirty && solidMapEnabled && World.Blocks) SolidMap_Build();
 
-	/* Order loops so that we minimise cache misses */
-	for (y = min.Y; y <= max.Y; y++) {
-		for (z = min.Z; z <= max.Z; z++) {
-			for (x = min.X; x <= max.X; x++) {
-				block = World_GetPhysicsBlock(x, y, z);
-				if (Blocks.Collide[block] != COLLIDE_SOLID) continue;
-
-				xx = (float)x; yy = (float)y; zz = (float)z;
-				blockBB.Min = Blocks.MinBB[block];
-				blockBB.Min.X += xx; blockBB.Min.Y += yy; blockBB.Min.Z += zz;
-				blockBB.Max = Blocks.MaxBB[block];
-				blockBB.Max.X += xx; blockBB.Max.Y += yy; blockBB.Max.Z += zz;
-
-				if (!AABB_Intersects(entityExtentBB, &blockBB)) continue; /* necessary for non whole blocks. (slabs) */
-				Searcher_CalcTime(&vel, entityBB, &blockBB, &tx, &ty, &tz);
-				if (tx > 1.0f || ty > 1.0f || tz > 1.0f) continue;
-
-				curState->X = (x << 3) | (block  & 0x007);
-				curState->Y = (y << 4) | ((block & 0x078) >> 3);
-				curState->Z = (z << 3) | ((block & 0x380) >> 7);
-				curState->tSquared = tx * tx + ty * ty + tz * tz;
-				curState++;
-			}
-		}
+	if (solidRows && elements >= SEARCHER_SOLIDMAP_MIN) {
+		curState = Searcher_CheckSolid(Searcher_States, &min, &max, &vel, entityBB, entityExtentBB);
+	} else {
+		curState = Searcher_CheckAll(Searcher_States,   &min, &max, &vel, entityBB, entityExtentBB);
 	}
 
 	count = (int)(curState - Searcher_States);
@@ -6,9 +6,11 @@ Provides various physics related structs and methods such as:
    - An axis aligned bounding box, and various methods related to them.
    - Various methods for intersecting geometry.
    - Calculates all possible blocks that a moving entity can intersect with
+   - Keeps track of which blocks in the map are solid, to speed up the above
 Copyright 2014-2022 ClassiCube | Licensed under BSD-3
 */
 struct Entity;
+extern struct IGameComponent Searcher_Component;
 
 /* Descibes an axis aligned bounding box. */
 struct AABB { Vec3 Min, Max; };
@@ -37,4 +39,7 @@ extern struct SearcherState* Searcher_States;
 int Searcher_FindReachableBlocks(struct Entity* entity, struct AABB* entityBB, struct AABB* entityExtentBB);
 void Searcher_CalcTime(Vec3* vel, struct AABB *entityBB, struct AABB* blockBB, float* tx, float* ty, float* tz);
 void Searcher_Free(void);
+/* Updates whether the block at the given coordinates is solid */
+/* NOTE: Must be called whenever a block in the map is changed */
+void Searcher_OnBlockChanged(int x, int y, int z, BlockID block);
 #endif
@@ -181,6 +181,10 @@ cc_result File_Create(cc_file* file, const cc_string* path);
 cc_result File_Open(cc_file* file, const cc_string* path);
 /* Attempts to open an existing or create a new file for reading and writing. */
 cc_result File_OpenOrCreate(cc_file* file, const cc_string* path);
+/* Attempts to delete the given file. */
+cc_result File_Delete(const cc_string* path);
+/* Attempts to rename the given file, replacing the destination file if it already exists. */
+cc_result File_Rename(const cc_string* src, const cc_string* dst);
 /* Attempts to read data from the file. */
 cc_result File_Read(cc_file file, void* data, cc_uint32 count, cc_uint32* bytesRead);
 /* Attempts to write data to the file. */
@@ -193,6 +197,12 @@ cc_result File_Seek(cc_file file, int offset, int seekType);
 cc_result File_Position(cc_file file, cc_uint32* pos);
 /* Attempts to retrieve the length of the given file. */
 cc_result File_Length(cc_file file, cc_uint32* len);
+/* Attempts to map the first 'length' bytes of the given file into memory. */
+/* Mapping is copy on write, i.e. changing the memory does not change the file. */
+/* NOTE: The memory remains valid after the file is closed, but the file must not be overwritten while mapped. */
+cc_result File_Map(cc_file file, cc_uint32 length, void** data);
+/* Unmaps memory previously returned by File_Map. */
+void File_Unmap(void* data, cc_uint32 length);
 
 typedef void (*Thread_StartFunc)(void);
 /* Blocks the current thread for the given number of milliseconds. */
@@ -24,6 +24,7 @@
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <utime.h>
 #include <signal.h>
@@ -240,6 +241,19 @@ cc_result File_OpenOrCreate(cc_file* file, const cc_string* path) {
 	return File_Do(file, path, O_RDWR | O_CREAT);
 }
 
+cc_result File_Delete(const cc_string* path) {
+	char str[NATIVE_STR_LEN];
+	Platform_EncodeUtf8(str, path);
+	return unlink(str) == -1 ? errno : 0;
+}
+
+cc_result File_Rename(const cc_string* src, const cc_string* dst) {
+	char srcStr[NATIVE_STR_LEN], dstStr[NATIVE_STR_LEN];
+	Platform_EncodeUtf8(srcStr, src);
+	Platform_EncodeUtf8(dstStr, dst);
+	return rename(srcStr, dstStr) == -1 ? errno : 0;
+}
+
 cc_result File_Read(cc_file file, void* data, cc_uint32 count, cc_uint32* bytesRead) {
 	*bytesRead = read(file, data, count);
 	return *bytesRead == -1 ? errno : 0;
@@ -270,6 +284,16 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	*len = st.st_size; return 0;
 }
 
+cc_result File_Map(cc_file file, cc_uint32 length, void** data) {
+	/* MAP_PRIVATE makes the mapping copy on write */
+	*data = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	if (*data != MAP_FAILED) return 0;
+
+	*data = NULL; return errno;
+}
+
+void File_Unmap(void* data, cc_uint32 length) { munmap(data, length); }
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
@@ -298,9 +322,21 @@ void* Thread_Create(Thread_StartFunc func) {
 	return Mem_Alloc(1, sizeof(pthread_t), "thread");
 }
 
+/* Decoding a PNG needs over 512 KB of stack, which is the default for secondary threads on macOS */
+#define THREAD_MIN_STACK_SIZE (1024 * 1024)
+
 void Thread_Start2(void* handle, Thread_StartFunc func) {
 	pthread_t* ptr = (pthread_t*)handle;
-	int res = pthread_create(ptr, NULL, ExecThread, (void*)func);
+	pthread_attr_t attrs;
+	size_t stackSize = 0;
+	int res;
+
+	pthread_attr_init(&attrs);
+	pthread_attr_getstacksize(&attrs, &stackSize);
+	if (stackSize < THREAD_MIN_STACK_SIZE) pthread_attr_setstacksize(&attrs, THREAD_MIN_STACK_SIZE);
+
+	res = pthread_create(ptr, &attrs, ExecThread, (void*)func);
+	pthread_attr_destroy(&attrs);
 	if (res) Logger_Abort2(res, "Creating thread");
 }
 
@@ -160,6 +160,21 @@ cc_result File_OpenOrCreate(cc_file* file, const cc_string* path) {
 	return File_Do(file, path, O_RDWR | O_CREAT);
 }
 
+extern int interop_FileDelete(const char* path);
+cc_result File_Delete(const cc_string* path) {
+	char str[NATIVE_STR_LEN];
+	Platform_EncodeUtf8(str, path);
+	return interop_FileDelete(str);
+}
+
+extern int interop_FileRename(const char* src, const char* dst);
+cc_result File_Rename(const cc_string* src, const cc_string* dst) {
+	char srcStr[NATIVE_STR_LEN], dstStr[NATIVE_STR_LEN];
+	Platform_EncodeUtf8(srcStr, src);
+	Platform_EncodeUtf8(dstStr, dst);
+	return interop_FileRename(srcStr, dstStr);
+}
+
 extern int interop_FileRead(int fd, void* data, int count);
 cc_result File_Read(cc_file file, void* data, cc_uint32 count, cc_uint32* bytesRead) {
 	int res = interop_FileRead(file, data, count);
@@ -220,6 +235,10 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	}
 }
 
+/* Files are accessed through javascript, so can't be mapped into memory */
+cc_result File_Map(cc_file file, cc_uint32 length, void** data) { *data = NULL; return ERR_NOT_SUPPORTED; }
+void File_Unmap(void* data, cc_uint32 length) { }
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
@@ -251,6 +251,35 @@ cc_result File_OpenOrCreate(cc_file* file, const cc_string* path) {
 	return DoFile(file, path, GENERIC_WRITE | GENERIC_READ, OPEN_ALWAYS);
 }
 
+cc_result File_Delete(const cc_string* path) {
+	WCHAR str[NATIVE_STR_LEN];
+	cc_result res;
+	Platform_EncodeUtf16(str, path);
+
+	if (DeleteFileW(str)) return 0;
+	if ((res = GetLastError()) != ERROR_CALL_NOT_IMPLEMENTED) return res;
+
+	/* Windows 9x does not support W API functions */
+	Platform_Utf16ToAnsi(str);
+	return DeleteFileA((LPCSTR)str) ? 0 : GetLastError();
+}
+
+cc_result File_Rename(const cc_string* src, const cc_string* dst) {
+	WCHAR srcStr[NATIVE_STR_LEN], dstStr[NATIVE_STR_LEN];
+	cc_result res;
+	Platform_EncodeUtf16(srcStr, src);
+	Platform_EncodeUtf16(dstStr, dst);
+
+	if (MoveFileExW(srcStr, dstStr, MOVEFILE_REPLACE_EXISTING)) return 0;
+	if ((res = GetLastError()) != ERROR_CALL_NOT_IMPLEMENTED) return res;
+
+	/* Windows 9x does not support W API functions or MoveFileEx */
+	Platform_Utf16ToAnsi(srcStr);
+	Platform_Utf16ToAnsi(dstStr);
+	DeleteFileA((LPCSTR)dstStr);
+	return MoveFileA((LPCSTR)srcStr, (LPCSTR)dstStr) ? 0 : GetLastError();
+}
+
 cc_result File_Read(cc_file file, void* data, cc_uint32 count, cc_uint32* bytesRead) {
 	BOOL success = ReadFile(file, data, count, bytesRead, NULL);
 	return success ? 0 : GetLastError();
@@ -281,6 +310,18 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	return *len != INVALID_FILE_SIZE ? 0 : GetLastError();
 }
 
+cc_result File_Map(cc_file file, cc_uint32 length, void** data) {
+	/* The view keeps the file mapping alive, so the handle can be closed straight away */
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if (!mapping) { *data = NULL; return GetLastError(); }
+
+	*data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, length);
+	CloseHandle(mapping);
+	return *data ? 0 : GetLastError();
+}
+
+void File_Unmap(void* data, cc_uint32 length) { UnmapViewOfFile(data); }
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
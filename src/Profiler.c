@@ -0,0 +1,90 @@
+#include "Profiler.h"
+#include "Platform.h"
+#include "Stream.h"
+#include "String.h"
+#include "Funcs.h"
+
+struct _ProfilerData Profiler;
+const char* const Profiler_Names[PROFILER_SCOPES_COUNT] = {
+	"Render3D", "MapRenderer", "Particles", "Weather", "Entities", "Server", "Audio", "Gui"
+};
+static cc_uint64 scopeStart[PROFILER_SCOPES_COUNT];
+
+void Profiler_SetEnabled(cc_bool enabled) {
+	Profiler.Enabled     = enabled;
+	Profiler.Frame       = 0;
+	Profiler.FramesCount = 0;
+	Mem_Set(Profiler.Times[0], 0, sizeof(Profiler.Times[0]));
+}
+
+void Profiler_Begin(int scope) {
+	if (!Profiler.Enabled) return;
+	scopeStart[scope] = Stopwatch_Measure();
+}
+
+void Profiler_End(int scope) {
+	if (!Profiler.Enabled) return;
+	/* A scope may be entered multiple times in a frame (e.g. several entity ticks) */
+	Profiler.Times[Profiler.Frame][scope] += (cc_uint32)Stopwatch_ElapsedMicroseconds(scopeStart[scope], Stopwatch_Measure());
+}
+
+void Profiler_EndFrame(double delta) {
+	if (!Profiler.Enabled) return;
+	Profiler.Times[Profiler.Frame][PROFILER_FRAME] = (cc_uint32)(delta * 1000 * 1000);
+
+	Profiler.Frame       = (Profiler.Frame + 1) % PROFILER_MAX_FRAMES;
+	/* The oldest frame is overwritten by the frame now being measured */
+	Profiler.FramesCount = min(Profiler.FramesCount + 1, PROFILER_MAX_FRAMES - 1);
+	Mem_Set(Profiler.Times[Profiler.Frame], 0, sizeof(Profiler.Times[0]));
+}
+
+void Profiler_Summarise(int scope, float* avgMS, float* maxMS) {
+	cc_uint32 time, totalTime = 0, maxTime = 0;
+	int i, frame;
+	*avgMS = 0.0f; *maxMS = 0.0f;
+	if (!Profiler.FramesCount) return;
+
+	for (i = 1; i <= Profiler.FramesCount; i++) {
+		frame = (Profiler.Frame - i + PROFILER_MAX_FRAMES) % PROFILER_MAX_FRAMES;
+		time  = Profiler.Times[frame][scope];
+		totalTime += time;
+		maxTime    = max(maxTime, time);
+	}
+	*avgMS = totalTime / (Profiler.FramesCount * 1000.0f);
+	*maxMS = maxTime   / 1000.0f;
+}
+
+cc_result Profiler_SaveCSV(const cc_string* path) {
+	cc_string line; char lineBuffer[STRING_SIZE * 2];
+	struct Stream stream;
+	cc_result res, closeRes;
+	int i, j, frame;
+	float ms;
+
+	res = Stream_CreateFile(&stream, path);
+	if (res) return res;
+	String_InitArray(line, lineBuffer);
+
+	String_AppendConst(&line, "Frame");
+	for (j = 0; j < PROFILER_SCOPES_COUNT; j++) {
+		String_Format1(&line, ",%c", Profiler_Names[j]);
+	}
+	String_AppendConst(&line, "\r\n");
+	res = Stream_Write(&stream, (cc_uint8*)line.buffer, line.length);
+
+	for (i = Profiler.FramesCount; i > 0 && !res; i--) {
+		frame = (Profiler.Frame - i + PROFILER_MAX_FRAMES) % PROFILER_MAX_FRAMES;
+		line.length = 0;
+
+		for (j = 0; j <= PROFILER_SCOPES_COUNT; j++) {
+			/* Total frame time is in the first column */
+			ms = Profiler.Times[frame][j ? j - 1 : PROFILER_FRAME] / 1000.0f;
+			String_Format1(&line, j ? ",%f3" : "%f3", &ms);
+		}
+		String_AppendConst(&line, "\r\n");
+		res = Stream_Write(&stream, (cc_uint8*)line.buffer, line.length);
+	}
+
+	closeRes = stream.Close(&stream);
+	return res ? res : closeRes;
+}
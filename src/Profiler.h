@@ -0,0 +1,46 @@
+#ifndef CC_PROFILER_H
+#define CC_PROFILER_H
+#include "Core.h"
+/* 
+Measures how long parts of each frame take (e.g. rendering the world, ticking entities, handling packets)
+  Timings for the most recent PROFILER_MAX_FRAMES frames are kept, and can be shown in the HUD or saved to a file
+Copyright 2014-2022 ClassiCube | Licensed under BSD-3
+*/
+
+enum PROFILER_SCOPE {
+	PROFILER_RENDER3D, PROFILER_MAPRENDERER, PROFILER_PARTICLES, PROFILER_WEATHER,
+	PROFILER_ENTITIES, PROFILER_SERVER, PROFILER_AUDIO, PROFILER_GUI, PROFILER_SCOPES_COUNT
+};
+#define PROFILER_MAX_FRAMES 240
+/* Index of the total frame time within each frame's timings */
+#define PROFILER_FRAME PROFILER_SCOPES_COUNT
+
+CC_VAR extern struct _ProfilerData {
+	/* Whether timings are currently being measured */
+	cc_bool Enabled;
+	/* Index into Times of the frame currently being measured */
+	int Frame;
+	/* Number of frames in Times that have been fully measured (at most PROFILER_MAX_FRAMES - 1) */
+	int FramesCount;
+	/* Microseconds spent in each scope (and in the whole frame) for each frame */
+	cc_uint32 Times[PROFILER_MAX_FRAMES][PROFILER_SCOPES_COUNT + 1];
+} Profiler;
+/* Names of each scope (e.g. "MapRenderer") */
+extern const char* const Profiler_Names[PROFILER_SCOPES_COUNT];
+
+/* Starts/Stops measuring timings, clearing any previously measured timings */
+void Profiler_SetEnabled(cc_bool enabled);
+/* Marks the start of the given scope in the current frame */
+/* NOTE: Scopes can be nested, but a scope must not be nested inside itself */
+CC_API void Profiler_Begin(int scope);
+/* Marks the end of the given scope, adding the time since Profiler_Begin to the current frame */
+CC_API void Profiler_End(int scope);
+/* Records the total time of the current frame, then moves onto the next frame */
+void Profiler_EndFrame(double delta);
+
+/* Calculates the average and maximum time spent in the given scope over the measured frames */
+/* NOTE: Use PROFILER_FRAME for the total frame time */
+void Profiler_Summarise(int scope, float* avgMS, float* maxMS);
+/* Saves the measured timings to the given file, with one line per frame (oldest first) */
+cc_result Profiler_SaveCSV(const cc_string* path);
+#endif
@@ -351,12 +351,8 @@ static cc_result MapState_Read(struct MapState* m) {
 
 	if (!m->blocks) {
 		m->blocks = (BlockRaw*)Mem_TryAlloc(map_volume, 1);
-		/* unlikely but possible */
-		if (!m->blocks) {
-			Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
-			m->allocFailed = true;
-			return 0;
-		}
+		/* unlikely but possible (see MapDecoder_CheckProgress) */
+		if (!m->blocks) { m->allocFailed = true; return 0; }
 	}
 
 	left = map_volume - m->index;
@@ -366,6 +362,192 @@ static cc_result MapState_Read(struct MapState* m) {
 	return res;
 }
 
+/* Decompresses a chunk of map data received from the server */
+static cc_result MapState_Decompress(struct MapState* m, cc_uint8* data, int length) {
+	cc_result res;
+	map_part.Meta.Mem.Cur    = data;
+	map_part.Meta.Mem.Base   = data;
+	map_part.Meta.Mem.Left   = length;
+	map_part.Meta.Mem.Length = length;
+
+	if (!m->gzHeader.done) {
+		res = GZipHeader_Read(&map_part, &m->gzHeader);
+		if (res && res != ERR_END_OF_STREAM) return res;
+	}
+
+	if (m->gzHeader.done) return MapState_Read(m);
+	return 0;
+}
+
+/* Progress of decompressing all the map data that has been received so far */
+struct MapProgress { cc_result res; int index, volume; cc_bool allocFailed; };
+static struct MapProgress map_progress;
+static cc_bool map_warnedAlloc;
+
+static cc_result MapDecoder_Decompress(struct MapState* m, cc_uint8* data, int length) {
+	/* Rest of the map data is useless once it is found to be corrupted */
+	if (map_progress.res) return 0;
+	return MapState_Decompress(m, data, length);
+}
+
+static void MapDecoder_UpdateProgress(struct MapState* m, cc_result res) {
+	if (res) map_progress.res = res;
+	map_progress.index        = map1.index;
+	map_progress.volume       = map_volume;
+	map_progress.allocFailed |= m->allocFailed;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Map decompressor thread-------------------------------------------------*
+*#########################################################################################################################*/
+#ifdef CC_BUILD_WEB
+/* Threads are not supported in the webclient, so map data is decompressed as soon as it is received */
+static void MapDecoder_Start(void)  { }
+static void MapDecoder_Stop(void)   { }
+static void MapDecoder_Finish(void) { }
+
+static void MapDecoder_Add(struct MapState* m, cc_uint8* data, int length) {
+	cc_result res = MapDecoder_Decompress(m, data, length);
+	MapDecoder_UpdateProgress(m, res);
+}
+static void MapDecoder_GetProgress(struct MapProgress* progress) { *progress = map_progress; }
+#else
+/* Map data is decompressed on a separate thread, so that reading from the socket is not held up */
+/*  by decompressing. Received chunks of map data are queued up, then decompressed in order. */
+#define MAP_QUEUE_SIZE 256
+struct MapChunk { struct MapState* state; int length; cc_uint8 data[1024]; };
+
+static struct MapChunk* map_queue;
+/* Index of next chunk to decompress, and number of chunks not yet decompressed */
+static int map_queueHead, map_queueCount;
+static void* map_thread;
+static void* map_mutex;     /* Protects map_queue, map_progress and map_stopThread */
+static void* map_pending;   /* Signalled when chunks are added to the queue, or the thread should stop */
+static void* map_processed; /* Signalled when the thread has finished decompressing a chunk */
+static cc_bool map_stopThread;
+
+static void MapDecoder_Run(void) {
+	struct MapChunk* chunk;
+	cc_result res;
+
+	for (;;) {
+		Mutex_Lock(map_mutex);
+		if (map_stopThread) { Mutex_Unlock(map_mutex); return; }
+
+		if (!map_queueCount) {
+			Mutex_Unlock(map_mutex);
+			Waitable_Wait(map_pending);
+			continue;
+		}
+		chunk = &map_queue[map_queueHead];
+		Mutex_Unlock(map_mutex);
+
+		/* Only this thread modifies map_progress while it is running, so can read it without locking */
+		res = MapDecoder_Decompress(chunk->state, chunk->data, chunk->length);
+
+		Mutex_Lock(map_mutex);
+		{
+			MapDecoder_UpdateProgress(chunk->state, res);
+			map_queueHead = (map_queueHead + 1) % MAP_QUEUE_SIZE;
+			map_queueCount--;
+		}
+		Mutex_Unlock(map_mutex);
+		Waitable_Signal(map_processed);
+	}
+}
+
+static void MapDecoder_Start(void) {
+	map_queue      = (struct MapChunk*)Mem_Alloc(MAP_QUEUE_SIZE, sizeof(struct MapChunk), "map queue");
+	map_queueHead  = 0;
+	map_queueCount = 0;
+	map_stopThread = false;
+
+	map_mutex     = Mutex_Create();
+	map_pending   = Waitable_Create();
+	map_processed = Waitable_Create();
+	map_thread    = Thread_Create(MapDecoder_Run);
+	Thread_Start2(map_thread, MapDecoder_Run);
+}
+
+/* Stops the thread, discarding any chunks that have not been decompressed yet */
+static void MapDecoder_Stop(void) {
+	if (!map_thread) return;
+
+	Mutex_Lock(map_mutex);
+	map_stopThread = true;
+	Mutex_Unlock(map_mutex);
+
+	Waitable_Signal(map_pending);
+	Thread_Join(map_thread);
+	map_thread = NULL;
+
+	Mutex_Free(map_mutex);
+	Waitable_Free(map_pending);
+	Waitable_Free(map_processed);
+	Mem_Free(map_queue);
+	map_queue = NULL;
+}
+
+/* Waits until the thread has decompressed at most 'maxLeft' queued chunks */
+static void MapDecoder_WaitFor(int maxLeft) {
+	int left;
+	for (;;) {
+		Mutex_Lock(map_mutex);
+		left = map_queueCount;
+		Mutex_Unlock(map_mutex);
+
+		if (left <= maxLeft) return;
+		Waitable_Wait(map_processed);
+	}
+}
+
+/* Waits for the thread to decompress all the remaining chunks, then stops it */
+static void MapDecoder_Finish(void) {
+	if (!map_thread) return;
+	MapDecoder_WaitFor(0);
+	MapDecoder_Stop();
+}
+
+static void MapDecoder_Add(struct MapState* m, cc_uint8* data, int length) {
+	struct MapChunk* chunk;
+	/* Only waits when thread has fallen far behind the server */
+	MapDecoder_WaitFor(MAP_QUEUE_SIZE - 1);
+
+	/* Only this thread adds chunks, so the free slot can't be taken by something else */
+	Mutex_Lock(map_mutex);
+	chunk = &map_queue[(map_queueHead + map_queueCount) % MAP_QUEUE_SIZE];
+	Mutex_Unlock(map_mutex);
+
+	chunk->state  = m;
+	chunk->length = length;
+	Mem_Copy(chunk->data, data, length);
+
+	Mutex_Lock(map_mutex);
+	map_queueCount++;
+	Mutex_Unlock(map_mutex);
+	Waitable_Signal(map_pending);
+}
+
+static void MapDecoder_GetProgress(struct MapProgress* progress) {
+	Mutex_Lock(map_mutex);
+	*progress = map_progress;
+	Mutex_Unlock(map_mutex);
+}
+#endif
+
+/* Warns user if there was not enough memory for the map, and returns whether map data is corrupted */
+static cc_bool MapDecoder_CheckProgress(struct MapProgress* progress) {
+	if (progress->allocFailed && !map_warnedAlloc) {
+		Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
+		map_warnedAlloc = true;
+	}
+
+	if (!progress->res) return false;
+	DisconnectInvalidMap(progress->res);
+	return true;
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Classic protocol-----------------------------------------------------*
@@ -463,6 +645,8 @@ static void Classic_StartLoading(void) {
 	WoM_CheckMotd();
 	classic_receivedFirstPos = false;
 
+	/* Make sure map states aren't still being used by an unfinished map */
+	MapDecoder_Stop();
 	map_begunLoading = true;
 	map_receiveBeg   = Stopwatch_Measure();
 	map_volume       = 0;
@@ -471,6 +655,9 @@ static void Classic_StartLoading(void) {
 #ifdef EXTENDED_BLOCKS
 	MapState_Init(&map2);
 #endif
+	Mem_Set(&map_progress, 0, sizeof(map_progress));
+	map_warnedAlloc = false;
+	MapDecoder_Start();
 }
 
 static void Classic_LevelInit(cc_uint8* data) {
@@ -489,19 +676,13 @@ static void Classic_LevelInit(cc_uint8* data) {
 }
 
 static void Classic_LevelDataChunk(cc_uint8* data) {
+	struct MapProgress progress;
 	struct MapState* m;
 	int usedLength;
-	float progress;
-	cc_result res;
 
 	/* Workaround for some servers that send LevelDataChunk before LevelInit due to their async sending behaviour */
 	if (!map_begunLoading) Classic_StartLoading();
-	usedLength = Stream_GetU16_BE(data);
-
-	map_part.Meta.Mem.Cur    = data + 2;
-	map_part.Meta.Mem.Base   = data + 2;
-	map_part.Meta.Mem.Left   = usedLength;
-	map_part.Meta.Mem.Length = usedLength;
+	usedLength = min(Stream_GetU16_BE(data), 1024);
 
 #ifndef EXTENDED_BLOCKS
 	m = &map1;
@@ -514,18 +695,12 @@ static void Classic_LevelDataChunk(cc_uint8* data) {
 	}
 #endif
 
-	if (!m->gzHeader.done) {
-		res = GZipHeader_Read(&map_part, &m->gzHeader);
-		if (res && res != ERR_END_OF_STREAM) { DisconnectInvalidMap(res); return; }
-	}
-
-	if (m->gzHeader.done) {
-		res = MapState_Read(m);
-		if (res) { DisconnectInvalidMap(res); return; }
-	}
+	MapDecoder_Add(m, data + 2, usedLength);
+	MapDecoder_GetProgress(&progress);
+	if (MapDecoder_CheckProgress(&progress)) return;
 
-	progress = !map_volume ? 0.0f : (float)map1.index / map_volume;
-	Event_RaiseFloat(&WorldEvents.Loading, progress);
+	Event_RaiseFloat(&WorldEvents.Loading, 
+		!progress.volume ? 0.0f : (float)progress.index / progress.volume);
 }
 
 static void Classic_LevelFinalise(cc_uint8* data) {
@@ -533,6 +708,10 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 	cc_uint64 end;
 	int delta;
 
+	/* Only need to wait for map data that hasn't been decompressed yet */
+	MapDecoder_Finish();
+	if (MapDecoder_CheckProgress(&map_progress)) return;
+
 	end   = Stopwatch_Measure();
 	delta = Stopwatch_ElapsedMS(map_receiveBeg, end);
 	Platform_Log1("map loading took: %i", &delta);
@@ -720,6 +899,7 @@ static void Classic_ReadAbsoluteLocation(cc_uint8* data, EntityID id, cc_uint8 f
 }
 
 static void Classic_Reset(void) {
+	MapDecoder_Stop();
 	Stream_ReadonlyMemory(&map_part, NULL, 0);
 	map_begunLoading = false;
 	classic_receivedFirstPos = false;
@@ -1178,10 +1358,9 @@ static void CPE_ExtAddEntity2(cc_uint8* data) {
 
 #define BULK_MAX_BLOCKS 256
 static void CPE_BulkBlockUpdate(cc_uint8* data) {
-	cc_int32 indices[BULK_MAX_BLOCKS];
+	int indices[BULK_MAX_BLOCKS];
 	BlockID blocks[BULK_MAX_BLOCKS];
-	int index, i;
-	int x, y, z;
+	int i, j;
 	int count = 1 + *data++;
 
 	for (i = 0; i < count; i++) {
@@ -1205,17 +1384,18 @@ static void CPE_BulkBlockUpdate(cc_uint8* data) {
 		data += BULK_MAX_BLOCKS / 4;
 	}
 
-	for (i = 0; i < count; i++) {
-		index = indices[i];
-		if (index < 0 || index >= World.Volume) continue;
-		World_Unpack(index, x, y, z);
-
+	/* Remove any invalid block changes */
+	for (i = 0, j = 0; i < count; i++) {
+		if (indices[i] < 0 || indices[i] >= World.Volume) continue;
+		indices[j] = indices[i];
 #ifdef EXTENDED_BLOCKS
-		Game_UpdateBlock(x, y, z, blocks[i] % BLOCK_COUNT);
+		blocks[j]  = blocks[i] % BLOCK_COUNT;
 #else
-		Game_UpdateBlock(x, y, z, blocks[i]);
+		blocks[j]  = blocks[i];
 #endif
+		j++;
 	}
+	Game_UpdateBlocks(indices, blocks, j);
 }
 
 static void CPE_SetTextColor(cc_uint8* data) {
@@ -1793,8 +1973,10 @@ static void OnReset(void) {
 	FreeMapStates();
 }
 
+static void OnFree(void) { MapDecoder_Stop(); }
+
 struct IGameComponent Protocol_Component = {
 	OnInit,  /* Init  */
-	NULL,    /* Free  */
+	OnFree,  /* Free  */
 	OnReset, /* Reset */
 };
@@ -21,6 +21,9 @@
 #include "World.h"
 #include "Input.h"
 #include "Utils.h"
+#include "MapRenderer.h"
+#include "Profiler.h"
+#include "Options.h"
 
 #define CHAT_MAX_STATUS Array_Elems(Chat_Status)
 #define CHAT_MAX_BOTTOMRIGHT Array_Elems(Chat_BottomRight)
@@ -74,6 +77,8 @@ static struct HUDScreen {
 	float lastSpeed;
 	int lastFov;
 	struct HotbarWidget hotbar;
+	/* Total frame time, then time of each profiler scope */
+	struct TextWidget profiler[PROFILER_SCOPES_COUNT + 1];
 } HUDScreen_Instance;
 
 static void HUDScreen_UpdateLine1(struct HUDScreen* s) {
@@ -95,6 +100,7 @@ static void HUDScreen_UpdateLine1(struct HUDScreen* s) {
 
 		indices = ICOUNT(Game_Vertices);
 		String_Format1(&status, "%i vertices", &indices);
+		if (MapRenderer_ChunksCulled) String_Format1(&status, ", %i chunks culled", &MapRenderer_ChunksCulled);
 
 		ping = Ping_AveragePingMS();
 		if (ping) String_Format1(&status, ", ping %i ms", &ping);
@@ -134,6 +140,36 @@ static void HUDScreen_DrawPosition(struct HUDScreen* s) {
 	Gfx_UpdateDynamicVb_IndexedTris(Models.Vb, vertices, count);
 }
 
+static void HUDScreen_LayoutProfiler(struct HUDScreen* s) {
+	int i, y = Display_ScaleY(2);
+	/* Shown in top right corner, one line below another */
+	for (i = 0; i < Array_Elems(s->profiler); i++) {
+		Widget_SetLocation(&s->profiler[i], ANCHOR_MAX, ANCHOR_MIN, 2, 0);
+		s->profiler[i].yOffset = y;
+		Widget_Layout(&s->profiler[i]);
+		y += s->profiler[i].height;
+	}
+}
+
+static void HUDScreen_UpdateProfiler(struct HUDScreen* s) {
+	cc_string line; char lineBuffer[STRING_SIZE];
+	float avgMS, maxMS;
+	int i;
+
+	String_InitArray(line, lineBuffer);
+	Profiler_Summarise(PROFILER_FRAME, &avgMS, &maxMS);
+	String_Format3(&line, "Frame: %f2 ms avg, %f2 ms max (%i frames)", &avgMS, &maxMS, &Profiler.FramesCount);
+	TextWidget_Set(&s->profiler[0], &line, &s->font);
+
+	for (i = 0; i < PROFILER_SCOPES_COUNT; i++) {
+		line.length = 0;
+		Profiler_Summarise(i, &avgMS, &maxMS);
+		String_Format3(&line, "%c: %f2 ms avg, %f2 ms max", Profiler_Names[i], &avgMS, &maxMS);
+		TextWidget_Set(&s->profiler[i + 1], &line, &s->font);
+	}
+	HUDScreen_LayoutProfiler(s);
+}
+
 static cc_bool HUDScreen_HasHacksChanged(struct HUDScreen* s) {
 	struct HacksComp* hacks = &LocalPlayer_Instance.Hacks;
 	float speed = HacksComp_CalcSpeedFactor(hacks, hacks->CanSpeed);
@@ -167,6 +203,7 @@ static void HUDScreen_Update(void* screen, double delta) {
 	if (s->accumulator < 1.0) return;
 
 	HUDScreen_UpdateLine1(s);
+	if (Profiler.Enabled) HUDScreen_UpdateProfiler(s);
 	s->accumulator = 0.0;
 	s->frames      = 0;
 	Game.ChunkUpdates = 0;
@@ -174,11 +211,16 @@ static void HUDScreen_Update(void* screen, double delta) {
 
 static void HUDScreen_ContextLost(void* screen) {
 	struct HUDScreen* s = (struct HUDScreen*)screen;
+	int i;
 	Font_Free(&s->font);
 	TextAtlas_Free(&s->posAtlas);
 	Elem_Free(&s->hotbar);
 	Elem_Free(&s->line1);
 	Elem_Free(&s->line2);
+
+	for (i = 0; i < Array_Elems(s->profiler); i++) {
+		Elem_Free(&s->profiler[i]);
+	}
 }
 
 static void HUDScreen_ContextRecreated(void* screen) {	
@@ -234,6 +276,7 @@ static void HUDScreen_Layout(void* screen) {
 
 	HUDScreen_LayoutHotbar();
 	Widget_Layout(line2);
+	HUDScreen_LayoutProfiler(s);
 }
 
 static int HUDScreen_KeyDown(void* screen, int key) {
@@ -284,16 +327,29 @@ static void HUDScreen_HacksChanged(void* obj) {
 
 static void HUDScreen_Init(void* screen) {
 	struct HUDScreen* s = (struct HUDScreen*)screen;
+	int i;
 	HotbarWidget_Create(&s->hotbar);
 	TextWidget_Init(&s->line1);
 	TextWidget_Init(&s->line2);
+
+	for (i = 0; i < Array_Elems(s->profiler); i++) {
+		TextWidget_Init(&s->profiler[i]);
+	}
 	Event_Register_(&UserEvents.HacksStateChanged, screen, HUDScreen_HacksChanged);
 }
 
 static void HUDScreen_Render(void* screen, double delta) {
 	struct HUDScreen* s = (struct HUDScreen*)screen;
+	int i;
 	if (Game_HideGui) return;
 
+	/* Profiler text is only created once timings have been measured for a while */
+	if (Profiler.Enabled && s->profiler[0].tex.ID) {
+		for (i = 0; i < Array_Elems(s->profiler); i++) {
+			Elem_Render(&s->profiler[i], delta);
+		}
+	}
+
 	/* TODO: If Game_ShowFps is off and not classic mode, we should just return here */
 	if (Gui.ShowFPS) Elem_Render(&s->line1, delta);
 
@@ -1778,6 +1834,12 @@ static void GeneratingScreen_Init(void* screen) {
 		Window_ShowDialog("Out of memory", "Not enough free memory to generate a map that large.\nTry a smaller size.");
 		Gen_Done = true;
 	} else if (Gen_Vanilla) {
+#ifdef CC_BUILD_WEB
+		/* Threads are not supported in the webclient */
+		Gen_ThreadsCount = 0;
+#else
+		Gen_ThreadsCount = Options_GetInt(OPT_GEN_THREADS, 0, GEN_MAX_THREADS, 4);
+#endif
 		thread = Thread_Create(NotchyGen_Generate);
 		Thread_Start2(thread,  NotchyGen_Generate);
 		Thread_Detach(thread);
@@ -24,6 +24,7 @@
 #include "Platform.h"
 #include "Input.h"
 #include "Errors.h"
+#include "Profiler.h"
 
 static char nameBuffer[STRING_SIZE];
 static char motdBuffer[STRING_SIZE];
@@ -483,6 +484,13 @@ static void OnNewMap(void) {
 	}
 }
 
+/* Handles packets in multiplayer, or runs physics in singleplayer */
+static void Server_Tick(struct ScheduledTask* task) {
+	Profiler_Begin(PROFILER_SERVER);
+	Server.Tick(task);
+	Profiler_End(PROFILER_SERVER);
+}
+
 static void OnInit(void) {
 	String_InitArray(Server.Name,    nameBuffer);
 	String_InitArray(Server.MOTD,    motdBuffer);
@@ -494,7 +502,7 @@ static void OnInit(void) {
 		MPConnection_Init();
 	}
 
-	ScheduledTask_Add(GAME_NET_TICKS, Server.Tick);
+	ScheduledTask_Add(GAME_NET_TICKS, Server_Tick);
 	String_AppendConst(&Server.AppName, GAME_APP_NAME);
 
 #ifdef CC_BUILD_WEB
@@ -12,6 +12,7 @@
 #include "Funcs.h"
 #include "ExtMath.h"
 #include "Options.h"
+#include "WorkerPool.h"
 #include "Logger.h"
 #include "Utils.h"
 #include "Chat.h" /* TODO avoid this include */
@@ -37,28 +38,147 @@ TextureRec Atlas1D_TexRec(TextureLoc texLoc, int uCount, int* index) {
 	return rec;
 }
 
+/* Pixels of all the 1D atlases, kept so that tiles can be changed without rebuilding whole atlases */
+/* All the 1D atlases are stacked on top of each other, so tile N is at y = N * Atlas2D.TileSize */
+static struct Bitmap atlas1D_bmp;
+#define ATLAS_MAX_TILES (ATLAS2D_TILES_PER_ROW * ATLAS2D_MAX_ROWS_COUNT)
+/* Tiles that have changed since their 1D atlas was last uploaded */
+static cc_bool dirtyTiles[ATLAS_MAX_TILES];
+/* Range of tiles in each 1D atlas that have changed since the atlas was last uploaded */
+/*  (dirtyMax of 0 means that no tiles in that atlas have changed) */
+static int dirtyMin[ATLAS1D_MAX_ATLASES], dirtyMax[ATLAS1D_MAX_ATLASES];
+/* Changed tiles with at most this many unchanged tiles between them are uploaded together */
+#define ATLAS1D_MAX_DIRTY_GAP 2
+
+static void Atlas1D_MarkDirty(int tile) {
+	int i = Atlas1D_Index(tile), y = Atlas1D_RowId(tile);
+	dirtyTiles[tile] = true;
+	dirtyMin[i] = min(dirtyMin[i], y);
+	dirtyMax[i] = max(dirtyMax[i], y + 1);
+}
+
+static void Atlas1D_ClearDirty(int i) {
+	int y;
+	for (y = dirtyMin[i]; y < dirtyMax[i]; y++) {
+		dirtyTiles[i * Atlas1D.TilesPerAtlas + y] = false;
+	}
+	dirtyMin[i] = Atlas1D.TilesPerAtlas;
+	dirtyMax[i] = 0;
+}
+
+static void Atlas1D_GetBitmap(int i, int y, int tiles, struct Bitmap* bmp) {
+	int tileSize = Atlas2D.TileSize;
+	Bitmap_Init((*bmp), tileSize, tiles * tileSize,
+				Bitmap_GetRow(&atlas1D_bmp, (i * Atlas1D.TilesPerAtlas + y) * tileSize));
+}
+
+void Atlas1D_UpdateTile(TextureLoc texLoc, struct Bitmap* bmp, int rowWidth) {
+	int tileSize = Atlas2D.TileSize;
+	int y;
+	if (!atlas1D_bmp.scan0 || texLoc >= Atlas1D.Count * Atlas1D.TilesPerAtlas) return;
+	if (texLoc >= ATLAS_MAX_TILES) return;
+
+	for (y = 0; y < bmp->height; y++) {
+		Mem_Copy(Bitmap_GetRow(&atlas1D_bmp, texLoc * tileSize + y),
+				bmp->scan0 + y * rowWidth, bmp->width * 4);
+	}
+	Atlas1D_MarkDirty(texLoc);
+}
+
+/* Uploads each run of changed tiles in the given 1D atlas separately */
+/*  (e.g. so that animating tiles 14 and 30 doesn't also upload the 15 tiles between them) */
+static void Atlas1D_UploadRuns(int i) {
+	cc_bool* dirty = &dirtyTiles[i * Atlas1D.TilesPerAtlas];
+	struct Bitmap part;
+	int y, beg, end;
+
+	for (y = dirtyMin[i]; y < dirtyMax[i]; ) {
+		if (!dirty[y]) { y++; continue; }
+		beg = y; end = y + 1;
+
+		/* Extend the run while the next changed tile is close enough */
+		for (y = end; y < dirtyMax[i] && y - end <= ATLAS1D_MAX_DIRTY_GAP; y++) {
+			if (dirty[y]) end = y + 1;
+		}
+		y = end;
+
+		Atlas1D_GetBitmap(i, beg, end - beg, &part);
+		Gfx_UpdateTexturePart(Atlas1D.TexIds[i], 0, beg * Atlas2D.TileSize, &part, Gfx.Mipmaps);
+	}
+}
+
+void Atlas1D_UploadDirty(void) {
+	int i;
+
+	for (i = 0; i < Atlas1D.Count; i++) {
+		if (!dirtyMax[i]) continue;
+
+		if (Atlas1D.TexIds[i]) Atlas1D_UploadRuns(i);
+		Atlas1D_ClearDirty(i);
+	}
+}
+
+/* Copies a tile from the 2D atlas into the 1D atlases, returning whether it was different */
+static cc_bool Atlas_CopyTile(int tile) {
+	int tileSize = Atlas2D.TileSize;
+	int atlasX   = Atlas2D_TileX(tile) * tileSize;
+	int atlasY   = Atlas2D_TileY(tile) * tileSize;
+	BitmapCol* src;
+	BitmapCol* dst;
+	int y;
+
+	for (y = 0; y < tileSize; y++) {
+		src = Bitmap_GetRow(&Atlas2D.Bmp, atlasY + y) + atlasX;
+		dst = Bitmap_GetRow(&atlas1D_bmp, tile * tileSize + y);
+		if (Mem_Equal(src, dst, tileSize * 4)) continue;
+
+		Bitmap_UNSAFE_CopyBlock(atlasX, atlasY, 0, tile * tileSize,
+								&Atlas2D.Bmp, &atlas1D_bmp, tileSize);
+		return true;
+	}
+	return false;
+}
+
 static void Atlas_Convert2DTo1D(void) {
 	int tileSize      = Atlas2D.TileSize;
 	int tilesPerAtlas = Atlas1D.TilesPerAtlas;
 	int atlasesCount  = Atlas1D.Count;
+	int maxTiles      = Atlas2D.RowsCount * ATLAS2D_TILES_PER_ROW;
 	struct Bitmap atlas1D;
-	int atlasX, atlasY;
-	int tile = 0, i, y;
+	int tile, i;
 
 	Platform_Log2("Loaded terrain atlas: %i bmps, %i per bmp", &atlasesCount, &tilesPerAtlas);
-	Bitmap_Allocate(&atlas1D, tileSize, tilesPerAtlas * tileSize);
-	
-	for (i = 0; i < atlasesCount; i++) {
-		for (y = 0; y < tilesPerAtlas; y++, tile++) {
-			atlasX = Atlas2D_TileX(tile) * tileSize;
-			atlasY = Atlas2D_TileY(tile) * tileSize;
+	/* Last 1D atlas may have more tiles than are left in the 2D atlas */
+	Bitmap_Init(atlas1D_bmp, tileSize, atlasesCount * tilesPerAtlas * tileSize, NULL);
+	atlas1D_bmp.scan0 = (BitmapCol*)Mem_AllocCleared(tileSize * atlas1D_bmp.height, 4, "1D atlases");
 
-			Bitmap_UNSAFE_CopyBlock(atlasX, atlasY, 0, y * tileSize,
-								&Atlas2D.Bmp, &atlas1D, tileSize);
-		}
+	for (tile = 0; tile < maxTiles; tile++) {
+		Bitmap_UNSAFE_CopyBlock(Atlas2D_TileX(tile) * tileSize, Atlas2D_TileY(tile) * tileSize, 
+								0, tile * tileSize, &Atlas2D.Bmp, &atlas1D_bmp, tileSize);
+	}
+
+	/* Layout of the 1D atlases might have changed, so dirtyMin/dirtyMax can't be used to clear dirtyTiles */
+	Mem_Set(dirtyTiles, 0, sizeof(dirtyTiles));
+	for (i = 0; i < atlasesCount; i++) {
+		Atlas1D_GetBitmap(i, 0, tilesPerAtlas, &atlas1D);
 		Gfx_RecreateTexture(&Atlas1D.TexIds[i], &atlas1D, TEXTURE_FLAG_MANAGED | TEXTURE_FLAG_DYNAMIC, Gfx.Mipmaps);
+		dirtyMin[i] = tilesPerAtlas;
+		dirtyMax[i] = 0;
 	}
-	Mem_Free(atlas1D.scan0);
+}
+
+/* Only updates the tiles that are different, when the new atlas has the same layout as the current one */
+static void Atlas_UpdateChanged(struct Bitmap* bmp) {
+	int tile, tiles = 0, count = Atlas2D.RowsCount * ATLAS2D_TILES_PER_ROW;
+	Atlas2D.Bmp = *bmp;
+
+	for (tile = 0; tile < count; tile++) {
+		if (!Atlas_CopyTile(tile)) continue;
+		Atlas1D_MarkDirty(tile);
+		tiles++;
+	}
+	Atlas1D_UploadDirty();
+	Platform_Log2("Updated terrain atlas: %i of %i tiles changed", &tiles, &count);
 }
 
 static void Atlas_Update1D(void) {
@@ -125,10 +245,13 @@ static void Atlas1D_Free(void) {
 	for (i = 0; i < Atlas1D.Count; i++) {
 		Gfx_DeleteTexture(&Atlas1D.TexIds[i]);
 	}
+	Mem_Free(atlas1D_bmp.scan0);
+	atlas1D_bmp.scan0 = NULL;
 }
 
 cc_bool Atlas_TryChange(struct Bitmap* atlas) {
 	static const cc_string terrain = String_FromConst("terrain.png");
+	int tileSize, rows;
 	if (!Game_ValidateBitmap(&terrain, atlas)) return false;
 
 	if (atlas->height < atlas->width) {
@@ -143,10 +266,19 @@ cc_bool Atlas_TryChange(struct Bitmap* atlas) {
 	}
 
 	if (Gfx.LostContext) return false;
-	Atlas1D_Free();
-	Atlas2D_Free();
-
-	Atlas_Update(atlas);
+	tileSize = atlas->width / ATLAS2D_TILES_PER_ROW;
+	rows     = min(atlas->height / tileSize, ATLAS2D_MAX_ROWS_COUNT);
+
+	/* e.g. servers that use a different texture pack for each map often only change some tiles */
+	if (atlas1D_bmp.scan0 && tileSize == Atlas2D.TileSize && rows == Atlas2D.RowsCount) {
+		Atlas2D_Free();
+		Atlas2D.RowsCount = rows;
+		Atlas_UpdateChanged(atlas);
+	} else {
+		Atlas1D_Free();
+		Atlas2D_Free();
+		Atlas_Update(atlas);
+	}
 	Event_RaiseVoid(&TextureEvents.AtlasChanged);
 	return true;
 }
@@ -155,18 +287,14 @@ cc_bool Atlas_TryChange(struct Bitmap* atlas) {
 /*########################################################################################################################*
 *------------------------------------------------------TextureCache-------------------------------------------------------*
 *#########################################################################################################################*/
-static struct StringsBuffer acceptedList, deniedList, etagCache, lastModCache;
+static struct StringsBuffer acceptedList, deniedList;
 #define ACCEPTED_TXT "texturecache/acceptedurls.txt"
 #define DENIED_TXT   "texturecache/deniedurls.txt"
-#define ETAGS_TXT    "texturecache/etags.txt"
-#define LASTMOD_TXT  "texturecache/lastmodified.txt"
 
 /* Initialises cache state (loading various lists) */
 static void TextureCache_Init(void) {
 	EntryList_UNSAFE_Load(&acceptedList, ACCEPTED_TXT);
 	EntryList_UNSAFE_Load(&deniedList,   DENIED_TXT);
-	EntryList_UNSAFE_Load(&etagCache,    ETAGS_TXT);
-	EntryList_UNSAFE_Load(&lastModCache, LASTMOD_TXT);
 }
 
 cc_bool TextureCache_HasAccepted(const cc_string* url) { return EntryList_Find(&acceptedList, url, ' ') >= 0; }
@@ -188,118 +316,235 @@ int TextureCache_ClearDenied(void) {
 	return count;
 }
 
-CC_INLINE static void HashUrl(cc_string* key, const cc_string* url) {
-	String_AppendUInt32(key, Utils_CRC32((const cc_uint8*)url->buffer, url->length));
-}
 
-CC_NOINLINE static void MakeCachePath(cc_string* path, const cc_string* url) {
-	cc_string key; char keyBuffer[STRING_INT_CHARS];
-	String_InitArray(key, keyBuffer);
+/*########################################################################################################################*
+*-------------------------------------------------------TexturePack-------------------------------------------------------*
+*#########################################################################################################################*/
+static char textureUrlBuffer[STRING_SIZE];
+static char texpackPathBuffer[FILENAME_SIZE];
 
-	HashUrl(&key, url);
-	Directory_GetCachePath(path, "texturecache");
-	String_Format1(path, "/%s", &key);
-}
+cc_string TexturePack_Url  = String_FromArray(textureUrlBuffer);
+cc_string TexturePack_Path = String_FromArray(texpackPathBuffer);
+static const cc_string defaultPath = String_FromConst("texpacks/default.zip");
 
-/* Returns non-zero if given URL has been cached */
-static int IsCached(const cc_string* url) {
-	cc_string path; char pathBuffer[FILENAME_SIZE];
-	String_InitArray(path, pathBuffer);
+void TexturePack_SetDefault(const cc_string* texPack) {
+	TexturePack_Path.length = 0;
+	String_Format1(&TexturePack_Path, "texpacks/%s", texPack);
+	Options_Set(OPT_DEFAULT_TEX_PACK, texPack);
+}
 
-	MakeCachePath(&path, url);
-	return File_Exists(&path);
+static cc_bool SelectZipEntry(const cc_string* path) { return true; }
+static cc_result ProcessZipEntry(const cc_string* path, struct Stream* stream, struct ZipEntry* source) {
+	cc_string name = *path;
+	Utils_UNSAFE_GetFilename(&name);
+	Event_RaiseEntry(&TextureEvents.FileChanged, stream, &name);
+	return 0;
 }
 
-/* Attempts to open the cached data stream for the given url */
-static cc_bool OpenCachedData(const cc_string* url, struct Stream* stream) {
-	cc_string path; char pathBuffer[FILENAME_SIZE];
-	cc_result res;
+/* Files in a texture pack are decompressed (and decoded if .png) on several threads, */
+/*  then the results are processed on the main thread in the same order as Zip_Extract would */
+/* To bound memory usage, entries are only decoded up to 2 entries per thread ahead of the entry being processed */
+#define TEXPACK_MAX_THREADS WORKERPOOL_MAX_THREADS
+enum ExtractEntryState { ENTRY_QUEUED, ENTRY_DECODING, ENTRY_DONE };
+
+struct ExtractEntry {
+	cc_string name;
+	cc_uint8* raw;  cc_uint32 rawSize;
+	cc_uint8* data; cc_uint32 size; /* Decompressed data */
+	cc_uint32 method;
+	cc_bool isPng;
+	volatile int state;
+	struct PngDecodedState png;
+};
 
-	String_InitArray(path, pathBuffer);
-	MakeCachePath(&path, url);
-	res = Stream_OpenFile(stream, &path);
+static struct ExtractState {
+	struct ExtractEntry* entries;
+	int count, capacity, next;
+	int applying, window; /* Entries at or after applying + window cannot be decoded yet */
+	void* mutex;
+	void* entryDone;
+} extract;
+static struct WorkerPool extractPool;
+
+static cc_result ReadZipEntry(const cc_string* path, struct Stream* stream, struct ZipEntry* source) {
+	static const cc_string png = String_FromConst(".png");
+	struct ExtractEntry* e;
+	cc_string name = *path;
+	cc_result res;
+	Utils_UNSAFE_GetFilename(&name);
 
-	if (res == ReturnCode_FileNotFound) return false;
-	if (res) { Logger_SysWarn2(res, "opening cache for", url); return false; }
-	return true;
+	if (extract.count == extract.capacity) {
+		extract.capacity = max(16, extract.capacity * 2);
+		extract.entries  = (struct ExtractEntry*)Mem_Realloc(extract.entries, extract.capacity,
+															sizeof(struct ExtractEntry), "texpack entries");
+	}
+	e = &extract.entries[extract.count];
+	Mem_Set(e, 0, sizeof(struct ExtractEntry));
+
+	/* NOTE: Entries for directories have no data */
+	e->raw = (cc_uint8*)Mem_TryAlloc(max(1, source->CompressedSize), 1);
+	if (!e->raw) return ERR_OUT_OF_MEMORY;
+	if ((res = Stream_Read(stream, e->raw, source->CompressedSize))) { Mem_Free(e->raw); return res; }
+
+	e->name = String_Init((char*)Mem_Alloc(max(1, name.length), 1, "texpack entry name"), name.length, name.length);
+	Mem_Copy(e->name.buffer, name.buffer, name.length);
+
+	e->rawSize = source->CompressedSize;
+	e->size    = source->UncompressedSize;
+	e->method  = source->Method;
+	e->isPng   = String_CaselessEnds(&name, &png);
+	extract.count++;
+	return 0;
 }
 
-CC_NOINLINE static cc_string GetCachedTag(const cc_string* url, struct StringsBuffer* list) {
-	cc_string key; char keyBuffer[STRING_INT_CHARS];
-	String_InitArray(key, keyBuffer);
+static void DecodeEntry(struct ExtractEntry* e) {
+	struct Stream src, comp;
+	struct InflateState inflate;
+	cc_result res = 0;
 
-	HashUrl(&key, url);
-	return EntryList_UNSAFE_Get(list, &key, ' ');
+	if (e->method == 0) {
+		e->data = e->raw;
+		e->size = e->rawSize;
+	} else {
+		e->data = (cc_uint8*)Mem_TryAlloc(max(1, e->size), 1);
+		if (!e->data) {
+			res = ERR_OUT_OF_MEMORY;
+		} else {
+			Stream_ReadonlyMemory(&src, e->raw, e->rawSize);
+			Inflate_MakeStream2(&comp, &inflate, &src);
+			res = Stream_Read(&comp, e->data, e->size);
+		}
+		Mem_Free(e->raw);
+	}
+	e->raw = NULL;
+
+	if (res) {
+		/* Nothing can be read from files that could not be decompressed */
+		e->size        = 0;
+		e->png.res     = res;
+		e->png.decoded = e->isPng;
+	} else if (e->isPng) {
+		Stream_ReadonlyMemory(&src, e->data, e->size);
+		e->png.res     = Png_Decode(&e->png.bmp, &src);
+		e->png.decoded = true;
+	}
 }
 
-static cc_string GetCachedLastModified(const cc_string* url) {
-	int i;
-	cc_string entry = GetCachedTag(url, &lastModCache);
-	/* Entry used to be a timestamp of C# DateTime ticks since 01/01/0001 */
-	/* Check whether timestamp entry is old or new format */
-	for (i = 0; i < entry.length; i++) {
-		if (entry.buffer[i] < '0' || entry.buffer[i] > '9') return entry;
+/* Takes the next entry that still needs to be decoded, */
+/*  or NULL if there are no more entries or the next entry is too far ahead of the entry being processed */
+static struct ExtractEntry* ClaimEntry(void) {
+	struct ExtractEntry* e = NULL;
+	Mutex_Lock(extract.mutex);
+	if (extract.next < extract.count && extract.next < extract.applying + extract.window) {
+		e = &extract.entries[extract.next++];
+		e->state = ENTRY_DECODING;
 	}
+	Mutex_Unlock(extract.mutex);
+	return e;
+}
 
-	/* Entry is all digits, so the old unsupported format */
-	entry.length = 0; return entry;
+static void FinishEntry(struct ExtractEntry* e) {
+	DecodeEntry(e);
+	Mutex_Lock(extract.mutex);
+	e->state = ENTRY_DONE;
+	Mutex_Unlock(extract.mutex);
+	Waitable_Signal(extract.entryDone);
 }
 
-static cc_string GetCachedETag(const cc_string* url) {
-	return GetCachedTag(url, &etagCache);
+/* Worker threads are woken up again each time an entry is processed, since more entries can then be claimed */
+static void ExtractWork(int index) {
+	struct ExtractEntry* e;
+	while ((e = ClaimEntry())) { FinishEntry(e); }
 }
+static void ExtractThread(void) { WorkerPool_RunWorker(&extractPool); }
 
-CC_NOINLINE static void SetCachedTag(const cc_string* url, struct StringsBuffer* list,
-									 const cc_string* data, const char* file) {
-	cc_string key; char keyBuffer[STRING_INT_CHARS];
-	if (!data->length) return;
+/* Main thread decodes later entries itself while waiting, instead of just sitting idle */
+static void WaitForEntry(struct ExtractEntry* e) {
+	struct ExtractEntry* next;
+	cc_bool done;
 
-	String_InitArray(key, keyBuffer);
-	HashUrl(&key, url);
-	EntryList_Set(list, &key, data, ' ');
-	EntryList_Save(list, file);
-}
+	for (;;) {
+		Mutex_Lock(extract.mutex);
+		done = e->state == ENTRY_DONE;
+		Mutex_Unlock(extract.mutex);
+		if (done) return;
 
-/* Updates cached data, ETag, and Last-Modified for the given URL */
-static void UpdateCache(struct HttpRequest* req) {
-	cc_string path, url; char pathBuffer[FILENAME_SIZE];
-	cc_result res;
-	url = String_FromRawArray(req->url);
+		if ((next = ClaimEntry())) {
+			FinishEntry(next);
+		} else {
+			Waitable_Wait(extract.entryDone);
+		}
+	}
+}
 
-	path = String_FromRawArray(req->etag);
-	SetCachedTag(&url, &etagCache, &path, ETAGS_TXT);
-	path = String_FromRawArray(req->lastModified);
-	SetCachedTag(&url, &lastModCache, &path, LASTMOD_TXT);
+static void ApplyEntry(struct ExtractEntry* e) {
+	struct Stream mem, png;
+	Stream_ReadonlyMemory(&mem, e->data, e->size);
 
-	String_InitArray(path, pathBuffer);
-	MakeCachePath(&path, &url);
-	res = Stream_WriteAllTo(&path, req->data, req->size);
-	if (res) { Logger_SysWarn2(res, "caching", &url); }
+	if (e->isPng) {
+		Png_MakeDecodedStream(&png, &e->png, &mem);
+		Event_RaiseEntry(&TextureEvents.FileChanged, &png, &e->name);
+		/* Bitmap is still owned by the entry if no handler decoded it */
+		Mem_Free(e->png.bmp.scan0);
+	} else {
+		Event_RaiseEntry(&TextureEvents.FileChanged, &mem, &e->name);
+	}
+	Mem_Free(e->data);
+	Mem_Free(e->name.buffer);
 }
 
+static cc_result ExtractZipParallel(struct Stream* stream, int threadsCount) {
+	cc_result res;
+	int i;
 
-/*########################################################################################################################*
-*-------------------------------------------------------TexturePack-------------------------------------------------------*
-*#########################################################################################################################*/
-static char textureUrlBuffer[STRING_SIZE];
-static char texpackPathBuffer[FILENAME_SIZE];
+	extract.count    = 0;
+	extract.next     = 0;
+	extract.applying = 0;
+	res = Zip_ExtractRaw(stream, SelectZipEntry, ReadZipEntry);
+
+	/* Entries read before the error are still used, same as when using Zip_Extract */
+	if (extract.count) {
+		extract.mutex     = Mutex_Create();
+		extract.entryDone = Waitable_Create();
+		threadsCount      = min(threadsCount, extract.count);
+		extract.window    = 2 * (threadsCount + 1);
+
+		WorkerPool_Start(&extractPool, threadsCount, ExtractThread, ExtractWork);
+		WorkerPool_WakeAll(&extractPool);
+
+		for (i = 0; i < extract.count; i++) {
+			WaitForEntry(&extract.entries[i]);
+			ApplyEntry(&extract.entries[i]);
+
+			Mutex_Lock(extract.mutex);
+			extract.applying = i + 1;
+			Mutex_Unlock(extract.mutex);
+			WorkerPool_WakeAll(&extractPool);
+		}
 
-cc_string TexturePack_Url  = String_FromArray(textureUrlBuffer);
-cc_string TexturePack_Path = String_FromArray(texpackPathBuffer);
-static const cc_string defaultPath = String_FromConst("texpacks/default.zip");
+		WorkerPool_Stop(&extractPool);
+		Mutex_Free(extract.mutex);
+		Waitable_Free(extract.entryDone);
+	}
 
-void TexturePack_SetDefault(const cc_string* texPack) {
-	TexturePack_Path.length = 0;
-	String_Format1(&TexturePack_Path, "texpacks/%s", texPack);
-	Options_Set(OPT_DEFAULT_TEX_PACK, texPack);
+	Mem_Free(extract.entries);
+	extract.entries  = NULL;
+	extract.capacity = 0;
+	return res;
 }
 
-static cc_bool SelectZipEntry(const cc_string* path) { return true; }
-static cc_result ProcessZipEntry(const cc_string* path, struct Stream* stream, struct ZipEntry* source) {
-	cc_string name = *path;
-	Utils_UNSAFE_GetFilename(&name);
-	Event_RaiseEntry(&TextureEvents.FileChanged, stream, &name);
+static cc_result ExtractZip(struct Stream* stream, int threadsCount) {
+	if (threadsCount) return ExtractZipParallel(stream, threadsCount);
+	return Zip_Extract(stream, SelectZipEntry, ProcessZipEntry);
+}
+
+static int GetExtractThreads(void) {
+#ifdef CC_BUILD_WEB
+	/* Threads are not supported in the webclient */
 	return 0;
+#else
+	return Options_GetInt(OPT_TEXPACK_THREADS, 0, TEXPACK_MAX_THREADS, 4);
+#endif
 }
 
 static cc_result ExtractPng(struct Stream* stream) {
@@ -324,7 +569,7 @@ static cc_result ExtractFrom(struct Stream* stream, const cc_string* path) {
 	res = ExtractPng(stream);
 	if (res == PNG_ERR_INVALID_SIG) {
 		/* file isn't a .png image, probably a .zip archive then */
-		res = Zip_Extract(stream, SelectZipEntry, ProcessZipEntry);
+		res = ExtractZip(stream, GetExtractThreads());
 
 		if (res) Logger_SysWarn2(res, "extracting", path);
 	} else if (res) {
@@ -375,7 +620,7 @@ cc_result TexturePack_ExtractCurrent(cc_bool forceReload) {
 		usingDefault = true;
 	}
 
-	if (url.length && OpenCachedData(&url, &stream)) {
+	if (url.length && Http_OpenCached(&url, &stream)) {
 		res = ExtractFrom(&stream, &url);
 		usingDefault = false;
 
@@ -391,9 +636,10 @@ static void ApplyDownloaded(struct HttpRequest* item) {
 	cc_string url;
 
 	url = String_FromRawArray(item->url);
-	UpdateCache(item);
 	/* Took too long to download and is no longer active texture pack */
 	if (!String_Equals(&TexturePack_Url, &url)) return;
+	/* Unchanged since it was cached, so was already extracted in TexturePack_ExtractCurrent */
+	if (item->statusCode == 304 && !usingDefault) return;
 
 	Stream_ReadonlyMemory(&mem, item->data, item->size);
 	ExtractFrom(&mem, &url);
@@ -424,18 +670,8 @@ void TexturePack_CheckPending(void) {
 
 /* Asynchronously downloads the given texture pack */
 static void DownloadAsync(const cc_string* url) {
-	cc_string etag = String_Empty;
-	cc_string time = String_Empty;
-
-	/* Only retrieve etag/last-modified headers if the file exists */
-	/* This inconsistency can occur if user deleted some cached files */
-	if (IsCached(url)) {
-		time = GetCachedLastModified(url);
-		etag = GetCachedETag(url);
-	}
-
 	Http_TryCancel(TexturePack_ReqID);
-	TexturePack_ReqID = Http_AsyncGetDataEx(url, HTTP_FLAG_PRIORITY, &time, &etag, NULL);
+	TexturePack_ReqID = Http_AsyncGetData(url, HTTP_FLAG_PRIORITY | HTTP_FLAG_CACHE);
 }
 
 void TexturePack_Extract(const cc_string* url) {
@@ -523,7 +759,7 @@ static void OnReset(void) {
 }
 
 static void OnFree(void) {
-	OnContextLost(NULL);
+	Atlas1D_Free();
 	Atlas2D_Free();
 	TexturePack_Url.length = 0;
 	entries_head = NULL;
@@ -71,6 +71,12 @@ cc_bool Atlas_TryChange(struct Bitmap* bmp);
 /* That is, returns U1/U2/V1/V2 coords that make up the tile in a 1D atlas. */
 /* index is set to the index of the 1D atlas that the tile is in. */
 TextureRec Atlas1D_TexRec(TextureLoc texLoc, int uCount, int* index);
+/* Copies the given bitmap into the given tile of the 1D atlases, and marks that tile as changed. */
+/* NOTE: rowWidth is in pixels (so for normal bitmaps, rowWidth equals width) */
+void Atlas1D_UpdateTile(TextureLoc texLoc, struct Bitmap* bmp, int rowWidth);
+/* Uploads the tiles that have changed, using one texture update for each run of changed tiles. */
+/* NOTE: A run also includes up to ATLAS1D_MAX_DIRTY_GAP unchanged tiles in between changed tiles. */
+void Atlas1D_UploadDirty(void);
 
 /* Whether the given URL is in list of accepted URLs. */
 cc_bool TextureCache_HasAccepted(const cc_string* url);
@@ -1,4 +1,11 @@
 #include "Vorbis.h"
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VORBIS_SSE2
+#elif defined __ARM_NEON
+#include <arm_neon.h>
+#define VORBIS_NEON
+#endif
 #include "Logger.h"
 #include "Platform.h"
 #include "Event.h"
@@ -172,6 +179,17 @@ static cc_result Vorbis_TryReadBits(struct VorbisState* ctx, cc_uint32 bitsCount
 	return 0;
 }
 
+/* Reads ahead as many whole bytes as fit in the bit buffer, without going past the end of the current packet */
+static void Vorbis_FillBits(struct VorbisState* ctx) {
+	struct OggState* source = ctx->source;
+
+	while (ctx->NumBits <= 24 && source->left) {
+		Vorbis_PushByte(ctx, *source->cur);
+		source->cur++;
+		source->left--;
+	}
+}
+
 static cc_uint32 Vorbis_ReadBit(struct VorbisState* ctx) {
 	cc_uint8 portion;
 	cc_uint32 data;
@@ -188,6 +206,15 @@ static cc_uint32 Vorbis_ReadBit(struct VorbisState* ctx) {
 }
 
 
+static cc_uint32 Vorbis_ReverseBits(cc_uint32 v) {
+	v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
+	v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
+	v = ((v >> 4) & 0x0F0F0F0F) | ((v & 0x0F0F0F0F) << 4);
+	v = ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
+	v = (v >> 16) | (v << 16);
+	return v;
+}
+
 static int iLog(int x) {
 	int bits = 0;
 	while (x > 0) { bits++; x >>= 1; }
@@ -214,21 +241,33 @@ static float float32_unpack(struct VorbisState* ctx) {
 *----------------------------------------------------Vorbis codebooks-----------------------------------------------------*
 *#########################################################################################################################*/
 #define CODEBOOK_SYNC 0x564342
+/* Max number of bits looked up at once when decoding a codeword */
+#define CODEBOOK_LOOKUP_BITS 10
+/* Max number of values in a codebook's precomputed vectors */
+#define CODEBOOK_MAX_VECTORS (256 * 1024)
+
 struct Codebook {
 	cc_uint32 dimensions, entries, totalCodewords;
 	cc_uint32* codewords;
 	cc_uint32* values;
 	cc_uint32 numCodewords[33]; /* number of codewords of bit length i */
+	/* (value << 8) | length of the codeword starting with the next lookupBits bits, 0 if none */
+	cc_uint32* lookup;
+	cc_uint32 lookupBits;
 	/* vector quantisation values */
 	float minValue, deltaValue;
 	cc_uint32 sequenceP, lookupType, lookupValues;
 	cc_uint16* multiplicands;
+	/* multiplicands * deltaValue + minValue of each entry's vector, NULL if too large */
+	float* vectors;
 };
 
 static void Codebook_Free(struct Codebook* c) {
 	Mem_Free(c->codewords);
 	Mem_Free(c->values);
+	Mem_Free(c->lookup);
 	Mem_Free(c->multiplicands);
+	Mem_Free(c->vectors);
 }
 
 static cc_uint32 Codebook_Pow(cc_uint32 base, cc_uint32 exp) {
@@ -316,6 +355,57 @@ static cc_bool Codebook_CalcCodewords(struct Codebook* c, cc_uint8* len) {
 	return true;
 }
 
+/* Fills in the lookup table entries for every codeword that is at most lookupBits long */
+static void Codebook_CalcLookup(struct Codebook* c) {
+	cc_uint32 len, maxLen = 0, i = 0, j, idx, mask;
+	cc_uint32 size;
+
+	for (len = 1; len < Array_Elems(c->numCodewords); len++) {
+		if (c->numCodewords[len]) maxLen = len;
+	}
+	c->lookupBits = min(maxLen, CODEBOOK_LOOKUP_BITS);
+	size = 1 << c->lookupBits;
+	mask = size - 1;
+	c->lookup = (cc_uint32*)Mem_AllocCleared(size, 4, "codebook lookup");
+
+	/* Codeword entries are ordered by length */
+	for (len = 1; len <= c->lookupBits; len++) {
+		for (j = 0; j < c->numCodewords[len]; j++, i++) {
+			/* Bits are read starting from the top bit of codewords */
+			idx = Vorbis_ReverseBits(c->codewords[i]) & mask;
+
+			for (; idx < size; idx += 1 << len) {
+				c->lookup[idx] = (c->values[i] << 8) | len;
+			}
+		}
+	}
+}
+
+static void Codebook_CalcVectors(struct Codebook* c) {
+	cc_uint32 i, j, offset, indexDivisor;
+	float* v;
+
+	c->vectors = NULL;
+	if (!c->dimensions || c->entries > CODEBOOK_MAX_VECTORS / c->dimensions) return;
+	c->vectors = (float*)Mem_TryAlloc(c->entries * c->dimensions, 4);
+	if (!c->vectors) return;
+
+	v = c->vectors;
+	for (i = 0; i < c->entries; i++) {
+		indexDivisor = 1;
+
+		for (j = 0; j < c->dimensions; j++) {
+			if (c->lookupType == 1) {
+				offset = (i / indexDivisor) % c->lookupValues;
+				indexDivisor *= c->lookupValues;
+			} else {
+				offset = i * c->dimensions + j;
+			}
+			*v++ = c->multiplicands[offset] * c->deltaValue + c->minValue;
+		}
+	}
+}
+
 static cc_result Codebook_DecodeSetup(struct VorbisState* ctx, struct Codebook* c) {
 	cc_uint32 sync;
 	cc_uint8* codewordLens;
@@ -367,10 +457,12 @@ static cc_result Codebook_DecodeSetup(struct VorbisState* ctx, struct Codebook*
 
 	c->totalCodewords = entry;
 	Codebook_CalcCodewords(c, codewordLens);
+	Codebook_CalcLookup(c);
 	Mem_Free(codewordLens);
 
 	c->lookupType    = Vorbis_ReadBits(ctx, 4);
 	c->multiplicands = NULL;
+	c->vectors       = NULL;
 	if (c->lookupType == 0) return 0;
 	if (c->lookupType > 2)  return VORBIS_ERR_CODEBOOK_LOOKUP;
 
@@ -390,6 +482,7 @@ static cc_result Codebook_DecodeSetup(struct VorbisState* ctx, struct Codebook*
 	for (i = 0; i < lookupValues; i++) {
 		c->multiplicands[i] = Vorbis_ReadBits(ctx, valueBits);
 	}
+	Codebook_CalcVectors(c);
 	return 0;
 }
 
@@ -397,8 +490,18 @@ static cc_uint32 Codebook_DecodeScalar(struct VorbisState* ctx, struct Codebook*
 	cc_uint32 codeword = 0, shift = 31, depth, i;
 	cc_uint32* codewords = c->codewords;
 	cc_uint32* values    = c->values;
+	cc_uint32 entry, len;
+
+	/* Most codewords are short enough to be looked up directly */
+	Vorbis_FillBits(ctx);
+	entry = c->lookup[Vorbis_PeekBits(ctx, c->lookupBits)];
+	len   = entry & 0xFF;
+	if (len && len <= ctx->NumBits) {
+		Vorbis_ConsumeBits(ctx, len);
+		return entry >> 8;
+	}
 
-	/* TODO: This is so massively slow */
+	/* Longer codewords, or codewords crossing the end of the packet, are read one bit at a time */
 	for (depth = 1; depth <= 32; depth++, shift--) {
 		codeword |= Vorbis_ReadBit(ctx) << shift;
 
@@ -418,8 +521,17 @@ static void Codebook_DecodeVectors(struct VorbisState* ctx, struct Codebook* c,
 	cc_uint32 lookupOffset = Codebook_DecodeScalar(ctx, c);
 	float last = 0.0f, value;
 	cc_uint32 i, offset;
+	float* vec;
+
+	if (c->vectors) {
+		vec = c->vectors + lookupOffset * c->dimensions;
+		for (i = 0; i < c->dimensions; i++, v += step) {
+			value = vec[i] + last;
 
-	if (c->lookupType == 1) {		
+			*v += value;
+			if (c->sequenceP) last = value;
+		}
+	} else if (c->lookupType == 1) {		
 		cc_uint32 indexDivisor = 1;
 		for (i = 0; i < c->dimensions; i++, v += step) {
 			offset = (lookupOffset / indexDivisor) % c->lookupValues;
@@ -457,6 +569,8 @@ struct Floor {
 	cc_int16 subclassBooks[FLOOR_MAX_CLASSES][8];
 	cc_int16  xList[FLOOR_MAX_VALUES];
 	cc_uint16 listOrder[FLOOR_MAX_VALUES];
+	cc_uint16 loNeighbor[FLOOR_MAX_VALUES];
+	cc_uint16 hiNeighbor[FLOOR_MAX_VALUES];
 	cc_int32  yList[VORBIS_MAX_CHANS][FLOOR_MAX_VALUES];
 };
 
@@ -517,6 +631,22 @@ static void Floor_SortXList(int left, int right) {
 	}
 }
 
+static int low_neighbor(cc_int16* v, int x) {
+	int n = 0, i, max = Int32_MinValue;
+	for (i = 0; i < x; i++) {
+		if (v[i] < v[x] && v[i] > max) { n = i; max = v[i]; }
+	}
+	return n;
+}
+
+static int high_neighbor(cc_int16* v, int x) {
+	int n = 0, i, min = Int32_MaxValue;
+	for (i = 0; i < x; i++) {
+		if (v[i] > v[x] && v[i] < min) { n = i; min = v[i]; }
+	}
+	return n;
+}
+
 static cc_result Floor_DecodeSetup(struct VorbisState* ctx, struct Floor* f) {
 	static const short ranges[4] = { 256, 128, 84, 64 };
 	int i, j, idx, maxClass;
@@ -564,6 +694,12 @@ static cc_result Floor_DecodeSetup(struct VorbisState* ctx, struct Floor* f) {
 	tmp_xlist = xlist_sorted; 
 	tmp_order = f->listOrder;
 	Floor_SortXList(0, idx - 1);
+
+	/* neighbours only depend on X list, so don't need to be recalculated every frame */
+	for (i = 2; i < idx; i++) {
+		f->loNeighbor[i] = low_neighbor(f->xList, i);
+		f->hiNeighbor[i] = high_neighbor(f->xList, i);
+	}
 	return 0;
 }
 
@@ -649,22 +785,6 @@ static void Floor_RenderLine(int x0, int y0, int x1, int y1, float* data) {
 	}
 }
 
-static int low_neighbor(cc_int16* v, int x) {
-	int n = 0, i, max = Int32_MinValue;
-	for (i = 0; i < x; i++) {
-		if (v[i] < v[x] && v[i] > max) { n = i; max = v[i]; }
-	}
-	return n;
-}
-
-static int high_neighbor(cc_int16* v, int x) {
-	int n = 0, i, min = Int32_MaxValue;
-	for (i = 0; i < x; i++) {
-		if (v[i] > v[x] && v[i] < min) { n = i; min = v[i]; }
-	}
-	return n;
-}
-
 static void Floor_Synthesis(struct VorbisState* ctx, struct Floor* f, int ch) {
 	/* amplitude arrays */
 	cc_int32 YFinal[FLOOR_MAX_VALUES];
@@ -690,8 +810,8 @@ static void Floor_Synthesis(struct VorbisState* ctx, struct Floor* f, int ch) {
 	YFinal[1] = yList[1];
 
 	for (i = 2; i < f->values; i++) {
-		lo_offset = low_neighbor(f->xList, i);
-		hi_offset = high_neighbor(f->xList, i);
+		lo_offset = f->loNeighbor[i];
+		hi_offset = f->hiNeighbor[i];
 		predicted = Floor_RenderPoint(f->xList[lo_offset], YFinal[lo_offset],
 									  f->xList[hi_offset], YFinal[hi_offset], f->xList[i]);
 
@@ -975,14 +1095,6 @@ static cc_result Mapping_DecodeSetup(struct VorbisState* ctx, struct Mapping* m)
 *------------------------------------------------------imdct impl---------------------------------------------------------*
 *#########################################################################################################################*/
 #define PI MATH_PI
-static cc_uint32 Vorbis_ReverseBits(cc_uint32 v) {
-	v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
-	v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
-	v = ((v >> 4) & 0x0F0F0F0F) | ((v & 0x0F0F0F0F) << 4);
-	v = ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
-	v = (v >> 16) | (v << 16);
-	return v;
-}
 
 void imdct_init(struct imdct_state* state, int n) {
 	int k, k2, n4 = n >> 2, n8 = n >> 3, log2_n;
@@ -1010,6 +1122,36 @@ void imdct_init(struct imdct_state* state, int n) {
 	}
 }
 
+/* Computes step 3 of imdct_calc for two values of r at once */
+/* (uses the same operations in the same order as the scalar loop, so output is identical) */
+#if defined VORBIS_SSE2
+static void imdct_step3_pair(float* w, float* u, const float* A0, const float* A1, int k0, int i) {
+	__m128 twC = _mm_set_ps( A0[0],  A0[0], A1[0],  A1[0]);
+	__m128 twS = _mm_set_ps(-A0[1],  A0[1], -A1[1], A1[1]);
+	__m128 e   = _mm_loadu_ps(&w[i - 3]);
+	__m128 f   = _mm_loadu_ps(&w[i - 3 - k0]);
+	__m128 d   = _mm_sub_ps(e, f);
+	__m128 ds  = _mm_shuffle_ps(d, d, _MM_SHUFFLE(2,3,0,1));
+
+	_mm_storeu_ps(&u[i - 3],      _mm_add_ps(e, f));
+	_mm_storeu_ps(&u[i - 3 - k0], _mm_add_ps(_mm_mul_ps(d, twC), _mm_mul_ps(ds, twS)));
+}
+#elif defined VORBIS_NEON
+static void imdct_step3_pair(float* w, float* u, const float* A0, const float* A1, int k0, int i) {
+	float twC_[4] = { A1[0],  A1[0], A0[0],  A0[0] };
+	float twS_[4] = { A1[1], -A1[1], A0[1], -A0[1] };
+	float32x4_t twC = vld1q_f32(twC_);
+	float32x4_t twS = vld1q_f32(twS_);
+	float32x4_t e   = vld1q_f32(&w[i - 3]);
+	float32x4_t f   = vld1q_f32(&w[i - 3 - k0]);
+	float32x4_t d   = vsubq_f32(e, f);
+	float32x4_t ds  = vrev64q_f32(d);
+
+	vst1q_f32(&u[i - 3],      vaddq_f32(e, f));
+	vst1q_f32(&u[i - 3 - k0], vaddq_f32(vmulq_f32(d, twC), vmulq_f32(ds, twS)));
+}
+#endif
+
 void imdct_calc(float* in, float* out, struct imdct_state* state) {
 	int k, k2, k4, n = state->n;
 	int n2 = n >> 1, n4 = n >> 2, n8 = n >> 3, n3_4 = n - n4;
@@ -1020,8 +1162,11 @@ void imdct_calc(float* in, float* out, struct imdct_state* state) {
 	/* Uses a few fixes for the paper noted at http://www.nothings.org/stb_vorbis/mdct_01.txt */
 	float *A = state->a, *B = state->b, *C = state->c;
 
-	float u[VORBIS_MAX_BLOCK_SIZE / 2];
-	float w[VORBIS_MAX_BLOCK_SIZE / 2];
+	float bufferA[VORBIS_MAX_BLOCK_SIZE / 2];
+	float bufferB[VORBIS_MAX_BLOCK_SIZE / 2];
+	float* w = bufferA;
+	float* u = bufferB;
+	float* tmp;
 	float e_1, e_2, f_1, f_2;
 	float g_1, g_2, h_1, h_2;
 	float x_1, x_2, y_1, y_2;
@@ -1049,8 +1194,16 @@ void imdct_calc(float* in, float* out, struct imdct_state* state) {
 	for (l = 0; l <= log2_n - 4; l++) {
 		int k0 = n >> (l+3), k1 = 1 << (l+3);
 		int r, r2, rMax = n >> (l+4), s2, s2Max = 1 << (l+2);
+		r = 0; r2 = 0;
 
-		for (r = 0, r2 = 0; r < rMax; r++, r2 += 2) {
+#if defined VORBIS_SSE2 || defined VORBIS_NEON
+		for (; r + 2 <= rMax; r += 2, r2 += 4) {
+			for (s2 = 0; s2 < s2Max; s2 += 2) {
+				imdct_step3_pair(w, u, &A[r*k1], &A[(r+1)*k1], k0, n2-1-k0*s2-r2);
+			}
+		}
+#endif
+		for (; r < rMax; r++, r2 += 2) {
 			for (s2 = 0; s2 < s2Max; s2 += 2) {
 				e_1 = w[n2-1-k0*s2-r2];     
 				e_2 = w[n2-2-k0*s2-r2];
@@ -1064,12 +1217,11 @@ void imdct_calc(float* in, float* out, struct imdct_state* state) {
 			}
 		}
 
-		/* TODO: eliminate this, do w/u in-place */
+		/* output of this level is the input to the next level */
 		/* TODO: dynamically allocate mem for imdct */
-		if (l+1 <= log2_n - 4) {
-			Mem_Copy(w, u, n2 * sizeof(float));
-		}
+		tmp = w; w = u; u = tmp;
 	}
+	u = w;
 
 	/* step 4, step 5, step 6, step 7, step 8, output */
 	reversed = state->reversed;
@@ -1353,7 +1505,6 @@ cc_result Vorbis_DecodeFrame(struct VorbisState* ctx) {
 
 	/* misc variables */
 	float* tmp;
-	cc_uint32 alignSkip;
 	int i, j; 
 	cc_result res;
 	
@@ -1461,10 +1612,85 @@ cc_result Vorbis_DecodeFrame(struct VorbisState* ctx) {
 	}
 
 	/* discard remaining bits at end of packet */
-	Vorbis_AlignBits(ctx);
+	/* (including any bytes that were read ahead when decoding codewords) */
+	ctx->Bits    = 0;
+	ctx->NumBits = 0;
+	Ogg_DiscardPacket(ctx->source);
 	return 0;
 }
 
+/* Windows, overlaps and converts as many mono or stereo samples as possible 4 at a time */
+/* Returns number of samples per channel that were converted */
+#if defined VORBIS_SSE2
+static int Vorbis_OverlapFast(float** prev, float** cur, struct VorbisWindow* window, int channels, int count, cc_int16* data) {
+	__m128 one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f), scale = _mm_set1_ps(32767.0f);
+	__m128 wPrev, wCur, sample;
+	__m128i ch0, ch1, all;
+	int i = 0;
+
+	#define Vorbis_OverlapSSE2(dst, ch) \
+		sample = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&prev[ch][i]), wPrev), _mm_mul_ps(_mm_loadu_ps(&cur[ch][i]), wCur)); \
+		sample = _mm_min_ps(_mm_max_ps(sample, minusOne), one); \
+		dst    = _mm_cvttps_epi32(_mm_mul_ps(sample, scale));
+
+	if (channels == 1) {
+		for (; i + 4 <= count; i += 4, data += 4) {
+			wPrev = _mm_loadu_ps(&window->Prev[i]);
+			wCur  = _mm_loadu_ps(&window->Cur[i]);
+			Vorbis_OverlapSSE2(ch0, 0);
+
+			all = _mm_packs_epi32(ch0, ch0);
+			_mm_storel_epi64((__m128i*)data, all);
+		}
+	} else if (channels == 2) {
+		for (; i + 4 <= count; i += 4, data += 8) {
+			wPrev = _mm_loadu_ps(&window->Prev[i]);
+			wCur  = _mm_loadu_ps(&window->Cur[i]);
+			Vorbis_OverlapSSE2(ch0, 0);
+			Vorbis_OverlapSSE2(ch1, 1);
+
+			/* L0 L1 L2 L3 R0 R1 R2 R3 > L0 R0 L1 R1 L2 R2 L3 R3 */
+			all = _mm_packs_epi32(ch0, ch1);
+			all = _mm_unpacklo_epi16(all, _mm_srli_si128(all, 8));
+			_mm_storeu_si128((__m128i*)data, all);
+		}
+	}
+	return i;
+}
+#elif defined VORBIS_NEON
+static int Vorbis_OverlapFast(float** prev, float** cur, struct VorbisWindow* window, int channels, int count, cc_int16* data) {
+	float32x4_t one = vdupq_n_f32(1.0f), minusOne = vdupq_n_f32(-1.0f), scale = vdupq_n_f32(32767.0f);
+	float32x4_t wPrev, wCur, sample;
+	int16x4x2_t all;
+	int i = 0;
+
+	#define Vorbis_OverlapNEON(dst, ch) \
+		sample = vaddq_f32(vmulq_f32(vld1q_f32(&prev[ch][i]), wPrev), vmulq_f32(vld1q_f32(&cur[ch][i]), wCur)); \
+		sample = vminq_f32(vmaxq_f32(sample, minusOne), one); \
+		dst    = vmovn_s32(vcvtq_s32_f32(vmulq_f32(sample, scale)));
+
+	if (channels == 1) {
+		for (; i + 4 <= count; i += 4, data += 4) {
+			wPrev = vld1q_f32(&window->Prev[i]);
+			wCur  = vld1q_f32(&window->Cur[i]);
+			Vorbis_OverlapNEON(all.val[0], 0);
+			vst1_s16(data, all.val[0]);
+		}
+	} else if (channels == 2) {
+		for (; i + 4 <= count; i += 4, data += 8) {
+			wPrev = vld1q_f32(&window->Prev[i]);
+			wCur  = vld1q_f32(&window->Cur[i]);
+			Vorbis_OverlapNEON(all.val[0], 0);
+			Vorbis_OverlapNEON(all.val[1], 1);
+			vst2_s16(data, all);
+		}
+	}
+	return i;
+}
+#else
+#define Vorbis_OverlapFast(prev, cur, window, channels, count, data) 0
+#endif
+
 int Vorbis_OutputFrame(struct VorbisState* ctx, cc_int16* data) {
 	struct VorbisWindow window;
 	float* prev[VORBIS_MAX_CHANS];
@@ -1523,7 +1749,10 @@ int Vorbis_OutputFrame(struct VorbisState* ctx, cc_int16* data) {
 
 	/* overlap and add data */
 	/* also perform windowing here */
-	for (i = 0; i < overlapSize; i++) {
+	i     = Vorbis_OverlapFast(prev, cur, &window, ctx->channels, overlapSize, data);
+	data += i * ctx->channels;
+
+	for (; i < overlapSize; i++) {
 		for (ch = 0; ch < ctx->channels; ch++) {
 			sample = prev[ch][i] * window.Prev[i] + cur[ch][i] * window.Cur[i];
 			Math_Clamp(sample, -1.0f, 1.0f);
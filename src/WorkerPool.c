@@ -0,0 +1,63 @@
+#include "WorkerPool.h"
+#include "Platform.h"
+#include "Funcs.h"
+
+void WorkerPool_Start(struct WorkerPool* pool, int count, void (*func)(void), WorkerPool_Func work) {
+	int i;
+	pool->Count   = max(0, min(count, WORKERPOOL_MAX_THREADS));
+	pool->Work    = work;
+	pool->Started = 0;
+	pool->Quit    = false;
+	if (!pool->Count) return;
+
+	/* All the wake waitables must exist before any worker thread picks one */
+	pool->Mutex = Mutex_Create();
+	for (i = 0; i < pool->Count; i++) {
+		pool->Wake[i] = Waitable_Create();
+	}
+	for (i = 0; i < pool->Count; i++) {
+		pool->Threads[i] = Thread_Create(func);
+		Thread_Start2(pool->Threads[i], func);
+	}
+}
+
+void WorkerPool_RunWorker(struct WorkerPool* pool) {
+	void* wake;
+	int i;
+
+	/* Threads may start in any order, so each one picks its index (and wake waitable) when it starts */
+	Mutex_Lock(pool->Mutex);
+	i = pool->Started++;
+	Mutex_Unlock(pool->Mutex);
+	wake = pool->Wake[i];
+
+	for (;;) {
+		Waitable_Wait(wake);
+		if (pool->Quit) return;
+		pool->Work(i);
+	}
+}
+
+void WorkerPool_WakeAll(struct WorkerPool* pool) {
+	int i;
+	for (i = 0; i < pool->Count; i++) { Waitable_Signal(pool->Wake[i]); }
+}
+
+void WorkerPool_Stop(struct WorkerPool* pool) {
+	int i;
+	if (!pool->Count) return;
+	pool->Quit = true;
+
+	/* Threads[i] is not necessarily the thread waiting on Wake[i], so all of them must be woken before joining */
+	WorkerPool_WakeAll(pool);
+	for (i = 0; i < pool->Count; i++) {
+		Thread_Join(pool->Threads[i]);
+	}
+	for (i = 0; i < pool->Count; i++) {
+		Waitable_Free(pool->Wake[i]);
+	}
+
+	Mutex_Free(pool->Mutex);
+	pool->Mutex = NULL;
+	pool->Count = 0;
+}
@@ -0,0 +1,36 @@
+#ifndef CC_WORKERPOOL_H
+#define CC_WORKERPOOL_H
+#include "Core.h"
+/*
+Manages a fixed set of worker threads, which sleep until woken up to help with some work
+  (e.g. building chunk meshes, ticking physics regions, compressing slices of a map)
+Copyright 2014-2022 ClassiCube | Licensed under BSD-3
+*/
+
+#define WORKERPOOL_MAX_THREADS 16
+/* Called on a worker thread every time the pool is woken up */
+/* index is the index of the worker thread in the pool (0 to Count - 1) */
+typedef void (*WorkerPool_Func)(int index);
+
+struct WorkerPool {
+	int Count;  /* Number of worker threads, 0 if the pool is not started */
+	WorkerPool_Func Work;
+	void* Threads[WORKERPOOL_MAX_THREADS];
+	void* Wake[WORKERPOOL_MAX_THREADS];
+	void* Mutex;
+	int Started; /* Number of worker threads that have picked their index */
+	volatile cc_bool Quit;
+};
+
+/* Starts count (at most WORKERPOOL_MAX_THREADS) worker threads that run func */
+/* NOTE: func must only call WorkerPool_RunWorker for the same pool */
+/*  (thread functions have no argument, so each pool needs its own thread function) */
+void WorkerPool_Start(struct WorkerPool* pool, int count, void (*func)(void), WorkerPool_Func work);
+/* Calls pool->Work on the calling worker thread every time the pool is woken up, until the pool is stopped */
+void WorkerPool_RunWorker(struct WorkerPool* pool);
+/* Wakes up all the worker threads, so that each of them calls pool->Work */
+/* NOTE: If a worker thread is still busy, it calls pool->Work again once it is done */
+void WorkerPool_WakeAll(struct WorkerPool* pool);
+/* Waits for all the worker threads to finish their current work and exit, then frees the pool */
+void WorkerPool_Stop(struct WorkerPool* pool);
+#endif
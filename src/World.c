@@ -10,6 +10,7 @@
 #include "Game.h"
 #include "TexturePack.h"
 #include "Window.h"
+#include "Errors.h"
 
 struct _WorldData World;
 static char nameBuffer[STRING_SIZE];
@@ -37,14 +38,31 @@ static void GenerateNewUuid(void) {
 	World.Uuid[8] |= 0x80; /* variant 2*/
 }
 
+static cc_bool IsMapped(BlockRaw* blocks) {
+	BlockRaw* mapped = (BlockRaw*)World.MappedData;
+	return mapped && blocks >= mapped && blocks < mapped + World.MappedSize;
+}
+
+/* Blocks in a memory mapped file are freed by unmapping the file instead */
+static void FreeBlocks(BlockRaw* blocks) {
+	if (!IsMapped(blocks)) Mem_Free(blocks);
+}
+
+static void UnmapFile(void) {
+	if (World.MappedData) File_Unmap(World.MappedData, World.MappedSize);
+	World.MappedData = NULL;
+	World.MappedSize = 0;
+}
+
 void World_Reset(void) {
 #ifdef EXTENDED_BLOCKS
-	if (World.Blocks != World.Blocks2) Mem_Free(World.Blocks2);
+	if (World.Blocks != World.Blocks2) FreeBlocks(World.Blocks2);
 	World.Blocks2 = NULL;
 	World.IDMask  = 0xFF;
 #endif
-	Mem_Free(World.Blocks);
+	FreeBlocks(World.Blocks);
 	World.Blocks = NULL;
+	UnmapFile();
 	String_InitArray(World.Name, nameBuffer);
 
 	World_SetDimensions(0, 0, 0);
@@ -112,6 +130,35 @@ void World_OutOfMemory(void) {
 	World_Reset();
 }
 
+static cc_result CopyMappedBlocks(BlockRaw** blocks) {
+	BlockRaw* copy;
+	if (!IsMapped(*blocks)) return 0;
+
+	copy = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	if (!copy) return ERR_OUT_OF_MEMORY;
+	Mem_Copy(copy, *blocks, World.Volume);
+	*blocks = copy;
+	return 0;
+}
+
+cc_result World_UnmapBlocks(void) {
+	cc_result res;
+	if (!World.MappedData) return 0;
+
+#ifdef EXTENDED_BLOCKS
+	if (World.Blocks2 != World.Blocks) {
+		if ((res = CopyMappedBlocks(&World.Blocks2))) return res;
+	}
+	if ((res = CopyMappedBlocks(&World.Blocks))) return res;
+	/* Blocks2 is an alias of Blocks when only 8 bit blocks are used */
+	if (IsMapped(World.Blocks2)) World.Blocks2 = World.Blocks;
+#else
+	if ((res = CopyMappedBlocks(&World.Blocks))) return res;
+#endif
+	UnmapFile();
+	return 0;
+}
+
 
 #ifdef EXTENDED_BLOCKS
 static CC_NOINLINE void LazyInitUpper(int i, BlockID block) {
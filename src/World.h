@@ -58,6 +58,9 @@ CC_VAR extern struct _WorldData {
 	int ChunksCount;
 	/* Seed world was generated with. May be 0 (unknown) */
 	int Seed;
+	/* Memory mapped file that Blocks/Blocks2 may point into (see File_Map). NULL if none. */
+	void* MappedData;
+	cc_uint32 MappedSize;
 } World;
 
 /* Frees the blocks array, sets dimensions to 0, resets environment to default. */
@@ -72,6 +75,9 @@ CC_API void World_SetNewMap(BlockRaw* blocks, int width, int height, int length)
 /* NOTE: This is an internal API. Use World_SetNewMap instead. */
 CC_NOINLINE void World_SetDimensions(int width, int height, int length);
 void World_OutOfMemory(void);
+/* Copies Blocks/Blocks2 out of the memory mapped file they were loaded from into normal memory. */
+/* NOTE: Must be called before overwriting the file that the world was loaded from. */
+cc_result World_UnmapBlocks(void);
 
 #ifdef EXTENDED_BLOCKS
 /* Sets World.Blocks2 and updates internal state for more than 256 blocks. */
@@ -7,10 +7,13 @@
 #include "Game.h"
 #include "Utils.h"
 #include "Options.h"
+#include "Errors.h"
 
 static cc_bool httpsOnly, httpOnly, httpsVerify;
 static char skinServer_buffer[128];
 static cc_string skinServer = String_FromArray(skinServer_buffer);
+struct _HttpStatsData HttpStats;
+enum HttpPriority { HTTP_PRIORITY_BACKGROUND, HTTP_PRIORITY_NORMAL, HTTP_PRIORITY_HIGH };
 
 /* Frees data from a HTTP request. */
 static void HttpRequest_Free(struct HttpRequest* request) {
@@ -36,21 +39,14 @@ static void RequestList_EnsureSpace(struct RequestList* list) {
 				sizeof(struct HttpRequest), HTTP_DEF_ELEMS, 10);
 }
 
-/* Adds a request to the list */
-static void RequestList_Append(struct RequestList* list, struct HttpRequest* item, cc_uint8 flags) {
+/* Adds a request to the list, after all other requests with the same or higher priority */
+static void RequestList_Append(struct RequestList* list, struct HttpRequest* item) {
 	int i;
 	RequestList_EnsureSpace(list);
 
-	if (flags & HTTP_FLAG_PRIORITY) {
-		/* Shift all requests right one place */
-		for (i = list->count; i > 0; i--) {
-			list->entries[i] = list->entries[i - 1];
-		}
-		/* Insert new request at front/start */
-		i = 0;
-	} else {
-		/* Insert new request at end */
-		i = list->count;
+	/* Shift lower priority requests right one place */
+	for (i = list->count; i > 0 && list->entries[i - 1]._priority < item->_priority; i--) {
+		list->entries[i] = list->entries[i - 1];
 	}
 
 	list->entries[i] = *item;
@@ -100,6 +96,451 @@ static void RequestList_Free(struct RequestList* list) {
 }
 
 
+/*########################################################################################################################*
+*-----------------------------------------------------Http asset cache----------------------------------------------------*
+*#########################################################################################################################*/
+/* Responses to requests with HTTP_FLAG_CACHE are stored in texturecache/[CRC32 of url] */
+/* The index of cached responses is loaded at startup, and is used to revalidate cached responses */
+/*  with If-None-Match/If-Modified-Since, and to delete the least recently used responses */
+struct AssetCacheEntry {
+	cc_uint32 hash;     /* CRC32 of the url, which is also the name of the file */
+	cc_uint32 check;    /* Another hash of the url, in case two urls have the same CRC32 */
+	cc_uint32 size;     /* Size of the file */
+	cc_uint32 lastUsed; /* Unix time (in seconds) the response was last requested */
+	char etag[STRING_SIZE];
+	char lastModified[STRING_SIZE];
+};
+#define ASSET_CACHE_DIR "texturecache"
+/* hash, check, size, last used, length of last modified, last modified, and etag, separated by spaces */
+/* NOTE: Both last modified and etag may contain spaces, so etag is always the rest of the line */
+#define ASSET_CACHE_LINE_SIZE (5 * 11 + 2 * (STRING_SIZE + 1) + 2)
+
+static struct AssetCacheEntry* assetEntries;
+static int assetCount, assetCapacity;
+static cc_uint64 assetTotalSize, assetMaxSize;
+static cc_bool assetLoaded, assetDirty;
+static void* assetMutex;
+
+static cc_uint32 AssetCache_Hash(const cc_string* url) {
+	return Utils_CRC32((const cc_uint8*)url->buffer, url->length);
+}
+
+/* FNV-1a hash of the url */
+static cc_uint32 AssetCache_Check(const cc_string* url) {
+	cc_uint32 hash = 2166136261U;
+	int i;
+
+	for (i = 0; i < url->length; i++) {
+		hash = (hash ^ (cc_uint8)url->buffer[i]) * 16777619U;
+	}
+	return hash;
+}
+
+static cc_uint32 AssetCache_Now(void) {
+	return (cc_uint32)((DateTime_CurrentUTC_MS() - UNIX_EPOCH) / 1000);
+}
+
+static void AssetCache_MakePath(cc_string* path, cc_uint32 hash) {
+	Directory_GetCachePath(path, ASSET_CACHE_DIR);
+	String_Append(path, '/');
+	String_AppendUInt32(path, hash);
+}
+
+static void AssetCache_MakeIndexPath(cc_string* path) {
+	Directory_GetCachePath(path, ASSET_CACHE_DIR);
+	String_AppendConst(path, "/index.txt");
+}
+
+/* Returns index of the entry whose file is the given hash, or -1 if there is no such entry */
+/* NOTE: assetMutex must be locked when calling this */
+static int AssetCache_FindHash(cc_uint32 hash) {
+	int i;
+	for (i = 0; i < assetCount; i++) {
+		if (assetEntries[i].hash == hash) return i;
+	}
+	return -1;
+}
+
+/* Returns index of the entry for the given url, or -1 if the url is not cached */
+/* NOTE: assetMutex must be locked when calling this */
+static int AssetCache_Find(const cc_string* url) {
+	int i = AssetCache_FindHash(AssetCache_Hash(url));
+	if (i == -1) return -1;
+
+	/* Entries imported from the old texture pack cache only know the CRC32 of their url */
+	if (!assetEntries[i].check) {
+		assetEntries[i].check = AssetCache_Check(url);
+		assetDirty = true;
+	}
+	return assetEntries[i].check == AssetCache_Check(url) ? i : -1;
+}
+
+/* NOTE: assetMutex must be locked when calling this */
+static void AssetCache_RemoveAt(int i) {
+	assetTotalSize -= assetEntries[i].size;
+	assetEntries[i] = assetEntries[--assetCount];
+	assetDirty      = true;
+}
+
+/* Deletes the least recently used responses until the total size is under the limit */
+/* NOTE: assetMutex must be locked when calling this */
+static void AssetCache_Evict(cc_uint32 keepHash) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_result res;
+	int i, lru;
+
+	while (assetTotalSize > assetMaxSize) {
+		lru = -1;
+		for (i = 0; i < assetCount; i++) {
+			if (assetEntries[i].hash == keepHash) continue;
+			if (lru == -1 || assetEntries[i].lastUsed < assetEntries[lru].lastUsed) lru = i;
+		}
+		if (lru == -1) return;
+
+		String_InitArray(path, pathBuffer);
+		AssetCache_MakePath(&path, assetEntries[lru].hash);
+		res = File_Delete(&path);
+		if (res && res != ReturnCode_FileNotFound) Platform_Log2("Error %h deleting %s", &res, &path);
+
+		AssetCache_RemoveAt(lru);
+	}
+}
+
+/* Sets If-None-Match and If-Modified-Since to the tags of the cached response (if any) */
+static void AssetCache_Prepare(struct HttpRequest* req) {
+	cc_string url = String_FromRawArray(req->url);
+	struct AssetCacheEntry* e;
+	int i;
+	if (!req->_useCache || req->etag[0] || req->lastModified[0]) return;
+
+	Mutex_Lock(assetMutex);
+	{
+		i = AssetCache_Find(&url);
+		if (i >= 0) {
+			e = &assetEntries[i];
+			e->lastUsed = AssetCache_Now();
+			assetDirty  = true;
+
+			Mem_Copy(req->etag,         e->etag,         STRING_SIZE);
+			Mem_Copy(req->lastModified, e->lastModified, STRING_SIZE);
+		}
+	}
+	Mutex_Unlock(assetMutex);
+}
+
+/* Adds or updates the entry in the index for the response that was just written to disc */
+/* NOTE: assetMutex must be locked when calling this */
+static void AssetCache_Update(struct HttpRequest* req, const cc_string* url, cc_uint32 hash) {
+	struct AssetCacheEntry* e;
+	/* Also replaces the entry of another url with the same CRC32, as its file was just overwritten */
+	int i = AssetCache_FindHash(hash);
+
+	if (i == -1) {
+		if (assetCount == assetCapacity) {
+			Utils_Resize((void**)&assetEntries, &assetCapacity,
+						sizeof(struct AssetCacheEntry), 0, 512);
+		}
+		i = assetCount++;
+	} else {
+		assetTotalSize -= assetEntries[i].size;
+	}
+
+	e = &assetEntries[i];
+	e->hash     = hash;
+	e->check    = AssetCache_Check(url);
+	e->size     = req->size;
+	e->lastUsed = AssetCache_Now();
+	Mem_Copy(e->etag,         req->etag,         STRING_SIZE);
+	Mem_Copy(e->lastModified, req->lastModified, STRING_SIZE);
+
+	assetTotalSize += e->size;
+	assetDirty      = true;
+	AssetCache_Evict(hash);
+}
+
+/* Writes the contents of a 200 response to disc, then adds or updates its entry in the index */
+static void AssetCache_Store(struct HttpRequest* req) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string tmp;  char tmpBuffer[FILENAME_SIZE];
+	cc_string url = String_FromRawArray(req->url);
+	cc_uint32 hash = AssetCache_Hash(&url);
+	cc_result res;
+
+	String_InitArray(path, pathBuffer);
+	String_InitArray(tmp,  tmpBuffer);
+	AssetCache_MakePath(&path, hash);
+
+	/* Written to a temp file first, so a partially written response is never read from the cache */
+	/*  (request ID is part of the name, as another worker may be storing a response for the same url) */
+	String_Format2(&tmp, "%s_%i.tmp", &path, &req->id);
+	res = Stream_WriteAllTo(&tmp, req->data, req->size);
+
+	if (!res) {
+		Mutex_Lock(assetMutex);
+		{
+			/* Renamed while locked, so the file and its entry in the index are always updated together */
+			res = File_Rename(&tmp, &path);
+			if (!res) AssetCache_Update(req, &url, hash);
+		}
+		Mutex_Unlock(assetMutex);
+	}
+	if (!res) return;
+
+	/* NOTE: This may be called on a worker thread, so can't use Logger_Warn */
+	Platform_Log2("Error %h caching %s", &res, &url);
+	(void)File_Delete(&tmp);
+}
+
+/* Replaces the empty contents of a 304 response with the contents of the cached response */
+static void AssetCache_Load(struct HttpRequest* req) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string url = String_FromRawArray(req->url);
+	struct Stream stream;
+	cc_uint32 size = 0;
+	cc_result res;
+	int i;
+
+	String_InitArray(path, pathBuffer);
+	AssetCache_MakePath(&path, AssetCache_Hash(&url));
+	HttpRequest_Free(req);
+
+	if (!(res = Stream_OpenFile(&stream, &path))) {
+		if (!(res = stream.Length(&stream, &size)) && size) {
+			req->data = (cc_uint8*)Mem_Alloc(size, 1, "cached http data");
+			req->size = size;
+			res = Stream_Read(&stream, req->data, size);
+		}
+		(void)stream.Close(&stream);
+	}
+	if (!res && size) return;
+
+	/* e.g. user deleted the file, so make sure it's completely downloaded again next time */
+	Platform_Log2("Error %h reading cached %s", &res, &url);
+	HttpRequest_Free(req);
+
+	Mutex_Lock(assetMutex);
+	{
+		i = AssetCache_Find(&url);
+		if (i >= 0) AssetCache_RemoveAt(i);
+	}
+	Mutex_Unlock(assetMutex);
+}
+
+static void AssetCache_Complete(struct HttpRequest* req) {
+	if (!req->_useCache || req->result) return;
+
+	if (req->statusCode == 200 && req->data && req->size) {
+		AssetCache_Store(req);
+	} else if (req->statusCode == 304) {
+		AssetCache_Load(req);
+	}
+}
+
+static void AssetCache_ParseEntry(const cc_string* line) {
+	struct AssetCacheEntry e = { 0 };
+	cc_string rest = *line, part, lastModified, etag = String_Empty;
+	cc_uint64 values[5];
+	int i;
+
+	for (i = 0; i < 5; i++) {
+		String_UNSAFE_SplitBy(&rest, ' ', &part);
+		if (!Convert_ParseUInt64(&part, &values[i])) return;
+	}
+	if (values[4] > (cc_uint64)rest.length) return;
+
+	e.hash  = (cc_uint32)values[0]; e.check    = (cc_uint32)values[1];
+	e.size  = (cc_uint32)values[2]; e.lastUsed = (cc_uint32)values[3];
+	lastModified = String_UNSAFE_Substring(&rest, 0, (int)values[4]);
+	if ((int)values[4] < rest.length) etag = String_UNSAFE_SubstringAt(&rest, (int)values[4] + 1);
+
+	String_CopyToRawArray(e.etag,         &etag);
+	String_CopyToRawArray(e.lastModified, &lastModified);
+	if (AssetCache_FindHash(e.hash) >= 0) return;
+
+	if (assetCount == assetCapacity) {
+		Utils_Resize((void**)&assetEntries, &assetCapacity,
+					sizeof(struct AssetCacheEntry), 0, 512);
+	}
+	assetEntries[assetCount++] = e;
+	assetTotalSize += e.size;
+}
+
+/* Returns whether index.txt exists */
+static cc_bool AssetCache_LoadIndex(void) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string line; char lineBuffer[ASSET_CACHE_LINE_SIZE];
+	cc_uint8 buffer[2048];
+	struct Stream stream, buffered;
+	cc_result res;
+
+	String_InitArray(path, pathBuffer);
+	AssetCache_MakeIndexPath(&path);
+
+	res = Stream_OpenFile(&stream, &path);
+	if (res == ReturnCode_FileNotFound) return false;
+	if (res) { Logger_SysWarn2(res, "opening", &path); return true; }
+
+	/* ReadLine reads single byte at a time */
+	Stream_ReadonlyBuffered(&buffered, &stream, buffer, sizeof(buffer));
+	for (;;) {
+		String_InitArray(line, lineBuffer);
+		res = Stream_ReadLine(&buffered, &line);
+
+		if (res == ERR_END_OF_STREAM) break;
+		if (res) { Logger_SysWarn2(res, "reading from", &path); break; }
+		AssetCache_ParseEntry(&line);
+	}
+	(void)stream.Close(&stream);
+	return true;
+}
+
+/* The texture pack cache used to keep ETags and Last-Modified in two lists instead, */
+/*  with each entry being the CRC32 of the url followed by a space and the value */
+static struct StringsBuffer legacyETags, legacyLastMod;
+#define LEGACY_ETAGS_TXT   "texturecache/etags.txt"
+#define LEGACY_LASTMOD_TXT "texturecache/lastmodified.txt"
+
+static void AssetCache_ImportFile(const cc_string* path, void* obj) {
+	struct AssetCacheEntry e = { 0 };
+	cc_string name = *path, etag, lastModified;
+	struct Stream stream;
+	cc_uint64 hash;
+	int i;
+
+	/* Cached files are named by CRC32 of the url, other files (e.g. acceptedurls.txt) aren't */
+	Utils_UNSAFE_GetFilename(&name);
+	if (!Convert_ParseUInt64(&name, &hash) || hash > 0xFFFFFFFFU) return;
+	if (AssetCache_FindHash((cc_uint32)hash) >= 0) return;
+
+	if (Stream_OpenFile(&stream, path)) return;
+	if (stream.Length(&stream, &e.size)) e.size = 0;
+	(void)stream.Close(&stream);
+	if (!e.size) return;
+
+	etag         = EntryList_UNSAFE_Get(&legacyETags,   &name, ' ');
+	lastModified = EntryList_UNSAFE_Get(&legacyLastMod, &name, ' ');
+	/* Entry used to be a timestamp of C# DateTime ticks, which is no longer supported */
+	for (i = 0; i < lastModified.length; i++) {
+		if (lastModified.buffer[i] < '0' || lastModified.buffer[i] > '9') break;
+	}
+	if (i == lastModified.length) lastModified.length = 0;
+
+	e.hash     = (cc_uint32)hash;
+	e.lastUsed = AssetCache_Now();
+	String_CopyToRawArray(e.etag,         &etag);
+	String_CopyToRawArray(e.lastModified, &lastModified);
+
+	if (assetCount == assetCapacity) {
+		Utils_Resize((void**)&assetEntries, &assetCapacity,
+					sizeof(struct AssetCacheEntry), 0, 512);
+	}
+	assetEntries[assetCount++] = e;
+	assetTotalSize += e.size;
+	assetDirty      = true;
+}
+
+/* Adds the files from the old texture pack cache to the index, so they are revalidated instead of downloaded again */
+static void AssetCache_ImportLegacy(void) {
+	static const cc_string etags   = String_FromConst(LEGACY_ETAGS_TXT);
+	static const cc_string lastMod = String_FromConst(LEGACY_LASTMOD_TXT);
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+
+	EntryList_UNSAFE_Load(&legacyETags,   LEGACY_ETAGS_TXT);
+	EntryList_UNSAFE_Load(&legacyLastMod, LEGACY_LASTMOD_TXT);
+
+	String_InitArray(path, pathBuffer);
+	Directory_GetCachePath(&path, ASSET_CACHE_DIR);
+	Directory_Enum(&path, NULL, AssetCache_ImportFile);
+
+	StringsBuffer_Clear(&legacyETags);
+	StringsBuffer_Clear(&legacyLastMod);
+	(void)File_Delete(&etags);
+	(void)File_Delete(&lastMod);
+	/* Make sure index.txt exists, so the import only happens once */
+	assetDirty = true;
+}
+
+static void AssetCache_SaveIndex(void) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_string line; char lineBuffer[ASSET_CACHE_LINE_SIZE];
+	struct AssetCacheEntry* e;
+	cc_string etag, lastModified;
+	cc_uint8* data = NULL;
+	cc_uint32 size = 0;
+	cc_result res;
+	int i;
+	if (!assetDirty) return;
+
+	/* Only copy the index while locked, so workers aren't blocked while it is written */
+	Mutex_Lock(assetMutex);
+	{
+		if (assetCount) data = (cc_uint8*)Mem_Alloc(assetCount, ASSET_CACHE_LINE_SIZE, "asset cache index");
+
+		for (i = 0; i < assetCount; i++) {
+			e = &assetEntries[i];
+			etag         = String_FromRawArray(e->etag);
+			lastModified = String_FromRawArray(e->lastModified);
+
+			String_InitArray(line, lineBuffer);
+			String_AppendUInt32(&line, e->hash);  String_Append(&line, ' ');
+			String_AppendUInt32(&line, e->check); String_Append(&line, ' ');
+			String_AppendUInt32(&line, e->size);  String_Append(&line, ' ');
+			String_AppendUInt32(&line, e->lastUsed); String_Append(&line, ' ');
+			String_AppendInt(&line, lastModified.length);
+			String_Format2(&line, " %s %s" _NL, &lastModified, &etag);
+
+			Mem_Copy(data + size, line.buffer, line.length);
+			size += line.length;
+		}
+		assetDirty = false;
+	}
+	Mutex_Unlock(assetMutex);
+
+	String_InitArray(path, pathBuffer);
+	AssetCache_MakeIndexPath(&path);
+	res = Stream_WriteAllTo(&path, data, size);
+
+	if (res) Logger_SysWarn2(res, "saving", &path);
+	Mem_Free(data);
+}
+
+static void AssetCache_SaveTask(struct ScheduledTask* task) { AssetCache_SaveIndex(); }
+
+static void AssetCache_Init(void) {
+	/* Http component gets initialised multiple times on Android */
+	if (assetLoaded) return;
+	assetLoaded  = true;
+	assetMutex   = Mutex_Create();
+	assetMaxSize = (cc_uint64)Options_GetInt(OPT_HTTP_CACHE_SIZE, 1, 4096, 100) * 1024 * 1024;
+
+	Utils_EnsureDirectory(ASSET_CACHE_DIR);
+	if (!AssetCache_LoadIndex()) AssetCache_ImportLegacy();
+	/* In case the size limit was reduced since the last time */
+	AssetCache_Evict(0);
+}
+
+cc_bool Http_OpenCached(const cc_string* url, struct Stream* stream) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_result res;
+	int i;
+
+	Mutex_Lock(assetMutex);
+	{
+		i = AssetCache_Find(url);
+	}
+	Mutex_Unlock(assetMutex);
+	if (i == -1) return false;
+
+	String_InitArray(path, pathBuffer);
+	AssetCache_MakePath(&path, AssetCache_Hash(url));
+	res = Stream_OpenFile(stream, &path);
+
+	if (res == ReturnCode_FileNotFound) return false;
+	if (res) { Logger_SysWarn2(res, "opening cache for", url); return false; }
+	return true;
+}
+
+
 /*########################################################################################################################*
 *--------------------------------------------------Common downloader code-------------------------------------------------*
 *#########################################################################################################################*/
@@ -120,6 +561,16 @@ static int Http_Add(const cc_string* url, cc_uint8 flags, cc_uint8 type, const c
 
 	req.id = ++nextReqID;
 	req.requestType = type;
+	req._timeAdded  = Stopwatch_Measure();
+	req._useCache   = (flags & HTTP_FLAG_CACHE) && type == REQUEST_TYPE_GET;
+
+	if (flags & HTTP_FLAG_PRIORITY) {
+		req._priority = HTTP_PRIORITY_HIGH;
+	} else if (flags & HTTP_FLAG_BACKGROUND) {
+		req._priority = HTTP_PRIORITY_BACKGROUND;
+	} else {
+		req._priority = HTTP_PRIORITY_NORMAL;
+	}
 
 	/* Change http:// to https:// if required */
 	if (httpsOnly) {
@@ -172,15 +623,30 @@ static void Http_GetUrl(struct HttpRequest* req, cc_string* dst) {
 }
 
 
+static int Http_HistogramBucket(cc_uint64 beg, cc_uint64 end) {
+	int ms = Stopwatch_ElapsedMS(beg, end), i;
+	for (i = 0; ms && i < HTTP_HISTOGRAM_BUCKETS - 1; i++) { ms >>= 1; }
+	return i;
+}
+
 /* Updates state after a completed http request */
 static void Http_FinishRequest(struct HttpRequest* req) {
-	req->success = !req->result && req->statusCode == 200 && req->data && req->size;
+	cc_uint64 now = Stopwatch_Measure();
+	AssetCache_Complete(req);
+
+	req->success  = !req->result && (req->statusCode == 200 || req->statusCode == 304) && req->data && req->size;
 	if (!req->success) HttpRequest_Free(req);
+	/* Request may have failed before it was ever started */
+	if (!req->_timeStarted) req->_timeStarted = now;
 
 	Mutex_Lock(processedMutex);
 	{
 		req->timeDownloaded = DateTime_CurrentUTC_MS();
-		RequestList_Append(&processedReqs, req, false);
+		RequestList_Append(&processedReqs, req);
+
+		HttpStats.Count++;
+		HttpStats.WaitTimes[Http_HistogramBucket(req->_timeAdded,   req->_timeStarted)]++;
+		HttpStats.Latencies[Http_HistogramBucket(req->_timeStarted, now)]++;
 	}
 	Mutex_Unlock(processedMutex);
 }
@@ -217,7 +683,12 @@ int Http_AsyncGetSkin(const cc_string* skinName, cc_uint8 flags) {
 	} else {
 		String_Format2(&url, "%s/%s.png", &skinServer, skinName);
 	}
-	return Http_AsyncGetData(&url, flags);
+
+	/* There can be hundreds of skins to download when joining a busy server, */
+	/*  which shouldn't delay e.g. downloading the server's texture pack */
+	if (!(flags & HTTP_FLAG_PRIORITY)) flags |= HTTP_FLAG_BACKGROUND;
+	/* Skins rarely change, so are cached on disc and only downloaded again when the server reports they have changed */
+	return Http_AsyncGetData(&url, flags | HTTP_FLAG_CACHE);
 }
 
 int Http_AsyncGetData(const cc_string* url, cc_uint8 flags) {
@@ -272,11 +743,18 @@ static void Http_InitCommon(void) {
 
 	Options_Get(OPT_SKIN_SERVER, &skinServer, SKINS_SERVER);
 	ScheduledTask_Add(30, Http_CleanCacheTask);
+	ScheduledTask_Add(30, AssetCache_SaveTask);
+	AssetCache_Init();
 }
 static void Http_Init(void);
 
+static void Http_Free(void) {
+	AssetCache_SaveIndex();
+	Http_ClearPending();
+}
+
 struct IGameComponent Http_Component = {
 	Http_Init,        /* Init  */
-	Http_ClearPending,/* Free  */
+	Http_Free,        /* Free  */
 	Http_ClearPending /* Reset */
 };
@@ -303,6 +303,51 @@ mergeInto(LibraryManager.library, {
     }
   },
   interop_FileClose__deps: ['interop_SaveNode'],
+  interop_FileDelete__deps: ['IDBFS_getDB'],
+  interop_FileDelete: function(raw) {
+    var path = UTF8ToString(raw);
+    try {
+      path = CCFS.lookupPath(path).path;
+      CCFS.unlink(path);
+    } catch (e) {
+      if (!(e instanceof CCFS.ErrnoError)) abort(e);
+      return e.errno;
+    }
+    
+    // also remove the file from IndexedDB, otherwise it reappears when the page is reloaded
+    _IDBFS_getDB(function(err, db) {
+      if (err) return;
+      try {
+        db.transaction([IDBFS_DB_STORE_NAME], 'readwrite').objectStore(IDBFS_DB_STORE_NAME).delete(path);
+      } catch (e) { }
+    });
+    return 0;
+  },
+  interop_FileRename__deps: ['interop_SaveNode', 'IDBFS_getDB'],
+  interop_FileRename: function(rawSrc, rawDst) {
+    var src = UTF8ToString(rawSrc);
+    var dst = CCFS.resolvePath(UTF8ToString(rawDst));
+    try {
+      var lookup = CCFS.lookupPath(src);
+      src = lookup.path;
+      lookup.node.path = dst;
+      CCFS.entries[dst] = lookup.node;
+      delete CCFS.entries[src];
+    } catch (e) {
+      if (!(e instanceof CCFS.ErrnoError)) abort(e);
+      return e.errno;
+    }
+
+    // move the file in IndexedDB too, otherwise the old file reappears when the page is reloaded
+    _interop_SaveNode(dst);
+    _IDBFS_getDB(function(err, db) {
+      if (err) return;
+      try {
+        db.transaction([IDBFS_DB_STORE_NAME], 'readwrite').objectStore(IDBFS_DB_STORE_NAME).delete(src);
+      } catch (e) { }
+    });
+    return 0;
+  },
   
   
 //########################################################################################################################